@@ -0,0 +1,31 @@
+/*
+ * accounting.h
+ */
+
+#ifndef ACCOUNTING_H
+#define ACCOUNTING_H
+
+/*** ACCOUNTING structures ***/
+
+// Accounted states (several states can be active at the same time, except sleep).
+typedef enum {
+	ACCOUNTING_STATE_SLEEP,
+	ACCOUNTING_STATE_MEASURE,
+	ACCOUNTING_STATE_GPS,
+	ACCOUNTING_STATE_TX,
+	ACCOUNTING_STATE_RX,
+	ACCOUNTING_STATE_LAST
+} ACCOUNTING_State;
+
+/*** ACCOUNTING functions ***/
+
+void ACCOUNTING_Init(void);
+void ACCOUNTING_Save(void);
+void ACCOUNTING_Reset(void);
+void ACCOUNTING_EnterState(ACCOUNTING_State state);
+void ACCOUNTING_ExitState(ACCOUNTING_State state);
+void ACCOUNTING_GetStateTime(ACCOUNTING_State state, unsigned int* time_seconds);
+void ACCOUNTING_GetStateCharge(ACCOUNTING_State state, unsigned int* charge_mas);
+unsigned char ACCOUNTING_GetSummary(void);
+
+#endif /* ACCOUNTING_H */
@@ -21,11 +21,17 @@
 #define AT_COMMANDS_SIGFOX
 #define AT_COMMANDS_CW
 #define AT_COMMANDS_TEST_MODES
+#define AT_COMMANDS_ACCOUNTING
+#define AT_COMMANDS_PROVISIONING
+#ifdef PROFILER
+#define AT_COMMANDS_PROFILER
+#endif
 
 /*** AT user functions ***/
 
 void AT_Init(void);
 void AT_Task(void);
+unsigned char AT_IsIdle(void);
 
 /*** AT utility functions ***/
 
@@ -0,0 +1,19 @@
+/*
+ * energy.h
+ */
+
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include "sensors.h"
+
+/*** ENERGY functions ***/
+
+void ENERGY_Init(unsigned int supercap_voltage_min_mv);
+void ENERGY_Update(SENSORS_Snapshot* snapshot);
+void ENERGY_GetStoredEnergy(unsigned int* stored_energy_mj);
+void ENERGY_GetLevel(unsigned char* level_percent);
+void ENERGY_GetBalance(signed int* balance_uw);
+unsigned int ENERGY_GetPeriod(unsigned int nominal_period_seconds, unsigned int min_period_seconds, unsigned int max_period_seconds);
+
+#endif /* ENERGY_H */
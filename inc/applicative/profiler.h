@@ -0,0 +1,54 @@
+/*
+ * profiler.h
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "mode.h"
+
+#if (defined PROFILER) && !(defined ATM)
+#error "Profiler results can only be read in AT command mode."
+#endif
+
+/*** PROFILER structures ***/
+
+// Regions measured with begin/end probes.
+typedef enum {
+	PROFILER_PROBE_RF_API_SEND,
+	PROFILER_PROBE_NEOM8N_PARSE_GGA,
+	PROFILER_PROBE_ADC_MEASUREMENTS,
+	PROFILER_PROBE_LAST
+} PROFILER_Probe;
+
+/*** PROFILER macros ***/
+
+// Probes are removed when profiler is disabled.
+#ifdef PROFILER
+#define PROFILER_BEGIN(probe)	PROFILER_Begin(probe)
+#define PROFILER_END(probe)		PROFILER_End(probe)
+#else
+#define PROFILER_BEGIN(probe)
+#define PROFILER_END(probe)
+#endif
+
+#ifdef PROFILER
+
+/*** PROFILER functions ***/
+
+void PROFILER_Init(void);
+void PROFILER_Reset(void);
+void PROFILER_Begin(PROFILER_Probe probe);
+void PROFILER_End(PROFILER_Probe probe);
+void PROFILER_GetSamples(unsigned int* sample_count, unsigned int* outside_flash_count, unsigned int* period_cycles);
+unsigned short PROFILER_GetBucketNumber(void);
+void PROFILER_GetBucket(unsigned short bucket_idx, unsigned int* start_address, unsigned int* sample_count);
+void PROFILER_GetProbe(PROFILER_Probe probe, unsigned int* count, unsigned int* average_cycles, unsigned int* max_cycles);
+
+/*** PROFILER utility functions ***/
+
+void PROFILER_SampleProgramCounter(unsigned int program_counter);
+
+#endif
+
+#endif /* PROFILER_H */
@@ -0,0 +1,21 @@
+/*
+ * prov.h
+ */
+
+#ifndef PROV_H
+#define PROV_H
+
+#include "mode.h"
+
+#ifdef ATM
+
+/*** PROV functions ***/
+
+void PROV_Init(void);
+unsigned char PROV_Task(void);
+unsigned char PROV_IsIdle(void);
+void PROV_FillRxBuffer(unsigned char rx_byte);
+
+#endif
+
+#endif /* PROV_H */
@@ -0,0 +1,26 @@
+/*
+ * scheduler.h
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+/*** SCHEDULER structures ***/
+
+typedef enum {
+	SCHEDULER_EVENT_KEEP_ALIVE,
+	SCHEDULER_EVENT_STOP_CONDITION,
+	SCHEDULER_EVENT_GEOLOC,
+	SCHEDULER_EVENT_RETRY,
+	SCHEDULER_EVENT_LAST
+} SCHEDULER_Event;
+
+/*** SCHEDULER functions ***/
+
+void SCHEDULER_Init(void);
+void SCHEDULER_SetDeadline(SCHEDULER_Event event, unsigned int delay_seconds);
+void SCHEDULER_CancelDeadline(SCHEDULER_Event event);
+SCHEDULER_Event SCHEDULER_GetExpiredEvent(void);
+void SCHEDULER_StartWakeUpTimer(void);
+
+#endif /* SCHEDULER_H */
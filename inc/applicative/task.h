@@ -0,0 +1,54 @@
+/*
+ * task.h
+ */
+
+#ifndef TASK_H
+#define TASK_H
+
+/*** TASK macros ***/
+
+#define TASK_LINE_ENDED		0xFFFF
+
+// Task body delimiters (local variables are not preserved across waits, task data must be stored in a static context).
+#define TASK_BEGIN(task_ctx) \
+	if ((task_ctx) -> task_line == TASK_LINE_ENDED) return TASK_STATUS_ENDED; \
+	switch ((task_ctx) -> task_line) { case 0:
+#define TASK_END(task_ctx) \
+	} \
+	(task_ctx) -> task_line = TASK_LINE_ENDED; \
+	return TASK_STATUS_ENDED;
+// Return to the scheduler until condition is true (re-evaluated each time the task is called).
+#define TASK_WAIT_UNTIL(task_ctx, condition) \
+	(task_ctx) -> task_line = __LINE__; case __LINE__: \
+	if (!(condition)) return TASK_STATUS_WAITING;
+// Return to the scheduler once to let other tasks run.
+#define TASK_YIELD(task_ctx) \
+	(task_ctx) -> task_yield_flag = 1; \
+	(task_ctx) -> task_line = __LINE__; case __LINE__: \
+	if ((task_ctx) -> task_yield_flag != 0) { (task_ctx) -> task_yield_flag = 0; return TASK_STATUS_WAITING; }
+
+/*** TASK structures ***/
+
+typedef enum {
+	TASK_STATUS_WAITING,
+	TASK_STATUS_ENDED
+} TASK_Status;
+
+typedef struct {
+	unsigned short task_line; // Resume point.
+	unsigned char task_yield_flag;
+} TASK_Context;
+
+typedef TASK_Status (*TASK_Function)(TASK_Context* task_ctx);
+typedef void (*TASK_IdleFunction)(void);
+
+typedef struct {
+	TASK_Function task_function;
+	TASK_Context task_ctx;
+} TASK_Descriptor;
+
+/*** TASK functions ***/
+
+void TASK_Run(TASK_Descriptor* task_list, unsigned char task_list_size, TASK_IdleFunction idle_function);
+
+#endif /* TASK_H */
@@ -32,9 +32,21 @@ typedef struct {
 	unsigned int altitude;
 } Position;
 
+typedef struct {
+	// Date.
+	unsigned short year;
+	unsigned char month;
+	unsigned char date;
+	// Time.
+	unsigned char hours;
+	unsigned char minutes;
+	unsigned char seconds;
+} Timestamp;
+
 typedef enum {
 	NEOM8N_SUCCESS,			// Parsing successful and data valid.
-	NEOM8N_TIMEOUT			// Parsing failure (= timeout).
+	NEOM8N_TIMEOUT,			// Parsing failure (= timeout).
+	NEOM8N_RUNNING			// Acquisition in progress.
 } NEOM8N_ReturnCode;
 
 /*** NEOM8N user functions ***/
@@ -43,6 +55,10 @@ void NEOM8N_Init(void);
 #if (defined HW1_1) && (defined NEOM8N_USE_VBCKP)
 void NEOM8N_SetVbckp(unsigned char vbckp_on);
 #endif
+void NEOM8N_StartAcquisition(unsigned int timeout_seconds, unsigned int supercap_voltage_min_mv);
+NEOM8N_ReturnCode NEOM8N_ProcessAcquisition(void);
+unsigned char NEOM8N_IsIdle(void);
+NEOM8N_ReturnCode NEOM8N_StopAcquisition(Position* gps_position, unsigned int* fix_duration_seconds);
 NEOM8N_ReturnCode NEOM8N_GetPosition(Position* gps_position, unsigned int timeout_seconds, unsigned int supercap_voltage_min_mv, unsigned int* fix_duration_seconds);
 
 /*** NEOM8N utility functions ***/
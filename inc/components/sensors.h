@@ -0,0 +1,33 @@
+/*
+ * sensors.h
+ */
+
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include "sht3x.h"
+
+/*** SENSORS structures ***/
+
+typedef struct {
+	unsigned int timestamp_seconds;				// RTC timestamp of the acquisition.
+	unsigned char temperature_degrees_comp1;	// SHT3x temperature (1-complement).
+	signed char temperature_degrees_comp2;		// SHT3x temperature (2-complement).
+	unsigned char humidity_percent;				// SHT3x humidity.
+	signed int temperature_centidegrees;		// SHT3x temperature (0.01 resolution).
+	unsigned int humidity_centipercent;			// SHT3x humidity (0.01 resolution).
+	SHT3X_Repeatability repeatability;			// SHT3x measurement repeatability.
+	unsigned int source_voltage_mv;
+	unsigned int supercap_voltage_mv;
+	unsigned int mcu_voltage_mv;
+	unsigned char mcu_temperature_degrees_comp1;
+	signed char mcu_temperature_degrees_comp2;
+} SENSORS_Snapshot;
+
+/*** SENSORS functions ***/
+
+void SENSORS_Init(void);
+void SENSORS_PerformMeasurements(SHT3X_Repeatability repeatability);
+void SENSORS_GetSnapshot(SENSORS_Snapshot* snapshot, unsigned int max_age_seconds, SHT3X_Repeatability repeatability);
+
+#endif /* SENSORS_H */
@@ -8,12 +8,25 @@
 #ifndef SHT3X_H
 #define SHT3X_H
 
+/*** SHT3x structures ***/
+
+typedef enum {
+	SHT3X_REPEATABILITY_LOW,	// Lowest energy, 4ms max conversion time.
+	SHT3X_REPEATABILITY_MEDIUM,	// 6ms max conversion time.
+	SHT3X_REPEATABILITY_HIGH,	// Best accuracy, 15ms max conversion time.
+	SHT3X_REPEATABILITY_LAST
+} SHT3X_Repeatability;
+
 /*** SHT3x functions ***/
 
 void SHT3X_Init(void);
-void SHT3X_PerformMeasurements(void);
+unsigned char SHT3X_StartMeasurements(SHT3X_Repeatability repeatability);
+unsigned char SHT3X_ReadMeasurements(void);
+unsigned char SHT3X_PerformMeasurements(SHT3X_Repeatability repeatability);
 void SHT3X_GetTemperatureComp1(unsigned char* temperature_degrees);
 void SHT3X_GetTemperatureComp2(signed char* temperature_degrees);
+void SHT3X_GetTemperatureCentiDegrees(signed int* temperature_centidegrees);
 void SHT3X_GetHumidity(unsigned char* humidity_percent);
+void SHT3X_GetHumidityCentiPercent(unsigned int* humidity_centipercent);
 
 #endif /* SHT3X_H */
@@ -18,6 +18,7 @@
 /*** Debug mode ***/
 
 //#define DEBUG		// Use programming pins for debug purpose if defined.
+//#define PROFILER	// SysTick program counter sampling and cycle probes, read with AT$PROF? command (AT mode only).
 
 /*** Error management ***/
 
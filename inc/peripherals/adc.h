@@ -16,6 +16,9 @@ void ADC1_PowerOn(void);
 void ADC1_PowerOff(void);
 void ADC1_PerformAllMeasurements(void);
 void ADC1_PerformSupercapMeasurement(void);
+void ADC1_StartSupercapWatchdog(unsigned int supercap_voltage_min_mv);
+void ADC1_StopSupercapWatchdog(void);
+unsigned char ADC1_GetSupercapWatchdogFlag(void);
 void ADC1_GetSourceVoltage(unsigned int* source_voltage_mv);
 void ADC1_GetSupercapVoltage(unsigned int* supercap_voltage_mv);
 void ADC1_GetMcuVoltage(unsigned int* supply_voltage_mv);
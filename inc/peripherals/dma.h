@@ -16,6 +16,11 @@ void DMA1_StopChannel3(void);
 void DMA1_SetChannel3SourceAddr(unsigned int source_buf_addr, unsigned short source_buf_size);
 unsigned char DMA1_GetChannel3Status(void);
 
+void DMA1_InitChannel4(void);
+void DMA1_StartChannel4(void);
+void DMA1_StopChannel4(void);
+void DMA1_SetChannel4SourceAddr(unsigned int source_buf_addr, unsigned short source_buf_size);
+
 void DMA1_InitChannel6(void);
 void DMA1_StartChannel6(void);
 void DMA1_StopChannel6(void);
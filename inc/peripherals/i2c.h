@@ -8,13 +8,24 @@
 #ifndef I2C_H
 #define I2C_H
 
+/*** I2C structures ***/
+
+typedef enum {
+	I2C_SPEED_STANDARD_100KHZ,
+	I2C_SPEED_FAST_400KHZ,
+	I2C_SPEED_LAST
+} I2C_Speed;
+
 /*** I2C functions ***/
 
 void I2C1_Init(void);
+void I2C1_SetSpeed(I2C_Speed speed);
 void I2C1_Disable(void);
 void I2C1_PowerOn(void);
 void I2C1_PowerOff(void);
+void I2C1_WaitSlaveReady(unsigned int startup_time_ms);
 unsigned char I2C1_Write(unsigned char slave_address, unsigned char* tx_buf, unsigned char tx_buf_length, unsigned char stop_flag);
 unsigned char I2C1_Read(unsigned char slave_address, unsigned char* rx_buf, unsigned char rx_buf_length);
+unsigned char I2C1_WriteRead(unsigned char slave_address, unsigned char* tx_buf, unsigned char tx_buf_length, unsigned char* rx_buf, unsigned char rx_buf_length);
 
 #endif /* I2C_H */
@@ -11,6 +11,7 @@
 /*** IWDG macros ***/
 
 #define IWDG_REFRESH_PERIOD_SECONDS		10
+#define IWDG_TIMEOUT_MIN_SECONDS		18 // 4095 * 256 / 56kHz (highest LSI frequency).
 
 /*** IWDG functions ***/
 
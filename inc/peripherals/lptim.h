@@ -8,11 +8,29 @@
 #ifndef LPTIM_H
 #define LPTIM_H
 
+/*** LPTIM macros ***/
+
+#define LPTIM_TIMER_NUMBER	6 // Maximum number of concurrent software timers.
+
+/*** LPTIM structures ***/
+
+typedef enum {
+	LPTIM_TIMER_MODE_SINGLE,
+	LPTIM_TIMER_MODE_PERIODIC
+} LPTIM_TimerMode;
+
+typedef void (*LPTIM_TimerCallback)(void);
+
 /*** LPTIM functions ***/
 
 void LPTIM1_Init(unsigned int lsi_freq_hz);
 void LPTIM1_Enable(void);
 void LPTIM1_Disable(void);
+unsigned char LPTIM1_StartTimer(unsigned char* timer_id, unsigned int duration_ms, LPTIM_TimerMode mode, LPTIM_TimerCallback callback);
+void LPTIM1_StopTimer(unsigned char timer_id);
+unsigned char LPTIM1_GetTimerFlag(unsigned char timer_id);
+void LPTIM1_ClearTimerFlag(unsigned char timer_id);
+void LPTIM1_WaitTimer(unsigned char timer_id, unsigned char stop_mode);
 void LPTIM1_DelayMilliseconds(unsigned int delay_ms, unsigned char stop_mode);
 
 #endif /* LPTIM_H */
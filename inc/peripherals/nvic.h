@@ -53,6 +53,8 @@ typedef enum {
 void NVIC_Init(void);
 void NVIC_EnableInterrupt(NVIC_InterruptVector it_num);
 void NVIC_DisableInterrupt(NVIC_InterruptVector it_num);
+void NVIC_DisableInterrupts(void);
+void NVIC_EnableInterrupts(void);
 void NVIC_SetPriority(NVIC_InterruptVector it_num, unsigned char priority);
 
 #endif /* NVIC_H */
@@ -26,6 +26,9 @@ void NVM_Enable(void);
 void NVM_Disable(void);
 void NVM_ReadByte(unsigned short address_offset, unsigned char* byte_to_read);
 void NVM_WriteByte(unsigned short address_offset, unsigned char byte_to_store);
+unsigned char NVM_ReadBlock(unsigned short address_offset, unsigned char* data, unsigned short data_length);
+unsigned char NVM_WriteBlock(unsigned short address_offset, unsigned char* data, unsigned short data_length);
+unsigned char NVM_ComputeCrc32(unsigned short address_offset, unsigned short data_length, unsigned int* crc32);
 void NVM_ResetDefault(void);
 
 #endif /* NVM_H */
@@ -15,12 +15,44 @@
 #define RCC_MSI_FREQUENCY_KHZ	65
 #define RCC_HSI_FREQUENCY_KHZ	16000
 
+/*** RCC structures ***/
+
+// System clock levels (ascending frequency).
+typedef enum {
+	RCC_CLOCK_LEVEL_MSI_65KHZ,
+	RCC_CLOCK_LEVEL_MSI_131KHZ,
+	RCC_CLOCK_LEVEL_MSI_262KHZ,
+	RCC_CLOCK_LEVEL_MSI_524KHZ,
+	RCC_CLOCK_LEVEL_MSI_1MHZ,
+	RCC_CLOCK_LEVEL_MSI_2MHZ,
+	RCC_CLOCK_LEVEL_MSI_4MHZ,
+	RCC_CLOCK_LEVEL_HSI_16MHZ,
+	RCC_CLOCK_LEVEL_LAST
+} RCC_ClockLevel;
+
+// Clock manager clients.
+typedef enum {
+	RCC_CLOCK_CLIENT_APPLICATION,
+	RCC_CLOCK_CLIENT_ADC1,
+	RCC_CLOCK_CLIENT_I2C1,
+	RCC_CLOCK_CLIENT_LPUART1,
+	RCC_CLOCK_CLIENT_SPI1,
+	RCC_CLOCK_CLIENT_LAST
+} RCC_ClockClient;
+
+typedef void (*RCC_ClockCallback)(void);
+
 /*** RCC functions ***/
 
 void RCC_Init(void);
 unsigned int RCC_GetSysclkKhz(void);
-unsigned char RCC_SwitchToMsi(void);
-unsigned char RCC_SwitchToHsi(void);
+unsigned char RCC_SetHsiKernelRequest(unsigned char hsi_kernel_request);
+void RCC_SetClockRequest(RCC_ClockClient client, unsigned int frequency_min_khz);
+void RCC_SetClockCallback(RCC_ClockClient client, RCC_ClockCallback callback);
+void RCC_EnterStopMode(void);
+void RCC_ExitStopMode(void);
+void RCC_StartClockLevelTime(void);
+void RCC_GetClockLevelTime(RCC_ClockLevel level, unsigned int* time_ms);
 unsigned char RCC_EnableLsi(void);
 void RCC_GetLsiFrequency(unsigned int* lsi_frequency_hz);
 unsigned char RCC_EnableLse(void);
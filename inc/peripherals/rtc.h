@@ -13,9 +13,15 @@
 
 /*** RTC macros ***/
 
-// RTC wake-up timer period.
-// Warning: this value must be lower than the watchdog period = 25s.
- #define RTC_WAKEUP_PERIOD_SECONDS	10
+#define RTC_BACKUP_REGISTERS_NUMBER		5
+
+/*** RTC structures ***/
+
+typedef enum {
+	RTC_ALARM_A,
+	RTC_ALARM_B,
+	RTC_ALARM_LAST
+} RTC_Alarm;
 
 /*** RTC functions ***/
 
@@ -25,5 +31,16 @@ void RTC_StartWakeUpTimer(unsigned int delay_seconds);
 void RTC_StopWakeUpTimer(void);
 volatile unsigned char RTC_GetWakeUpTimerFlag(void);
 void RTC_ClearWakeUpTimerFlag(void);
+void RTC_StartAlarm(RTC_Alarm alarm, unsigned int utc_seconds);
+void RTC_StopAlarm(RTC_Alarm alarm);
+volatile unsigned char RTC_GetAlarmFlag(RTC_Alarm alarm);
+void RTC_ClearAlarmFlag(RTC_Alarm alarm);
+unsigned char RTC_SetTimestamp(Timestamp* timestamp);
+void RTC_GetTimestamp(Timestamp* timestamp);
+void RTC_GetUtcSeconds(unsigned int* utc_seconds);
+void RTC_GetTimestampSeconds(unsigned int* timestamp_seconds);
+void RTC_GetTimestampMilliseconds(unsigned int* timestamp_ms);
+void RTC_WriteBackupRegister(unsigned char register_idx, unsigned int value);
+void RTC_ReadBackupRegister(unsigned char register_idx, unsigned int* value);
 
 #endif /* RTC_H */
@@ -26,7 +26,13 @@ typedef enum {
 void USART2_Init(void);
 #ifdef ATM
 void USART2_SendValue(unsigned int tx_value, USART_Format format, unsigned char print_prefix);
+void USART2_SendSignedValue(signed int tx_value);
+void USART2_SendFixedPoint(signed int tx_value, unsigned char number_of_decimals);
 void USART2_SendString(char* tx_string);
+void USART2_SendBytes(unsigned char* tx_bytes, unsigned int tx_length);
+unsigned int USART2_GetTxFreeSpace(void);
+unsigned char USART2_IsTxComplete(void);
+void USART2_DmaTransferComplete(void);
 #endif
 
 #endif /* USART_H */
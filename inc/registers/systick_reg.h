@@ -0,0 +1,21 @@
+/*
+ * systick_reg.h
+ */
+
+#ifndef SYSTICK_REG_H
+#define SYSTICK_REG_H
+
+/*** SYSTICK registers ***/
+
+typedef struct {
+	volatile unsigned int CTRL;		// SysTick control and status register.
+	volatile unsigned int LOAD;		// SysTick reload value register.
+	volatile unsigned int VAL;		// SysTick current value register.
+	volatile unsigned int CALIB;	// SysTick calibration value register.
+} SYSTICK_BaseAddress;
+
+/*** SYSTICK base address ***/
+
+#define SYSTICK		((SYSTICK_BaseAddress*) ((unsigned int) 0xE000E010))
+
+#endif /* SYSTICK_REG_H */
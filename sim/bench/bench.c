@@ -0,0 +1,266 @@
+/*
+ * bench.c
+ */
+
+// Firmware sources are included so that local (static) kernels can be called directly.
+// Functions which are not benchmarked are removed by the linker (--gc-sections), only the peripherals they reach are stubbed below.
+#include "mode.h"
+#define main TKFX_Main
+#include "../../src/main.c"
+#undef main
+#include "../../src/components/filter.c"
+#include "../../src/components/mma8653fc.c"
+#include "../../src/components/neom8n.c"
+#include "../../src/components/s2lp.c"
+#include "../../src/sigfox/rf_api.c"
+
+#include "bench.h"
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*** BENCH local macros ***/
+
+#define BENCH_ITERATIONS				16 // Calls counted per kernel.
+#define BENCH_MEDIAN_FILTER_LENGTH		9 // Same settings as ADC driver.
+#define BENCH_MEDIAN_AVERAGE_LENGTH		3
+#define BENCH_SIGN_EXTEND_LENGTH		1024
+#define BENCH_SIGFOX_FRAME_LENGTH		26 // Longest uplink frame (12 bytes payload).
+
+/*** BENCH local structures ***/
+
+typedef struct {
+	const char* bench_name;
+	void (*bench_function)(void);
+} BENCH_Kernel;
+
+typedef struct {
+	unsigned char bench_s2lp_header; // Previous SPI byte.
+	unsigned char bench_s2lp_state;
+	volatile unsigned int bench_sink; // Prevents the compiler from removing kernels.
+	volatile unsigned char bench_bus_sink; // Prevents the compiler from removing peripherals accesses.
+} BENCH_Context;
+
+/*** BENCH local global variables ***/
+
+static BENCH_Context bench_ctx;
+static const unsigned int bench_adc_samples[BENCH_MEDIAN_FILTER_LENGTH] = {2048, 2051, 2039, 2101, 2047, 1990, 2050, 2046, 2049};
+static unsigned char bench_nmea_gga[NMEA_RX_BUFFER_SIZE] = "$GPGGA,120000.00,4533.12345,N,00512.54321,E,1,08,0.9,245.3,M,47.0,M,,*6A\r\n"; // Buffer is cleared by the parser on error.
+static unsigned char bench_ubx_cfg_msg[NEOM8N_MSG_OVERHEAD_LENGTH + NEOM8N_CFG_MSG_PAYLOAD_LENGTH] = {0xB5, 0x62, 0x06, 0x01, 0x08, 0x00, 0xF0, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+static unsigned char bench_sigfox_frame[BENCH_SIGFOX_FRAME_LENGTH] = {0xAA, 0xAA, 0xA3, 0x5F, 0x06, 0x0F, 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF, 0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE, 0x5A, 0xC3, 0x96, 0x3C};
+
+/*** BENCH peripherals stubs ***/
+
+void GPIO_Write(const GPIO* gpio, unsigned char state) {
+	bench_ctx.bench_bus_sink = state;
+	bench_ctx.bench_s2lp_header = 0;
+}
+
+unsigned char SPI1_WriteByte(unsigned char tx_data) {
+	bench_ctx.bench_bus_sink = tx_data;
+	// Track S2LP state so that state switches complete immediately.
+	if (bench_ctx.bench_s2lp_header == S2LP_HEADER_BYTE_COMMAND) {
+		switch (tx_data) {
+		case S2LP_CMD_TX:
+			bench_ctx.bench_s2lp_state = S2LP_STATE_TX;
+			break;
+		case S2LP_CMD_STANDBY:
+			bench_ctx.bench_s2lp_state = S2LP_STATE_STANDBY;
+			break;
+		default:
+			bench_ctx.bench_s2lp_state = S2LP_STATE_READY;
+			break;
+		}
+	}
+	bench_ctx.bench_s2lp_header = tx_data;
+	return 1;
+}
+
+unsigned char SPI1_ReadByte(unsigned char tx_data, unsigned char* rx_data) {
+	(*rx_data) = (bench_ctx.bench_s2lp_state << 1);
+	return 1;
+}
+
+void DMA1_SetChannel3SourceAddr(unsigned int source_buf_addr, unsigned short source_buf_size) {}
+void DMA1_StartChannel3(void) {}
+void DMA1_StopChannel3(void) {}
+unsigned char DMA1_GetChannel3Status(void) {return 1;}
+void PWR_EnterSleepMode(void) {}
+void PWR_EnterStopMode(void) {
+	// S2LP FIFO interrupt.
+	rf_api_ctx.rf_api_s2lp_irq_flag = 1;
+}
+void EXTI_ClearAllFlags(void) {}
+void NVIC_EnableInterrupt(NVIC_InterruptVector it_num) {}
+void NVIC_DisableInterrupt(NVIC_InterruptVector it_num) {}
+void ACCOUNTING_EnterState(ACCOUNTING_State state) {}
+void ACCOUNTING_ExitState(ACCOUNTING_State state) {}
+
+/*** BENCH kernels ***/
+
+static void BENCH_FilterMedian(void) {
+	unsigned int buf[BENCH_MEDIAN_FILTER_LENGTH];
+	memcpy(buf, bench_adc_samples, sizeof(buf));
+	bench_ctx.bench_sink = FILTER_ComputeMedianFilter(buf, BENCH_MEDIAN_FILTER_LENGTH, BENCH_MEDIAN_AVERAGE_LENGTH);
+}
+
+static void BENCH_NmeaChecksum(void) {
+	bench_ctx.bench_sink = NEOM8N_ComputeNmeaChecksum(bench_nmea_gga);
+}
+
+static void BENCH_NmeaGga(void) {
+	Position gps_position;
+	NEOM8N_ParseNmeaGgaMessage(bench_nmea_gga, &gps_position);
+	bench_ctx.bench_sink = gps_position.lat_seconds;
+}
+
+static void BENCH_UbxChecksum(void) {
+	NEOM8N_ComputeUbxChecksum(bench_ubx_cfg_msg, NEOM8N_CFG_MSG_PAYLOAD_LENGTH);
+	bench_ctx.bench_sink = bench_ubx_cfg_msg[NEOM8N_MSG_OVERHEAD_LENGTH + NEOM8N_CFG_MSG_PAYLOAD_LENGTH - 1];
+}
+
+static void BENCH_SignExtend(void) {
+	unsigned int value = 0;
+	signed int sum = 0;
+	for (value=0 ; value<BENCH_SIGN_EXTEND_LENGTH ; value++) {
+		sum += MMA8653FC_SignExtend(value);
+	}
+	bench_ctx.bench_sink = (unsigned int) sum;
+}
+
+static void BENCH_S2lpFrequency(void) {
+	S2LP_SetRfFrequency(868130000 + (bench_ctx.bench_sink & 0xFF));
+}
+
+static void BENCH_RfSymbols(void) {
+	RF_API_send(bench_sigfox_frame, SFX_DBPSK_100BPS, BENCH_SIGFOX_FRAME_LENGTH);
+	bench_ctx.bench_sink = rf_api_ctx.rf_api_s2lp_fifo_buffer[RF_API_S2LP_FIFO_BUFFER_FDEV_IDX];
+}
+
+static void BENCH_MonitoringFrame(void) {
+	tkfx_ctx.tkfx_sfx_monitoring_data.field.temperature_degrees = tkfx_ctx.tkfx_temperature_degrees;
+	tkfx_ctx.tkfx_sfx_monitoring_data.field.mcu_temperature_degrees = tkfx_ctx.tkfx_mcu_temperature_degrees;
+	tkfx_ctx.tkfx_sfx_monitoring_data.field.source_voltage_mv = tkfx_ctx.tkfx_source_voltage_mv;
+	tkfx_ctx.tkfx_sfx_monitoring_data.field.supercap_voltage_mv = tkfx_ctx.tkfx_supercap_voltage_mv;
+	tkfx_ctx.tkfx_sfx_monitoring_data.field.mcu_voltage_mv = tkfx_ctx.tkfx_mcu_voltage_mv;
+	tkfx_ctx.tkfx_sfx_monitoring_data.field.status_byte = tkfx_ctx.tkfx_status_byte;
+	bench_ctx.bench_sink = tkfx_ctx.tkfx_sfx_monitoring_data.raw_frame[4];
+	tkfx_ctx.tkfx_supercap_voltage_mv++;
+}
+
+static void BENCH_GeolocFrame(void) {
+	tkfx_ctx.tkfx_sfx_geoloc_data.field.latitude_degrees = tkfx_ctx.tkfx_geoloc_position.lat_degrees;
+	tkfx_ctx.tkfx_sfx_geoloc_data.field.latitude_minutes = tkfx_ctx.tkfx_geoloc_position.lat_minutes;
+	tkfx_ctx.tkfx_sfx_geoloc_data.field.latitude_seconds = tkfx_ctx.tkfx_geoloc_position.lat_seconds;
+	tkfx_ctx.tkfx_sfx_geoloc_data.field.latitude_north_flag = tkfx_ctx.tkfx_geoloc_position.lat_north_flag;
+	tkfx_ctx.tkfx_sfx_geoloc_data.field.longitude_degrees = tkfx_ctx.tkfx_geoloc_position.long_degrees;
+	tkfx_ctx.tkfx_sfx_geoloc_data.field.longitude_minutes = tkfx_ctx.tkfx_geoloc_position.long_minutes;
+	tkfx_ctx.tkfx_sfx_geoloc_data.field.longitude_seconds = tkfx_ctx.tkfx_geoloc_position.long_seconds;
+	tkfx_ctx.tkfx_sfx_geoloc_data.field.longitude_east_flag = tkfx_ctx.tkfx_geoloc_position.long_east_flag;
+	tkfx_ctx.tkfx_sfx_geoloc_data.field.altitude_meters = tkfx_ctx.tkfx_geoloc_position.altitude;
+	tkfx_ctx.tkfx_sfx_geoloc_data.field.gps_fix_duration_seconds = tkfx_ctx.tkfx_geoloc_fix_duration_seconds;
+	bench_ctx.bench_sink = tkfx_ctx.tkfx_sfx_geoloc_data.raw_frame[5];
+	tkfx_ctx.tkfx_geoloc_position.lat_seconds++;
+}
+
+static const BENCH_Kernel bench_kernels[] = {
+	{"filter_median", &BENCH_FilterMedian},
+	{"nmea_checksum", &BENCH_NmeaChecksum},
+	{"nmea_gga", &BENCH_NmeaGga},
+	{"ubx_checksum", &BENCH_UbxChecksum},
+	{"sign_extend_1024", &BENCH_SignExtend},
+	{"s2lp_frequency", &BENCH_S2lpFrequency},
+	{"rf_symbols_26", &BENCH_RfSymbols},
+	{"at_parameters", &BENCH_AT_ParseArguments},
+	{"monitoring_frame", &BENCH_MonitoringFrame},
+	{"geoloc_frame", &BENCH_GeolocFrame},
+};
+
+/*** BENCH local functions ***/
+
+/* EMPTY KERNEL USED AS REFERENCE (LOOP AND SYNCHRONIZATION OVERHEAD).
+ * @param:	None.
+ * @return:	None.
+ */
+static void BENCH_Empty(void) {
+	bench_ctx.bench_sink = 0;
+}
+
+/* COUNT HOST INSTRUCTIONS EXECUTED BY A KERNEL.
+ * @param kernel_function:	Kernel to measure.
+ * @return step_count:		Number of instructions executed by BENCH_ITERATIONS calls (0 on error).
+ */
+static unsigned long long BENCH_CountInstructions(void (*kernel_function)(void)) {
+	// Local variables.
+	unsigned long long step_count = 0;
+	unsigned int idx = 0;
+	int status = 0;
+	pid_t child = fork();
+	if (child < 0) return 0;
+	if (child == 0) {
+		// Warm-up call (first call effects), then counted calls between two stops.
+		ptrace(PTRACE_TRACEME, 0, 0, 0);
+		kernel_function();
+		raise(SIGSTOP);
+		for (idx=0 ; idx<BENCH_ITERATIONS ; idx++) kernel_function();
+		raise(SIGSTOP);
+		_exit(0);
+	}
+	// Single-step the child until the second stop.
+	waitpid(child, &status, 0);
+	while (1) {
+		if (ptrace(PTRACE_SINGLESTEP, child, 0, 0) < 0) break;
+		if (waitpid(child, &status, 0) < 0) break;
+		if ((WIFSTOPPED(status) == 0) || (WSTOPSIG(status) == SIGSTOP)) break;
+		step_count++;
+	}
+	kill(child, SIGKILL);
+	waitpid(child, &status, 0);
+	return step_count;
+}
+
+/* MEASURE ONE KERNEL.
+ * @param kernel:		Kernel to measure.
+ * @param reference:	Instructions count of the empty kernel.
+ * @return:				Number of host instructions per call.
+ */
+static double BENCH_Measure(const BENCH_Kernel* kernel, unsigned long long reference) {
+	// Local variables.
+	unsigned long long step_count = BENCH_CountInstructions(kernel -> bench_function);
+	// Remove overhead.
+	if (step_count <= reference) return 0.0;
+	return (double) (step_count - reference) / (double) BENCH_ITERATIONS;
+}
+
+/*** BENCH functions ***/
+
+/* MAIN FUNCTION OF THE BENCHMARK.
+ * @param argc:	Number of arguments.
+ * @param argv:	Kernel names to run (all kernels if none).
+ * @return:		0, or 1 if instructions could not be counted.
+ */
+int main(int argc, char** argv) {
+	// Local variables.
+	unsigned int kernel_idx = 0;
+	int arg_idx = 0;
+	unsigned char selected = 0;
+	unsigned long long reference = BENCH_CountInstructions(&BENCH_Empty);
+	if (reference == 0) {
+		printf("BENCH: ptrace single-step unavailable\n");
+		return 1;
+	}
+	// Run kernels.
+	for (kernel_idx=0 ; kernel_idx<(sizeof(bench_kernels) / sizeof(BENCH_Kernel)) ; kernel_idx++) {
+		selected = (argc > 1) ? 0 : 1;
+		for (arg_idx=1 ; arg_idx<argc ; arg_idx++) {
+			if (strcmp(argv[arg_idx], bench_kernels[kernel_idx].bench_name) == 0) selected = 1;
+		}
+		if (selected == 0) continue;
+		printf("%-24s %12.1f\n", bench_kernels[kernel_idx].bench_name, BENCH_Measure(&(bench_kernels[kernel_idx]), reference));
+		fflush(stdout);
+	}
+	return 0;
+}
@@ -0,0 +1,12 @@
+/*
+ * bench.h
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+/*** BENCH functions ***/
+
+void BENCH_AT_ParseArguments(void);
+
+#endif /* BENCH_H */
@@ -0,0 +1,63 @@
+#!/bin/sh
+#
+# bench.sh
+#
+# Build and run the compute kernels benchmark on the host, then compare each kernel with the checked-in baseline.
+# Kernels are measured in host instructions per call (ptrace single-step), which do not depend on the machine load.
+# A kernel executing more instructions than the baseline by more than TKFX_BENCH_TOLERANCE_PERCENT (2% by default) is reported as a regression.
+# Counts depend on the host architecture and compiler version: use --update to write a new baseline after a toolchain change.
+#
+# Usage: sim/bench/bench.sh [--update] [kernel_name ...]
+
+BENCH_DIR=$(cd "$(dirname "$0")" && pwd)
+SIM_DIR=$(dirname "$BENCH_DIR")
+BASELINE="$BENCH_DIR/baseline.txt"
+BINARY="${TMPDIR:-/tmp}/tkfx_bench"
+TOLERANCE="${TKFX_BENCH_TOLERANCE_PERCENT:-2}"
+
+UPDATE=0
+if [ "$1" = "--update" ]; then
+	UPDATE=1
+	shift
+fi
+
+# Build with the same options as the host simulation.
+make -s -C "$SIM_DIR" bench BENCH_BINARY="$BINARY" > "$BINARY.build" 2>&1 || { cat "$BINARY.build" >&2; exit 1; }
+RESULTS=$("$BINARY" "$@") || exit 1
+
+if [ "$UPDATE" -eq 1 ]; then
+	{
+		echo "# Host benchmark baseline (instructions per call), written by sim/bench/bench.sh --update."
+		echo "# Toolchain: $(uname -m), gcc $(gcc -dumpfullversion 2>/dev/null || gcc -dumpversion)."
+		echo "$RESULTS"
+	} > "$BASELINE"
+	echo "$RESULTS"
+	exit 0
+fi
+
+# Compare with baseline.
+echo "$RESULTS" | awk -v tolerance="$TOLERANCE" -v baseline="$BASELINE" '
+	BEGIN {
+		while ((getline line < baseline) > 0) {
+			if (line ~ /^#/) continue;
+			split(line, fields);
+			reference[fields[1]] = fields[2];
+		}
+		printf "%-24s %12s %12s %8s\n", "kernel", "instr/call", "baseline", "delta";
+		status = 0;
+	}
+	{
+		if (!($1 in reference) || (reference[$1] == 0)) {
+			printf "%-24s %12.1f %12s %8s\n", $1, $2, "-", "-";
+			next;
+		}
+		delta = (($2 - reference[$1]) * 100.0) / reference[$1];
+		flag = "";
+		if (delta > tolerance) {
+			flag = " REGRESSION";
+			status = 1;
+		}
+		printf "%-24s %12.1f %12.1f %+7.1f%%%s\n", $1, $2, reference[$1], delta, flag;
+	}
+	END { exit status }
+'
@@ -0,0 +1,41 @@
+/*
+ * bench_at.c
+ */
+
+// AT parser is only compiled in AT command mode, it is built in its own translation unit.
+#include "mode.h"
+#undef SSM
+#undef PM
+#define ATM
+#include "../../src/applicative/at.c"
+
+#include "bench.h"
+#include <string.h>
+
+/*** BENCH AT local macros ***/
+
+#define BENCH_AT_COMMAND			"AT$NVMW=1F,0123456789ABCDEF\r"
+#define BENCH_AT_HEADER_LENGTH		8
+
+/*** BENCH AT local global variables ***/
+
+static const AT_Command bench_at_command = {"AT$NVMW=", {AT_PARAM_TYPE_HEXADECIMAL, AT_PARAM_TYPE_BYTE_ARRAY}, 2, 2, NULL};
+volatile unsigned char bench_at_sink;
+
+/*** BENCH AT functions ***/
+
+/* PARSE THE PARAMETERS OF A NVM WRITE COMMAND.
+ * @param:	None.
+ * @return:	None.
+ */
+void BENCH_AT_ParseArguments(void) {
+	// Local variables.
+	AT_Arguments arguments;
+	// Load command as received by the USART interrupt.
+	memcpy((unsigned char*) at_ctx.at_rx_buf, BENCH_AT_COMMAND, sizeof(BENCH_AT_COMMAND));
+	at_ctx.at_rx_buf_idx = sizeof(BENCH_AT_COMMAND) - 1;
+	at_ctx.start_idx = BENCH_AT_HEADER_LENGTH;
+	at_ctx.separator_idx = BENCH_AT_HEADER_LENGTH - 1;
+	AT_ParseArguments(&bench_at_command, &arguments);
+	bench_at_sink = arguments.at_byte_array_length;
+}
@@ -0,0 +1,41 @@
+/*
+ * flash_reg.h
+ */
+
+#ifndef FLASH_REG_H
+#define FLASH_REG_H
+
+/*** FLASH registers ***/
+
+typedef struct {
+	volatile unsigned int ACR;		// NVM interface access control register.
+	volatile unsigned int PECR;		// NVM interface program and erase control register.
+	volatile unsigned int PDKEYR;	// NVM interface power down key register.
+	volatile unsigned int PEKEYR;	// NVM interface PECR unlock key register.
+	volatile unsigned int PRGKEYR;	// NVM interface program and erase key register.
+	volatile unsigned int OPTKEYR;	// NVM interface option bytes unlock key register.
+	volatile unsigned int SR;		// NVM interface status register.
+	volatile unsigned int OPTR;		// NVM interface option bytes register.
+	volatile unsigned int WRPROT1;	// NVM interface write protection register 1.
+	unsigned int RESERVED[23];		// Reserved 0x24.
+	volatile unsigned int WRPROT2;	// NVM interface write protection register 2.
+} FLASH_BaseAddress;
+
+/*** EEPROM size ***/
+
+#define EEPROM_SIZE				1024 // 1kB for STM32L041xxxx (category 2 device).
+
+/*** FLASH and EEPROM in-memory registers (host simulation) ***/
+
+extern FLASH_BaseAddress sim_flash_registers;
+extern unsigned char sim_eeprom[EEPROM_SIZE];
+
+/*** FLASH registers base address ***/
+
+#define FLASH	(&sim_flash_registers)
+
+/*** EEPROM address range ***/
+
+#define EEPROM_START_ADDRESS	((unsigned long) sim_eeprom) // Host pointer width.
+
+#endif /* FLASH_REG_H */
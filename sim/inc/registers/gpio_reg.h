@@ -0,0 +1,39 @@
+/*
+ * gpio_reg.h
+ */
+
+#ifndef GPIO_REG_H
+#define GPIO_REG_H
+
+/*** GPIO registers ***/
+
+typedef struct {
+	volatile unsigned int MODER;    	// GPIO port mode register.
+	volatile unsigned int OTYPER;   	// GPIO port output type register.
+	volatile unsigned int OSPEEDR;  	// GPIO port output speed register.
+	volatile unsigned int PUPDR;    	// GPIO port pull-up/pull-down register.
+	volatile unsigned int IDR;      	// GPIO port input data register.
+	volatile unsigned int ODR;      	// GPIO port output data register.
+	volatile unsigned int BSRR;    		// GPIO port bit set/reset low register.
+	volatile unsigned int LCKR;     	// GPIO port configuration lock register.
+	volatile unsigned int AFRL;   		// GPIO alternate function low register.
+	volatile unsigned int AFRH;   		// GPIO alternate function high register.
+	volatile unsigned int BRR;   		// GPIO port bir reset register.
+} GPIO_BaseAddress;
+
+/*** GPIO in-memory registers (host simulation) ***/
+
+#define SIM_GPIO_PORT_NUMBER	6
+
+extern GPIO_BaseAddress sim_gpio_registers[SIM_GPIO_PORT_NUMBER];
+
+/*** GPIO base addresses ***/
+
+#define GPIOA	(&(sim_gpio_registers[0]))
+#define GPIOB	(&(sim_gpio_registers[1]))
+#define GPIOC	(&(sim_gpio_registers[2]))
+#define GPIOD	(&(sim_gpio_registers[3]))
+#define GPIOE	(&(sim_gpio_registers[4]))
+#define GPIOH	(&(sim_gpio_registers[5]))
+
+#endif /* GPIO_REG_H */
@@ -0,0 +1,83 @@
+/*
+ * sim.h
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+/*** SIM macros ***/
+
+#define SIM_TIME_NONE					0xFFFFFFFFFFFFFFFFULL // No pending event.
+#define SIM_SCENARIO_KEYWORD_LENGTH		16
+#define SIM_SCENARIO_ARGUMENTS_LENGTH	64
+
+/*** SIM structures ***/
+
+// MCU power modes (time is accounted in each mode).
+typedef enum {
+	SIM_POWER_MODE_RUN,
+	SIM_POWER_MODE_SLEEP,
+	SIM_POWER_MODE_LOW_POWER_SLEEP,
+	SIM_POWER_MODE_STOP,
+	SIM_POWER_MODE_LAST
+} SIM_PowerMode;
+
+// Loads supplied by the supercap (MCU and quiescent currents excluded).
+typedef enum {
+	SIM_ENERGY_LOAD_GPS,
+	SIM_ENERGY_LOAD_RADIO,
+	SIM_ENERGY_LOAD_RADIO_TX,
+	SIM_ENERGY_LOAD_RADIO_RX,
+	SIM_ENERGY_LOAD_SENSORS,
+	SIM_ENERGY_LOAD_LAST
+} SIM_EnergyLoad;
+
+/*** SIM functions ***/
+
+unsigned long long SIM_GetTimeUs(void);
+void SIM_Consume(unsigned int duration_us);
+void SIM_WaitForInterrupt(SIM_PowerMode power_mode);
+void SIM_SignalInterrupt(void);
+void SIM_Log(const char* format, ...);
+void SIM_Debug(const char* format, ...);
+
+/*** SIM models functions ***/
+
+// MCU peripherals (sim_mcu.c).
+unsigned long long SIM_MCU_GetNextEventTime(void);
+void SIM_MCU_ProcessEvents(void);
+unsigned char SIM_MCU_ScenarioEvent(char* keyword, char* arguments);
+void SIM_MCU_PrintReport(void);
+unsigned char SIM_MCU_IsInterruptEnabled(unsigned char it_num);
+unsigned char SIM_MCU_WriteDmaChannel6(unsigned char rx_byte);
+// Sensors (sim_sensors.c).
+unsigned long long SIM_SENSORS_GetNextEventTime(void);
+void SIM_SENSORS_ProcessEvents(void);
+unsigned char SIM_SENSORS_ScenarioEvent(char* keyword, char* arguments);
+void SIM_SENSORS_PrintReport(void);
+// GPS (sim_gps.c).
+unsigned long long SIM_GPS_GetNextEventTime(void);
+void SIM_GPS_ProcessEvents(void);
+unsigned char SIM_GPS_ScenarioEvent(char* keyword, char* arguments);
+void SIM_GPS_PrintReport(void);
+// Radio (sim_radio.c).
+unsigned long long SIM_RADIO_GetNextEventTime(void);
+void SIM_RADIO_ProcessEvents(void);
+unsigned char SIM_RADIO_ScenarioEvent(char* keyword, char* arguments);
+void SIM_RADIO_PrintReport(void);
+void SIM_RADIO_SetChipSelect(unsigned char cs_state);
+// Sigfox library stub (sim_sigfox.c).
+void SIM_SIGFOX_PrintReport(void);
+void SIM_SIGFOX_ExpectStartAlarm(void);
+unsigned char SIM_SIGFOX_IsMovingReported(void);
+// Energy (sim_energy.c).
+void SIM_ENERGY_Init(void);
+void SIM_ENERGY_Integrate(unsigned long long start_time_us, unsigned long long duration_us, SIM_PowerMode power_mode);
+unsigned char SIM_ENERGY_ScenarioEvent(char* keyword, char* arguments);
+void SIM_ENERGY_PrintReport(void);
+void SIM_ENERGY_SetLoad(SIM_EnergyLoad load, unsigned char enabled);
+unsigned int SIM_ENERGY_GetSupercapVoltage(void);
+unsigned int SIM_ENERGY_GetSourceVoltage(void);
+unsigned char SIM_ENERGY_IsBrownOut(void);
+
+#endif /* SIM_H */
@@ -0,0 +1,302 @@
+/*
+ * sim.c
+ */
+
+#include "sim.h"
+
+#include "mode.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ATM
+#error "Host simulation does not support AT command mode."
+#endif
+
+/*** SIM local macros ***/
+
+#define SIM_DURATION_SECONDS_DEFAULT	86400
+#define SIM_SCENARIO_EVENTS_MAX			256
+#define SIM_SCENARIO_LINE_LENGTH		128
+#define SIM_SCENARIO_COMMENT_CHAR		'#'
+
+/*** SIM local structures ***/
+
+typedef struct {
+	unsigned long long sim_event_time_us;
+	char sim_event_keyword[SIM_SCENARIO_KEYWORD_LENGTH];
+	char sim_event_arguments[SIM_SCENARIO_ARGUMENTS_LENGTH];
+} SIM_ScenarioEvent;
+
+typedef struct {
+	// Simulated time.
+	unsigned long long sim_time_us;
+	unsigned long long sim_end_time_us;
+	unsigned long long sim_power_mode_time_us[SIM_POWER_MODE_LAST];
+	unsigned int sim_interrupt_count;
+	unsigned char sim_verbose;
+	// Scenario.
+	SIM_ScenarioEvent sim_scenario[SIM_SCENARIO_EVENTS_MAX];
+	unsigned int sim_scenario_length;
+	unsigned int sim_scenario_idx;
+} SIM_Context;
+
+/*** SIM local global variables ***/
+
+static SIM_Context sim_ctx;
+static const char* const sim_power_mode_name[SIM_POWER_MODE_LAST] = {"run", "sleep", "low power sleep", "stop"};
+
+/*** SIM local functions ***/
+
+/* PRINT A LOG LINE WITH SIMULATED TIME PREFIX.
+ * @param format:	printf-like format.
+ * @param args:		Format arguments.
+ * @return:			None.
+ */
+static void SIM_PrintLine(const char* format, va_list args) {
+	printf("[%8llu.%06llu] ", (sim_ctx.sim_time_us / 1000000), (sim_ctx.sim_time_us % 1000000));
+	vprintf(format, args);
+	printf("\n");
+}
+
+/* DISPATCH A SCENARIO EVENT TO THE MODEL HANDLING ITS KEYWORD.
+ * @param event:	Event to process.
+ * @return:			None.
+ */
+static void SIM_ProcessScenarioEvent(SIM_ScenarioEvent* event) {
+	// Local variables.
+	unsigned char handled = 0;
+	SIM_Log("scenario: %s %s", event -> sim_event_keyword, event -> sim_event_arguments);
+	// Try each model.
+	handled |= SIM_MCU_ScenarioEvent(event -> sim_event_keyword, event -> sim_event_arguments);
+	if (handled == 0) handled |= SIM_SENSORS_ScenarioEvent(event -> sim_event_keyword, event -> sim_event_arguments);
+	if (handled == 0) handled |= SIM_GPS_ScenarioEvent(event -> sim_event_keyword, event -> sim_event_arguments);
+	if (handled == 0) handled |= SIM_RADIO_ScenarioEvent(event -> sim_event_keyword, event -> sim_event_arguments);
+	if (handled == 0) handled |= SIM_ENERGY_ScenarioEvent(event -> sim_event_keyword, event -> sim_event_arguments);
+	if (handled == 0) {
+		SIM_Log("scenario: unknown keyword or invalid arguments");
+	}
+}
+
+/* LOAD SCENARIO FILE.
+ * Each line is '<time_seconds> <keyword> [arguments]', lines starting with '#' are ignored.
+ * @param file_name:	Scenario file path.
+ * @return:				None.
+ */
+static void SIM_LoadScenario(const char* file_name) {
+	// Local variables.
+	FILE* scenario_file = fopen(file_name, "r");
+	char line[SIM_SCENARIO_LINE_LENGTH];
+	double time_seconds = 0.0;
+	SIM_ScenarioEvent event;
+	unsigned int idx = 0;
+	// Check file.
+	if (scenario_file == NULL) {
+		fprintf(stderr, "sim: cannot open scenario file %s\n", file_name);
+		exit(1);
+	}
+	while ((fgets(line, SIM_SCENARIO_LINE_LENGTH, scenario_file) != NULL) && (sim_ctx.sim_scenario_length < SIM_SCENARIO_EVENTS_MAX)) {
+		if (line[0] == SIM_SCENARIO_COMMENT_CHAR) continue;
+		event.sim_event_arguments[0] = '\0';
+		if (sscanf(line, "%lf %15s %63[^\n]", &time_seconds, event.sim_event_keyword, event.sim_event_arguments) < 2) continue;
+		event.sim_event_time_us = (unsigned long long) (time_seconds * 1000000.0);
+		// Insert event by ascending time (events with the same time keep file order).
+		idx = sim_ctx.sim_scenario_length;
+		while ((idx > 0) && (sim_ctx.sim_scenario[idx - 1].sim_event_time_us > event.sim_event_time_us)) {
+			sim_ctx.sim_scenario[idx] = sim_ctx.sim_scenario[idx - 1];
+			idx--;
+		}
+		sim_ctx.sim_scenario[idx] = event;
+		sim_ctx.sim_scenario_length++;
+	}
+	fclose(scenario_file);
+}
+
+/* GET THE NEAREST PENDING EVENT OF ALL MODELS.
+ * @param:	None.
+ * @return:	Absolute time of the next event in us (SIM_TIME_NONE if there is no pending event).
+ */
+static unsigned long long SIM_GetNextEventTime(void) {
+	// Local variables.
+	unsigned long long next_time_us = SIM_TIME_NONE;
+	unsigned long long model_time_us = 0;
+	// Scenario.
+	if (sim_ctx.sim_scenario_idx < sim_ctx.sim_scenario_length) {
+		next_time_us = sim_ctx.sim_scenario[sim_ctx.sim_scenario_idx].sim_event_time_us;
+	}
+	// Models.
+	model_time_us = SIM_MCU_GetNextEventTime();
+	if (model_time_us < next_time_us) next_time_us = model_time_us;
+	model_time_us = SIM_SENSORS_GetNextEventTime();
+	if (model_time_us < next_time_us) next_time_us = model_time_us;
+	model_time_us = SIM_GPS_GetNextEventTime();
+	if (model_time_us < next_time_us) next_time_us = model_time_us;
+	model_time_us = SIM_RADIO_GetNextEventTime();
+	if (model_time_us < next_time_us) next_time_us = model_time_us;
+	return next_time_us;
+}
+
+/* PROCESS ALL EVENTS DUE AT CURRENT TIME.
+ * @param:	None.
+ * @return:	None.
+ */
+static void SIM_ProcessEvents(void) {
+	// Scenario.
+	while ((sim_ctx.sim_scenario_idx < sim_ctx.sim_scenario_length) && (sim_ctx.sim_scenario[sim_ctx.sim_scenario_idx].sim_event_time_us <= sim_ctx.sim_time_us)) {
+		SIM_ProcessScenarioEvent(&(sim_ctx.sim_scenario[sim_ctx.sim_scenario_idx]));
+		sim_ctx.sim_scenario_idx++;
+	}
+	// Models.
+	SIM_MCU_ProcessEvents();
+	SIM_SENSORS_ProcessEvents();
+	SIM_GPS_ProcessEvents();
+	SIM_RADIO_ProcessEvents();
+}
+
+/* ADVANCE SIMULATED TIME.
+ * @param time_us:		Absolute time to reach.
+ * @param power_mode:	MCU power mode during the elapsed time.
+ * @return:				None.
+ */
+static void SIM_Advance(unsigned long long time_us, SIM_PowerMode power_mode) {
+	if (time_us > sim_ctx.sim_time_us) {
+		SIM_ENERGY_Integrate(sim_ctx.sim_time_us, (time_us - sim_ctx.sim_time_us), power_mode);
+		sim_ctx.sim_power_mode_time_us[power_mode] += (time_us - sim_ctx.sim_time_us);
+		sim_ctx.sim_time_us = time_us;
+	}
+}
+
+/* PRINT SIMULATION REPORT AND EXIT.
+ * @param:	None.
+ * @return:	None.
+ */
+static void SIM_Terminate(void) {
+	// Local variables.
+	unsigned char power_mode = 0;
+	// Global statistics.
+	printf("\n*** Simulation report ***\n");
+	printf("Simulated time: %llu.%06llu s\n", (sim_ctx.sim_time_us / 1000000), (sim_ctx.sim_time_us % 1000000));
+	for (power_mode=0 ; power_mode<SIM_POWER_MODE_LAST ; power_mode++) {
+		printf("  %-16s %12llu.%06llu s\n", sim_power_mode_name[power_mode], (sim_ctx.sim_power_mode_time_us[power_mode] / 1000000), (sim_ctx.sim_power_mode_time_us[power_mode] % 1000000));
+	}
+	printf("Interrupts: %u\n", sim_ctx.sim_interrupt_count);
+	// Models statistics.
+	SIM_MCU_PrintReport();
+	SIM_SENSORS_PrintReport();
+	SIM_GPS_PrintReport();
+	SIM_RADIO_PrintReport();
+	SIM_SIGFOX_PrintReport();
+	SIM_ENERGY_PrintReport();
+	fflush(stdout);
+	exit(0);
+}
+
+/* INIT SIMULATION BEFORE MAIN FUNCTION.
+ * @param:	None.
+ * @return:	None.
+ */
+static void __attribute__((constructor)) SIM_Init(void) {
+	// Local variables.
+	char* env_value = NULL;
+	unsigned long long duration_seconds = SIM_DURATION_SECONDS_DEFAULT;
+	// Line buffered output so that logs and firmware prints keep their order.
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	// Read configuration.
+	env_value = getenv("TKFX_SIM_DURATION_SECONDS");
+	if (env_value != NULL) {
+		duration_seconds = strtoull(env_value, NULL, 10);
+	}
+	sim_ctx.sim_end_time_us = (duration_seconds * 1000000);
+	env_value = getenv("TKFX_SIM_VERBOSE");
+	sim_ctx.sim_verbose = ((env_value != NULL) && (env_value[0] != '0')) ? 1 : 0;
+	env_value = getenv("TKFX_SIM_SEED");
+	srand((env_value != NULL) ? (unsigned int) strtoul(env_value, NULL, 10) : 1);
+	SIM_ENERGY_Init();
+	env_value = getenv("TKFX_SIM_SCENARIO");
+	if (env_value != NULL) {
+		SIM_LoadScenario(env_value);
+	}
+	// Apply initial conditions.
+	while ((sim_ctx.sim_scenario_idx < sim_ctx.sim_scenario_length) && (sim_ctx.sim_scenario[sim_ctx.sim_scenario_idx].sim_event_time_us == 0)) {
+		SIM_ProcessScenarioEvent(&(sim_ctx.sim_scenario[sim_ctx.sim_scenario_idx]));
+		sim_ctx.sim_scenario_idx++;
+	}
+	SIM_Log("simulation started (duration %llu s, %u scenario events)", duration_seconds, sim_ctx.sim_scenario_length);
+}
+
+/*** SIM functions ***/
+
+/* GET SIMULATED TIME.
+ * @param:	None.
+ * @return:	Time elapsed since simulation start in us.
+ */
+unsigned long long SIM_GetTimeUs(void) {
+	return sim_ctx.sim_time_us;
+}
+
+/* CONSUME MCU RUN TIME (BLOCKING PERIPHERAL ACCESS).
+ * @param duration_us:	Duration in us.
+ * @return:				None.
+ */
+void SIM_Consume(unsigned int duration_us) {
+	SIM_Advance((sim_ctx.sim_time_us + duration_us), SIM_POWER_MODE_RUN);
+}
+
+/* WAIT FOR NEXT INTERRUPT (WFI INSTRUCTION).
+ * Simulated time jumps from one model event to the next one until an interrupt is signaled.
+ * Simulation ends when the configured duration is reached or when no event can wake the MCU up anymore.
+ * @param power_mode:	MCU power mode while waiting.
+ * @return:				None.
+ */
+void SIM_WaitForInterrupt(SIM_PowerMode power_mode) {
+	// Local variables.
+	unsigned int interrupt_count = sim_ctx.sim_interrupt_count;
+	unsigned long long next_time_us = 0;
+	// Process events until one of them triggers an interrupt.
+	while (sim_ctx.sim_interrupt_count == interrupt_count) {
+		next_time_us = SIM_GetNextEventTime();
+		if (next_time_us == SIM_TIME_NONE) {
+			SIM_Log("no wake-up source in %s mode", sim_power_mode_name[power_mode]);
+			SIM_Advance(sim_ctx.sim_end_time_us, power_mode);
+			SIM_Terminate();
+		}
+		if (next_time_us > sim_ctx.sim_end_time_us) {
+			SIM_Advance(sim_ctx.sim_end_time_us, power_mode);
+			SIM_Terminate();
+		}
+		SIM_Advance(next_time_us, power_mode);
+		SIM_ProcessEvents();
+	}
+}
+
+/* SIGNAL AN INTERRUPT TO THE MCU (WAKES-UP PENDING WFI).
+ * @param:	None.
+ * @return:	None.
+ */
+void SIM_SignalInterrupt(void) {
+	sim_ctx.sim_interrupt_count++;
+}
+
+/* PRINT A SIMULATION LOG LINE.
+ * @param format:	printf-like format.
+ * @return:			None.
+ */
+void SIM_Log(const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	SIM_PrintLine(format, args);
+	va_end(args);
+}
+
+/* PRINT A SIMULATION LOG LINE IN VERBOSE MODE ONLY.
+ * @param format:	printf-like format.
+ * @return:			None.
+ */
+void SIM_Debug(const char* format, ...) {
+	va_list args;
+	if (sim_ctx.sim_verbose == 0) return;
+	va_start(args, format);
+	SIM_PrintLine(format, args);
+	va_end(args);
+}
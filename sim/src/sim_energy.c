@@ -0,0 +1,267 @@
+/*
+ * sim_energy.c
+ */
+
+#include "sim.h"
+
+#include "rcc.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*** SIM ENERGY local macros ***/
+
+// Board current consumption (uA).
+#define SIM_ENERGY_BOARD_QUIESCENT_UA		8		// LDO, accelerometer in motion detection and supercap leakage.
+#define SIM_ENERGY_MCU_RUN_BASE_UA			20
+#define SIM_ENERGY_MCU_RUN_UA_PER_MHZ		100
+#define SIM_ENERGY_MCU_SLEEP_RATIO_PERCENT	40		// Sleep current relatively to run current.
+#define SIM_ENERGY_MCU_LP_SLEEP_UA			6
+#define SIM_ENERGY_MCU_STOP_UA				1		// RTC and IWDG on LSI.
+#define SIM_ENERGY_GPS_UA					25000	// NEOM8N acquisition.
+#define SIM_ENERGY_RADIO_UA					500		// S2LP and TCXO powered, ready state.
+#define SIM_ENERGY_RADIO_TX_UA				21500	// Additional current at 14dBm.
+#define SIM_ENERGY_RADIO_RX_UA				8500	// Additional current in reception.
+#define SIM_ENERGY_SENSORS_UA				500		// SHT3x, MMA8653FC and I2C pull-ups.
+// Supercap and solar cell.
+#define SIM_ENERGY_SUPERCAP_MF_DEFAULT		1000
+#define SIM_ENERGY_SUPERCAP_MV_DEFAULT		2500
+#define SIM_ENERGY_SUPERCAP_MV_MAX			2700	// Supercap rated voltage (harvester stops charging).
+#define SIM_ENERGY_BROWN_OUT_MV_DEFAULT		1000	// Minimum input voltage of the board regulator.
+#define SIM_ENERGY_BROWN_OUT_HYSTERESIS_MV	200
+#define SIM_ENERGY_SOLAR_PEAK_UA_DEFAULT	5000	// Charge current at noon in full sun.
+#define SIM_ENERGY_SOLAR_SUNRISE_S			(7 * 3600)
+#define SIM_ENERGY_SOLAR_SUNSET_S			(19 * 3600)
+#define SIM_ENERGY_SOLAR_OPEN_VOLTAGE_MV	5000
+#define SIM_ENERGY_STEP_US					10000000 // Integration step (solar current is evaluated in the middle of each step).
+#define SIM_ENERGY_DAY_US					86400000000ULL
+
+/*** SIM ENERGY local structures ***/
+
+typedef struct {
+	// Configuration.
+	double energy_supercap_capacitance_f;
+	double energy_brown_out_mv;
+	double energy_solar_peak_ua;
+	// State.
+	unsigned char energy_loads[SIM_ENERGY_LOAD_LAST];
+	double energy_supercap_mv;
+	double energy_solar_ratio; // Irradiance relatively to full sun.
+	unsigned char energy_brown_out;
+	// Statistics.
+	double energy_consumed_uas;
+	double energy_harvested_uas;
+	double energy_load_uas[SIM_ENERGY_LOAD_LAST];
+	double energy_supercap_min_mv;
+	double energy_supercap_max_mv;
+	unsigned int energy_brown_out_count;
+	unsigned long long energy_brown_out_time_us;
+} SIM_ENERGY_Context;
+
+/*** SIM ENERGY local global variables ***/
+
+static const unsigned int sim_energy_load_ua[SIM_ENERGY_LOAD_LAST] = {
+	SIM_ENERGY_GPS_UA,
+	SIM_ENERGY_RADIO_UA,
+	SIM_ENERGY_RADIO_TX_UA,
+	SIM_ENERGY_RADIO_RX_UA,
+	SIM_ENERGY_SENSORS_UA
+};
+static const char* sim_energy_load_name[SIM_ENERGY_LOAD_LAST] = {"gps", "radio", "radio TX", "radio RX", "sensors"};
+static SIM_ENERGY_Context sim_energy_ctx;
+
+/*** SIM ENERGY local functions ***/
+
+/* COMPUTE MCU CURRENT.
+ * @param power_mode:	MCU power mode.
+ * @return:				Current in uA.
+ */
+static double SIM_ENERGY_GetMcuCurrent(SIM_PowerMode power_mode) {
+	// Local variables.
+	double run_ua = SIM_ENERGY_MCU_RUN_BASE_UA + ((SIM_ENERGY_MCU_RUN_UA_PER_MHZ * (double) RCC_GetSysclkKhz()) / 1000.0);
+	// Compute current according to mode.
+	switch (power_mode) {
+	case SIM_POWER_MODE_RUN:
+		return run_ua;
+	case SIM_POWER_MODE_SLEEP:
+		return ((run_ua * SIM_ENERGY_MCU_SLEEP_RATIO_PERCENT) / 100.0);
+	case SIM_POWER_MODE_LOW_POWER_SLEEP:
+		return SIM_ENERGY_MCU_LP_SLEEP_UA;
+	default:
+		return SIM_ENERGY_MCU_STOP_UA;
+	}
+}
+
+/* COMPUTE SOLAR CELL CURRENT.
+ * @param time_us:	Simulated time (simulation starts at midnight).
+ * @return:			Harvested current in uA.
+ */
+static double SIM_ENERGY_GetSolarCurrent(unsigned long long time_us) {
+	// Local variables.
+	double day_seconds = (double) (time_us % SIM_ENERGY_DAY_US) / 1000000.0;
+	double daylight_seconds = (SIM_ENERGY_SOLAR_SUNSET_S - SIM_ENERGY_SOLAR_SUNRISE_S);
+	// Half-sine irradiance profile between sunrise and sunset.
+	if ((day_seconds <= SIM_ENERGY_SOLAR_SUNRISE_S) || (day_seconds >= SIM_ENERGY_SOLAR_SUNSET_S)) {
+		sim_energy_ctx.energy_solar_ratio = 0.0;
+	}
+	else {
+		sim_energy_ctx.energy_solar_ratio = sin((M_PI * (day_seconds - SIM_ENERGY_SOLAR_SUNRISE_S)) / daylight_seconds);
+	}
+	return (sim_energy_ctx.energy_solar_peak_ua * sim_energy_ctx.energy_solar_ratio);
+}
+
+/* READ A NUMERIC ENVIRONMENT VARIABLE.
+ * @param name:				Variable name.
+ * @param default_value:	Value returned if the variable is not set.
+ * @return:					Variable value.
+ */
+static double SIM_ENERGY_GetEnvironmentValue(const char* name, double default_value) {
+	char* env_value = getenv(name);
+	return (env_value != NULL) ? atof(env_value) : default_value;
+}
+
+/*** SIM ENERGY functions ***/
+
+/* INIT ENERGY MODEL FROM ENVIRONMENT.
+ * @param:	None.
+ * @return:	None.
+ */
+void SIM_ENERGY_Init(void) {
+	// Configuration.
+	sim_energy_ctx.energy_supercap_capacitance_f = SIM_ENERGY_GetEnvironmentValue("TKFX_SIM_SUPERCAP_MF", SIM_ENERGY_SUPERCAP_MF_DEFAULT) / 1000.0;
+	sim_energy_ctx.energy_supercap_mv = SIM_ENERGY_GetEnvironmentValue("TKFX_SIM_SUPERCAP_MV", SIM_ENERGY_SUPERCAP_MV_DEFAULT);
+	sim_energy_ctx.energy_brown_out_mv = SIM_ENERGY_GetEnvironmentValue("TKFX_SIM_BROWN_OUT_MV", SIM_ENERGY_BROWN_OUT_MV_DEFAULT);
+	sim_energy_ctx.energy_solar_peak_ua = SIM_ENERGY_GetEnvironmentValue("TKFX_SIM_SOLAR_PEAK_UA", SIM_ENERGY_SOLAR_PEAK_UA_DEFAULT);
+	// Statistics.
+	sim_energy_ctx.energy_supercap_min_mv = sim_energy_ctx.energy_supercap_mv;
+	sim_energy_ctx.energy_supercap_max_mv = sim_energy_ctx.energy_supercap_mv;
+}
+
+/* INTEGRATE SUPERCAP CHARGE OVER A TIME INTERVAL.
+ * @param start_time_us:	Start of the interval.
+ * @param duration_us:		Duration of the interval.
+ * @param power_mode:		MCU power mode during the interval.
+ * @return:					None.
+ */
+void SIM_ENERGY_Integrate(unsigned long long start_time_us, unsigned long long duration_us, SIM_PowerMode power_mode) {
+	// Local variables.
+	unsigned long long step_us = 0;
+	unsigned char load = 0;
+	double load_ua = SIM_ENERGY_BOARD_QUIESCENT_UA + SIM_ENERGY_GetMcuCurrent(power_mode);
+	double solar_ua = 0.0;
+	double step_s = 0.0;
+	// Constant load over the interval.
+	for (load=0 ; load<SIM_ENERGY_LOAD_LAST ; load++) {
+		if (sim_energy_ctx.energy_loads[load] != 0) {
+			load_ua += sim_energy_load_ua[load];
+			sim_energy_ctx.energy_load_uas[load] += (sim_energy_load_ua[load] * (double) duration_us) / 1000000.0;
+		}
+	}
+	// Solar current changes slowly: split long intervals.
+	while (duration_us > 0) {
+		step_us = (duration_us > SIM_ENERGY_STEP_US) ? SIM_ENERGY_STEP_US : duration_us;
+		step_s = (double) step_us / 1000000.0;
+		solar_ua = SIM_ENERGY_GetSolarCurrent(start_time_us + (step_us / 2));
+		// Harvester stops charging at rated voltage.
+		if (sim_energy_ctx.energy_supercap_mv >= SIM_ENERGY_SUPERCAP_MV_MAX) {
+			solar_ua = (solar_ua > load_ua) ? load_ua : solar_ua;
+		}
+		sim_energy_ctx.energy_consumed_uas += (load_ua * step_s);
+		sim_energy_ctx.energy_harvested_uas += (solar_ua * step_s);
+		// dV = (I * dt) / C.
+		sim_energy_ctx.energy_supercap_mv += (((solar_ua - load_ua) * step_s) / (1000.0 * sim_energy_ctx.energy_supercap_capacitance_f));
+		if (sim_energy_ctx.energy_supercap_mv < 0.0) sim_energy_ctx.energy_supercap_mv = 0.0;
+		if (sim_energy_ctx.energy_supercap_mv > SIM_ENERGY_SUPERCAP_MV_MAX) sim_energy_ctx.energy_supercap_mv = SIM_ENERGY_SUPERCAP_MV_MAX;
+		if (sim_energy_ctx.energy_supercap_mv < sim_energy_ctx.energy_supercap_min_mv) sim_energy_ctx.energy_supercap_min_mv = sim_energy_ctx.energy_supercap_mv;
+		if (sim_energy_ctx.energy_supercap_mv > sim_energy_ctx.energy_supercap_max_mv) sim_energy_ctx.energy_supercap_max_mv = sim_energy_ctx.energy_supercap_mv;
+		// Brown-out detection.
+		if ((sim_energy_ctx.energy_brown_out == 0) && (sim_energy_ctx.energy_supercap_mv < sim_energy_ctx.energy_brown_out_mv)) {
+			sim_energy_ctx.energy_brown_out = 1;
+			sim_energy_ctx.energy_brown_out_count++;
+			SIM_Log("energy: brown-out, supercap voltage %umV, MCU would reset", (unsigned int) sim_energy_ctx.energy_supercap_mv);
+		}
+		else if ((sim_energy_ctx.energy_brown_out != 0) && (sim_energy_ctx.energy_supercap_mv >= (sim_energy_ctx.energy_brown_out_mv + SIM_ENERGY_BROWN_OUT_HYSTERESIS_MV))) {
+			sim_energy_ctx.energy_brown_out = 0;
+			SIM_Log("energy: supply restored, supercap voltage %umV", (unsigned int) sim_energy_ctx.energy_supercap_mv);
+		}
+		if (sim_energy_ctx.energy_brown_out != 0) {
+			sim_energy_ctx.energy_brown_out_time_us += step_us;
+		}
+		start_time_us += step_us;
+		duration_us -= step_us;
+	}
+}
+
+/* ENABLE OR DISABLE A LOAD.
+ * @param load:		Load to update.
+ * @param enabled:	0 to disable the load, enable otherwise.
+ * @return:			None.
+ */
+void SIM_ENERGY_SetLoad(SIM_EnergyLoad load, unsigned char enabled) {
+	if (load < SIM_ENERGY_LOAD_LAST) {
+		sim_energy_ctx.energy_loads[load] = (enabled != 0) ? 1 : 0;
+	}
+}
+
+/* GET SUPERCAP VOLTAGE.
+ * @param:	None.
+ * @return:	Supercap voltage in mV.
+ */
+unsigned int SIM_ENERGY_GetSupercapVoltage(void) {
+	return (unsigned int) sim_energy_ctx.energy_supercap_mv;
+}
+
+/* GET SOLAR CELL VOLTAGE.
+ * @param:	None.
+ * @return:	Source voltage in mV.
+ */
+unsigned int SIM_ENERGY_GetSourceVoltage(void) {
+	if (sim_energy_ctx.energy_solar_peak_ua <= 0.0) return 0;
+	return (unsigned int) (SIM_ENERGY_SOLAR_OPEN_VOLTAGE_MV * sim_energy_ctx.energy_solar_ratio);
+}
+
+/* CHECK IF THE BOARD IS IN BROWN-OUT.
+ * @param:	None.
+ * @return:	1 if supercap voltage is too low to supply the board, 0 otherwise.
+ */
+unsigned char SIM_ENERGY_IsBrownOut(void) {
+	return sim_energy_ctx.energy_brown_out;
+}
+
+/* PROCESS ENERGY SCENARIO EVENT.
+ * @param keyword:		Event keyword.
+ * @param arguments:	Event arguments.
+ * @return:				1 if the keyword was handled, 0 otherwise.
+ */
+unsigned char SIM_ENERGY_ScenarioEvent(char* keyword, char* arguments) {
+	// Parse keyword.
+	if (strcmp(keyword, "vcap") == 0) {
+		sim_energy_ctx.energy_supercap_mv = atof(arguments);
+	}
+	else if (strcmp(keyword, "solar") == 0) {
+		sim_energy_ctx.energy_solar_peak_ua = atof(arguments);
+	}
+	else {
+		return 0;
+	}
+	return 1;
+}
+
+/* PRINT ENERGY REPORT.
+ * @param:	None.
+ * @return:	None.
+ */
+void SIM_ENERGY_PrintReport(void) {
+	// Local variables.
+	double days = (double) SIM_GetTimeUs() / (double) SIM_ENERGY_DAY_US;
+	unsigned char load = 0;
+	// Normalize to one day.
+	if (days <= 0.0) days = 1.0;
+	printf("ENERGY: %.0f mAs/day consumed, %.0f mAs/day harvested, average current %.1f uA\n", (sim_energy_ctx.energy_consumed_uas / (1000.0 * days)), (sim_energy_ctx.energy_harvested_uas / (1000.0 * days)), (sim_energy_ctx.energy_consumed_uas / (days * 86400.0)));
+	for (load=0 ; load<SIM_ENERGY_LOAD_LAST ; load++) {
+		printf("  %-16s %12.0f mAs/day\n", sim_energy_load_name[load], (sim_energy_ctx.energy_load_uas[load] / (1000.0 * days)));
+	}
+	printf("SUPERCAP: %u mV final, %u mV min, %u mV max\n", (unsigned int) sim_energy_ctx.energy_supercap_mv, (unsigned int) sim_energy_ctx.energy_supercap_min_mv, (unsigned int) sim_energy_ctx.energy_supercap_max_mv);
+	printf("BROWN-OUTS: %u (%llu s)\n", sim_energy_ctx.energy_brown_out_count, (sim_energy_ctx.energy_brown_out_time_us / 1000000));
+}
@@ -0,0 +1,343 @@
+/*
+ * sim_gps.c
+ */
+
+#include "sim.h"
+
+#include "accounting.h"
+#include "gpio.h"
+#include "lptim.h"
+#include "lpuart.h"
+#include "mapping.h"
+#include "neom8n.h"
+#include "nvic.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*** SIM GPS local macros ***/
+
+#define SIM_GPS_BYTE_DURATION_US		1042 // 10 bits at 9600 bauds.
+#define SIM_GPS_EPOCH_PERIOD_US			1000000
+#define SIM_GPS_TTFF_MEDIAN_DEFAULT_S	30
+#define SIM_GPS_TTFF_HOT_START_S		3 // Time to fix when ephemeris are still valid.
+#define SIM_GPS_EPHEMERIS_VALIDITY_S	7200
+#define SIM_GPS_UTC_ORIGIN_SECONDS		1792281600 // 18/10/2026 00:00:00 UTC (Unix time).
+#define SIM_GPS_SENTENCE_LENGTH_MAX		96
+
+/*** SIM GPS local structures ***/
+
+typedef enum {
+	SIM_GPS_SENTENCE_ZDA,
+	SIM_GPS_SENTENCE_GGA,
+	SIM_GPS_SENTENCE_LAST
+} SIM_GPS_Sentence;
+
+typedef struct {
+	// LPUART.
+	unsigned char gps_powered;
+	unsigned char gps_rx_enabled;
+	unsigned long long gps_power_on_time_us;
+	unsigned int gps_tx_byte_count;
+	// Receiver.
+	double gps_ttff_median_seconds;
+	double gps_ttff_sigma; // Log-normal distribution shape (0 for a constant time to fix).
+	unsigned int gps_no_fix_percent;
+	signed int gps_fix_delay_seconds; // Drawn at each power-on, negative value means no fix.
+	unsigned long long gps_last_fix_time_us;
+	SIM_GPS_Sentence gps_sentence;
+	unsigned long long gps_sentence_time_us; // Start of transmission, or end if pending.
+	unsigned char gps_sentence_pending;
+	char gps_sentence_buf[SIM_GPS_SENTENCE_LENGTH_MAX];
+	unsigned int gps_sentence_length;
+	unsigned char gps_fix_logged;
+	// Position.
+	char gps_latitude[16];
+	char gps_north_south;
+	char gps_longitude[16];
+	char gps_east_west;
+	char gps_altitude[16];
+	// Statistics.
+	unsigned int gps_power_on_count;
+	unsigned int gps_fix_count;
+	unsigned int gps_sentence_count;
+	unsigned long long gps_powered_time_us;
+} SIM_GPS_Context;
+
+/*** SIM GPS local global variables ***/
+
+static SIM_GPS_Context sim_gps_ctx = {
+	0, 0, 0, 0,
+	SIM_GPS_TTFF_MEDIAN_DEFAULT_S, 0.0, 0, SIM_GPS_TTFF_MEDIAN_DEFAULT_S, SIM_TIME_NONE, SIM_GPS_SENTENCE_ZDA, SIM_TIME_NONE, 0, {0}, 0, 0,
+	"4334.12345", 'N', "00127.54321", 'E', "150.3",
+	0, 0, 0, 0
+};
+
+/*** SIM GPS local functions ***/
+
+/* CHECK IF THE RECEIVER HAS A FIX.
+ * @param:	None.
+ * @return:	1 if position and time are available, 0 otherwise.
+ */
+static unsigned char SIM_GPS_HasFix(void) {
+	if (sim_gps_ctx.gps_fix_delay_seconds < 0) return 0;
+	return (SIM_GetTimeUs() >= (sim_gps_ctx.gps_power_on_time_us + ((unsigned long long) sim_gps_ctx.gps_fix_delay_seconds * 1000000ULL))) ? 1 : 0;
+}
+
+/* DRAW TIME TO FIRST FIX OF THE CURRENT ACQUISITION.
+ * @param:	None.
+ * @return:	Fix delay in seconds (-1 if the receiver will not get a fix).
+ */
+static signed int SIM_GPS_DrawFixDelay(void) {
+	// Local variables.
+	double uniform_1 = 0.0;
+	double uniform_2 = 0.0;
+	double normal = 0.0;
+	// No fix.
+	if ((unsigned int) (rand() % 100) < sim_gps_ctx.gps_no_fix_percent) return -1;
+	// Hot start.
+	if ((sim_gps_ctx.gps_last_fix_time_us != SIM_TIME_NONE) && ((SIM_GetTimeUs() - sim_gps_ctx.gps_last_fix_time_us) < (SIM_GPS_EPHEMERIS_VALIDITY_S * 1000000ULL))) {
+		return SIM_GPS_TTFF_HOT_START_S;
+	}
+	// Log-normal distribution (Box-Muller transform).
+	uniform_1 = ((double) rand() + 1.0) / ((double) RAND_MAX + 2.0);
+	uniform_2 = ((double) rand() + 1.0) / ((double) RAND_MAX + 2.0);
+	normal = sqrt(-2.0 * log(uniform_1)) * cos(2.0 * M_PI * uniform_2);
+	return (signed int) (sim_gps_ctx.gps_ttff_median_seconds * exp(sim_gps_ctx.gps_ttff_sigma * normal));
+}
+
+/* BUILD AN NMEA SENTENCE.
+ * @param sentence:		Sentence to build.
+ * @param nmea_buf:		Buffer that will contain the sentence (CR and LF included).
+ * @return:				Sentence length.
+ */
+static unsigned int SIM_GPS_BuildSentence(SIM_GPS_Sentence sentence, char* nmea_buf) {
+	// Local variables.
+	time_t utc_seconds = (time_t) (SIM_GPS_UTC_ORIGIN_SECONDS + (SIM_GetTimeUs() / 1000000ULL));
+	struct tm* utc = gmtime(&utc_seconds);
+	unsigned char fix = SIM_GPS_HasFix();
+	unsigned char ck = 0;
+	unsigned int idx = 0;
+	int length = 0;
+	// Body.
+	if (sentence == SIM_GPS_SENTENCE_ZDA) {
+		if (fix != 0) {
+			length = snprintf(nmea_buf, SIM_GPS_SENTENCE_LENGTH_MAX, "$GPZDA,%02d%02d%02d.00,%02d,%02d,%04d,00,00*", utc -> tm_hour, utc -> tm_min, utc -> tm_sec, utc -> tm_mday, (utc -> tm_mon) + 1, (utc -> tm_year) + 1900);
+		}
+		else {
+			length = snprintf(nmea_buf, SIM_GPS_SENTENCE_LENGTH_MAX, "$GPZDA,,,,,00,00*");
+		}
+	}
+	else {
+		if (fix != 0) {
+			length = snprintf(nmea_buf, SIM_GPS_SENTENCE_LENGTH_MAX, "$GPGGA,%02d%02d%02d.00,%s,%c,%s,%c,1,08,1.00,%s,M,50.0,M,,*", utc -> tm_hour, utc -> tm_min, utc -> tm_sec, sim_gps_ctx.gps_latitude, sim_gps_ctx.gps_north_south, sim_gps_ctx.gps_longitude, sim_gps_ctx.gps_east_west, sim_gps_ctx.gps_altitude);
+		}
+		else {
+			length = snprintf(nmea_buf, SIM_GPS_SENTENCE_LENGTH_MAX, "$GPGGA,%02d%02d%02d.00,,,,,0,00,99.99,,,,,,*", utc -> tm_hour, utc -> tm_min, utc -> tm_sec);
+		}
+	}
+	// Checksum is the exclusive OR of all characters between '$' and '*'.
+	for (idx=1 ; idx<(unsigned int) (length - 1) ; idx++) {
+		ck ^= nmea_buf[idx];
+	}
+	length += snprintf(&(nmea_buf[length]), (SIM_GPS_SENTENCE_LENGTH_MAX - length), "%02X\r\n", ck);
+	return (unsigned int) length;
+}
+
+/* SCHEDULE THE START OF THE NEXT SENTENCE.
+ * @param:	None.
+ * @return:	None.
+ */
+static void SIM_GPS_ScheduleNextSentence(void) {
+	// Local variables.
+	unsigned long long elapsed_us = (SIM_GetTimeUs() - sim_gps_ctx.gps_power_on_time_us);
+	// GGA follows ZDA immediately, ZDA starts each epoch.
+	if (sim_gps_ctx.gps_sentence == SIM_GPS_SENTENCE_ZDA) {
+		sim_gps_ctx.gps_sentence = SIM_GPS_SENTENCE_GGA;
+		sim_gps_ctx.gps_sentence_time_us = SIM_GetTimeUs();
+	}
+	else {
+		sim_gps_ctx.gps_sentence = SIM_GPS_SENTENCE_ZDA;
+		sim_gps_ctx.gps_sentence_time_us = sim_gps_ctx.gps_power_on_time_us + (((elapsed_us / SIM_GPS_EPOCH_PERIOD_US) + 1) * SIM_GPS_EPOCH_PERIOD_US);
+	}
+	sim_gps_ctx.gps_sentence_pending = 0;
+}
+
+/* DELIVER THE PENDING SENTENCE TO THE MCU.
+ * @param:	None.
+ * @return:	None.
+ */
+static void SIM_GPS_DeliverSentence(void) {
+	// Local variables.
+	unsigned int idx = 0;
+	unsigned char rx_byte = 0;
+	sim_gps_ctx.gps_sentence_count++;
+	SIM_Debug("gps: %.*s", (int) (sim_gps_ctx.gps_sentence_length - 2), sim_gps_ctx.gps_sentence_buf);
+	// Bytes are lost if receiver is disabled.
+	if (sim_gps_ctx.gps_rx_enabled == 0) return;
+	for (idx=0 ; idx<sim_gps_ctx.gps_sentence_length ; idx++) {
+		rx_byte = (unsigned char) sim_gps_ctx.gps_sentence_buf[idx];
+		SIM_MCU_WriteDmaChannel6(rx_byte);
+		// Character match interrupt.
+		if ((rx_byte == NMEA_LF) && (SIM_MCU_IsInterruptEnabled(NVIC_IT_LPUART1) != 0)) {
+			NEOM8N_SwitchDmaBuffer(1);
+			SIM_SignalInterrupt();
+		}
+	}
+}
+
+/*** SIM GPS functions ***/
+
+/* GET TIME OF THE NEXT GPS EVENT.
+ * @param:	None.
+ * @return:	Absolute time in us (SIM_TIME_NONE if no event is pending).
+ */
+unsigned long long SIM_GPS_GetNextEventTime(void) {
+	if (sim_gps_ctx.gps_powered == 0) return SIM_TIME_NONE;
+	return sim_gps_ctx.gps_sentence_time_us;
+}
+
+/* PROCESS GPS EVENTS DUE AT CURRENT TIME.
+ * @param:	None.
+ * @return:	None.
+ */
+void SIM_GPS_ProcessEvents(void) {
+	// Check state.
+	if ((sim_gps_ctx.gps_powered == 0) || (sim_gps_ctx.gps_sentence_time_us > SIM_GetTimeUs())) return;
+	if (sim_gps_ctx.gps_sentence_pending == 0) {
+		// Start of transmission: content is fixed, sentence is delivered once its last byte is received.
+		sim_gps_ctx.gps_sentence_length = SIM_GPS_BuildSentence(sim_gps_ctx.gps_sentence, sim_gps_ctx.gps_sentence_buf);
+		sim_gps_ctx.gps_sentence_time_us += (sim_gps_ctx.gps_sentence_length * SIM_GPS_BYTE_DURATION_US);
+		sim_gps_ctx.gps_sentence_pending = 1;
+		if ((sim_gps_ctx.gps_fix_logged == 0) && (SIM_GPS_HasFix() != 0)) {
+			SIM_Log("gps: fix");
+			sim_gps_ctx.gps_fix_count++;
+			sim_gps_ctx.gps_last_fix_time_us = SIM_GetTimeUs();
+			sim_gps_ctx.gps_fix_logged = 1;
+		}
+	}
+	else {
+		SIM_GPS_DeliverSentence();
+		SIM_GPS_ScheduleNextSentence();
+	}
+}
+
+/* PROCESS GPS SCENARIO EVENT.
+ * @param keyword:		Event keyword.
+ * @param arguments:	Event arguments.
+ * @return:				1 if the keyword was handled, 0 otherwise.
+ */
+unsigned char SIM_GPS_ScenarioEvent(char* keyword, char* arguments) {
+	// Local variables.
+	char latitude[16];
+	char longitude[16];
+	char altitude[16];
+	char north_south = 0;
+	char east_west = 0;
+	double median_seconds = 0.0;
+	double sigma = 0.0;
+	unsigned int no_fix_percent = 0;
+	// Parse keyword.
+	if (strcmp(keyword, "gps") == 0) {
+		// Constant time to fix (negative value for no fix).
+		sim_gps_ctx.gps_ttff_median_seconds = atof(arguments);
+		sim_gps_ctx.gps_ttff_sigma = 0.0;
+		sim_gps_ctx.gps_no_fix_percent = (sim_gps_ctx.gps_ttff_median_seconds < 0.0) ? 100 : 0;
+	}
+	else if (strcmp(keyword, "ttff") == 0) {
+		// Cold start time to fix distribution.
+		if (sscanf(arguments, "%lf %lf %u", &median_seconds, &sigma, &no_fix_percent) < 2) return 0;
+		sim_gps_ctx.gps_ttff_median_seconds = median_seconds;
+		sim_gps_ctx.gps_ttff_sigma = sigma;
+		sim_gps_ctx.gps_no_fix_percent = no_fix_percent;
+	}
+	else if (strcmp(keyword, "position") == 0) {
+		if (sscanf(arguments, "%10s %c %11s %c %15s", latitude, &north_south, longitude, &east_west, altitude) != 5) return 0;
+		strcpy(sim_gps_ctx.gps_latitude, latitude);
+		sim_gps_ctx.gps_north_south = north_south;
+		strcpy(sim_gps_ctx.gps_longitude, longitude);
+		sim_gps_ctx.gps_east_west = east_west;
+		strcpy(sim_gps_ctx.gps_altitude, altitude);
+	}
+	else {
+		return 0;
+	}
+	return 1;
+}
+
+/* PRINT GPS REPORT.
+ * @param:	None.
+ * @return:	None.
+ */
+void SIM_GPS_PrintReport(void) {
+	// Include current power-on period.
+	if (sim_gps_ctx.gps_powered != 0) {
+		sim_gps_ctx.gps_powered_time_us += (SIM_GetTimeUs() - sim_gps_ctx.gps_power_on_time_us);
+		sim_gps_ctx.gps_power_on_time_us = SIM_GetTimeUs();
+	}
+	printf("GPS: %u power-on, %u fix, %u sentences, %llu ms powered\n", sim_gps_ctx.gps_power_on_count, sim_gps_ctx.gps_fix_count, sim_gps_ctx.gps_sentence_count, (sim_gps_ctx.gps_powered_time_us / 1000));
+}
+
+/* LPUART1 STAND-IN (BYTES ARE EXCHANGED WITH THE NEO-M8N MODEL).
+ * @param:	None.
+ * @return:	None.
+ */
+void LPUART1_Init(unsigned char lpuart_use_lse) {
+	GPIO_Write(&GPIO_GPS_POWER_ENABLE, 0);
+}
+
+void LPUART1_UpdateBrr(void) {
+	// Nothing to do.
+}
+
+void LPUART1_EnableTx(void) {
+	// Nothing to do.
+}
+
+void LPUART1_EnableRx(void) {
+	sim_gps_ctx.gps_rx_enabled = 1;
+	NVIC_EnableInterrupt(NVIC_IT_LPUART1);
+}
+
+void LPUART1_Disable(void) {
+	NVIC_DisableInterrupt(NVIC_IT_LPUART1);
+	sim_gps_ctx.gps_rx_enabled = 0;
+}
+
+void LPUART1_PowerOn(void) {
+	// Turn NEOM8N on.
+	GPIO_Write(&GPIO_GPS_POWER_ENABLE, 1);
+	ACCOUNTING_EnterState(ACCOUNTING_STATE_GPS);
+	SIM_ENERGY_SetLoad(SIM_ENERGY_LOAD_GPS, 1);
+	sim_gps_ctx.gps_powered = 1;
+	sim_gps_ctx.gps_power_on_time_us = SIM_GetTimeUs();
+	sim_gps_ctx.gps_fix_delay_seconds = SIM_GPS_DrawFixDelay();
+	sim_gps_ctx.gps_power_on_count++;
+	sim_gps_ctx.gps_fix_logged = 0;
+	// First sentence is sent at the end of the first epoch.
+	sim_gps_ctx.gps_sentence = SIM_GPS_SENTENCE_GGA;
+	SIM_GPS_ScheduleNextSentence();
+	SIM_Log("gps: power on (fix delay %d s)", sim_gps_ctx.gps_fix_delay_seconds);
+	LPTIM1_DelayMilliseconds(100, 1);
+}
+
+void LPUART1_PowerOff(void) {
+	// Turn NEOM8N off.
+	GPIO_Write(&GPIO_GPS_POWER_ENABLE, 0);
+	ACCOUNTING_ExitState(ACCOUNTING_STATE_GPS);
+	SIM_ENERGY_SetLoad(SIM_ENERGY_LOAD_GPS, 0);
+	if (sim_gps_ctx.gps_powered != 0) {
+		sim_gps_ctx.gps_powered_time_us += (SIM_GetTimeUs() - sim_gps_ctx.gps_power_on_time_us);
+	}
+	sim_gps_ctx.gps_powered = 0;
+	SIM_Log("gps: power off");
+	// Delay required if another cycle is requested by applicative layer.
+	LPTIM1_DelayMilliseconds(100, 1);
+}
+
+void LPUART1_SendByte(unsigned char tx_byte) {
+	sim_gps_ctx.gps_tx_byte_count++;
+	SIM_Consume(SIM_GPS_BYTE_DURATION_US);
+}
@@ -0,0 +1,999 @@
+/*
+ * sim_mcu.c
+ */
+
+#include "sim.h"
+
+#include "aes.h"
+#include "dma.h"
+#include "exti.h"
+#include "flash.h"
+#include "flash_reg.h"
+#include "gpio.h"
+#include "gpio_reg.h"
+#include "iwdg.h"
+#include "lptim.h"
+#include "mapping.h"
+#include "mode.h"
+#include "neom8n.h"
+#include "nvic.h"
+#include "pwr.h"
+#include "rcc.h"
+#include "rcc_reg.h"
+#include "rtc.h"
+#include "spi.h"
+#include "tim.h"
+#include "usart.h"
+#include <stdio.h>
+
+/*** SIM MCU local macros ***/
+
+#define SIM_MCU_IWDG_TIMEOUT_US			((4096ULL * 256ULL * 1000000ULL) / RCC_LSI_FREQUENCY_HZ)
+#define SIM_MCU_RTC_WAKEUP_TIMER_MAX	65536
+#define SIM_MCU_RTC_SECONDS_PER_DAY		86400
+#define SIM_MCU_RTC_YEAR_ORIGIN			2000
+#define SIM_MCU_RTC_YEAR_MAX			2099
+#define SIM_MCU_LPTIM_DELAY_MS_MIN		1
+#define SIM_MCU_LPTIM_DELAY_MS_MAX		55000
+
+/*** SIM MCU local structures ***/
+
+typedef struct {
+	unsigned int nvic_enabled_mask;
+} NVIC_Context;
+
+typedef struct {
+	unsigned char iwdg_running;
+	unsigned long long iwdg_deadline_us;
+	unsigned int iwdg_expiry_count;
+} IWDG_Context;
+
+typedef struct {
+	RCC_ClockLevel rcc_clock_level;
+	unsigned int rcc_sysclk_khz;
+	unsigned int rcc_clock_requests_khz[RCC_CLOCK_CLIENT_LAST];
+	RCC_ClockCallback rcc_clock_callbacks[RCC_CLOCK_CLIENT_LAST];
+	unsigned int rcc_clock_level_time_ms[RCC_CLOCK_LEVEL_LAST];
+	unsigned int rcc_clock_level_start_ms;
+	unsigned char rcc_clock_level_time_enabled;
+} RCC_Context;
+
+typedef struct {
+	unsigned long long rtc_origin_us;
+	unsigned int rtc_calendar_offset_seconds;
+	// Wake-up timer.
+	unsigned char rtc_wakeup_timer_running;
+	unsigned long long rtc_wakeup_timer_period_us;
+	unsigned long long rtc_wakeup_timer_next_us;
+	volatile unsigned char rtc_wakeup_timer_flag;
+	// Alarms.
+	unsigned char rtc_alarm_running[RTC_ALARM_LAST];
+	unsigned int rtc_alarm_utc_seconds[RTC_ALARM_LAST];
+	volatile unsigned char rtc_alarm_flag[RTC_ALARM_LAST];
+	// Backup registers.
+	unsigned int rtc_backup_registers[RTC_BACKUP_REGISTERS_NUMBER];
+} RTC_Context;
+
+typedef struct {
+	unsigned char lptim_timer_allocated;
+	unsigned char lptim_timer_running;
+	LPTIM_TimerMode lptim_timer_mode;
+	unsigned long long lptim_timer_period_us;
+	unsigned long long lptim_timer_expiry_us;
+	LPTIM_TimerCallback lptim_timer_callback;
+	volatile unsigned char lptim_timer_flag;
+} LPTIM_Timer;
+
+typedef struct {
+	LPTIM_Timer lptim_timers[LPTIM_TIMER_NUMBER];
+} LPTIM_Context;
+
+typedef struct {
+	// Channel 3 (SPI1 TX).
+	unsigned char* dma_channel3_source;
+	unsigned short dma_channel3_size;
+	unsigned char dma_channel3_done;
+	// Channel 6 (LPUART1 RX).
+	unsigned char* dma_channel6_dest;
+	unsigned short dma_channel6_size;
+	unsigned short dma_channel6_idx;
+	unsigned char dma_channel6_running;
+} DMA_Context;
+
+/*** SIM MCU global variables ***/
+
+// In-memory registers used by modules compiled from the firmware sources (see sim/inc/registers).
+GPIO_BaseAddress sim_gpio_registers[SIM_GPIO_PORT_NUMBER];
+RCC_BaseAddress sim_rcc_registers;
+FLASH_BaseAddress sim_flash_registers;
+unsigned char sim_eeprom[EEPROM_SIZE];
+
+/*** SIM MCU local global variables ***/
+
+static NVIC_Context nvic_ctx;
+static IWDG_Context iwdg_ctx;
+static RCC_Context rcc_ctx;
+static RTC_Context rtc_ctx;
+static LPTIM_Context lptim_ctx;
+static DMA_Context dma_ctx;
+static const unsigned int rcc_clock_level_khz[RCC_CLOCK_LEVEL_LAST] = {RCC_MSI_FREQUENCY_KHZ, 131, 262, 524, 1048, 2097, 4194, RCC_HSI_FREQUENCY_KHZ};
+static const unsigned short rtc_days_before_month[12] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+
+/*** SIM MCU local functions ***/
+
+/* CONVERT A CALENDAR DATE AND TIME TO SECONDS (COPY OF RTC DRIVER).
+ * @param timestamp:	Pointer to the date and time to convert.
+ * @return:				Number of seconds elapsed since 01/01/2000 00:00:00.
+ */
+static unsigned int RTC_TimestampToSeconds(Timestamp* timestamp) {
+	// Local variables.
+	unsigned char year = ((timestamp -> year) - SIM_MCU_RTC_YEAR_ORIGIN);
+	unsigned char month = (timestamp -> month);
+	unsigned int days = 0;
+	unsigned int seconds = 0;
+	// Compute number of days.
+	if ((month < 1) || (month > 12)) {
+		month = 1;
+	}
+	days = (365 * year) + ((year + 3) / 4);
+	days += rtc_days_before_month[month - 1];
+	if (((year % 4) == 0) && (month > 2)) {
+		days++;
+	}
+	days += (timestamp -> date) - 1;
+	// Add time of day.
+	seconds = (days * SIM_MCU_RTC_SECONDS_PER_DAY);
+	seconds += (timestamp -> hours) * 3600;
+	seconds += (timestamp -> minutes) * 60;
+	seconds += (timestamp -> seconds);
+	return seconds;
+}
+
+/* CONVERT SECONDS TO CALENDAR DATE AND TIME (COPY OF RTC DRIVER).
+ * @param seconds:		Number of seconds elapsed since 01/01/2000 00:00:00.
+ * @param timestamp:	Pointer to the structure that will contain the date and time.
+ * @return:				None.
+ */
+static void RTC_SecondsToTimestamp(unsigned int seconds, Timestamp* timestamp) {
+	// Local variables.
+	unsigned int days = (seconds / SIM_MCU_RTC_SECONDS_PER_DAY);
+	unsigned int seconds_of_day = (seconds % SIM_MCU_RTC_SECONDS_PER_DAY);
+	unsigned short days_in_year = 366;
+	unsigned char leap_day = 0;
+	unsigned char month = 12;
+	// Time of day.
+	(timestamp -> hours) = (seconds_of_day / 3600);
+	(timestamp -> minutes) = ((seconds_of_day % 3600) / 60);
+	(timestamp -> seconds) = (seconds_of_day % 60);
+	// Year.
+	(timestamp -> year) = SIM_MCU_RTC_YEAR_ORIGIN;
+	while (days >= days_in_year) {
+		days -= days_in_year;
+		(timestamp -> year)++;
+		days_in_year = (((timestamp -> year) % 4) == 0) ? 366 : 365;
+	}
+	// Month and date.
+	leap_day = (days_in_year == 366) ? 1 : 0;
+	while ((month > 1) && (days < (rtc_days_before_month[month - 1] + ((month > 2) ? leap_day : 0)))) {
+		month--;
+	}
+	(timestamp -> month) = month;
+	(timestamp -> date) = days - (rtc_days_before_month[month - 1] + ((month > 2) ? leap_day : 0)) + 1;
+}
+
+/* GET ABSOLUTE SIMULATION TIME OF A UTC DATE.
+ * @param utc_seconds:	UTC time in seconds since 01/01/2000 00:00:00.
+ * @return:				Simulation time in us.
+ */
+static unsigned long long RTC_UtcSecondsToSimTime(unsigned int utc_seconds) {
+	return rtc_ctx.rtc_origin_us + ((unsigned long long) (utc_seconds - rtc_ctx.rtc_calendar_offset_seconds) * 1000000ULL);
+}
+
+/* ADD TIME ELAPSED SINCE LAST CLOCK CHANGE TO THE CURRENT LEVEL.
+ * @param:	None.
+ * @return:	None.
+ */
+static void RCC_UpdateClockLevelTime(void) {
+	// Local variables.
+	unsigned int timestamp_ms = 0;
+	// Check if accounting is started.
+	if (rcc_ctx.rcc_clock_level_time_enabled == 0) return;
+	// Update statistics.
+	RTC_GetTimestampMilliseconds(&timestamp_ms);
+	rcc_ctx.rcc_clock_level_time_ms[rcc_ctx.rcc_clock_level] += (timestamp_ms - rcc_ctx.rcc_clock_level_start_ms);
+	rcc_ctx.rcc_clock_level_start_ms = timestamp_ms;
+}
+
+/* SWITCH SYSTEM CLOCK TO A GIVEN LEVEL AND UPDATE CLIENTS PRESCALERS.
+ * @param level:	Clock level to use.
+ * @return:			1 (oscillators never fail in simulation).
+ */
+static unsigned char RCC_SwitchClockLevel(RCC_ClockLevel level) {
+	// Local variables.
+	unsigned char client_idx = 0;
+	// Update statistics, level and frequency.
+	RCC_UpdateClockLevelTime();
+	rcc_ctx.rcc_clock_level = level;
+	rcc_ctx.rcc_sysclk_khz = rcc_clock_level_khz[level];
+	// Update clients prescalers.
+	for (client_idx=0 ; client_idx<RCC_CLOCK_CLIENT_LAST ; client_idx++) {
+		if (rcc_ctx.rcc_clock_callbacks[client_idx] != 0) {
+			rcc_ctx.rcc_clock_callbacks[client_idx]();
+		}
+	}
+	return 1;
+}
+
+/* SWITCH TO THE LOWEST CLOCK LEVEL SATISFYING ALL CLIENTS REQUESTS.
+ * @param:	None.
+ * @return:	None.
+ */
+static void RCC_ApplyClockRequests(void) {
+	// Local variables.
+	unsigned int frequency_min_khz = 0;
+	unsigned char client_idx = 0;
+	RCC_ClockLevel level = RCC_CLOCK_LEVEL_MSI_65KHZ;
+	// Get highest request.
+	for (client_idx=0 ; client_idx<RCC_CLOCK_CLIENT_LAST ; client_idx++) {
+		if (rcc_ctx.rcc_clock_requests_khz[client_idx] > frequency_min_khz) {
+			frequency_min_khz = rcc_ctx.rcc_clock_requests_khz[client_idx];
+		}
+	}
+	// Search lowest level.
+	while ((level < RCC_CLOCK_LEVEL_HSI_16MHZ) && (rcc_clock_level_khz[level] < frequency_min_khz)) {
+		level++;
+	}
+	// Switch if needed.
+	if (level != rcc_ctx.rcc_clock_level) {
+		RCC_SwitchClockLevel(level);
+	}
+}
+
+/* PROCESS EXPIRED LPTIM TIMERS (SAME SEMANTICS AS LPTIM1_UpdateTimers).
+ * @param:	None.
+ * @return:	None.
+ */
+static void LPTIM1_UpdateTimers(void) {
+	// Local variables.
+	unsigned long long now_us = SIM_GetTimeUs();
+	unsigned char timer_idx = 0;
+	// Timers are processed under interrupt.
+	if (SIM_MCU_IsInterruptEnabled(NVIC_IT_LPTIM1) == 0) return;
+	for (timer_idx=0 ; timer_idx<LPTIM_TIMER_NUMBER ; timer_idx++) {
+		if (lptim_ctx.lptim_timers[timer_idx].lptim_timer_running == 0) continue;
+		if (lptim_ctx.lptim_timers[timer_idx].lptim_timer_expiry_us <= now_us) {
+			// Update timer.
+			if (lptim_ctx.lptim_timers[timer_idx].lptim_timer_mode == LPTIM_TIMER_MODE_PERIODIC) {
+				lptim_ctx.lptim_timers[timer_idx].lptim_timer_expiry_us += lptim_ctx.lptim_timers[timer_idx].lptim_timer_period_us;
+			}
+			else {
+				lptim_ctx.lptim_timers[timer_idx].lptim_timer_running = 0;
+			}
+			// Notify client.
+			lptim_ctx.lptim_timers[timer_idx].lptim_timer_flag = 1;
+			if (lptim_ctx.lptim_timers[timer_idx].lptim_timer_callback != 0) {
+				lptim_ctx.lptim_timers[timer_idx].lptim_timer_callback();
+			}
+			SIM_SignalInterrupt();
+		}
+	}
+}
+
+/* GET TIME OF THE NEXT RTC EVENT.
+ * @param:	None.
+ * @return:	Absolute time in us (SIM_TIME_NONE if no event is pending).
+ */
+static unsigned long long RTC_GetNextEventTime(void) {
+	// Local variables.
+	unsigned long long next_time_us = SIM_TIME_NONE;
+	unsigned long long alarm_time_us = 0;
+	unsigned char alarm = 0;
+	// Interrupt must be enabled to wake-up the MCU.
+	if (SIM_MCU_IsInterruptEnabled(NVIC_IT_RTC) == 0) return SIM_TIME_NONE;
+	if (rtc_ctx.rtc_wakeup_timer_running != 0) {
+		next_time_us = rtc_ctx.rtc_wakeup_timer_next_us;
+	}
+	for (alarm=0 ; alarm<RTC_ALARM_LAST ; alarm++) {
+		if (rtc_ctx.rtc_alarm_running[alarm] == 0) continue;
+		alarm_time_us = RTC_UtcSecondsToSimTime(rtc_ctx.rtc_alarm_utc_seconds[alarm]);
+		if (alarm_time_us < next_time_us) next_time_us = alarm_time_us;
+	}
+	return next_time_us;
+}
+
+/* PROCESS RTC EVENTS.
+ * @param:	None.
+ * @return:	None.
+ */
+static void RTC_ProcessEvents(void) {
+	// Local variables.
+	unsigned long long now_us = SIM_GetTimeUs();
+	unsigned char alarm = 0;
+	// Interrupt must be enabled to wake-up the MCU.
+	if (SIM_MCU_IsInterruptEnabled(NVIC_IT_RTC) == 0) return;
+	// Wake-up timer (auto-reload).
+	if ((rtc_ctx.rtc_wakeup_timer_running != 0) && (rtc_ctx.rtc_wakeup_timer_next_us <= now_us)) {
+		rtc_ctx.rtc_wakeup_timer_next_us += rtc_ctx.rtc_wakeup_timer_period_us;
+		rtc_ctx.rtc_wakeup_timer_flag = 1;
+		SIM_SignalInterrupt();
+	}
+	// Alarms.
+	for (alarm=0 ; alarm<RTC_ALARM_LAST ; alarm++) {
+		if (rtc_ctx.rtc_alarm_running[alarm] == 0) continue;
+		if (RTC_UtcSecondsToSimTime(rtc_ctx.rtc_alarm_utc_seconds[alarm]) <= now_us) {
+			// Hardware compares date and time only: the alarm would match again next month, it is disarmed here.
+			rtc_ctx.rtc_alarm_running[alarm] = 0;
+			rtc_ctx.rtc_alarm_flag[alarm] = 1;
+			SIM_SignalInterrupt();
+		}
+	}
+}
+
+/*** SIM MCU functions ***/
+
+/* GET TIME OF THE NEXT MCU PERIPHERALS EVENT.
+ * @param:	None.
+ * @return:	Absolute time in us (SIM_TIME_NONE if no event is pending).
+ */
+unsigned long long SIM_MCU_GetNextEventTime(void) {
+	// Local variables.
+	unsigned long long next_time_us = RTC_GetNextEventTime();
+	unsigned char timer_idx = 0;
+	// Watchdog.
+	if ((iwdg_ctx.iwdg_running != 0) && (iwdg_ctx.iwdg_deadline_us < next_time_us)) {
+		next_time_us = iwdg_ctx.iwdg_deadline_us;
+	}
+	// Timers.
+	if (SIM_MCU_IsInterruptEnabled(NVIC_IT_LPTIM1) != 0) {
+		for (timer_idx=0 ; timer_idx<LPTIM_TIMER_NUMBER ; timer_idx++) {
+			if (lptim_ctx.lptim_timers[timer_idx].lptim_timer_running == 0) continue;
+			if (lptim_ctx.lptim_timers[timer_idx].lptim_timer_expiry_us < next_time_us) {
+				next_time_us = lptim_ctx.lptim_timers[timer_idx].lptim_timer_expiry_us;
+			}
+		}
+	}
+	return next_time_us;
+}
+
+/* PROCESS MCU PERIPHERALS EVENTS DUE AT CURRENT TIME.
+ * @param:	None.
+ * @return:	None.
+ */
+void SIM_MCU_ProcessEvents(void) {
+	// Watchdog.
+	if ((iwdg_ctx.iwdg_running != 0) && (iwdg_ctx.iwdg_deadline_us <= SIM_GetTimeUs())) {
+		iwdg_ctx.iwdg_expiry_count++;
+		SIM_Log("iwdg: watchdog expired, MCU would reset");
+		iwdg_ctx.iwdg_deadline_us = SIM_GetTimeUs() + SIM_MCU_IWDG_TIMEOUT_US;
+	}
+	RTC_ProcessEvents();
+	LPTIM1_UpdateTimers();
+}
+
+/* PROCESS MCU SCENARIO EVENT.
+ * @param keyword:		Event keyword.
+ * @param arguments:	Event arguments.
+ * @return:				1 if the keyword was handled, 0 otherwise.
+ */
+unsigned char SIM_MCU_ScenarioEvent(char* keyword, char* arguments) {
+	// No MCU scenario event.
+	return 0;
+}
+
+/* PRINT MCU PERIPHERALS REPORT.
+ * @param:	None.
+ * @return:	None.
+ */
+void SIM_MCU_PrintReport(void) {
+	// Local variables.
+	unsigned char level = 0;
+	unsigned int time_ms = 0;
+	// Watchdog.
+	printf("Watchdog expiries: %u\n", iwdg_ctx.iwdg_expiry_count);
+	// Clock levels.
+	printf("Clock levels (stop mode excluded):\n");
+	for (level=0 ; level<RCC_CLOCK_LEVEL_LAST ; level++) {
+		RCC_GetClockLevelTime(level, &time_ms);
+		printf("  %5u kHz %12u ms\n", rcc_clock_level_khz[level], time_ms);
+	}
+}
+
+/* CHECK IF AN INTERRUPT LINE IS ENABLED IN NVIC.
+ * @param it_num:	Interrupt number.
+ * @return:			1 if the interrupt is enabled, 0 otherwise.
+ */
+unsigned char SIM_MCU_IsInterruptEnabled(unsigned char it_num) {
+	return ((nvic_ctx.nvic_enabled_mask & (0b1 << it_num)) != 0) ? 1 : 0;
+}
+
+/* RECEIVE A BYTE THROUGH DMA CHANNEL 6 (LPUART1 RX).
+ * @param rx_byte:	Received byte.
+ * @return:			1 if the byte was stored, 0 if the channel is not running.
+ */
+unsigned char SIM_MCU_WriteDmaChannel6(unsigned char rx_byte) {
+	// Check channel.
+	if ((dma_ctx.dma_channel6_running == 0) || (dma_ctx.dma_channel6_dest == NULL)) return 0;
+	// Store byte.
+	dma_ctx.dma_channel6_dest[dma_ctx.dma_channel6_idx] = rx_byte;
+	dma_ctx.dma_channel6_idx++;
+	// Transfer complete interrupt.
+	if (dma_ctx.dma_channel6_idx >= dma_ctx.dma_channel6_size) {
+		dma_ctx.dma_channel6_running = 0;
+		if (SIM_MCU_IsInterruptEnabled(NVIC_IT_DMA1_CH_4_7) != 0) {
+			NEOM8N_SwitchDmaBuffer(0);
+			SIM_SignalInterrupt();
+		}
+	}
+	return 1;
+}
+
+/* NVIC STAND-IN.
+ * @param:	None.
+ * @return:	None.
+ */
+void NVIC_Init(void) {
+	nvic_ctx.nvic_enabled_mask = 0;
+}
+
+void NVIC_EnableInterrupt(NVIC_InterruptVector it_num) {
+	nvic_ctx.nvic_enabled_mask |= (0b1 << it_num);
+}
+
+void NVIC_DisableInterrupt(NVIC_InterruptVector it_num) {
+	nvic_ctx.nvic_enabled_mask &= ~(0b1 << it_num);
+}
+
+void NVIC_DisableInterrupts(void) {
+	// Interrupts are only signaled while the MCU waits, masking is not simulated.
+}
+
+void NVIC_EnableInterrupts(void) {
+	// Interrupts are only signaled while the MCU waits, masking is not simulated.
+}
+
+void NVIC_SetPriority(NVIC_InterruptVector it_num, unsigned char priority) {
+	// Priorities are not simulated.
+}
+
+/* IWDG STAND-IN (TIMEOUT IS CHECKED AGAINST SIMULATED TIME, EXPIRIES ARE REPORTED INSTEAD OF RESETTING THE MCU).
+ * @param:	None.
+ * @return:	None.
+ */
+void IWDG_Init(void) {
+	iwdg_ctx.iwdg_running = 1;
+	IWDG_Reload();
+}
+
+void IWDG_Reload(void) {
+	iwdg_ctx.iwdg_deadline_us = SIM_GetTimeUs() + SIM_MCU_IWDG_TIMEOUT_US;
+}
+
+/* RCC STAND-IN (SAME CLOCK LEVELS MANAGEMENT AS THE DRIVER, OSCILLATORS ARE ALWAYS READY).
+ * @param:	None.
+ * @return:	None.
+ */
+void RCC_Init(void) {
+	// Local variables.
+	unsigned char idx = 0;
+	// Init clock manager.
+	for (idx=0 ; idx<RCC_CLOCK_CLIENT_LAST ; idx++) {
+		rcc_ctx.rcc_clock_requests_khz[idx] = 0;
+		rcc_ctx.rcc_clock_callbacks[idx] = 0;
+	}
+	for (idx=0 ; idx<RCC_CLOCK_LEVEL_LAST ; idx++) rcc_ctx.rcc_clock_level_time_ms[idx] = 0;
+	rcc_ctx.rcc_clock_level = RCC_CLOCK_LEVEL_MSI_2MHZ;
+	rcc_ctx.rcc_sysclk_khz = rcc_clock_level_khz[RCC_CLOCK_LEVEL_MSI_2MHZ];
+	rcc_ctx.rcc_clock_level_start_ms = 0;
+	rcc_ctx.rcc_clock_level_time_enabled = 0;
+}
+
+unsigned int RCC_GetSysclkKhz(void) {
+	return rcc_ctx.rcc_sysclk_khz;
+}
+
+unsigned char RCC_SetHsiKernelRequest(unsigned char hsi_kernel_request) {
+	return 1;
+}
+
+void RCC_SetClockRequest(RCC_ClockClient client, unsigned int frequency_min_khz) {
+	// Check parameter.
+	if (client >= RCC_CLOCK_CLIENT_LAST) return;
+	// Update request and clock.
+	rcc_ctx.rcc_clock_requests_khz[client] = frequency_min_khz;
+	RCC_ApplyClockRequests();
+}
+
+void RCC_SetClockCallback(RCC_ClockClient client, RCC_ClockCallback callback) {
+	// Check parameter.
+	if (client >= RCC_CLOCK_CLIENT_LAST) return;
+	rcc_ctx.rcc_clock_callbacks[client] = callback;
+}
+
+void RCC_EnterStopMode(void) {
+	RCC_UpdateClockLevelTime();
+}
+
+void RCC_ExitStopMode(void) {
+	// Local variables.
+	unsigned char client_idx = 0;
+	// Stop mode duration is not accounted.
+	if (rcc_ctx.rcc_clock_level_time_enabled != 0) {
+		RTC_GetTimestampMilliseconds(&rcc_ctx.rcc_clock_level_start_ms);
+	}
+	if (rcc_ctx.rcc_clock_level != RCC_CLOCK_LEVEL_HSI_16MHZ) {
+		// System wakes-up on HSI.
+		rcc_ctx.rcc_clock_level = RCC_CLOCK_LEVEL_HSI_16MHZ;
+		rcc_ctx.rcc_sysclk_khz = RCC_HSI_FREQUENCY_KHZ;
+		RCC_ApplyClockRequests();
+		if (rcc_ctx.rcc_clock_level == RCC_CLOCK_LEVEL_HSI_16MHZ) {
+			for (client_idx=0 ; client_idx<RCC_CLOCK_CLIENT_LAST ; client_idx++) {
+				if (rcc_ctx.rcc_clock_callbacks[client_idx] != 0) {
+					rcc_ctx.rcc_clock_callbacks[client_idx]();
+				}
+			}
+		}
+	}
+}
+
+void RCC_StartClockLevelTime(void) {
+	// Local variables.
+	unsigned char idx = 0;
+	// Reset statistics and start current slot.
+	for (idx=0 ; idx<RCC_CLOCK_LEVEL_LAST ; idx++) rcc_ctx.rcc_clock_level_time_ms[idx] = 0;
+	RTC_GetTimestampMilliseconds(&rcc_ctx.rcc_clock_level_start_ms);
+	rcc_ctx.rcc_clock_level_time_enabled = 1;
+}
+
+void RCC_GetClockLevelTime(RCC_ClockLevel level, unsigned int* time_ms) {
+	// Check parameter.
+	(*time_ms) = 0;
+	if (level >= RCC_CLOCK_LEVEL_LAST) return;
+	// Include current slot.
+	if (level == rcc_ctx.rcc_clock_level) {
+		RCC_UpdateClockLevelTime();
+	}
+	(*time_ms) = rcc_ctx.rcc_clock_level_time_ms[level];
+}
+
+unsigned char RCC_EnableLsi(void) {
+	return 1;
+}
+
+void RCC_GetLsiFrequency(unsigned int* lsi_frequency_hz) {
+	(*lsi_frequency_hz) = RCC_LSI_FREQUENCY_HZ;
+}
+
+unsigned char RCC_EnableLse(void) {
+	return 1;
+}
+
+/* PWR STAND-IN (WFI INSTRUCTION IS REPLACED BY SIMULATED TIME PROGRESSION).
+ * @param:	None.
+ * @return:	None.
+ */
+void PWR_Init(void) {
+	// Nothing to do.
+}
+
+void PWR_EnterSleepMode(void) {
+	SIM_WaitForInterrupt(SIM_POWER_MODE_SLEEP);
+}
+
+void PWR_EnterLowPowerSleepMode(void) {
+	SIM_WaitForInterrupt(SIM_POWER_MODE_LOW_POWER_SLEEP);
+}
+
+void PWR_EnterStopMode(void) {
+	RCC_EnterStopMode();
+	SIM_WaitForInterrupt(SIM_POWER_MODE_STOP);
+	RCC_ExitStopMode();
+}
+
+/* FLASH STAND-IN.
+ * @param wait_states:	Number of wait states.
+ * @return:				None.
+ */
+void FLASH_SetLatency(unsigned char wait_states) {
+	// Latency is not simulated.
+}
+
+/* GPIO STAND-IN (S2LP CHIP SELECT IS FORWARDED TO THE RADIO MODEL).
+ * Mapping constants are static in each module, GPIOs are identified by port and pin number.
+ * @param:	None.
+ * @return:	None.
+ */
+void GPIO_Init(void) {
+	// Nothing to do.
+}
+
+void GPIO_Configure(const GPIO* gpio, GPIO_Mode mode, GPIO_OutputType output_type, GPIO_OutputSpeed output_speed, GPIO_PullResistor pull_resistor) {
+	(gpio -> gpio_port_address) -> MODER &= ~(0b11 << (2 * (gpio -> gpio_num)));
+	(gpio -> gpio_port_address) -> MODER |= (mode << (2 * (gpio -> gpio_num)));
+}
+
+void GPIO_Write(const GPIO* gpio, unsigned char state) {
+	// Set bit.
+	if (state == 0) {
+		(gpio -> gpio_port_address) -> ODR &= ~(0b1 << (gpio -> gpio_num));
+	}
+	else {
+		(gpio -> gpio_port_address) -> ODR |= (0b1 << (gpio -> gpio_num));
+	}
+	// Forward chip select to radio model.
+	if (((gpio -> gpio_port_address) == GPIO_S2LP_CS.gpio_port_address) && ((gpio -> gpio_num) == GPIO_S2LP_CS.gpio_num)) {
+		SIM_RADIO_SetChipSelect(state);
+	}
+}
+
+unsigned char GPIO_Read(const GPIO* gpio) {
+	// Local variables.
+	unsigned int mode = ((((gpio -> gpio_port_address) -> MODER) >> (2 * (gpio -> gpio_num))) & 0b11);
+	unsigned int data = (mode == GPIO_MODE_INPUT) ? ((gpio -> gpio_port_address) -> IDR) : ((gpio -> gpio_port_address) -> ODR);
+	return ((data & (0b1 << (gpio -> gpio_num))) != 0) ? 1 : 0;
+}
+
+void GPIO_Toggle(const GPIO* gpio) {
+	GPIO_Write(gpio, (GPIO_Read(gpio) == 0) ? 1 : 0);
+}
+
+/* EXTI STAND-IN (EXTERNAL EVENTS ARE SIGNALED BY THE MODELS THROUGH NVIC MASK).
+ * @param:	None.
+ * @return:	None.
+ */
+void EXTI_Init(void) {
+	// Nothing to do.
+}
+
+void EXTI_ConfigureGpio(const GPIO* gpio, EXTI_Trigger edge_trigger) {
+	// Nothing to do.
+}
+
+void EXTI_ConfigureLine(EXTI_Line line, EXTI_Trigger edge_trigger) {
+	// Nothing to do.
+}
+
+void EXTI_ClearAllFlags(void) {
+	// Nothing to do.
+}
+
+/* RTC STAND-IN (CALENDAR IS DERIVED FROM SIMULATED TIME).
+ * @param:	None.
+ * @return:	None.
+ */
+void RTC_Reset(void) {
+	// Local variables.
+	unsigned char idx = 0;
+	// Calendar restarts from 01/01/2000 00:00:00.
+	rtc_ctx.rtc_origin_us = SIM_GetTimeUs();
+	rtc_ctx.rtc_calendar_offset_seconds = 0;
+	rtc_ctx.rtc_wakeup_timer_running = 0;
+	for (idx=0 ; idx<RTC_ALARM_LAST ; idx++) rtc_ctx.rtc_alarm_running[idx] = 0;
+	for (idx=0 ; idx<RTC_BACKUP_REGISTERS_NUMBER ; idx++) rtc_ctx.rtc_backup_registers[idx] = 0;
+}
+
+void RTC_Init(unsigned char* rtc_use_lse, unsigned int lsi_freq_hz) {
+	// Init context.
+	rtc_ctx.rtc_wakeup_timer_flag = 0;
+	rtc_ctx.rtc_alarm_flag[RTC_ALARM_A] = 0;
+	rtc_ctx.rtc_alarm_flag[RTC_ALARM_B] = 0;
+	rtc_ctx.rtc_calendar_offset_seconds = 0;
+	NVIC_EnableInterrupt(NVIC_IT_RTC);
+}
+
+void RTC_StartWakeUpTimer(unsigned int delay_seconds) {
+	// Clamp parameter.
+	unsigned int local_delay_seconds = delay_seconds;
+	if (local_delay_seconds > SIM_MCU_RTC_WAKEUP_TIMER_MAX) {
+		local_delay_seconds = SIM_MCU_RTC_WAKEUP_TIMER_MAX;
+	}
+	// Check if timer is not already running.
+	if (rtc_ctx.rtc_wakeup_timer_running == 0) {
+		rtc_ctx.rtc_wakeup_timer_period_us = ((unsigned long long) local_delay_seconds * 1000000ULL);
+		rtc_ctx.rtc_wakeup_timer_next_us = SIM_GetTimeUs() + rtc_ctx.rtc_wakeup_timer_period_us;
+		rtc_ctx.rtc_wakeup_timer_running = 1;
+	}
+}
+
+void RTC_StopWakeUpTimer(void) {
+	rtc_ctx.rtc_wakeup_timer_running = 0;
+}
+
+volatile unsigned char RTC_GetWakeUpTimerFlag(void) {
+	return rtc_ctx.rtc_wakeup_timer_flag;
+}
+
+void RTC_ClearWakeUpTimerFlag(void) {
+	rtc_ctx.rtc_wakeup_timer_flag = 0;
+}
+
+void RTC_StartAlarm(RTC_Alarm alarm, unsigned int utc_seconds) {
+	// Check parameter.
+	if (alarm >= RTC_ALARM_LAST) return;
+	rtc_ctx.rtc_alarm_utc_seconds[alarm] = utc_seconds;
+	rtc_ctx.rtc_alarm_flag[alarm] = 0;
+	rtc_ctx.rtc_alarm_running[alarm] = 1;
+}
+
+void RTC_StopAlarm(RTC_Alarm alarm) {
+	// Check parameter.
+	if (alarm >= RTC_ALARM_LAST) return;
+	rtc_ctx.rtc_alarm_running[alarm] = 0;
+}
+
+volatile unsigned char RTC_GetAlarmFlag(RTC_Alarm alarm) {
+	// Check parameter.
+	if (alarm >= RTC_ALARM_LAST) return 0;
+	return rtc_ctx.rtc_alarm_flag[alarm];
+}
+
+void RTC_ClearAlarmFlag(RTC_Alarm alarm) {
+	// Check parameter.
+	if (alarm >= RTC_ALARM_LAST) return;
+	rtc_ctx.rtc_alarm_flag[alarm] = 0;
+}
+
+unsigned char RTC_SetTimestamp(Timestamp* timestamp) {
+	// Local variables.
+	unsigned int previous_utc_seconds = 0;
+	// Check parameters.
+	if (((timestamp -> year) < SIM_MCU_RTC_YEAR_ORIGIN) || ((timestamp -> year) > SIM_MCU_RTC_YEAR_MAX)) return 0;
+	if (((timestamp -> month) < 1) || ((timestamp -> month) > 12)) return 0;
+	if (((timestamp -> date) < 1) || ((timestamp -> date) > 31)) return 0;
+	if (((timestamp -> hours) > 23) || ((timestamp -> minutes) > 59) || ((timestamp -> seconds) > 59)) return 0;
+	// Keep monotonic timestamps continuous.
+	RTC_GetUtcSeconds(&previous_utc_seconds);
+	rtc_ctx.rtc_calendar_offset_seconds += (RTC_TimestampToSeconds(timestamp) - previous_utc_seconds);
+	return 1;
+}
+
+void RTC_GetTimestamp(Timestamp* timestamp) {
+	// Local variables.
+	unsigned int utc_seconds = 0;
+	RTC_GetUtcSeconds(&utc_seconds);
+	RTC_SecondsToTimestamp(utc_seconds, timestamp);
+}
+
+void RTC_GetUtcSeconds(unsigned int* utc_seconds) {
+	// Local variables.
+	unsigned int timestamp_seconds = 0;
+	RTC_GetTimestampSeconds(&timestamp_seconds);
+	(*utc_seconds) = (timestamp_seconds + rtc_ctx.rtc_calendar_offset_seconds);
+}
+
+void RTC_GetTimestampSeconds(unsigned int* timestamp_seconds) {
+	(*timestamp_seconds) = (unsigned int) ((SIM_GetTimeUs() - rtc_ctx.rtc_origin_us) / 1000000ULL);
+}
+
+void RTC_GetTimestampMilliseconds(unsigned int* timestamp_ms) {
+	(*timestamp_ms) = (unsigned int) ((SIM_GetTimeUs() - rtc_ctx.rtc_origin_us) / 1000ULL);
+}
+
+void RTC_WriteBackupRegister(unsigned char register_idx, unsigned int value) {
+	if (register_idx < RTC_BACKUP_REGISTERS_NUMBER) {
+		rtc_ctx.rtc_backup_registers[register_idx] = value;
+	}
+}
+
+void RTC_ReadBackupRegister(unsigned char register_idx, unsigned int* value) {
+	(*value) = 0;
+	if (register_idx < RTC_BACKUP_REGISTERS_NUMBER) {
+		(*value) = rtc_ctx.rtc_backup_registers[register_idx];
+	}
+}
+
+/* LPTIM STAND-IN (SOFTWARE TIMERS RUN ON SIMULATED TIME WITH 1US RESOLUTION).
+ * @param:	None.
+ * @return:	None.
+ */
+void LPTIM1_Init(unsigned int lsi_freq_hz) {
+	// Local variables.
+	unsigned char timer_idx = 0;
+	// Init context.
+	for (timer_idx=0 ; timer_idx<LPTIM_TIMER_NUMBER ; timer_idx++) {
+		lptim_ctx.lptim_timers[timer_idx].lptim_timer_allocated = 0;
+		lptim_ctx.lptim_timers[timer_idx].lptim_timer_running = 0;
+		lptim_ctx.lptim_timers[timer_idx].lptim_timer_flag = 0;
+	}
+	NVIC_EnableInterrupt(NVIC_IT_LPTIM1);
+}
+
+void LPTIM1_Enable(void) {
+	// Nothing to do.
+}
+
+void LPTIM1_Disable(void) {
+	// Local variables.
+	unsigned char timer_idx = 0;
+	// Disable interrupt and stop all timers.
+	NVIC_DisableInterrupt(NVIC_IT_LPTIM1);
+	for (timer_idx=0 ; timer_idx<LPTIM_TIMER_NUMBER ; timer_idx++) {
+		lptim_ctx.lptim_timers[timer_idx].lptim_timer_running = 0;
+	}
+}
+
+unsigned char LPTIM1_StartTimer(unsigned char* timer_id, unsigned int duration_ms, LPTIM_TimerMode mode, LPTIM_TimerCallback callback) {
+	// Local variables.
+	unsigned char timer_idx = 0;
+	// Search free timer.
+	for (timer_idx=0 ; timer_idx<LPTIM_TIMER_NUMBER ; timer_idx++) {
+		if (lptim_ctx.lptim_timers[timer_idx].lptim_timer_allocated == 0) {
+			lptim_ctx.lptim_timers[timer_idx].lptim_timer_mode = mode;
+			lptim_ctx.lptim_timers[timer_idx].lptim_timer_period_us = ((duration_ms == 0) ? 1 : ((unsigned long long) duration_ms * 1000ULL));
+			lptim_ctx.lptim_timers[timer_idx].lptim_timer_expiry_us = SIM_GetTimeUs() + lptim_ctx.lptim_timers[timer_idx].lptim_timer_period_us;
+			lptim_ctx.lptim_timers[timer_idx].lptim_timer_callback = callback;
+			lptim_ctx.lptim_timers[timer_idx].lptim_timer_flag = 0;
+			lptim_ctx.lptim_timers[timer_idx].lptim_timer_allocated = 1;
+			lptim_ctx.lptim_timers[timer_idx].lptim_timer_running = 1;
+			(*timer_id) = timer_idx;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void LPTIM1_StopTimer(unsigned char timer_id) {
+	// Check parameter.
+	if (timer_id >= LPTIM_TIMER_NUMBER) return;
+	lptim_ctx.lptim_timers[timer_id].lptim_timer_running = 0;
+	lptim_ctx.lptim_timers[timer_id].lptim_timer_allocated = 0;
+}
+
+unsigned char LPTIM1_GetTimerFlag(unsigned char timer_id) {
+	// Check parameter.
+	if (timer_id >= LPTIM_TIMER_NUMBER) return 0;
+	return lptim_ctx.lptim_timers[timer_id].lptim_timer_flag;
+}
+
+void LPTIM1_ClearTimerFlag(unsigned char timer_id) {
+	// Check parameter.
+	if (timer_id >= LPTIM_TIMER_NUMBER) return;
+	lptim_ctx.lptim_timers[timer_id].lptim_timer_flag = 0;
+}
+
+void LPTIM1_WaitTimer(unsigned char timer_id, unsigned char stop_mode) {
+	// Check parameter.
+	if (timer_id >= LPTIM_TIMER_NUMBER) return;
+	// Wait for expiry (or timer stop), busy wait is simulated as run mode.
+	while ((lptim_ctx.lptim_timers[timer_id].lptim_timer_flag == 0) && (lptim_ctx.lptim_timers[timer_id].lptim_timer_running != 0)) {
+		if (stop_mode != 0) {
+			PWR_EnterStopMode();
+		}
+		else {
+			SIM_WaitForInterrupt(SIM_POWER_MODE_RUN);
+		}
+	}
+}
+
+void LPTIM1_DelayMilliseconds(unsigned int delay_ms, unsigned char stop_mode) {
+	// Local variables.
+	unsigned char timer_id = 0;
+	// Clamp value if required.
+	unsigned int local_delay_ms = delay_ms;
+	if (local_delay_ms > SIM_MCU_LPTIM_DELAY_MS_MAX) {
+		local_delay_ms = SIM_MCU_LPTIM_DELAY_MS_MAX;
+	}
+	if (local_delay_ms < SIM_MCU_LPTIM_DELAY_MS_MIN) {
+		local_delay_ms = SIM_MCU_LPTIM_DELAY_MS_MIN;
+	}
+	// Start single shot timer and wait for expiry.
+	if (LPTIM1_StartTimer(&timer_id, local_delay_ms, LPTIM_TIMER_MODE_SINGLE, 0) == 0) return;
+	LPTIM1_WaitTimer(timer_id, stop_mode);
+	LPTIM1_StopTimer(timer_id);
+}
+
+/* DMA STAND-IN.
+ * Channel 3 pushes the S2LP FIFO bytes to the radio model, channel 6 receives GPS model bytes.
+ * @param:	None.
+ * @return:	None.
+ */
+void DMA1_InitChannel3(void) {
+	dma_ctx.dma_channel3_done = 0;
+}
+
+void DMA1_StartChannel3(void) {
+	// Local variables.
+	unsigned short byte_idx = 0;
+	// Transfer is performed at once.
+	for (byte_idx=0 ; byte_idx<dma_ctx.dma_channel3_size ; byte_idx++) {
+		SPI1_WriteByte(dma_ctx.dma_channel3_source[byte_idx]);
+	}
+	dma_ctx.dma_channel3_done = 1;
+}
+
+void DMA1_StopChannel3(void) {
+	dma_ctx.dma_channel3_done = 0;
+}
+
+void DMA1_SetChannel3SourceAddr(unsigned int source_buf_addr, unsigned short source_buf_size) {
+	dma_ctx.dma_channel3_source = (unsigned char*) (unsigned long) source_buf_addr;
+	dma_ctx.dma_channel3_size = source_buf_size;
+}
+
+unsigned char DMA1_GetChannel3Status(void) {
+	return dma_ctx.dma_channel3_done;
+}
+
+void DMA1_InitChannel4(void) {
+	// Nothing to do.
+}
+
+void DMA1_StartChannel4(void) {
+	// Nothing to do.
+}
+
+void DMA1_StopChannel4(void) {
+	// Nothing to do.
+}
+
+void DMA1_SetChannel4SourceAddr(unsigned int source_buf_addr, unsigned short source_buf_size) {
+	// Nothing to do.
+}
+
+void DMA1_InitChannel6(void) {
+	dma_ctx.dma_channel6_running = 0;
+	NVIC_EnableInterrupt(NVIC_IT_DMA1_CH_4_7);
+}
+
+void DMA1_StartChannel6(void) {
+	dma_ctx.dma_channel6_idx = 0;
+	dma_ctx.dma_channel6_running = 1;
+}
+
+void DMA1_StopChannel6(void) {
+	dma_ctx.dma_channel6_running = 0;
+}
+
+void DMA1_SetChannel6DestAddr(unsigned int dest_buf_addr, unsigned short dest_buf_size) {
+	dma_ctx.dma_channel6_dest = (unsigned char*) (unsigned long) dest_buf_addr;
+	dma_ctx.dma_channel6_size = dest_buf_size;
+}
+
+void DMA1_Disable(void) {
+	dma_ctx.dma_channel3_done = 0;
+	dma_ctx.dma_channel6_running = 0;
+	NVIC_DisableInterrupt(NVIC_IT_DMA1_CH_4_7);
+}
+
+/* AES STAND-IN (NOT A CRYPTOGRAPHIC IMPLEMENTATION, ONLY USED TO PRODUCE DETERMINISTIC FRAMES).
+ * @param:	None.
+ * @return:	None.
+ */
+void AES_Init(void) {
+	// Nothing to do.
+}
+
+void AES_Disable(void) {
+	// Nothing to do.
+}
+
+void AES_EncodeCbc(unsigned char data_in[AES_BLOCK_SIZE], unsigned char data_out[AES_BLOCK_SIZE], unsigned char init_vector[AES_BLOCK_SIZE], unsigned char key[AES_BLOCK_SIZE]) {
+	// Local variables.
+	unsigned char idx = 0;
+	for (idx=0 ; idx<AES_BLOCK_SIZE ; idx++) {
+		data_out[idx] = (data_in[idx] ^ init_vector[idx] ^ key[idx]);
+	}
+}
+
+/* TIM21 STAND-IN.
+ * @param:	None.
+ * @return:	None.
+ */
+void TIM21_Init(void) {
+	// Nothing to do.
+}
+
+void TIM21_GetLsiFrequency(unsigned int* lsi_frequency_hz) {
+	(*lsi_frequency_hz) = RCC_LSI_FREQUENCY_HZ;
+}
+
+void TIM21_Disable(void) {
+	// Nothing to do.
+}
+
+/* USART2 STAND-IN (AT INTERFACE IS NOT SIMULATED).
+ * @param:	None.
+ * @return:	None.
+ */
+void USART2_Init(void) {
+	// Nothing to do.
+}
@@ -0,0 +1,338 @@
+/*
+ * sim_radio.c
+ */
+
+#include "sim.h"
+
+#include "gpio.h"
+#include "mapping.h"
+#include "nvic.h"
+#include "rf_api.h"
+#include "s2lp.h"
+#include "s2lp_reg.h"
+#include "spi.h"
+#include "lptim.h"
+#include <stdio.h>
+
+/*** SIM RADIO local macros ***/
+
+#define SIM_RADIO_SPI_BYTE_DURATION_US	8 // 8 bits at 1MHz.
+#define SIM_RADIO_HEADER_BYTE_READ		0x01
+#define SIM_RADIO_HEADER_BYTE_COMMAND	0x80
+#define SIM_RADIO_XO_FREQUENCY_HZ		26000000
+#define SIM_RADIO_REGISTER_NUMBER		256
+
+/*** SIM RADIO local structures ***/
+
+typedef struct {
+	// SPI.
+	unsigned char radio_powered;
+	unsigned char radio_transaction_idx; // Byte index since CS falling edge.
+	unsigned char radio_header;
+	unsigned char radio_address;
+	// S2LP.
+	unsigned char radio_registers[SIM_RADIO_REGISTER_NUMBER];
+	S2LP_State radio_state;
+	unsigned int radio_tx_fifo_count;
+	unsigned char radio_tx_fifo_irq_armed;
+	unsigned long long radio_tx_fifo_update_time_us;
+	// Statistics.
+	unsigned long long radio_tx_start_time_us;
+	unsigned long long radio_rx_start_time_us;
+	unsigned long long radio_tx_time_us;
+	unsigned long long radio_rx_time_us;
+	unsigned int radio_tx_count;
+	unsigned int radio_rx_count;
+} SIM_RADIO_Context;
+
+/*** SIM RADIO local global variables ***/
+
+static SIM_RADIO_Context sim_radio_ctx;
+
+/*** SIM RADIO local functions ***/
+
+/* COMPUTE DURATION OF ONE TX FIFO BYTE.
+ * @param:	None.
+ * @return:	Duration in us (polar mode consumes 16 bytes per data rate period).
+ */
+static unsigned long long SIM_RADIO_GetFifoByteDurationUs(void) {
+	// Local variables.
+	unsigned long long mantissa = (sim_radio_ctx.radio_registers[S2LP_REG_MOD4] << 8) + sim_radio_ctx.radio_registers[S2LP_REG_MOD3];
+	unsigned char exponent = sim_radio_ctx.radio_registers[S2LP_REG_MOD2] & 0x0F;
+	double data_rate = 0.0;
+	// See equation p.28 of S2LP datasheet.
+	if (exponent == 0) {
+		data_rate = ((double) SIM_RADIO_XO_FREQUENCY_HZ * (double) mantissa) / 4294967296.0;
+	}
+	else {
+		data_rate = ((double) SIM_RADIO_XO_FREQUENCY_HZ * (double) (65536 + mantissa) * (double) (1ULL << exponent)) / 8589934592.0;
+	}
+	if (data_rate < 1.0) data_rate = 1.0;
+	return (unsigned long long) (1000000.0 / (16.0 * data_rate));
+}
+
+/* GET PROGRAMMED RF FREQUENCY.
+ * @param:	None.
+ * @return:	RF frequency in Hz.
+ */
+static unsigned int SIM_RADIO_GetRfFrequency(void) {
+	// Local variables.
+	unsigned long long synt = ((sim_radio_ctx.radio_registers[S2LP_REG_SYNT3] & 0x0F) << 24);
+	synt += (sim_radio_ctx.radio_registers[S2LP_REG_SYNT2] << 16);
+	synt += (sim_radio_ctx.radio_registers[S2LP_REG_SYNT1] << 8);
+	synt += (sim_radio_ctx.radio_registers[S2LP_REG_SYNT0] << 0);
+	// fRF = (fXO * SYNT) / 2^21 (high band, REFDIV=0).
+	return (unsigned int) ((synt * SIM_RADIO_XO_FREQUENCY_HZ) >> 21);
+}
+
+/* UPDATE TX FIFO LEVEL ACCORDING TO ELAPSED TIME.
+ * @param:	None.
+ * @return:	None.
+ */
+static void SIM_RADIO_UpdateTxFifo(void) {
+	// Local variables.
+	unsigned long long now_us = SIM_GetTimeUs();
+	unsigned long long byte_duration_us = 0;
+	unsigned long long drained = 0;
+	// FIFO is only consumed in TX state.
+	if ((sim_radio_ctx.radio_state != S2LP_STATE_TX) || (sim_radio_ctx.radio_tx_fifo_count == 0)) {
+		sim_radio_ctx.radio_tx_fifo_update_time_us = now_us;
+		return;
+	}
+	byte_duration_us = SIM_RADIO_GetFifoByteDurationUs();
+	drained = (now_us - sim_radio_ctx.radio_tx_fifo_update_time_us) / byte_duration_us;
+	if (drained >= sim_radio_ctx.radio_tx_fifo_count) {
+		sim_radio_ctx.radio_tx_fifo_count = 0;
+		sim_radio_ctx.radio_tx_fifo_update_time_us = now_us;
+	}
+	else {
+		sim_radio_ctx.radio_tx_fifo_count -= (unsigned int) drained;
+		sim_radio_ctx.radio_tx_fifo_update_time_us += (drained * byte_duration_us);
+	}
+}
+
+/* EXECUTE AN S2LP COMMAND.
+ * @param command:	Command byte.
+ * @return:			None.
+ */
+static void SIM_RADIO_ExecuteCommand(unsigned char command) {
+	// Close current TX or RX period.
+	SIM_RADIO_UpdateTxFifo();
+	if ((sim_radio_ctx.radio_state == S2LP_STATE_TX) && (command != S2LP_CMD_TX)) {
+		sim_radio_ctx.radio_tx_time_us += (SIM_GetTimeUs() - sim_radio_ctx.radio_tx_start_time_us);
+	}
+	if ((sim_radio_ctx.radio_state == S2LP_STATE_RX) && (command != S2LP_CMD_RX)) {
+		sim_radio_ctx.radio_rx_time_us += (SIM_GetTimeUs() - sim_radio_ctx.radio_rx_start_time_us);
+	}
+	// Apply command.
+	switch (command) {
+	case S2LP_CMD_TX:
+		if (sim_radio_ctx.radio_state != S2LP_STATE_TX) {
+			sim_radio_ctx.radio_tx_start_time_us = SIM_GetTimeUs();
+			sim_radio_ctx.radio_tx_count++;
+			SIM_Log("radio: TX on %u Hz", SIM_RADIO_GetRfFrequency());
+		}
+		sim_radio_ctx.radio_state = S2LP_STATE_TX;
+		break;
+	case S2LP_CMD_RX:
+		if (sim_radio_ctx.radio_state != S2LP_STATE_RX) {
+			sim_radio_ctx.radio_rx_start_time_us = SIM_GetTimeUs();
+			sim_radio_ctx.radio_rx_count++;
+			SIM_Log("radio: RX on %u Hz", SIM_RADIO_GetRfFrequency());
+		}
+		sim_radio_ctx.radio_state = S2LP_STATE_RX;
+		break;
+	case S2LP_CMD_READY:
+	case S2LP_CMD_SABORT:
+		sim_radio_ctx.radio_state = S2LP_STATE_READY;
+		break;
+	case S2LP_CMD_STANDBY:
+	case S2LP_CMD_SRES:
+		sim_radio_ctx.radio_state = S2LP_STATE_STANDBY;
+		break;
+	case S2LP_CMD_SLEEP:
+		sim_radio_ctx.radio_state = S2LP_STATE_SLEEP_A;
+		break;
+	case S2LP_CMD_LOCKRX:
+	case S2LP_CMD_LOCKTX:
+		sim_radio_ctx.radio_state = S2LP_STATE_LOCK;
+		break;
+	case S2LP_CMD_FLUSHTXFIFO:
+		sim_radio_ctx.radio_tx_fifo_count = 0;
+		sim_radio_ctx.radio_tx_fifo_irq_armed = 0;
+		break;
+	default:
+		break;
+	}
+	sim_radio_ctx.radio_tx_fifo_update_time_us = SIM_GetTimeUs();
+	// Update supply current.
+	SIM_ENERGY_SetLoad(SIM_ENERGY_LOAD_RADIO_TX, (sim_radio_ctx.radio_state == S2LP_STATE_TX) ? 1 : 0);
+	SIM_ENERGY_SetLoad(SIM_ENERGY_LOAD_RADIO_RX, (sim_radio_ctx.radio_state == S2LP_STATE_RX) ? 1 : 0);
+}
+
+/* HANDLE A BYTE WRITTEN ON SPI BUS.
+ * @param tx_data:	Byte sent by the MCU.
+ * @return:			Byte returned by the S2LP.
+ */
+static unsigned char SIM_RADIO_Transfer(unsigned char tx_data) {
+	// Local variables.
+	unsigned char rx_data = 0;
+	SIM_Consume(SIM_RADIO_SPI_BYTE_DURATION_US);
+	// Ignore bytes sent while the chip is unselected or off.
+	if ((sim_radio_ctx.radio_powered == 0) || (sim_radio_ctx.radio_transaction_idx == 0xFF)) return 0;
+	switch (sim_radio_ctx.radio_transaction_idx) {
+	case 0:
+		sim_radio_ctx.radio_header = tx_data;
+		break;
+	case 1:
+		sim_radio_ctx.radio_address = tx_data;
+		if (sim_radio_ctx.radio_header == SIM_RADIO_HEADER_BYTE_COMMAND) {
+			SIM_RADIO_ExecuteCommand(tx_data);
+		}
+		break;
+	default:
+		if (sim_radio_ctx.radio_header == SIM_RADIO_HEADER_BYTE_READ) {
+			// Read access.
+			if (sim_radio_ctx.radio_address == S2LP_REG_MC_STATE0) {
+				rx_data = (sim_radio_ctx.radio_state << 1) | 0x01; // XO_ON is always set.
+			}
+			else if (sim_radio_ctx.radio_address != S2LP_REG_FIFO) {
+				rx_data = sim_radio_ctx.radio_registers[sim_radio_ctx.radio_address];
+			}
+		}
+		else if (sim_radio_ctx.radio_header != SIM_RADIO_HEADER_BYTE_COMMAND) {
+			// Write access.
+			if (sim_radio_ctx.radio_address == S2LP_REG_FIFO) {
+				SIM_RADIO_UpdateTxFifo();
+				if (sim_radio_ctx.radio_tx_fifo_count < S2LP_FIFO_SIZE_BYTES) {
+					sim_radio_ctx.radio_tx_fifo_count++;
+				}
+				if (sim_radio_ctx.radio_tx_fifo_count > sim_radio_ctx.radio_registers[S2LP_FIFO_THRESHOLD_TX_EMPTY]) {
+					sim_radio_ctx.radio_tx_fifo_irq_armed = 1;
+				}
+			}
+			else {
+				sim_radio_ctx.radio_registers[sim_radio_ctx.radio_address] = tx_data;
+			}
+		}
+		// Address is auto-incremented except for FIFO.
+		if (sim_radio_ctx.radio_address != S2LP_REG_FIFO) {
+			sim_radio_ctx.radio_address++;
+		}
+		break;
+	}
+	if (sim_radio_ctx.radio_transaction_idx < 0xFE) {
+		sim_radio_ctx.radio_transaction_idx++;
+	}
+	return rx_data;
+}
+
+/*** SIM RADIO functions ***/
+
+/* GET TIME OF THE NEXT RADIO EVENT.
+ * @param:	None.
+ * @return:	Absolute time in us (SIM_TIME_NONE if no event is pending).
+ */
+unsigned long long SIM_RADIO_GetNextEventTime(void) {
+	// Local variables.
+	unsigned int threshold = sim_radio_ctx.radio_registers[S2LP_FIFO_THRESHOLD_TX_EMPTY];
+	// FIFO almost empty event.
+	if ((sim_radio_ctx.radio_state != S2LP_STATE_TX) || (sim_radio_ctx.radio_tx_fifo_irq_armed == 0)) return SIM_TIME_NONE;
+	if (sim_radio_ctx.radio_tx_fifo_count <= threshold) return SIM_GetTimeUs();
+	return sim_radio_ctx.radio_tx_fifo_update_time_us + ((sim_radio_ctx.radio_tx_fifo_count - threshold) * SIM_RADIO_GetFifoByteDurationUs());
+}
+
+/* PROCESS RADIO EVENTS DUE AT CURRENT TIME.
+ * @param:	None.
+ * @return:	None.
+ */
+void SIM_RADIO_ProcessEvents(void) {
+	// Update FIFO level.
+	SIM_RADIO_UpdateTxFifo();
+	if ((sim_radio_ctx.radio_state != S2LP_STATE_TX) || (sim_radio_ctx.radio_tx_fifo_irq_armed == 0)) return;
+	if (sim_radio_ctx.radio_tx_fifo_count > sim_radio_ctx.radio_registers[S2LP_FIFO_THRESHOLD_TX_EMPTY]) return;
+	// FIFO almost empty: GPIO0 is connected to EXTI line.
+	sim_radio_ctx.radio_tx_fifo_irq_armed = 0;
+	if (SIM_MCU_IsInterruptEnabled(NVIC_IT_EXTI_4_15) != 0) {
+		RF_API_SetIrqFlag();
+		SIM_SignalInterrupt();
+	}
+}
+
+/* PROCESS RADIO SCENARIO EVENT.
+ * @param keyword:		Event keyword.
+ * @param arguments:	Event arguments.
+ * @return:				1 if the keyword was handled, 0 otherwise.
+ */
+unsigned char SIM_RADIO_ScenarioEvent(char* keyword, char* arguments) {
+	// No downlink model yet.
+	return 0;
+}
+
+/* PRINT RADIO REPORT.
+ * @param:	None.
+ * @return:	None.
+ */
+void SIM_RADIO_PrintReport(void) {
+	printf("RADIO: %u TX (%llu ms), %u RX (%llu ms)\n", sim_radio_ctx.radio_tx_count, (sim_radio_ctx.radio_tx_time_us / 1000), sim_radio_ctx.radio_rx_count, (sim_radio_ctx.radio_rx_time_us / 1000));
+}
+
+/* UPDATE S2LP CHIP SELECT STATE.
+ * @param cs_state:	New CS pin state.
+ * @return:			None.
+ */
+void SIM_RADIO_SetChipSelect(unsigned char cs_state) {
+	// Transaction starts on falling edge.
+	sim_radio_ctx.radio_transaction_idx = (cs_state == 0) ? 0 : 0xFF;
+}
+
+/* SPI1 STAND-IN (BYTES ARE EXCHANGED WITH THE S2LP MODEL).
+ * @param:	None.
+ * @return:	None.
+ */
+void SPI1_Init(void) {
+	sim_radio_ctx.radio_transaction_idx = 0xFF;
+	GPIO_Write(&GPIO_RF_POWER_ENABLE, 0);
+}
+
+void SPI1_Enable(void) {
+	// Nothing to do.
+}
+
+void SPI1_Disable(void) {
+	// Nothing to do.
+}
+
+void SPI1_PowerOn(void) {
+	// Turn S2LP on.
+	GPIO_Write(&GPIO_RF_POWER_ENABLE, 1);
+	SIM_ENERGY_SetLoad(SIM_ENERGY_LOAD_RADIO, 1);
+	sim_radio_ctx.radio_powered = 1;
+	sim_radio_ctx.radio_state = S2LP_STATE_READY;
+	sim_radio_ctx.radio_tx_fifo_count = 0;
+	sim_radio_ctx.radio_tx_fifo_irq_armed = 0;
+	LPTIM1_DelayMilliseconds(50, 1);
+	GPIO_Write(&GPIO_S2LP_CS, 1);
+	LPTIM1_DelayMilliseconds(50, 1);
+}
+
+void SPI1_PowerOff(void) {
+	// Turn S2LP off.
+	GPIO_Write(&GPIO_RF_POWER_ENABLE, 0);
+	SIM_ENERGY_SetLoad(SIM_ENERGY_LOAD_RADIO, 0);
+	SIM_ENERGY_SetLoad(SIM_ENERGY_LOAD_RADIO_TX, 0);
+	SIM_ENERGY_SetLoad(SIM_ENERGY_LOAD_RADIO_RX, 0);
+	sim_radio_ctx.radio_powered = 0;
+	GPIO_Write(&GPIO_S2LP_CS, 0);
+	LPTIM1_DelayMilliseconds(100, 1);
+}
+
+unsigned char SPI1_WriteByte(unsigned char tx_data) {
+	SIM_RADIO_Transfer(tx_data);
+	return 1;
+}
+
+unsigned char SPI1_ReadByte(unsigned char tx_data, unsigned char* rx_data) {
+	(*rx_data) = SIM_RADIO_Transfer(tx_data);
+	return 1;
+}
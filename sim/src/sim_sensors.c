@@ -0,0 +1,524 @@
+/*
+ * sim_sensors.c
+ */
+
+#include "sim.h"
+
+#include "adc.h"
+#include "gpio.h"
+#include "i2c.h"
+#include "lptim.h"
+#include "mapping.h"
+#include "mma8653fc.h"
+#include "mma8653fc_reg.h"
+#include "mode.h"
+#include "nvic.h"
+#include "rtc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*** SIM SENSORS local macros ***/
+
+#define SIM_SENSORS_ADC_CONVERSIONS_US		2000
+#define SIM_SENSORS_I2C_BYTE_STANDARD_US	90
+#define SIM_SENSORS_I2C_BYTE_FAST_US		23
+#define SIM_SENSORS_I2C_POWER_OFF_MIN_MS	100
+#define SIM_SENSORS_I2C_TIMESTAMP_MARGIN_MS	4
+#define SIM_SENSORS_MOVE_PERIOD_S_DEFAULT	10 // Motion interrupts period during a movement.
+
+#define SIM_SHT3X_I2C_ADDRESS				0x44
+#define SIM_SHT3X_COMMAND_SINGLE_SHOT_MSB	0x24
+#define SIM_SHT3X_DATA_LENGTH_BYTES			6
+#define SIM_SHT3X_CRC8_POLYNOMIAL			0x31
+#define SIM_SHT3X_CRC8_INIT_VALUE			0xFF
+
+#define SIM_MMA8653FC_I2C_ADDRESS			0x1D
+#define SIM_MMA8653FC_WHO_AM_I				0x5A
+#define SIM_MMA8653FC_REGISTERS_NUMBER		0x32
+
+/*** SIM SENSORS local structures ***/
+
+typedef struct {
+	// ADC (source and supercap voltages are given by the energy model).
+	unsigned int adc_mcu_voltage_mv;
+	signed char adc_mcu_temperature_degrees;
+	unsigned char adc_watchdog_running;
+	unsigned int adc_watchdog_threshold_mv;
+	volatile unsigned char adc_watchdog_flag;
+	unsigned int adc_conversion_count;
+	// I2C.
+	I2C_Speed i2c_speed;
+	unsigned char i2c_power_users;
+	unsigned char i2c_power_off_valid;
+	unsigned int i2c_power_on_timestamp_ms;
+	unsigned int i2c_power_off_timestamp_ms;
+	unsigned int i2c_transfer_count;
+	unsigned int i2c_nack_count;
+	// SHT3x.
+	signed int sht3x_temperature_centidegrees;
+	unsigned int sht3x_humidity_centipercent;
+	unsigned char sht3x_conversion_running;
+	unsigned long long sht3x_conversion_end_us;
+	unsigned int sht3x_measurement_count;
+	// MMA8653FC.
+	unsigned char mma8653fc_registers[SIM_MMA8653FC_REGISTERS_NUMBER];
+	unsigned char mma8653fc_register_pointer;
+	signed short mma8653fc_data[3];
+	unsigned long long mma8653fc_move_next_us;
+	unsigned long long mma8653fc_move_end_us;
+	unsigned long long mma8653fc_move_period_us;
+	unsigned int mma8653fc_motion_count;
+	unsigned int mma8653fc_masked_count;
+} SIM_SENSORS_Context;
+
+/*** SIM SENSORS local global variables ***/
+
+static SIM_SENSORS_Context sim_sensors_ctx = {
+	3000, 20, 0, 0, 0, 0,
+	I2C_SPEED_STANDARD_100KHZ, 0, 0, 0, 0, 0, 0,
+	2000, 5000, 0, 0, 0,
+	{0}, 0, {0, 0, 256}, SIM_TIME_NONE, 0, 0, 0, 0
+};
+
+/*** SIM SENSORS local functions ***/
+
+/* CONSUME I2C BUS TIME.
+ * @param byte_count:	Number of bytes transferred (address included).
+ * @return:				None.
+ */
+static void SIM_SENSORS_ConsumeI2c(unsigned char byte_count) {
+	SIM_Consume(byte_count * ((sim_sensors_ctx.i2c_speed == I2C_SPEED_FAST_400KHZ) ? SIM_SENSORS_I2C_BYTE_FAST_US : SIM_SENSORS_I2C_BYTE_STANDARD_US));
+}
+
+/* COMPUTE SHT3X CRC8.
+ * @param data:	Pointer to the 2 bytes to protect.
+ * @return crc:	Computed CRC.
+ */
+static unsigned char SIM_SHT3X_ComputeCrc8(unsigned char* data) {
+	// Local variables.
+	unsigned char crc = SIM_SHT3X_CRC8_INIT_VALUE;
+	unsigned char byte_idx = 0;
+	unsigned char bit_idx = 0;
+	for (byte_idx=0 ; byte_idx<2 ; byte_idx++) {
+		crc ^= data[byte_idx];
+		for (bit_idx=0 ; bit_idx<8 ; bit_idx++) {
+			crc = ((crc & 0x80) != 0) ? ((crc << 1) ^ SIM_SHT3X_CRC8_POLYNOMIAL) : (crc << 1);
+		}
+	}
+	return crc;
+}
+
+/* SHT3X WRITE TRANSFER.
+ * @param tx_buf:			Bytes sent by the master.
+ * @param tx_buf_length:	Number of bytes.
+ * @return:					1 if the transfer was acknowledged, 0 otherwise.
+ */
+static unsigned char SIM_SHT3X_Write(unsigned char* tx_buf, unsigned char tx_buf_length) {
+	// Local variables.
+	unsigned int conversion_time_us = 13000;
+	// Only single shot measurement commands are supported.
+	if ((tx_buf_length != 2) || (tx_buf[0] != SIM_SHT3X_COMMAND_SINGLE_SHOT_MSB)) return 0;
+	if (sim_sensors_ctx.sht3x_conversion_running != 0) return 0;
+	// Typical conversion time depends on repeatability.
+	if (tx_buf[1] == 0x16) conversion_time_us = 3000;
+	if (tx_buf[1] == 0x0B) conversion_time_us = 5000;
+	sim_sensors_ctx.sht3x_conversion_end_us = SIM_GetTimeUs() + conversion_time_us;
+	sim_sensors_ctx.sht3x_conversion_running = 1;
+	return 1;
+}
+
+/* SHT3X READ TRANSFER.
+ * @param rx_buf:			Bytes returned to the master.
+ * @param rx_buf_length:	Number of bytes.
+ * @return:					1 if the transfer was acknowledged, 0 otherwise.
+ */
+static unsigned char SIM_SHT3X_Read(unsigned char* rx_buf, unsigned char rx_buf_length) {
+	// Local variables.
+	unsigned char data[SIM_SHT3X_DATA_LENGTH_BYTES];
+	unsigned int raw = 0;
+	unsigned char idx = 0;
+	// Read header is not acknowledged while conversion is running.
+	if ((sim_sensors_ctx.sht3x_conversion_running == 0) || (SIM_GetTimeUs() < sim_sensors_ctx.sht3x_conversion_end_us)) return 0;
+	sim_sensors_ctx.sht3x_conversion_running = 0;
+	sim_sensors_ctx.sht3x_measurement_count++;
+	// Temperature: raw = (T + 45) * (2^(16)-1) / 175.
+	raw = (unsigned int) ((((signed long long) sim_sensors_ctx.sht3x_temperature_centidegrees + 4500) * 65535) / 17500);
+	data[0] = (raw >> 8) & 0xFF;
+	data[1] = (raw & 0xFF);
+	data[2] = SIM_SHT3X_ComputeCrc8(&(data[0]));
+	// Humidity: raw = RH * (2^(16)-1) / 100.
+	raw = (unsigned int) (((unsigned long long) sim_sensors_ctx.sht3x_humidity_centipercent * 65535) / 10000);
+	data[3] = (raw >> 8) & 0xFF;
+	data[4] = (raw & 0xFF);
+	data[5] = SIM_SHT3X_ComputeCrc8(&(data[3]));
+	for (idx=0 ; (idx<rx_buf_length) && (idx<SIM_SHT3X_DATA_LENGTH_BYTES) ; idx++) {
+		rx_buf[idx] = data[idx];
+	}
+	return 1;
+}
+
+/* UPDATE MMA8653FC OUTPUT REGISTERS FROM MODEL DATA.
+ * @param:	None.
+ * @return:	None.
+ */
+static void SIM_MMA8653FC_UpdateOutputs(void) {
+	// Local variables.
+	unsigned char axis = 0;
+	unsigned short raw = 0;
+	// 10-bits left justified values.
+	for (axis=0 ; axis<3 ; axis++) {
+		raw = ((unsigned short) sim_sensors_ctx.mma8653fc_data[axis]) & 0x3FF;
+		sim_sensors_ctx.mma8653fc_registers[MMA8653FC_REG_OUT_X_MSB + (2 * axis)] = (raw >> 2);
+		sim_sensors_ctx.mma8653fc_registers[MMA8653FC_REG_OUT_X_LSB + (2 * axis)] = ((raw & 0x03) << 6);
+	}
+	sim_sensors_ctx.mma8653fc_registers[MMA8653FC_REG_WHO_AM_I] = SIM_MMA8653FC_WHO_AM_I;
+}
+
+/* MMA8653FC REGISTER POINTER AUTO-INCREMENT.
+ * @param:	None.
+ * @return:	None.
+ */
+static void SIM_MMA8653FC_IncrementPointer(void) {
+	// Fast read mode skips LSB registers.
+	if (((sim_sensors_ctx.mma8653fc_registers[MMA8653FC_REG_CTRL_REG1] & (0b1 << 1)) != 0) && (sim_sensors_ctx.mma8653fc_register_pointer >= MMA8653FC_REG_OUT_X_MSB) && (sim_sensors_ctx.mma8653fc_register_pointer < MMA8653FC_REG_OUT_Z_MSB)) {
+		sim_sensors_ctx.mma8653fc_register_pointer += 2;
+	}
+	else {
+		sim_sensors_ctx.mma8653fc_register_pointer++;
+	}
+	if (sim_sensors_ctx.mma8653fc_register_pointer >= SIM_MMA8653FC_REGISTERS_NUMBER) {
+		sim_sensors_ctx.mma8653fc_register_pointer = 0;
+	}
+}
+
+/* MMA8653FC WRITE TRANSFER (REGISTER ADDRESS FOLLOWED BY DATA).
+ * @param tx_buf:			Bytes sent by the master.
+ * @param tx_buf_length:	Number of bytes.
+ * @return:					1.
+ */
+static unsigned char SIM_MMA8653FC_Write(unsigned char* tx_buf, unsigned char tx_buf_length) {
+	// Local variables.
+	unsigned char idx = 0;
+	if (tx_buf_length == 0) return 1;
+	sim_sensors_ctx.mma8653fc_register_pointer = (tx_buf[0] % SIM_MMA8653FC_REGISTERS_NUMBER);
+	for (idx=1 ; idx<tx_buf_length ; idx++) {
+		sim_sensors_ctx.mma8653fc_registers[sim_sensors_ctx.mma8653fc_register_pointer] = tx_buf[idx];
+		SIM_MMA8653FC_IncrementPointer();
+	}
+	return 1;
+}
+
+/* MMA8653FC READ TRANSFER (FROM CURRENT REGISTER POINTER).
+ * @param rx_buf:			Bytes returned to the master.
+ * @param rx_buf_length:	Number of bytes.
+ * @return:					1.
+ */
+static unsigned char SIM_MMA8653FC_Read(unsigned char* rx_buf, unsigned char rx_buf_length) {
+	// Local variables.
+	unsigned char idx = 0;
+	SIM_MMA8653FC_UpdateOutputs();
+	for (idx=0 ; idx<rx_buf_length ; idx++) {
+		rx_buf[idx] = sim_sensors_ctx.mma8653fc_registers[sim_sensors_ctx.mma8653fc_register_pointer];
+		SIM_MMA8653FC_IncrementPointer();
+	}
+	return 1;
+}
+
+/* RAISE MMA8653FC MOTION INTERRUPT IF ENABLED.
+ * @param:	None.
+ * @return:	None.
+ */
+static void SIM_MMA8653FC_Motion(void) {
+	// A start alarm is expected if the tracker is known as stopped.
+	SIM_SIGFOX_ExpectStartAlarm();
+	// Check supply, sensor configuration and EXTI line.
+	if ((SIM_ENERGY_IsBrownOut() != 0) ||
+		((sim_sensors_ctx.mma8653fc_registers[MMA8653FC_REG_CTRL_REG1] & (0b1 << 0)) == 0) || // ACTIVE='0'.
+		((sim_sensors_ctx.mma8653fc_registers[MMA8653FC_REG_CTRL_REG4] & (0b1 << 2)) == 0) || // INT_EN_FF_MT='0'.
+		(SIM_MCU_IsInterruptEnabled(NVIC_IT_EXTI_0_1) == 0)) {
+		sim_sensors_ctx.mma8653fc_masked_count++;
+		return;
+	}
+	sim_sensors_ctx.mma8653fc_motion_count++;
+#ifdef SSM
+	MMA8653FC_SetMotionInterruptFlag();
+#endif
+	SIM_SignalInterrupt();
+}
+
+/*** SIM SENSORS functions ***/
+
+/* GET TIME OF THE NEXT SENSORS EVENT.
+ * @param:	None.
+ * @return:	Absolute time in us (SIM_TIME_NONE if no event is pending).
+ */
+unsigned long long SIM_SENSORS_GetNextEventTime(void) {
+	// Supercap watchdog triggers as soon as voltage is below threshold.
+	if ((sim_sensors_ctx.adc_watchdog_running != 0) && (sim_sensors_ctx.adc_watchdog_flag == 0) && (SIM_ENERGY_GetSupercapVoltage() < sim_sensors_ctx.adc_watchdog_threshold_mv) && (SIM_MCU_IsInterruptEnabled(NVIC_IT_ADC_COMP) != 0)) {
+		return SIM_GetTimeUs();
+	}
+	// Next motion interrupt of the current movement.
+	return sim_sensors_ctx.mma8653fc_move_next_us;
+}
+
+/* PROCESS SENSORS EVENTS DUE AT CURRENT TIME.
+ * @param:	None.
+ * @return:	None.
+ */
+void SIM_SENSORS_ProcessEvents(void) {
+	// Supercap watchdog.
+	if ((sim_sensors_ctx.adc_watchdog_running != 0) && (sim_sensors_ctx.adc_watchdog_flag == 0) && (SIM_ENERGY_GetSupercapVoltage() < sim_sensors_ctx.adc_watchdog_threshold_mv) && (SIM_MCU_IsInterruptEnabled(NVIC_IT_ADC_COMP) != 0)) {
+		SIM_Log("adc: supercap voltage %umV below %umV", SIM_ENERGY_GetSupercapVoltage(), sim_sensors_ctx.adc_watchdog_threshold_mv);
+		sim_sensors_ctx.adc_watchdog_flag = 1;
+		SIM_SignalInterrupt();
+	}
+	// Movement.
+	if (sim_sensors_ctx.mma8653fc_move_next_us <= SIM_GetTimeUs()) {
+		SIM_MMA8653FC_Motion();
+		sim_sensors_ctx.mma8653fc_move_next_us += sim_sensors_ctx.mma8653fc_move_period_us;
+		if (sim_sensors_ctx.mma8653fc_move_next_us > sim_sensors_ctx.mma8653fc_move_end_us) {
+			sim_sensors_ctx.mma8653fc_move_next_us = SIM_TIME_NONE;
+		}
+	}
+}
+
+/* PROCESS SENSORS SCENARIO EVENT.
+ * @param keyword:		Event keyword.
+ * @param arguments:	Event arguments.
+ * @return:				1 if the keyword was handled, 0 otherwise.
+ */
+unsigned char SIM_SENSORS_ScenarioEvent(char* keyword, char* arguments) {
+	// Local variables.
+	double value = atof(arguments);
+	double duration_seconds = 0.0;
+	double period_seconds = SIM_SENSORS_MOVE_PERIOD_S_DEFAULT;
+	int x = 0;
+	int y = 0;
+	int z = 0;
+	// Parse keyword.
+	if (strcmp(keyword, "motion") == 0) {
+		SIM_MMA8653FC_Motion();
+	}
+	else if (strcmp(keyword, "move") == 0) {
+		// Periodic motion interrupts until the end of the movement.
+		if ((sscanf(arguments, "%lf %lf", &duration_seconds, &period_seconds) < 1) || (period_seconds <= 0.0)) return 0;
+		sim_sensors_ctx.mma8653fc_move_period_us = (unsigned long long) (period_seconds * 1000000.0);
+		sim_sensors_ctx.mma8653fc_move_end_us = SIM_GetTimeUs() + (unsigned long long) (duration_seconds * 1000000.0);
+		sim_sensors_ctx.mma8653fc_move_next_us = SIM_GetTimeUs();
+	}
+	else if (strcmp(keyword, "accel") == 0) {
+		if (sscanf(arguments, "%d %d %d", &x, &y, &z) != 3) return 0;
+		sim_sensors_ctx.mma8653fc_data[0] = x;
+		sim_sensors_ctx.mma8653fc_data[1] = y;
+		sim_sensors_ctx.mma8653fc_data[2] = z;
+	}
+	else if (strcmp(keyword, "vmcu") == 0) {
+		sim_sensors_ctx.adc_mcu_voltage_mv = (unsigned int) value;
+	}
+	else if (strcmp(keyword, "tmcu") == 0) {
+		sim_sensors_ctx.adc_mcu_temperature_degrees = (signed char) value;
+	}
+	else if (strcmp(keyword, "temperature") == 0) {
+		sim_sensors_ctx.sht3x_temperature_centidegrees = (signed int) (value * 100.0);
+	}
+	else if (strcmp(keyword, "humidity") == 0) {
+		sim_sensors_ctx.sht3x_humidity_centipercent = (unsigned int) (value * 100.0);
+	}
+	else {
+		return 0;
+	}
+	return 1;
+}
+
+/* PRINT SENSORS REPORT.
+ * @param:	None.
+ * @return:	None.
+ */
+void SIM_SENSORS_PrintReport(void) {
+	printf("ADC conversions: %u\n", sim_sensors_ctx.adc_conversion_count);
+	printf("I2C transfers: %u (%u not acknowledged)\n", sim_sensors_ctx.i2c_transfer_count, sim_sensors_ctx.i2c_nack_count);
+	printf("SHT3x measurements: %u\n", sim_sensors_ctx.sht3x_measurement_count);
+	printf("MMA8653FC motion interrupts: %u (%u masked)\n", sim_sensors_ctx.mma8653fc_motion_count, sim_sensors_ctx.mma8653fc_masked_count);
+}
+
+/* ADC1 STAND-IN (VALUES ARE SET BY SCENARIO AND ENERGY MODEL).
+ * @param:	None.
+ * @return:	None.
+ */
+void ADC1_Init(void) {
+	// Nothing to do.
+}
+
+void ADC1_Disable(void) {
+	// Nothing to do.
+}
+
+void ADC1_PowerOn(void) {
+	GPIO_Write(&GPIO_ADC_POWER_ENABLE, 1);
+}
+
+void ADC1_PowerOff(void) {
+	GPIO_Write(&GPIO_ADC_POWER_ENABLE, 0);
+}
+
+void ADC1_PerformAllMeasurements(void) {
+	sim_sensors_ctx.adc_conversion_count++;
+	SIM_Consume(SIM_SENSORS_ADC_CONVERSIONS_US);
+}
+
+void ADC1_PerformSupercapMeasurement(void) {
+	sim_sensors_ctx.adc_conversion_count++;
+	SIM_Consume(SIM_SENSORS_ADC_CONVERSIONS_US / 4);
+}
+
+void ADC1_StartSupercapWatchdog(unsigned int supercap_voltage_min_mv) {
+	sim_sensors_ctx.adc_watchdog_flag = 0;
+	sim_sensors_ctx.adc_watchdog_threshold_mv = supercap_voltage_min_mv;
+	sim_sensors_ctx.adc_watchdog_running = 1;
+	NVIC_EnableInterrupt(NVIC_IT_ADC_COMP);
+}
+
+void ADC1_StopSupercapWatchdog(void) {
+	NVIC_DisableInterrupt(NVIC_IT_ADC_COMP);
+	sim_sensors_ctx.adc_watchdog_running = 0;
+	sim_sensors_ctx.adc_watchdog_flag = 0;
+}
+
+unsigned char ADC1_GetSupercapWatchdogFlag(void) {
+	return sim_sensors_ctx.adc_watchdog_flag;
+}
+
+void ADC1_GetSourceVoltage(unsigned int* source_voltage_mv) {
+	(*source_voltage_mv) = SIM_ENERGY_GetSourceVoltage();
+}
+
+void ADC1_GetSupercapVoltage(unsigned int* supercap_voltage_mv) {
+	(*supercap_voltage_mv) = SIM_ENERGY_GetSupercapVoltage();
+}
+
+void ADC1_GetMcuVoltage(unsigned int* mcu_voltage_mv) {
+	(*mcu_voltage_mv) = sim_sensors_ctx.adc_mcu_voltage_mv;
+}
+
+void ADC1_GetMcuTemperatureComp2(signed char* mcu_temperature_degrees) {
+	(*mcu_temperature_degrees) = sim_sensors_ctx.adc_mcu_temperature_degrees;
+}
+
+void ADC1_GetMcuTemperatureComp1(unsigned char* mcu_temperature_degrees) {
+	// Convert to 1-complement value.
+	if (sim_sensors_ctx.adc_mcu_temperature_degrees < 0) {
+		(*mcu_temperature_degrees) = 0x80 | (((-1) * sim_sensors_ctx.adc_mcu_temperature_degrees) & 0x7F);
+	}
+	else {
+		(*mcu_temperature_degrees) = (sim_sensors_ctx.adc_mcu_temperature_degrees & 0x7F);
+	}
+}
+
+/* I2C1 STAND-IN (TRANSFERS ARE ROUTED TO THE SENSORS MODELS BY SLAVE ADDRESS).
+ * @param:	None.
+ * @return:	None.
+ */
+void I2C1_Init(void) {
+	sim_sensors_ctx.i2c_speed = I2C_SPEED_STANDARD_100KHZ;
+}
+
+void I2C1_SetSpeed(I2C_Speed speed) {
+	if (speed < I2C_SPEED_LAST) {
+		sim_sensors_ctx.i2c_speed = speed;
+	}
+}
+
+void I2C1_Disable(void) {
+	// Nothing to do.
+}
+
+void I2C1_PowerOn(void) {
+	// Local variables.
+	unsigned int timestamp_ms = 0;
+	unsigned int power_off_duration_ms = 0;
+	// Check if rail is already on.
+	sim_sensors_ctx.i2c_power_users++;
+	if (sim_sensors_ctx.i2c_power_users > 1) return;
+	// Ensure slaves were switched off long enough to be properly reset.
+	if (sim_sensors_ctx.i2c_power_off_valid != 0) {
+		RTC_GetTimestampMilliseconds(&timestamp_ms);
+		power_off_duration_ms = (timestamp_ms - sim_sensors_ctx.i2c_power_off_timestamp_ms);
+		if (power_off_duration_ms < SIM_SENSORS_I2C_POWER_OFF_MIN_MS) {
+			LPTIM1_DelayMilliseconds((SIM_SENSORS_I2C_POWER_OFF_MIN_MS - power_off_duration_ms), 1);
+		}
+	}
+	GPIO_Write(&GPIO_SENSORS_POWER_ENABLE, 1);
+	SIM_ENERGY_SetLoad(SIM_ENERGY_LOAD_SENSORS, 1);
+	RTC_GetTimestampMilliseconds(&sim_sensors_ctx.i2c_power_on_timestamp_ms);
+}
+
+void I2C1_PowerOff(void) {
+	// Check if rail is still used.
+	if (sim_sensors_ctx.i2c_power_users > 0) {
+		sim_sensors_ctx.i2c_power_users--;
+	}
+	if (sim_sensors_ctx.i2c_power_users > 0) return;
+	GPIO_Write(&GPIO_SENSORS_POWER_ENABLE, 0);
+	SIM_ENERGY_SetLoad(SIM_ENERGY_LOAD_SENSORS, 0);
+	// SHT3x is reset.
+	sim_sensors_ctx.sht3x_conversion_running = 0;
+	RTC_GetTimestampMilliseconds(&sim_sensors_ctx.i2c_power_off_timestamp_ms);
+	sim_sensors_ctx.i2c_power_off_valid = 1;
+}
+
+void I2C1_WaitSlaveReady(unsigned int startup_time_ms) {
+	// Local variables.
+	unsigned int timestamp_ms = 0;
+	unsigned int power_on_duration_ms = 0;
+	// Check rail state.
+	if (sim_sensors_ctx.i2c_power_users == 0) return;
+	// Compute remaining time.
+	RTC_GetTimestampMilliseconds(&timestamp_ms);
+	power_on_duration_ms = (timestamp_ms - sim_sensors_ctx.i2c_power_on_timestamp_ms);
+	if (power_on_duration_ms < (startup_time_ms + SIM_SENSORS_I2C_TIMESTAMP_MARGIN_MS)) {
+		LPTIM1_DelayMilliseconds((startup_time_ms + SIM_SENSORS_I2C_TIMESTAMP_MARGIN_MS - power_on_duration_ms), 1);
+	}
+}
+
+unsigned char I2C1_Write(unsigned char slave_address, unsigned char* tx_buf, unsigned char tx_buf_length, unsigned char stop_flag) {
+	// Local variables.
+	unsigned char ack = 0;
+	// Route transfer.
+	sim_sensors_ctx.i2c_transfer_count++;
+	SIM_SENSORS_ConsumeI2c(1 + tx_buf_length);
+	if ((slave_address == SIM_SHT3X_I2C_ADDRESS) && (sim_sensors_ctx.i2c_power_users != 0)) {
+		ack = SIM_SHT3X_Write(tx_buf, tx_buf_length);
+	}
+	if (slave_address == SIM_MMA8653FC_I2C_ADDRESS) {
+		ack = SIM_MMA8653FC_Write(tx_buf, tx_buf_length);
+	}
+	if (ack == 0) {
+		sim_sensors_ctx.i2c_nack_count++;
+	}
+	return ack;
+}
+
+unsigned char I2C1_Read(unsigned char slave_address, unsigned char* rx_buf, unsigned char rx_buf_length) {
+	// Local variables.
+	unsigned char ack = 0;
+	// Route transfer.
+	sim_sensors_ctx.i2c_transfer_count++;
+	if ((slave_address == SIM_SHT3X_I2C_ADDRESS) && (sim_sensors_ctx.i2c_power_users != 0)) {
+		ack = SIM_SHT3X_Read(rx_buf, rx_buf_length);
+	}
+	if (slave_address == SIM_MMA8653FC_I2C_ADDRESS) {
+		ack = SIM_MMA8653FC_Read(rx_buf, rx_buf_length);
+	}
+	// Address only if not acknowledged.
+	SIM_SENSORS_ConsumeI2c((ack != 0) ? (1 + rx_buf_length) : 1);
+	if (ack == 0) {
+		sim_sensors_ctx.i2c_nack_count++;
+	}
+	return ack;
+}
+
+unsigned char I2C1_WriteRead(unsigned char slave_address, unsigned char* tx_buf, unsigned char tx_buf_length, unsigned char* rx_buf, unsigned char rx_buf_length) {
+	if (I2C1_Write(slave_address, tx_buf, tx_buf_length, 0) == 0) return 0;
+	return I2C1_Read(slave_address, rx_buf, rx_buf_length);
+}
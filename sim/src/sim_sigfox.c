@@ -0,0 +1,360 @@
+/*
+ * sim_sigfox.c
+ */
+
+#include "sim.h"
+
+#include "addon_sigfox_rf_protocol_api.h"
+#include "mcu_api.h"
+#include "rf_api.h"
+#include "sigfox_api.h"
+#include "sigfox_types.h"
+#include <stdio.h>
+#include <string.h>
+
+/*** SIM SIGFOX local macros ***/
+
+// The Sigfox library is only available as a Cortex-M0+ archive: this stub reproduces its calls to the MCU and RF APIs.
+#define SIM_SIGFOX_UPLINK_PAYLOAD_LENGTH_MAX	12
+#define SIM_SIGFOX_UPLINK_FRAME_LENGTH_MAX		(14 + SIM_SIGFOX_UPLINK_PAYLOAD_LENGTH_MAX) // Preamble, frame type, sequence, ID, payload, MAC and CRC.
+#define SIM_SIGFOX_UPLINK_REPETITIONS			3
+#define SIM_SIGFOX_DOWNLINK_DELAY_SECONDS		20
+#define SIM_SIGFOX_DOWNLINK_PAYLOAD_LENGTH		8
+#define SIM_SIGFOX_OOB_PAYLOAD_LENGTH			8
+#define SIM_SIGFOX_AES_BLOCK_SIZE				16
+#define SIM_SIGFOX_MONITORING_LENGTH_MIN		8 // Monitoring frame is 8 or 9 bytes long, status byte is the 8th one.
+#define SIM_SIGFOX_MONITORING_LENGTH_MAX		9
+#define SIM_SIGFOX_MONITORING_STATUS_BYTE_IDX	7
+#define SIM_SIGFOX_STATUS_ALARM_FLAG			0x04
+#define SIM_SIGFOX_STATUS_MOVING_FLAG			0x08
+#define SIM_SIGFOX_ALARM_TIMEOUT_SECONDS		600 // Start alarm received later than this delay is considered missed.
+
+/*** SIM SIGFOX local structures ***/
+
+typedef struct {
+	unsigned char sigfox_opened;
+	sfx_rc_t sigfox_rc;
+	unsigned char sigfox_channel_idx;
+	// Statistics.
+	unsigned int sigfox_message_count;
+	unsigned int sigfox_frame_count;
+	unsigned int sigfox_downlink_count;
+	unsigned int sigfox_error_count;
+	// Alarms.
+	unsigned char sigfox_moving_reported;
+	unsigned long long sigfox_alarm_expected_time_us;
+	unsigned int sigfox_alarm_expected_count;
+	unsigned int sigfox_alarm_reported_count;
+	unsigned int sigfox_alarm_missed_count;
+	unsigned long long sigfox_alarm_latency_sum_us;
+	unsigned long long sigfox_alarm_latency_max_us;
+} SIM_SIGFOX_Context;
+
+/*** SIM SIGFOX local global variables ***/
+
+static SIM_SIGFOX_Context sim_sigfox_ctx = {0, {0}, 0, 0, 0, 0, 0, 0, SIM_TIME_NONE, 0, 0, 0, 0, 0};
+static sfx_u8 sim_sigfox_version[] = "SIM";
+
+/*** SIM SIGFOX local functions ***/
+
+/* COMPUTE CRC16 OF A FRAME.
+ * @param data:		Bytes to protect.
+ * @param length:	Number of bytes.
+ * @return:			CRC16 (CCITT polynomial).
+ */
+static unsigned short SIM_SIGFOX_ComputeCrc16(unsigned char* data, unsigned char length) {
+	// Local variables.
+	unsigned short crc = 0xFFFF;
+	unsigned char byte_idx = 0;
+	unsigned char bit_idx = 0;
+	// Compute CRC.
+	for (byte_idx=0 ; byte_idx<length ; byte_idx++) {
+		crc ^= (data[byte_idx] << 8);
+		for (bit_idx=0 ; bit_idx<8 ; bit_idx++) {
+			crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+		}
+	}
+	return (crc ^ 0xFFFF);
+}
+
+/* SEND A SIGFOX MESSAGE (UPLINK REPETITIONS AND OPTIONAL DOWNLINK WINDOW).
+ * @param payload:			Uplink payload.
+ * @param payload_length:	Payload length in bytes.
+ * @param downlink_data:	Buffer that will contain the downlink payload (may be null).
+ * @param downlink_flag:	Request a downlink if non zero.
+ * @return sfx_error:		Library error code.
+ */
+static sfx_error_t SIM_SIGFOX_SendMessage(sfx_u8* payload, sfx_u8 payload_length, sfx_u8* downlink_data, sfx_bool downlink_flag) {
+	// Local variables.
+	sfx_u8 nv_mem[SFX_NVMEM_BLOCK_SIZE];
+	sfx_u8 device_id[ID_LENGTH];
+	sfx_bool payload_encryption = SFX_FALSE;
+	sfx_u8 aes_input[SIM_SIGFOX_AES_BLOCK_SIZE];
+	sfx_u8 aes_output[SIM_SIGFOX_AES_BLOCK_SIZE];
+	sfx_u8 frame[SIM_SIGFOX_UPLINK_FRAME_LENGTH_MAX];
+	sfx_u8 frame_length = 0;
+	sfx_u8 frame_idx = 0;
+	sfx_u8 downlink_frame[15];
+	sfx_s16 rssi = 0;
+	sfx_rx_state_enum_t rx_state = DL_TIMEOUT;
+	unsigned short sequence_number = 0;
+	unsigned short crc = 0;
+	// Check state and parameters.
+	if (sim_sigfox_ctx.sigfox_opened == 0) return SFX_ERR_API_SEND_FRAME_DATA_LENGTH;
+	if (payload_length > SIM_SIGFOX_UPLINK_PAYLOAD_LENGTH_MAX) return SFX_ERR_API_SEND_FRAME_DATA_LENGTH;
+	if ((downlink_flag != SFX_FALSE) && (downlink_data == 0)) return SFX_ERR_API_SEND_FRAME_RESPONSE_PTR;
+	// Update sequence number in NVM.
+	MCU_API_get_nv_mem(nv_mem);
+	sequence_number = (nv_mem[SFX_NVMEM_MSG_COUNTER] + (nv_mem[SFX_NVMEM_MSG_COUNTER + 1] << 8) + 1) & 0x0FFF;
+	nv_mem[SFX_NVMEM_MSG_COUNTER] = (sequence_number >> 0) & 0xFF;
+	nv_mem[SFX_NVMEM_MSG_COUNTER + 1] = (sequence_number >> 8) & 0xFF;
+	MCU_API_set_nv_mem(nv_mem);
+	MCU_API_get_device_id_and_payload_encryption_flag(device_id, &payload_encryption);
+	// Build frame.
+	frame[frame_length++] = 0xAA;
+	frame[frame_length++] = 0xAA;
+	frame[frame_length++] = 0xA0 | (downlink_flag ? 0x0A : 0x06); // Frame type.
+	frame[frame_length++] = 0x6B;
+	frame[frame_length++] = (sequence_number >> 8) & 0x0F;
+	frame[frame_length++] = (sequence_number >> 0) & 0xFF;
+	memcpy(&(frame[frame_length]), device_id, ID_LENGTH);
+	frame_length += ID_LENGTH;
+	memcpy(&(frame[frame_length]), payload, payload_length);
+	frame_length += payload_length;
+	// Authentication code.
+	memset(aes_input, 0, SIM_SIGFOX_AES_BLOCK_SIZE);
+	memcpy(aes_input, &(frame[4]), (frame_length - 4));
+	MCU_API_aes_128_cbc_encrypt(aes_output, aes_input, SIM_SIGFOX_AES_BLOCK_SIZE, 0, CREDENTIALS_PRIVATE_KEY);
+	frame[frame_length++] = aes_output[0];
+	frame[frame_length++] = aes_output[1];
+	crc = SIM_SIGFOX_ComputeCrc16(&(frame[4]), (frame_length - 4));
+	frame[frame_length++] = (crc >> 8) & 0xFF;
+	frame[frame_length++] = (crc >> 0) & 0xFF;
+	sim_sigfox_ctx.sigfox_message_count++;
+	SIM_Log("sigfox: message %u (%u bytes payload, downlink=%u)", sequence_number, payload_length, downlink_flag);
+	// Start downlink timer.
+	if (downlink_flag != SFX_FALSE) {
+		MCU_API_timer_start(SIM_SIGFOX_DOWNLINK_DELAY_SECONDS);
+	}
+	// Uplink repetitions on 3 different channels.
+	for (frame_idx=0 ; frame_idx<SIM_SIGFOX_UPLINK_REPETITIONS ; frame_idx++) {
+		sim_sigfox_ctx.sigfox_channel_idx = (sim_sigfox_ctx.sigfox_channel_idx + 7) % 48;
+		RF_API_init(SFX_RF_MODE_TX);
+		RF_API_change_frequency(sim_sigfox_ctx.sigfox_rc.open_tx_frequency - (sim_sigfox_ctx.sigfox_rc.macro_channel_width / 2) + (sim_sigfox_ctx.sigfox_channel_idx * 4000) + 2000);
+		RF_API_send(frame, sim_sigfox_ctx.sigfox_rc.modulation, frame_length);
+		RF_API_stop();
+		sim_sigfox_ctx.sigfox_frame_count++;
+		if (frame_idx < (SIM_SIGFOX_UPLINK_REPETITIONS - 1)) {
+			MCU_API_delay((downlink_flag != SFX_FALSE) ? SFX_DLY_INTER_FRAME_TRX : SFX_DLY_INTER_FRAME_TX);
+		}
+	}
+	if (downlink_flag == SFX_FALSE) return SFX_ERR_NONE;
+	// Downlink window.
+	MCU_API_timer_wait_for_end();
+	RF_API_init(SFX_RF_MODE_RX);
+	RF_API_change_frequency(sim_sigfox_ctx.sigfox_rc.open_rx_frequency);
+	RF_API_wait_frame(downlink_frame, &rssi, &rx_state);
+	RF_API_stop();
+	MCU_API_timer_stop();
+	if (rx_state != DL_PASSED) {
+		SIM_Log("sigfox: downlink timeout");
+		sim_sigfox_ctx.sigfox_error_count++;
+		return SFX_ERR_INT_GET_RECEIVED_FRAMES_TIMEOUT;
+	}
+	memcpy(downlink_data, downlink_frame, SIM_SIGFOX_DOWNLINK_PAYLOAD_LENGTH);
+	sim_sigfox_ctx.sigfox_downlink_count++;
+	// Out of band acknowledge.
+	MCU_API_delay(SFX_DLY_OOB_ACK);
+	return SIGFOX_API_send_outofband(SFX_OOB_SERVICE);
+}
+
+/* CHECK IF THE PENDING START ALARM HAS EXPIRED.
+ * @param:	None.
+ * @return:	None.
+ */
+static void SIM_SIGFOX_CheckAlarmTimeout(void) {
+	if (sim_sigfox_ctx.sigfox_alarm_expected_time_us == SIM_TIME_NONE) return;
+	if ((SIM_GetTimeUs() - sim_sigfox_ctx.sigfox_alarm_expected_time_us) > (SIM_SIGFOX_ALARM_TIMEOUT_SECONDS * 1000000ULL)) {
+		SIM_Log("sigfox: start alarm missed");
+		sim_sigfox_ctx.sigfox_alarm_missed_count++;
+		sim_sigfox_ctx.sigfox_alarm_expected_time_us = SIM_TIME_NONE;
+	}
+}
+
+/* UPDATE ALARM STATISTICS WITH AN UPLINK MONITORING FRAME.
+ * @param status_byte:	Tracker status byte.
+ * @return:				None.
+ */
+static void SIM_SIGFOX_UpdateAlarms(unsigned char status_byte) {
+	// Local variables.
+	unsigned long long latency_us = 0;
+	// Update moving state seen by the backend.
+	sim_sigfox_ctx.sigfox_moving_reported = ((status_byte & SIM_SIGFOX_STATUS_MOVING_FLAG) != 0) ? 1 : 0;
+	// Start alarm.
+	if ((status_byte & (SIM_SIGFOX_STATUS_ALARM_FLAG | SIM_SIGFOX_STATUS_MOVING_FLAG)) != (SIM_SIGFOX_STATUS_ALARM_FLAG | SIM_SIGFOX_STATUS_MOVING_FLAG)) return;
+	SIM_SIGFOX_CheckAlarmTimeout();
+	if (sim_sigfox_ctx.sigfox_alarm_expected_time_us == SIM_TIME_NONE) return;
+	latency_us = SIM_GetTimeUs() - sim_sigfox_ctx.sigfox_alarm_expected_time_us;
+	SIM_Log("sigfox: start alarm reported after %llu s", (latency_us / 1000000ULL));
+	sim_sigfox_ctx.sigfox_alarm_reported_count++;
+	sim_sigfox_ctx.sigfox_alarm_latency_sum_us += latency_us;
+	if (latency_us > sim_sigfox_ctx.sigfox_alarm_latency_max_us) {
+		sim_sigfox_ctx.sigfox_alarm_latency_max_us = latency_us;
+	}
+	sim_sigfox_ctx.sigfox_alarm_expected_time_us = SIM_TIME_NONE;
+}
+
+/*** SIM SIGFOX functions ***/
+
+/* REGISTER A MOTION THAT SHOULD TRIGGER A START ALARM.
+ * @param:	None.
+ * @return:	None.
+ */
+void SIM_SIGFOX_ExpectStartAlarm(void) {
+	SIM_SIGFOX_CheckAlarmTimeout();
+	// Nothing is expected if the backend already knows the tracker is moving.
+	if ((sim_sigfox_ctx.sigfox_moving_reported != 0) || (sim_sigfox_ctx.sigfox_alarm_expected_time_us != SIM_TIME_NONE)) return;
+	sim_sigfox_ctx.sigfox_alarm_expected_time_us = SIM_GetTimeUs();
+	sim_sigfox_ctx.sigfox_alarm_expected_count++;
+}
+
+/* GET MOVING STATE REPORTED TO THE BACKEND.
+ * @param:	None.
+ * @return:	1 if the last monitoring frame had the moving flag set, 0 otherwise.
+ */
+unsigned char SIM_SIGFOX_IsMovingReported(void) {
+	return sim_sigfox_ctx.sigfox_moving_reported;
+}
+
+/* PRINT SIGFOX REPORT.
+ * @param:	None.
+ * @return:	None.
+ */
+void SIM_SIGFOX_PrintReport(void) {
+	// Local variables.
+	unsigned long long latency_average_us = 0;
+	printf("SIGFOX: %u messages, %u frames, %u downlinks, %u errors\n", sim_sigfox_ctx.sigfox_message_count, sim_sigfox_ctx.sigfox_frame_count, sim_sigfox_ctx.sigfox_downlink_count, sim_sigfox_ctx.sigfox_error_count);
+	// Close pending alarm.
+	SIM_SIGFOX_CheckAlarmTimeout();
+	if (sim_sigfox_ctx.sigfox_alarm_reported_count != 0) {
+		latency_average_us = sim_sigfox_ctx.sigfox_alarm_latency_sum_us / sim_sigfox_ctx.sigfox_alarm_reported_count;
+	}
+	printf("ALARMS: %u expected, %u reported, %u missed, latency %llu s average, %llu s max\n", sim_sigfox_ctx.sigfox_alarm_expected_count, sim_sigfox_ctx.sigfox_alarm_reported_count, sim_sigfox_ctx.sigfox_alarm_missed_count, (latency_average_us / 1000000ULL), (sim_sigfox_ctx.sigfox_alarm_latency_max_us / 1000000ULL));
+}
+
+/* SIGFOX LIBRARY STAND-IN.
+ * @param:	See sigfox_api.h.
+ * @return:	See sigfox_api.h.
+ */
+sfx_error_t SIGFOX_API_open(sfx_rc_t* rc) {
+	if (sim_sigfox_ctx.sigfox_opened != 0) return SFX_ERR_API_OPEN;
+	sim_sigfox_ctx.sigfox_rc = (*rc);
+	sim_sigfox_ctx.sigfox_opened = 1;
+	return SFX_ERR_NONE;
+}
+
+sfx_error_t SIGFOX_API_close(void) {
+	if (sim_sigfox_ctx.sigfox_opened == 0) return SFX_ERR_API_CLOSE_STATE;
+	sim_sigfox_ctx.sigfox_opened = 0;
+	return SFX_ERR_NONE;
+}
+
+sfx_error_t SIGFOX_API_send_frame(sfx_u8* customer_data, sfx_u8 customer_data_length, sfx_u8* customer_response, sfx_u8 tx_mode, sfx_bool initiate_downlink_flag) {
+	// Local variables.
+	sfx_error_t sfx_error = SIM_SIGFOX_SendMessage(customer_data, customer_data_length, customer_response, initiate_downlink_flag);
+	// Monitoring frames carry the tracker status (uplink is sent even if the downlink failed).
+	if ((customer_data_length >= SIM_SIGFOX_MONITORING_LENGTH_MIN) && (customer_data_length <= SIM_SIGFOX_MONITORING_LENGTH_MAX) && (sfx_error != SFX_ERR_API_SEND_FRAME_DATA_LENGTH)) {
+		SIM_SIGFOX_UpdateAlarms(customer_data[SIM_SIGFOX_MONITORING_STATUS_BYTE_IDX]);
+	}
+	return sfx_error;
+}
+
+sfx_error_t SIGFOX_API_send_bit(sfx_bool bit_value, sfx_u8* customer_response, sfx_u8 tx_mode, sfx_bool initiate_downlink_flag) {
+	return SIM_SIGFOX_SendMessage(0, 0, customer_response, initiate_downlink_flag);
+}
+
+sfx_error_t SIGFOX_API_send_outofband(sfx_oob_enum_t oob_type) {
+	// Local variables.
+	sfx_u8 oob_payload[SIM_SIGFOX_OOB_PAYLOAD_LENGTH];
+	sfx_u16 voltage_idle = 0;
+	sfx_u16 voltage_tx = 0;
+	sfx_s16 temperature = 0;
+	// Voltage and temperature report.
+	MCU_API_get_voltage_temperature(&voltage_idle, &voltage_tx, &temperature);
+	memset(oob_payload, 0, SIM_SIGFOX_OOB_PAYLOAD_LENGTH);
+	oob_payload[0] = (sfx_u8) oob_type;
+	oob_payload[1] = (voltage_idle >> 8) & 0xFF;
+	oob_payload[2] = (voltage_idle >> 0) & 0xFF;
+	oob_payload[3] = (voltage_tx >> 8) & 0xFF;
+	oob_payload[4] = (voltage_tx >> 0) & 0xFF;
+	oob_payload[5] = (temperature >> 8) & 0xFF;
+	oob_payload[6] = (temperature >> 0) & 0xFF;
+	return SIM_SIGFOX_SendMessage(oob_payload, SIM_SIGFOX_OOB_PAYLOAD_LENGTH, 0, SFX_FALSE);
+}
+
+sfx_error_t SIGFOX_API_set_std_config(sfx_u32 config_words[3], sfx_bool timer_enable) {
+	return SFX_ERR_NONE;
+}
+
+sfx_error_t SIGFOX_API_start_continuous_transmission(sfx_u32 frequency, sfx_modulation_type_t type) {
+	RF_API_init(SFX_RF_MODE_TX);
+	RF_API_change_frequency(frequency);
+	return RF_API_start_continuous_transmission(type);
+}
+
+sfx_error_t SIGFOX_API_stop_continuous_transmission(void) {
+	RF_API_stop_continuous_transmission();
+	return RF_API_stop();
+}
+
+sfx_error_t SIGFOX_API_send_test_frame(sfx_u32 frequency, sfx_u8* customer_data, sfx_u8 customer_data_length, sfx_bool initiate_downlink_flag) {
+	return SFX_ERR_NONE;
+}
+
+sfx_error_t SIGFOX_API_receive_test_frame(sfx_u32 frequency, sfx_authentication_mode_t mode, sfx_u8* buffer, sfx_u8 timeout, sfx_s16* rssi) {
+	return SFX_ERR_INT_GET_RECEIVED_FRAMES_TIMEOUT;
+}
+
+sfx_error_t SIGFOX_API_get_version(sfx_u8** version, sfx_u8* size, sfx_version_type_t type) {
+	(*version) = sim_sigfox_version;
+	(*size) = sizeof(sim_sigfox_version) - 1;
+	return SFX_ERR_NONE;
+}
+
+sfx_error_t SIGFOX_API_get_info(sfx_u8* info) {
+	(*info) = 0;
+	return SFX_ERR_NONE;
+}
+
+sfx_error_t SIGFOX_API_get_device_id(sfx_u8* dev_id) {
+	sfx_bool payload_encryption = SFX_FALSE;
+	MCU_API_get_device_id_and_payload_encryption_flag(dev_id, &payload_encryption);
+	return SFX_ERR_NONE;
+}
+
+sfx_error_t SIGFOX_API_get_initial_pac(sfx_u8* initial_pac) {
+	MCU_API_get_initial_pac(initial_pac);
+	return SFX_ERR_NONE;
+}
+
+sfx_error_t SIGFOX_API_switch_public_key(sfx_bool use_public_key) {
+	return SFX_ERR_NONE;
+}
+
+sfx_error_t SIGFOX_API_set_rc_sync_period(sfx_u16 rc_sync_period) {
+	return SFX_ERR_NONE;
+}
+
+sfx_error_t ADDON_SIGFOX_RF_PROTOCOL_API_get_version(sfx_u8** version, sfx_u8* size) {
+	(*version) = sim_sigfox_version;
+	(*size) = sizeof(sim_sigfox_version) - 1;
+	return SFX_ERR_NONE;
+}
+
+sfx_error_t ADDON_SIGFOX_RF_PROTOCOL_API_test_mode(sfx_rc_enum_t rc_enum, sfx_test_mode_t test_mode) {
+	return SFX_ERR_NONE;
+}
+
+sfx_error_t ADDON_SIGFOX_RF_PROTOCOL_API_monarch_test_mode(sfx_rc_enum_t rc_enum, sfx_test_mode_t test_mode, sfx_u8 rc_capabilities) {
+	return SFX_ERR_NONE;
+}
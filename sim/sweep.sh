@@ -0,0 +1,56 @@
+#!/bin/sh
+#
+# sweep.sh
+#
+# Run the host simulation for several configurations in parallel and print a summary.
+# Each line of the configurations file is '<name> [-D<MACRO>=<value> ...] [<VARIABLE>=<value> ...]':
+# -D options are passed to the compiler (firmware parameters), other tokens are exported to the simulation.
+# Lines starting with '#' are ignored.
+#
+# Usage: sim/sweep.sh <configurations_file> [output_directory]
+
+SIM_DIR=$(cd "$(dirname "$0")" && pwd)
+
+# Single configuration (called through xargs).
+if [ "$1" = "--run" ]; then
+	OUT="$2"
+	NAME="$3"
+	shift 3
+	DEFINES=""
+	for TOKEN in "$@"; do
+		case "$TOKEN" in
+			-D*) DEFINES="$DEFINES $TOKEN" ;;
+			*) export "$TOKEN" ;;
+		esac
+	done
+	# Always rebuild since the binary may come from a previous sweep with other parameters.
+	make -s -B -C "$SIM_DIR" sim SIM_BINARY="$OUT/$NAME.bin" DEFINES="$DEFINES" > "$OUT/$NAME.build" 2>&1 || { echo "$NAME: build failed (see $OUT/$NAME.build)" >&2; exit 1; }
+	"$OUT/$NAME.bin" > "$OUT/$NAME.log"
+	exit 0
+fi
+
+if [ $# -lt 1 ]; then
+	echo "Usage: $0 <configurations_file> [output_directory]" >&2
+	exit 1
+fi
+CONFIGURATIONS="$1"
+OUT="${2:-sweep}"
+mkdir -p "$OUT" || exit 1
+OUT=$(cd "$OUT" && pwd)
+
+# Run all configurations, one per host core by default.
+grep -v -e '^[[:space:]]*#' -e '^[[:space:]]*$' "$CONFIGURATIONS" | xargs -P "${TKFX_SIM_JOBS:-$(nproc)}" -L 1 "$0" --run "$OUT"
+
+# Summary.
+printf "%-24s %12s %12s %10s %10s %10s %10s\n" "configuration" "mAs/day" "harvest" "brown-out" "alarms" "missed" "messages"
+grep -v -e '^[[:space:]]*#' -e '^[[:space:]]*$' "$CONFIGURATIONS" | while read -r NAME ARGUMENTS; do
+	LOG="$OUT/$NAME.log"
+	[ -f "$LOG" ] || continue
+	awk -v name="$NAME" '
+		/^ENERGY:/ { consumed = $2; harvested = $5 }
+		/^BROWN-OUTS:/ { brown_outs = $2 }
+		/^ALARMS:/ { expected = $2; missed = $6 }
+		/^SIGFOX:/ { messages = $2 }
+		END { printf "%-24s %12s %12s %10s %10s %10s %10s\n", name, consumed, harvested, brown_outs, expected, missed, messages }
+	' "$LOG"
+done
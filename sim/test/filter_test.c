@@ -0,0 +1,178 @@
+/*
+ * filter_test.c
+ */
+
+// Compares the sorting networks median filter with the original bubble sort implementation.
+#include "../../src/components/filter.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*** FILTER_TEST local macros ***/
+
+#define FILTER_TEST_LENGTH_MAX			0xFF
+#define FILTER_TEST_RANDOM_DRAWS		64
+#define FILTER_TEST_LONG_LENGTH			16 // Longer buffers are tested with less draws and average lengths.
+#define FILTER_TEST_LONG_RANDOM_DRAWS	4
+#define FILTER_TEST_LONG_AVERAGE_MAX	5
+#define FILTER_TEST_DUPLICATES_RANGE	4
+
+/*** FILTER_TEST local structures ***/
+
+typedef enum {
+	FILTER_TEST_PATTERN_RANDOM,
+	FILTER_TEST_PATTERN_DUPLICATES,
+	FILTER_TEST_PATTERN_SORTED,
+	FILTER_TEST_PATTERN_REVERSE_SORTED,
+	FILTER_TEST_PATTERN_CONSTANT,
+	FILTER_TEST_PATTERN_EXTREMES,
+	FILTER_TEST_PATTERN_LAST
+} FILTER_TEST_Pattern;
+
+/*** FILTER_TEST local functions ***/
+
+/* ORIGINAL MEDIAN FILTER (BUBBLE SORT ON A ZERO PADDED COPY).
+ * @param buf:				Input buffer.
+ * @param median_length:	Number of elements taken for median value search.
+ * @param average_length:	Number of center elements taken for final average.
+ * @return filter_out:		Output value of the median filter.
+ */
+static unsigned int FILTER_TEST_ComputeReferenceMedianFilter(unsigned int* buf, unsigned char median_length, unsigned char average_length) {
+	// Local variables.
+	unsigned int local_buf[FILTER_TEST_LENGTH_MAX];
+	unsigned char buffer_sorted = 0;
+	unsigned char idx1 = 0;
+	unsigned char idx2 = 0;
+	unsigned char start_idx = 0;
+	unsigned char end_idx = 0;
+	unsigned int sum = 0;
+	unsigned int filter_out = 0;
+	// Copy input buffer into local buffer.
+	for (idx1=0 ; idx1<median_length ; idx1++) {
+		local_buf[idx1] = buf[idx1];
+	}
+	// Pad with zeroes.
+	for (; idx1<FILTER_TEST_LENGTH_MAX ; idx1++) {
+		local_buf[idx1] = 0;
+	}
+	// Sort buffer in ascending order.
+	for (idx1=0; idx1<median_length; ++idx1) {
+		buffer_sorted = 1;
+		for (idx2=1 ; idx2<(median_length-idx1) ; ++idx2) {
+			if (local_buf[idx2 - 1] > local_buf[idx2]) {
+				unsigned int temp = local_buf[idx2 - 1];
+				local_buf[idx2 - 1] = local_buf[idx2];
+				local_buf[idx2] = temp;
+				buffer_sorted = 0;
+			}
+		}
+		if (buffer_sorted != 0) break;
+	}
+	// Compute average of center values if required.
+	if (average_length > 0) {
+		// Clamp value.
+		if (average_length > median_length) {
+			average_length = median_length;
+		}
+		start_idx = (median_length / 2) - (average_length / 2);
+		end_idx = (median_length / 2) + (average_length / 2);
+		if (end_idx >= median_length) {
+			end_idx = (median_length - 1);
+		}
+		for (idx1=start_idx ; idx1<(end_idx+1) ; idx1++) {
+			sum += local_buf[idx1];
+		}
+		// Compute average.
+		filter_out = ((sum) / (end_idx - start_idx + 1));
+	}
+	else {
+		// Return median value.
+		filter_out = local_buf[(median_length / 2)];
+	}
+	return filter_out;
+}
+
+/* FILL A BUFFER WITH A TEST PATTERN.
+ * @param buf:		Buffer to fill.
+ * @param length:	Number of elements.
+ * @param pattern:	Pattern to use.
+ * @return:			None.
+ */
+static void FILTER_TEST_Fill(unsigned int* buf, unsigned char length, FILTER_TEST_Pattern pattern) {
+	// Local variables.
+	unsigned char idx = 0;
+	// Fill buffer.
+	for (idx=0 ; idx<length ; idx++) {
+		switch (pattern) {
+		case FILTER_TEST_PATTERN_RANDOM:
+			buf[idx] = (unsigned int) rand() & 0xFFF; // 12-bits ADC samples.
+			break;
+		case FILTER_TEST_PATTERN_DUPLICATES:
+			buf[idx] = 2048 + ((unsigned int) rand() % FILTER_TEST_DUPLICATES_RANGE);
+			break;
+		case FILTER_TEST_PATTERN_SORTED:
+			buf[idx] = idx;
+			break;
+		case FILTER_TEST_PATTERN_REVERSE_SORTED:
+			buf[idx] = (length - idx);
+			break;
+		case FILTER_TEST_PATTERN_CONSTANT:
+			buf[idx] = 1234;
+			break;
+		default:
+			// Alternate minimum and maximum values.
+			buf[idx] = (rand() & 0x01) ? 0xFFFFFFFF : 0;
+			break;
+		}
+	}
+}
+
+/*** FILTER_TEST functions ***/
+
+/* MAIN FUNCTION OF THE TEST.
+ * @param:	None.
+ * @return:	0 if both implementations always return the same value, 1 otherwise.
+ */
+int main(void) {
+	// Local variables.
+	unsigned int input_buf[FILTER_TEST_LENGTH_MAX];
+	unsigned int filter_buf[FILTER_TEST_LENGTH_MAX];
+	unsigned int reference_out = 0;
+	unsigned int filter_out = 0;
+	unsigned int median_length = 0;
+	unsigned int average_length = 0;
+	unsigned int draw = 0;
+	unsigned int idx = 0;
+	unsigned int test_count = 0;
+	unsigned int error_count = 0;
+	FILTER_TEST_Pattern pattern = 0;
+	// Fixed seed for reproducible draws.
+	srand(1);
+	// All lengths, including the ones handled by sorting networks (5, 9, 15).
+	for (median_length=1 ; median_length<=FILTER_TEST_LENGTH_MAX ; median_length++) {
+		for (pattern=0 ; pattern<FILTER_TEST_PATTERN_LAST ; pattern++) {
+			for (draw=0 ; draw<FILTER_TEST_RANDOM_DRAWS ; draw++) {
+				FILTER_TEST_Fill(input_buf, median_length, pattern);
+				// Average lengths from 0 (median only) to more than the buffer length (clamped).
+				for (average_length=0 ; average_length<=(median_length + 1) ; average_length++) {
+					if ((median_length > FILTER_TEST_LONG_LENGTH) && (average_length > FILTER_TEST_LONG_AVERAGE_MAX) && (average_length < (median_length - 1))) continue;
+					for (idx=0 ; idx<median_length ; idx++) filter_buf[idx] = input_buf[idx];
+					reference_out = FILTER_TEST_ComputeReferenceMedianFilter(input_buf, median_length, average_length);
+					filter_out = FILTER_ComputeMedianFilter(filter_buf, median_length, average_length);
+					test_count++;
+					if (filter_out != reference_out) {
+						if (error_count == 0) {
+							printf("FILTER: mismatch median_length=%u average_length=%u pattern=%u expected=%u result=%u\n", median_length, average_length, pattern, reference_out, filter_out);
+						}
+						error_count++;
+					}
+				}
+				// Deterministic patterns do not need several draws.
+				if ((pattern != FILTER_TEST_PATTERN_RANDOM) && (pattern != FILTER_TEST_PATTERN_DUPLICATES) && (pattern != FILTER_TEST_PATTERN_EXTREMES)) break;
+				if ((median_length > FILTER_TEST_LONG_LENGTH) && (draw >= (FILTER_TEST_LONG_RANDOM_DRAWS - 1))) break;
+			}
+		}
+	}
+	printf("FILTER: %u tests, %u errors\n", test_count, error_count);
+	return (error_count == 0) ? 0 : 1;
+}
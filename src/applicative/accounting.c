@@ -0,0 +1,189 @@
+/*
+ * accounting.c
+ */
+
+#include "accounting.h"
+
+#include "rtc.h"
+
+/*** ACCOUNTING local macros ***/
+
+// Estimated current consumption of the whole board in each state.
+#define ACCOUNTING_SLEEP_CURRENT_UA		10		// MCU in stop mode, RTC and accelerometer motion detection.
+#define ACCOUNTING_MEASURE_CURRENT_UA	2000	// MCU on HSI, ADC and SHT30 conversion.
+#define ACCOUNTING_GPS_CURRENT_UA		25000	// NEOM8N acquisition.
+#define ACCOUNTING_TX_CURRENT_UA		22000	// S2LP at 14dBm.
+#define ACCOUNTING_RX_CURRENT_UA		9000	// S2LP in reception.
+#define ACCOUNTING_SUMMARY_UNIT_MAS		10		// Summary byte resolution.
+#define ACCOUNTING_SUMMARY_MAX			0xFF
+
+/*** ACCOUNTING local structures ***/
+
+typedef struct {
+	unsigned char accounting_active_states; // Bit field of states currently entered.
+	unsigned int accounting_entry_ms[ACCOUNTING_STATE_LAST];
+	unsigned int accounting_time_seconds[ACCOUNTING_STATE_LAST]; // Mirrored in RTC backup registers.
+	unsigned int accounting_time_ms[ACCOUNTING_STATE_LAST]; // Remainder under 1 second (RAM only).
+	unsigned int accounting_summary_charge_mas; // Total charge when last summary was computed.
+} ACCOUNTING_Context;
+
+/*** ACCOUNTING local global variables ***/
+
+static const unsigned int accounting_current_ua[ACCOUNTING_STATE_LAST] = {
+	ACCOUNTING_SLEEP_CURRENT_UA,
+	ACCOUNTING_MEASURE_CURRENT_UA,
+	ACCOUNTING_GPS_CURRENT_UA,
+	ACCOUNTING_TX_CURRENT_UA,
+	ACCOUNTING_RX_CURRENT_UA
+};
+static ACCOUNTING_Context accounting_ctx;
+
+/*** ACCOUNTING local functions ***/
+
+/* COMPUTE TOTAL CHARGE CONSUMED IN ALL STATES.
+ * @param:	None.
+ * @return:	Total charge in mAs.
+ */
+static unsigned int ACCOUNTING_GetTotalCharge(void) {
+	// Local variables.
+	unsigned char state = 0;
+	unsigned int state_charge_mas = 0;
+	unsigned int total_charge_mas = 0;
+	// Sum all states.
+	for (state=0 ; state<ACCOUNTING_STATE_LAST ; state++) {
+		ACCOUNTING_GetStateCharge(state, &state_charge_mas);
+		total_charge_mas += state_charge_mas;
+	}
+	return total_charge_mas;
+}
+
+/*** ACCOUNTING functions ***/
+
+/* INIT ACCOUNTING COUNTERS FROM RTC BACKUP REGISTERS.
+ * @param:	None.
+ * @return:	None.
+ */
+void ACCOUNTING_Init(void) {
+	// Local variables.
+	unsigned char state = 0;
+	// Backup registers are cleared by a power-on reset, but kept after a watchdog or software reset.
+	// This function must therefore be called before RTC_Reset(), and ACCOUNTING_Save() after RTC_Init().
+	accounting_ctx.accounting_active_states = 0;
+	for (state=0 ; state<ACCOUNTING_STATE_LAST ; state++) {
+		accounting_ctx.accounting_entry_ms[state] = 0;
+		accounting_ctx.accounting_time_ms[state] = 0;
+		RTC_ReadBackupRegister(state, &accounting_ctx.accounting_time_seconds[state]);
+	}
+	accounting_ctx.accounting_summary_charge_mas = ACCOUNTING_GetTotalCharge();
+}
+
+/* COPY ACCOUNTING COUNTERS TO RTC BACKUP REGISTERS.
+ * @param:	None.
+ * @return:	None.
+ */
+void ACCOUNTING_Save(void) {
+	// Local variables.
+	unsigned char state = 0;
+	// Write all registers.
+	for (state=0 ; state<ACCOUNTING_STATE_LAST ; state++) {
+		RTC_WriteBackupRegister(state, accounting_ctx.accounting_time_seconds[state]);
+	}
+}
+
+/* RESET ALL ACCOUNTING COUNTERS.
+ * @param:	None.
+ * @return:	None.
+ */
+void ACCOUNTING_Reset(void) {
+	// Local variables.
+	unsigned char state = 0;
+	// Reset counters (states currently entered restart from now).
+	for (state=0 ; state<ACCOUNTING_STATE_LAST ; state++) {
+		RTC_GetTimestampMilliseconds(&accounting_ctx.accounting_entry_ms[state]);
+		accounting_ctx.accounting_time_seconds[state] = 0;
+		accounting_ctx.accounting_time_ms[state] = 0;
+	}
+	accounting_ctx.accounting_summary_charge_mas = 0;
+	ACCOUNTING_Save();
+}
+
+/* MARK THE BEGINNING OF A STATE.
+ * @param state:	State entered.
+ * @return:			None.
+ */
+void ACCOUNTING_EnterState(ACCOUNTING_State state) {
+	// Check parameter and ignore nested calls.
+	if (state >= ACCOUNTING_STATE_LAST) return;
+	if ((accounting_ctx.accounting_active_states & (0b1 << state)) != 0) return;
+	// Store entry time.
+	RTC_GetTimestampMilliseconds(&accounting_ctx.accounting_entry_ms[state]);
+	accounting_ctx.accounting_active_states |= (0b1 << state);
+}
+
+/* MARK THE END OF A STATE AND ACCUMULATE ITS DURATION.
+ * @param state:	State exited.
+ * @return:			None.
+ */
+void ACCOUNTING_ExitState(ACCOUNTING_State state) {
+	// Local variables.
+	unsigned int exit_ms = 0;
+	// Check parameter and state.
+	if (state >= ACCOUNTING_STATE_LAST) return;
+	if ((accounting_ctx.accounting_active_states & (0b1 << state)) == 0) return;
+	accounting_ctx.accounting_active_states &= ~(0b1 << state);
+	// Accumulate duration (unsigned difference handles timestamp roll-over).
+	RTC_GetTimestampMilliseconds(&exit_ms);
+	accounting_ctx.accounting_time_ms[state] += (exit_ms - accounting_ctx.accounting_entry_ms[state]);
+	accounting_ctx.accounting_time_seconds[state] += (accounting_ctx.accounting_time_ms[state] / 1000);
+	accounting_ctx.accounting_time_ms[state] %= 1000;
+	// Update backup register.
+	RTC_WriteBackupRegister(state, accounting_ctx.accounting_time_seconds[state]);
+}
+
+/* GET CUMULATED TIME SPENT IN A STATE.
+ * @param state:			State to read.
+ * @param time_seconds:		Pointer that will contain the cumulated time in seconds.
+ * @return:					None.
+ */
+void ACCOUNTING_GetStateTime(ACCOUNTING_State state, unsigned int* time_seconds) {
+	(*time_seconds) = 0;
+	if (state < ACCOUNTING_STATE_LAST) {
+		(*time_seconds) = accounting_ctx.accounting_time_seconds[state];
+	}
+}
+
+/* GET ESTIMATED CHARGE CONSUMED IN A STATE.
+ * @param state:		State to read.
+ * @param charge_mas:	Pointer that will contain the estimated charge in mAs.
+ * @return:				None.
+ */
+void ACCOUNTING_GetStateCharge(ACCOUNTING_State state, unsigned int* charge_mas) {
+	// Local variables.
+	unsigned int time_seconds = 0;
+	unsigned int current_ua = 0;
+	(*charge_mas) = 0;
+	if (state >= ACCOUNTING_STATE_LAST) return;
+	// Split computation to avoid 32-bits overflow: Q(mAs) = (t(ms) * I(uA)) / 10^6.
+	time_seconds = accounting_ctx.accounting_time_seconds[state];
+	current_ua = accounting_current_ua[state];
+	(*charge_mas) = ((time_seconds / 1000) * current_ua) + (((time_seconds % 1000) * current_ua) / 1000);
+	(*charge_mas) += ((accounting_ctx.accounting_time_ms[state] * current_ua) / 1000000);
+}
+
+/* GET CHARGE CONSUMED SINCE PREVIOUS CALL ON ONE BYTE.
+ * @param:	None.
+ * @return:	Charge in units of ACCOUNTING_SUMMARY_UNIT_MAS (saturated to 255).
+ */
+unsigned char ACCOUNTING_GetSummary(void) {
+	// Local variables.
+	unsigned int total_charge_mas = ACCOUNTING_GetTotalCharge();
+	unsigned int summary = ((total_charge_mas - accounting_ctx.accounting_summary_charge_mas) / ACCOUNTING_SUMMARY_UNIT_MAS);
+	// Keep the remainder for next summary.
+	accounting_ctx.accounting_summary_charge_mas += (summary * ACCOUNTING_SUMMARY_UNIT_MAS);
+	if (summary > ACCOUNTING_SUMMARY_MAX) {
+		// Saturate and restart from current total.
+		summary = ACCOUNTING_SUMMARY_MAX;
+		accounting_ctx.accounting_summary_charge_mas = total_charge_mas;
+	}
+	return ((unsigned char) summary);
+}
@@ -7,11 +7,13 @@
 
 #include "at.h"
 
+#include "accounting.h"
 #include "adc.h"
 #include "addon_sigfox_rf_protocol_api.h"
 #include "aes.h"
 #include "flash_reg.h"
 #include "i2c.h"
+#include "iwdg.h"
 #include "lpuart.h"
 #include "lptim.h"
 #include "mapping.h"
@@ -20,6 +22,9 @@
 #include "neom8n.h"
 #include "nvic.h"
 #include "nvm.h"
+#include "profiler.h"
+#include "prov.h"
+#include "rcc.h"
 #include "rf_api.h"
 #include "sht3x.h"
 #include "sigfox_api.h"
@@ -34,12 +39,32 @@
 
 #define AT_NULL_CHAR									'\0'
 #define AT_SEPARATOR_CHAR								','
+#define AT_EQUAL_CHAR									'='
 #define AT_CR_CHAR										'\r'
 #define AT_LF_CHAR										'\n'
 
 #define AT_COMMAND_MIN_SIZE								2
 #define AT_HEXA_MAX_DIGITS								8
 #define AT_DECIMAL_MAX_DIGITS							9
+#define AT_PARAMETERS_MAX								3
+#define AT_BYTE_ARRAY_MAX_LENGTH						24 // Longest byte array parameter is NVM write data (limited by AT buffer size).
+#define AT_NVM_DUMP_LINE_LENGTH							16
+#define AT_SIGFOX_UPLINK_DATA_MAX_LENGTH				12
+
+#define AT_COMMANDS_NUMBER								(sizeof(at_commands) / sizeof(AT_Command))
+#define AT_HASH_TABLE_SIZE								64 // Must be a power of 2, greater than the number of commands.
+#define AT_HASH_TABLE_EMPTY								0xFF
+#define AT_HASH_MULTIPLIER								31
+
+#define AT_ACCELERO_PERIOD_MS							50 // Streaming period (one line takes about 25ms at 9600 bauds).
+#define AT_ACCELERO_LINE_LENGTH_MAX						24 // Sample is skipped if TX buffer can not store a whole line.
+#define AT_ACCELERO_DATA_RATE_MAX						7 // MMA8653FC DR field (0=800Hz to 7=1.56Hz).
+#define AT_ACCELERO_STREAM_SYNC_BYTE					0xA5
+#define AT_ACCELERO_STREAM_HEADER_LENGTH				3 // <sync> <number_of_samples> <dropped_samples>.
+#define AT_ACCELERO_STREAM_SAMPLE_LENGTH				3 // <x> <y> <z> (8-bits signed, 1/64g).
+#define AT_ACCELERO_STREAM_BATCH_SIZE					8
+#define AT_ACCELERO_STREAM_PACKET_LENGTH				(AT_ACCELERO_STREAM_HEADER_LENGTH + (AT_ACCELERO_STREAM_BATCH_SIZE * AT_ACCELERO_STREAM_SAMPLE_LENGTH))
+#define AT_ACCELERO_STREAM_DROPPED_MAX					0xFF
 
 // Input commands without parameter.
 #define AT_IN_COMMAND_TEST								"AT"
@@ -51,11 +76,20 @@
 #define AT_IN_COMMAND_NVMR								"AT$NVMR"
 #define AT_IN_COMMAND_SF								"AT$SF"
 #define AT_IN_COMMAND_OOB								"AT$SO"
+#define AT_IN_COMMAND_PWR								"AT$PWR?"
+#define AT_IN_COMMAND_PWRR								"AT$PWRR"
+#define AT_IN_COMMAND_PROV								"AT$PROV"
+#define AT_IN_COMMAND_PROF								"AT$PROF?"
+#define AT_IN_COMMAND_PROFR								"AT$PROFR"
 
 // Input commands with parameters (headers).
 #define AT_IN_HEADER_ACC								"AT$ACC="		// AT$ACC=<enable><CR>.
+#define AT_IN_HEADER_ACCS								"AT$ACCS="		// AT$ACCS=<data_rate>,<binary><CR>.
 #define AT_IN_HEADER_GPS								"AT$GPS=" 		// AT$GPS=<timeout_seconds><CR>.
 #define AT_IN_HEADER_NVM								"AT$NVM="		// AT$NVM=<address_offset><CR>
+#define AT_IN_HEADER_NVMD								"AT$NVMD="		// AT$NVMD=<address_offset>,<length><CR>
+#define AT_IN_HEADER_NVMW								"AT$NVMW="		// AT$NVMW=<address_offset>,<data><CR>
+#define AT_IN_HEADER_NVMC								"AT$NVMC="		// AT$NVMC=<address_offset>,<length><CR>
 #define AT_IN_HEADER_ID									"AT$ID="		// AT$ID=<id><CR>.
 #define AT_IN_HEADER_KEY								"AT$KEY="		// AT$KEY=<key><CR>.
 #define AT_IN_HEADER_SF									"AT$SF="		// AT$SF=<uplink_data>,<downlink_request><CR>.
@@ -92,9 +126,12 @@
 #define AT_OUT_ERROR_UNKNOWN_RC							0x84			// Unknown Sigfox RC.
 #define AT_OUT_ERROR_UNKNOWN_TEST_MODE					0x85			// Unknwon Sigfox test mode.
 #define AT_OUT_ERROR_TIMEOUT_OVERFLOW					0x86			// Timeout is too large.
+#define AT_OUT_ERROR_ACCELERO_DATA_RATE_OVERFLOW		0x8A			// Accelerometer data rate code is too large.
 
 // Components errors
 #define AT_OUT_ERROR_NEOM8N_TIMEOUT						0x87			// GPS timeout.
+#define AT_OUT_ERROR_SHT3X_MEASUREMENT					0x88			// SHT3x not responding or invalid CRC.
+#define AT_OUT_ERROR_LPTIM_TIMER_UNAVAILABLE			0x89			// No software timer available.
 
 /*** AT local structures ***/
 
@@ -103,12 +140,39 @@ typedef enum {
 	AT_ERROR_SOURCE_SFX
 } AT_ErrorSource;
 
+typedef enum {
+	AT_ACCELERO_MODE_OFF,
+	AT_ACCELERO_MODE_PERIODIC,			// AT$ACC=1: text line on each timer period.
+	AT_ACCELERO_MODE_STREAM_TEXT,		// AT$ACCS=<data_rate>,0: text line on each data ready interrupt.
+	AT_ACCELERO_MODE_STREAM_BINARY		// AT$ACCS=<data_rate>,1: packets of samples on data ready interrupts.
+} AT_AcceleroMode;
+
 typedef enum at_param_type {
 	AT_PARAM_TYPE_BOOLEAN,
 	AT_PARAM_TYPE_HEXADECIMAL,
-	AT_PARAM_TYPE_DECIMAL
+	AT_PARAM_TYPE_DECIMAL,
+	AT_PARAM_TYPE_BYTE_ARRAY
 } AT_ParameterType;
 
+// Parsed parameters given to command handlers.
+typedef struct {
+	unsigned char at_param_count;
+	unsigned int at_param_value[AT_PARAMETERS_MAX]; // Boolean, hexadecimal and decimal parameters (by position).
+	unsigned char at_byte_array[AT_BYTE_ARRAY_MAX_LENGTH]; // Single byte array parameter.
+	unsigned char at_byte_array_length;
+} AT_Arguments;
+
+typedef void (*AT_CommandHandler)(AT_Arguments* arguments);
+
+// Command descriptor.
+typedef struct {
+	const char* at_header;
+	AT_ParameterType at_param_types[AT_PARAMETERS_MAX];
+	unsigned char at_param_count_min;
+	unsigned char at_param_count_max;
+	AT_CommandHandler at_handler;
+} AT_Command;
+
 typedef struct {
 	// AT command buffer.
 	volatile unsigned char at_rx_buf[AT_BUFFER_SIZE];
@@ -118,13 +182,28 @@ typedef struct {
 	unsigned int start_idx;
 	unsigned int end_idx;
 	unsigned int separator_idx;
-	// Accelero measurement flag.
-	unsigned char accelero_measurement_flag;
+	// Commands lookup.
+	unsigned char at_hash_table[AT_HASH_TABLE_SIZE];
+	// Accelero measurement mode, period timer and stream batch.
+	AT_AcceleroMode accelero_mode;
+	unsigned char accelero_timer_id;
+	unsigned char accelero_stream_buf[AT_ACCELERO_STREAM_PACKET_LENGTH];
+	unsigned char accelero_stream_count;
+	unsigned char accelero_stream_dropped;
+	// Binary provisioning mode (bytes are given to PROV instead of AT parser).
+	volatile unsigned char prov_mode_flag;
 } AT_Context;
 
 /*** AT local global variables ***/
 
 static AT_Context at_ctx;
+#ifdef AT_COMMANDS_ACCOUNTING
+static const char* at_accounting_state_name[ACCOUNTING_STATE_LAST] = {"Sleep", "Measure", "Gps", "Tx", "Rx"};
+static const char* at_clock_level_name[RCC_CLOCK_LEVEL_LAST] = {"65kHz", "131kHz", "262kHz", "524kHz", "1MHz", "2MHz", "4MHz", "16MHz"};
+#endif
+#ifdef AT_COMMANDS_PROFILER
+static const char* at_profiler_probe_name[PROFILER_PROBE_LAST] = {"RF_API_send", "NEOM8N_ParseNmeaGgaMessage", "ADC1_PerformAllMeasurements"};
+#endif
 
 /*** AT local functions ***/
 
@@ -184,64 +263,6 @@ static unsigned int AT_Pow10(unsigned char power) {
 	return result;
 }
 
-/* CHECK EQUALITY BETWEEN A GIVEN COMMAND AND THE CURRENT AT COMMAND BUFFER.
- * @param command:			String to compare.
- * @return return_code:		'AT_NO_ERROR' if strings are identical.
- * 							'AT_OUT_ERROR_UNKNOWN_COMMAND' otherwise.
- */
-static unsigned short AT_CompareCommand(char* command) {
-	unsigned short return_code = AT_OUT_ERROR_UNKNOWN_COMMAND;
-	unsigned int idx = 0;
-	// 'command' ends with a NULL character (standard in C).
-	// 'at_rx_buf' ends at 'at_rx_buf_idx'.
-	while ((command[idx] != AT_NULL_CHAR) && (idx < at_ctx.at_rx_buf_idx)) {
-		if (command[idx] != at_ctx.at_rx_buf[idx]) {
-			// Difference found, exit loop.
-			break;
-		}
-		else {
-			// Increment index to check next character.
-			idx++;
-		}
-	}
-	// Strings are identical if 'idx' reached 'at_rx_buf_idx'-1 (to ignore the single <CR> or <LF>) and 'command[idx]' = NULL.
-	if ((idx == (at_ctx.at_rx_buf_idx-1)) && (command[idx] == AT_NULL_CHAR)) {
-		return_code = AT_NO_ERROR;
-	}
-	return return_code;
-}
-
-/* CHECK EQUALITY BETWEEN A GIVEN HEADER AND THE BEGINNING OF THE CURRENT AT COMMAND BUFFER.
- * @param header:			String to compare.
- * @return return_code:		'AT_NO_ERROR' if headers are identical.
- * 							'AT_OUT_ERROR_UNKNOWN_COMMAND' otherwise.
- */
-static unsigned short AT_CompareHeader(char* header) {
-	unsigned short return_code = AT_OUT_ERROR_UNKNOWN_COMMAND;
-	unsigned int idx = 0;
-	// 'header' ends with a NULL character (standard in C).
-	// 'at_rx_buf' ends at 'at_buf_idx'.
-	while ((header[idx] != AT_NULL_CHAR) && (idx < at_ctx.at_rx_buf_idx)) {
-		if (header[idx] != at_ctx.at_rx_buf[idx]) {
-			// Difference found, exit loop.
-			break;
-		}
-		else {
-			// Increment index to check next character.
-			idx++;
-		}
-	}
-	// Header are identical if 'header[idx]' = NULL.
-	if (header[idx] == AT_NULL_CHAR) {
-		at_ctx.start_idx = idx; // At this step, idx is on the NULL character (after the header).
-		return_code = AT_NO_ERROR;
-	}
-	else {
-		at_ctx.start_idx = 0;
-	}
-	return return_code;
-}
-
 /* SEARCH SEPARATOR IN THE CURRENT AT COMMAND BUFFER.
  * @param:					None.
  * @return separator_found:	Boolean indicating if separator was found.
@@ -535,552 +556,948 @@ static void AT_PrintDownlinkData(sfx_u8* sfx_downlink_data) {
 }
 
 /* PRINT ACCELEROMETER DATA ON USART.
+ * @param x:	X-axis acceleration.
+ * @param y:	Y-axis acceleration.
+ * @param z:	Z-axis acceleration.
+ * @return:		None.
+ */
+static void AT_PrintAcceleroData(signed int x, signed int y, signed int z) {
+	// Print data.
+	USART2_SendString("x=");
+	USART2_SendSignedValue(x);
+	USART2_SendString(" y=");
+	USART2_SendSignedValue(y);
+	USART2_SendString(" z=");
+	USART2_SendSignedValue(z);
+	USART2_SendString("\r\n");
+}
+
+#ifdef AT_COMMANDS_ACCOUNTING
+/* PRINT TIME AND CHARGE ACCOUNTING OF ALL STATES AND TIME SPENT IN EACH CLOCK LEVEL ON USART.
+ * @param:	None.
+ * @return:	None.
+ */
+static void AT_PrintAccounting(void) {
+	// Local variables.
+	unsigned char state = 0;
+	unsigned int time_seconds = 0;
+	unsigned int charge_mas = 0;
+	unsigned char level = 0;
+	unsigned int time_ms = 0;
+	// Print one line per state.
+	for (state=0 ; state<ACCOUNTING_STATE_LAST ; state++) {
+		ACCOUNTING_GetStateTime(state, &time_seconds);
+		ACCOUNTING_GetStateCharge(state, &charge_mas);
+		USART2_SendString((char*) at_accounting_state_name[state]);
+		USART2_SendString(" t=");
+		USART2_SendValue(time_seconds, USART_FORMAT_DECIMAL, 0);
+		USART2_SendString("s Q=");
+		USART2_SendValue(charge_mas, USART_FORMAT_DECIMAL, 0);
+		USART2_SendString("mAs\r\n");
+	}
+	// Print one line per clock level (stop mode excluded).
+	for (level=0 ; level<RCC_CLOCK_LEVEL_LAST ; level++) {
+		RCC_GetClockLevelTime(level, &time_ms);
+		USART2_SendString("Clock ");
+		USART2_SendString((char*) at_clock_level_name[level]);
+		USART2_SendString(" t=");
+		USART2_SendValue(time_ms, USART_FORMAT_DECIMAL, 0);
+		USART2_SendString("ms\r\n");
+	}
+}
+#endif
+
+#ifdef AT_COMMANDS_PROFILER
+/* PRINT PROGRAM COUNTER HISTOGRAM AND PROBES ON USART.
  * @param:	None.
  * @return:	None.
  */
-static void AT_PrintAcceleroData(void) {
-	// Get data.
+static void AT_PrintProfiler(void) {
+	// Local variables.
+	unsigned int sample_count = 0;
+	unsigned int outside_flash_count = 0;
+	unsigned int period_cycles = 0;
+	unsigned short bucket_idx = 0;
+	unsigned int start_address = 0;
+	unsigned char probe = 0;
+	unsigned int average_cycles = 0;
+	unsigned int max_cycles = 0;
+	// Samples summary.
+	PROFILER_GetSamples(&sample_count, &outside_flash_count, &period_cycles);
+	USART2_SendString("Samples=");
+	USART2_SendValue(sample_count, USART_FORMAT_DECIMAL, 0);
+	USART2_SendString(" outside_flash=");
+	USART2_SendValue(outside_flash_count, USART_FORMAT_DECIMAL, 0);
+	USART2_SendString(" period=");
+	USART2_SendValue(period_cycles, USART_FORMAT_DECIMAL, 0);
+	USART2_SendString("cycles\r\n");
+	// Print non empty buckets (start address can be matched with linker map).
+	for (bucket_idx=0 ; bucket_idx<PROFILER_GetBucketNumber() ; bucket_idx++) {
+		PROFILER_GetBucket(bucket_idx, &start_address, &sample_count);
+		if (sample_count == 0) continue;
+		USART2_SendValue(start_address, USART_FORMAT_HEXADECIMAL, 1);
+		USART2_SendString(" n=");
+		USART2_SendValue(sample_count, USART_FORMAT_DECIMAL, 0);
+		USART2_SendString("\r\n");
+		IWDG_Reload();
+	}
+	// Print probes.
+	for (probe=0 ; probe<PROFILER_PROBE_LAST ; probe++) {
+		PROFILER_GetProbe(probe, &sample_count, &average_cycles, &max_cycles);
+		USART2_SendString((char*) at_profiler_probe_name[probe]);
+		USART2_SendString(" n=");
+		USART2_SendValue(sample_count, USART_FORMAT_DECIMAL, 0);
+		USART2_SendString(" avg=");
+		USART2_SendValue(average_cycles, USART_FORMAT_DECIMAL, 0);
+		USART2_SendString(" max=");
+		USART2_SendValue(max_cycles, USART_FORMAT_DECIMAL, 0);
+		USART2_SendString("cycles\r\n");
+	}
+}
+#endif
+
+/* TEST COMMAND AT<CR>.
+ * @param arguments:	Parsed parameters (unused).
+ * @return:				None.
+ */
+static void AT_TestCommand(AT_Arguments* arguments) {
+	// Nothing to do, only reply OK to acknowledge serial link.
+	AT_ReplyOk();
+}
+
+#ifdef AT_COMMANDS_GPS
+/* GPS COMMAND AT$GPS=<timeout_seconds><CR>.
+ * @param arguments:	Parsed parameters.
+ * @return:				None.
+ */
+static void AT_GpsCommand(AT_Arguments* arguments) {
+	// Local variables.
+	Position gps_position;
+	unsigned int gps_fix_duration = 0;
+	NEOM8N_ReturnCode get_position_result = NEOM8N_TIMEOUT;
+	// Start GPS fix.
+	LPUART1_PowerOn();
+	get_position_result = NEOM8N_GetPosition(&gps_position, (arguments -> at_param_value)[0], 0, &gps_fix_duration);
+	LPUART1_PowerOff();
+	switch (get_position_result) {
+	case NEOM8N_SUCCESS:
+		AT_PrintPosition(&gps_position, gps_fix_duration);
+		break;
+	case NEOM8N_TIMEOUT:
+		AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_NEOM8N_TIMEOUT);
+		break;
+	default:
+		break;
+	}
+}
+#endif
+
+#ifdef AT_COMMANDS_SENSORS
+/* ADC COMMAND AT$ADC?<CR>.
+ * @param arguments:	Parsed parameters (unused).
+ * @return:				None.
+ */
+static void AT_AdcCommand(AT_Arguments* arguments) {
+	// Local variables.
+	unsigned int source_voltage_mv = 0;
+	unsigned int supercap_voltage_mv = 0;
+	unsigned int mcu_supply_voltage_mv = 0;
+	// Perform ADC convertions.
+	ADC1_PowerOn();
+	ADC1_PerformAllMeasurements();
+	ADC1_PowerOff();
+	ADC1_GetSourceVoltage(&source_voltage_mv);
+	ADC1_GetSupercapVoltage(&supercap_voltage_mv);
+	ADC1_GetMcuVoltage(&mcu_supply_voltage_mv);
+	// Print results.
+	USART2_SendString("Vsrc=");
+	USART2_SendValue(source_voltage_mv, USART_FORMAT_DECIMAL, 0);
+	USART2_SendString("mV Vcap=");
+	USART2_SendValue(supercap_voltage_mv, USART_FORMAT_DECIMAL, 0);
+	USART2_SendString("mV Vmcu=");
+	USART2_SendValue(mcu_supply_voltage_mv, USART_FORMAT_DECIMAL, 0);
+	USART2_SendString("mV\r\n");
+}
+
+/* TEMPERATURE AND HUMIDITY SENSOR COMMAND AT$THS?<CR>.
+ * @param arguments:	Parsed parameters (unused).
+ * @return:				None.
+ */
+static void AT_ThsCommand(AT_Arguments* arguments) {
+	// Local variables.
+	signed int sht3x_temperature_centidegrees = 0;
+	unsigned int sht3x_humidity_centipercent = 0;
+	unsigned char sht3x_status = 0;
+	// Perform measurements with best accuracy.
+	I2C1_Init();
+	I2C1_PowerOn();
+	sht3x_status = SHT3X_PerformMeasurements(SHT3X_REPEATABILITY_HIGH);
+	I2C1_PowerOff();
+	I2C1_Disable();
+	if (sht3x_status == 0) {
+		AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_SHT3X_MEASUREMENT);
+	}
+	else {
+		SHT3X_GetTemperatureCentiDegrees(&sht3x_temperature_centidegrees);
+		SHT3X_GetHumidityCentiPercent(&sht3x_humidity_centipercent);
+		// Print results.
+		USART2_SendString("T=");
+		USART2_SendFixedPoint(sht3x_temperature_centidegrees, 2);
+		USART2_SendString("dC H=");
+		USART2_SendFixedPoint((signed int) sht3x_humidity_centipercent, 2);
+		USART2_SendString("%\r\n");
+	}
+}
+
+/* ACCELEROMETER CHECK COMMAND AT$ACC?<CR>.
+ * @param arguments:	Parsed parameters (unused).
+ * @return:				None.
+ */
+static void AT_AccCheckCommand(AT_Arguments* arguments) {
+	// Local variables.
+	unsigned char mma8653fc_who_am_i = 0;
+	// Get sensor ID.
+	I2C1_Init();
+	I2C1_PowerOn();
+	mma8653fc_who_am_i = MMA8653FC_GetId();
+	I2C1_PowerOff();
+	I2C1_Disable();
+	// Print results.
+	USART2_SendString("WhoAmI=");
+	USART2_SendValue(mma8653fc_who_am_i, USART_FORMAT_HEXADECIMAL, 0);
+	USART2_SendString("\r\n");
+}
+
+/* STOP ANY ACCELEROMETER MEASUREMENT MODE.
+ * @param:	None.
+ * @return:	None.
+ */
+static void AT_StopAccelero(void) {
+	switch (at_ctx.accelero_mode) {
+	case AT_ACCELERO_MODE_PERIODIC:
+		LPTIM1_StopTimer(at_ctx.accelero_timer_id);
+		break;
+	case AT_ACCELERO_MODE_STREAM_TEXT:
+	case AT_ACCELERO_MODE_STREAM_BINARY:
+		// Restore motion detection configuration.
+		NVIC_DisableInterrupt(NVIC_IT_EXTI_0_1);
+		MMA8653FC_WriteConfig(&(mma8653_tkfx_config[0]), MMA8653FC_TKFX_CONFIG_SIZE);
+		break;
+	default:
+		break;
+	}
+	// Turn sensor off (rail is reference counted).
+	if (at_ctx.accelero_mode != AT_ACCELERO_MODE_OFF) {
+		I2C1_PowerOff();
+		I2C1_Disable();
+	}
+	at_ctx.accelero_mode = AT_ACCELERO_MODE_OFF;
+}
+
+/* READ A SAMPLE AFTER DATA READY INTERRUPT AND SEND IT IN STREAM FORMAT.
+ * @param:	None.
+ * @return:	None.
+ */
+static void AT_StreamAcceleroData(void) {
+	// Local variables.
 	signed int x = 0;
 	signed int y = 0;
 	signed int z = 0;
+	unsigned char sample_idx = AT_ACCELERO_STREAM_HEADER_LENGTH + (at_ctx.accelero_stream_count * AT_ACCELERO_STREAM_SAMPLE_LENGTH);
+	// Reading output registers clears the data ready interrupt.
 	MMA8653FC_GetData(&x, &y, &z);
-	// Print data.
-	USART2_SendString("x=");
-	if (x < 0) {
-		USART2_SendString("-");
-		USART2_SendValue(((-1) * x), USART_FORMAT_DECIMAL, 0);
+	if (at_ctx.accelero_mode == AT_ACCELERO_MODE_STREAM_TEXT) {
+		// Skip sample instead of blocking if host link is too slow.
+		if (USART2_GetTxFreeSpace() >= AT_ACCELERO_LINE_LENGTH_MAX) {
+			AT_PrintAcceleroData(x, y, z);
+		}
+		return;
+	}
+	// Append sample to batch (fast read mode: 8 MSB of 10-bits data).
+	at_ctx.accelero_stream_buf[sample_idx + 0] = (unsigned char) (x >> 2);
+	at_ctx.accelero_stream_buf[sample_idx + 1] = (unsigned char) (y >> 2);
+	at_ctx.accelero_stream_buf[sample_idx + 2] = (unsigned char) (z >> 2);
+	at_ctx.accelero_stream_count++;
+	if (at_ctx.accelero_stream_count < AT_ACCELERO_STREAM_BATCH_SIZE) return;
+	// Send packet if TX buffer can store it, count dropped samples otherwise.
+	if (USART2_GetTxFreeSpace() >= AT_ACCELERO_STREAM_PACKET_LENGTH) {
+		at_ctx.accelero_stream_buf[0] = AT_ACCELERO_STREAM_SYNC_BYTE;
+		at_ctx.accelero_stream_buf[1] = AT_ACCELERO_STREAM_BATCH_SIZE;
+		at_ctx.accelero_stream_buf[2] = at_ctx.accelero_stream_dropped;
+		USART2_SendBytes(at_ctx.accelero_stream_buf, AT_ACCELERO_STREAM_PACKET_LENGTH);
+		at_ctx.accelero_stream_dropped = 0;
 	}
 	else {
-		USART2_SendValue(x, USART_FORMAT_DECIMAL, 0);
+		if (at_ctx.accelero_stream_dropped > (AT_ACCELERO_STREAM_DROPPED_MAX - AT_ACCELERO_STREAM_BATCH_SIZE)) {
+			at_ctx.accelero_stream_dropped = AT_ACCELERO_STREAM_DROPPED_MAX;
+		}
+		else {
+			at_ctx.accelero_stream_dropped += AT_ACCELERO_STREAM_BATCH_SIZE;
+		}
 	}
-	USART2_SendString(" y=");
-	if (y < 0) {
-		USART2_SendString("-");
-		USART2_SendValue(((-1) * y), USART_FORMAT_DECIMAL, 0);
+	at_ctx.accelero_stream_count = 0;
+}
+
+/* ACCELEROMETER DATA COMMAND AT$ACC=<enable><CR>.
+ * @param arguments:	Parsed parameters.
+ * @return:				None.
+ */
+static void AT_AccDataCommand(AT_Arguments* arguments) {
+	// Check enable bit.
+	if ((arguments -> at_param_value)[0] == 0) {
+		// Stop measurement.
+		AT_StopAccelero();
+		AT_ReplyOk();
 	}
 	else {
-		USART2_SendValue(y, USART_FORMAT_DECIMAL, 0);
+		// Start measurement, data is printed on each timer period.
+		if (at_ctx.accelero_mode != AT_ACCELERO_MODE_PERIODIC) {
+			AT_StopAccelero();
+			if (LPTIM1_StartTimer(&at_ctx.accelero_timer_id, AT_ACCELERO_PERIOD_MS, LPTIM_TIMER_MODE_PERIODIC, 0) == 0) {
+				AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_LPTIM_TIMER_UNAVAILABLE);
+			}
+			else {
+				I2C1_Init();
+				I2C1_PowerOn();
+				at_ctx.accelero_mode = AT_ACCELERO_MODE_PERIODIC;
+				AT_ReplyOk();
+			}
+		}
+		else {
+			AT_ReplyOk();
+		}
 	}
-	USART2_SendString(" z=");
-	if (z < 0) {
-		USART2_SendString("-");
-		USART2_SendValue(((-1) * z), USART_FORMAT_DECIMAL, 0);
+}
+
+/* ACCELEROMETER STREAM COMMAND AT$ACCS=<data_rate>,<binary><CR> (STOPPED WITH AT$ACC=0).
+ * @param arguments:	Parsed parameters.
+ * @return:				None.
+ */
+static void AT_AccStreamCommand(AT_Arguments* arguments) {
+	// Local variables.
+	unsigned int data_rate = (arguments -> at_param_value)[0];
+	unsigned int binary = (arguments -> at_param_value)[1];
+	MMA8653FC_RegisterSetting mma8653fc_stream_config[] = {
+		{MMA8653FC_REG_CTRL_REG1, 0x00}, // ACTIVE='0' (standby mode required to program registers).
+		{MMA8653FC_REG_XYZ_DATA_CFG, 0x00}, // Full scale = +/-2g.
+		{MMA8653FC_REG_CTRL_REG2, 0x00}, // MODS='00' (normal mode) and SLPE='0' (Auto sleep disabled).
+		{MMA8653FC_REG_CTRL_REG3, 0x02}, // IPOL='1' (interrupt pin active high).
+		{MMA8653FC_REG_CTRL_REG5, 0x01}, // INT_CFG_DRDY='1' (data ready interrupt on INT1 pin).
+		{MMA8653FC_REG_CTRL_REG4, 0x01}, // INT_EN_DRDY='1' (data ready interrupt enabled).
+		{MMA8653FC_REG_CTRL_REG1, ((data_rate << 3) | (binary << 1) | (0b1 << 0))} // DR, F_READ (8-bits data in binary mode) and ACTIVE='1'.
+	};
+	// Check parameters.
+	if (data_rate > AT_ACCELERO_DATA_RATE_MAX) {
+		AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_ACCELERO_DATA_RATE_OVERFLOW);
+		return;
+	}
+	AT_StopAccelero();
+	// Keep sensor powered and use fast I2C to read samples between two data ready events.
+	I2C1_Init();
+	I2C1_PowerOn();
+	I2C1_SetSpeed(I2C_SPEED_FAST_400KHZ);
+	MMA8653FC_WriteConfig(&(mma8653fc_stream_config[0]), (sizeof(mma8653fc_stream_config) / sizeof(MMA8653FC_RegisterSetting)));
+	at_ctx.accelero_mode = (binary != 0) ? AT_ACCELERO_MODE_STREAM_BINARY : AT_ACCELERO_MODE_STREAM_TEXT;
+	at_ctx.accelero_stream_count = 0;
+	at_ctx.accelero_stream_dropped = 0;
+	// Interrupt wakes-up the MCU, data ready pin level is checked by AT_Task().
+	NVIC_EnableInterrupt(NVIC_IT_EXTI_0_1);
+	AT_ReplyOk();
+}
+#endif
+
+#ifdef AT_COMMANDS_NVM
+/* NVM RESET COMMAND AT$NVMR<CR>.
+ * @param arguments:	Parsed parameters (unused).
+ * @return:				None.
+ */
+static void AT_NvmResetCommand(AT_Arguments* arguments) {
+	// Reset all NVM field to default value.
+	NVM_ResetDefault();
+	AT_ReplyOk();
+}
+
+/* NVM READ COMMAND AT$NVM=<address_offset><CR>.
+ * @param arguments:	Parsed parameters.
+ * @return:				None.
+ */
+static void AT_NvmReadCommand(AT_Arguments* arguments) {
+	// Local variables.
+	unsigned int address_offset = (arguments -> at_param_value)[0];
+	unsigned char nvm_byte = 0;
+	// Check if address is reachable.
+	if (address_offset < EEPROM_SIZE) {
+		// Read byte at requested address.
+		NVM_Enable();
+		NVM_ReadByte(address_offset, &nvm_byte);
+		NVM_Disable();
+		// Print byte.
+		USART2_SendValue(nvm_byte, USART_FORMAT_HEXADECIMAL, 1);
+		USART2_SendString("\r\n");
 	}
 	else {
-		USART2_SendValue(z, USART_FORMAT_DECIMAL, 0);
+		AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_NVM_ADDRESS_OVERFLOW);
+	}
+}
+
+/* NVM DUMP COMMAND AT$NVMD=<address_offset>,<length><CR>.
+ * @param arguments:	Parsed parameters.
+ * @return:				None.
+ */
+static void AT_NvmDumpCommand(AT_Arguments* arguments) {
+	// Local variables.
+	unsigned int address_offset = (arguments -> at_param_value)[0];
+	unsigned int length = (arguments -> at_param_value)[1];
+	unsigned char nvm_line[AT_NVM_DUMP_LINE_LENGTH];
+	unsigned char line_length = 0;
+	unsigned char idx = 0;
+	// Check range.
+	if ((address_offset + length) > EEPROM_SIZE) {
+		AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_NVM_ADDRESS_OVERFLOW);
+		return;
+	}
+	// Print lines of 16 bytes prefixed by address offset.
+	NVM_Enable();
+	while (length > 0) {
+		line_length = (length > AT_NVM_DUMP_LINE_LENGTH) ? AT_NVM_DUMP_LINE_LENGTH : length;
+		NVM_ReadBlock(address_offset, nvm_line, line_length);
+		USART2_SendValue(address_offset, USART_FORMAT_DECIMAL, 0);
+		USART2_SendString(":");
+		for (idx=0 ; idx<line_length ; idx++) {
+			USART2_SendString(" ");
+			USART2_SendValue(nvm_line[idx], USART_FORMAT_HEXADECIMAL, 0);
+		}
+		USART2_SendString("\r\n");
+		address_offset += line_length;
+		length -= line_length;
 	}
+	NVM_Disable();
+	AT_ReplyOk();
+}
+
+/* NVM WRITE COMMAND AT$NVMW=<address_offset>,<data><CR>.
+ * @param arguments:	Parsed parameters.
+ * @return:				None.
+ */
+static void AT_NvmWriteCommand(AT_Arguments* arguments) {
+	// Local variables.
+	unsigned char write_status = 0;
+	// Check range before writing.
+	if (((arguments -> at_param_value)[0] + (arguments -> at_byte_array_length)) > EEPROM_SIZE) {
+		AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_NVM_ADDRESS_OVERFLOW);
+		return;
+	}
+	// Write block.
+	NVM_Enable();
+	write_status = NVM_WriteBlock((arguments -> at_param_value)[0], (arguments -> at_byte_array), (arguments -> at_byte_array_length));
+	NVM_Disable();
+	if (write_status == 0) {
+		AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_NVM_ADDRESS_OVERFLOW);
+	}
+	else {
+		AT_ReplyOk();
+	}
+}
+
+/* NVM CRC COMMAND AT$NVMC=<address_offset>,<length><CR>.
+ * @param arguments:	Parsed parameters.
+ * @return:				None.
+ */
+static void AT_NvmCrcCommand(AT_Arguments* arguments) {
+	// Local variables.
+	unsigned int address_offset = (arguments -> at_param_value)[0];
+	unsigned int length = (arguments -> at_param_value)[1];
+	unsigned int crc32 = 0;
+	// Check range.
+	if ((address_offset + length) > EEPROM_SIZE) {
+		AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_NVM_ADDRESS_OVERFLOW);
+		return;
+	}
+	// Compute and print CRC-32.
+	NVM_Enable();
+	NVM_ComputeCrc32(address_offset, length, &crc32);
+	NVM_Disable();
+	USART2_SendValue(crc32, USART_FORMAT_HEXADECIMAL, 1);
 	USART2_SendString("\r\n");
 }
 
-/* PARSE THE CURRENT AT COMMAND BUFFER.
- * @param:	None.
- * @return:	None.
+/* GET ID COMMAND AT$ID?<CR>.
+ * @param arguments:	Parsed parameters (unused).
+ * @return:				None.
  */
-static void AT_DecodeRxBuffer(void) {
-	// At this step, 'at_buf_idx' is 1 character after the first line end character (<CR> or <LF>).
-	unsigned short get_param_result = 0;
+static void AT_GetIdCommand(AT_Arguments* arguments) {
+	// Local variables.
 	unsigned char byte_idx = 0;
-	unsigned char extracted_length = 0;
+	unsigned char id_byte = 0;
+	// Retrieve device ID in NVM.
+	NVM_Enable();
+	for (byte_idx=0 ; byte_idx<ID_LENGTH ; byte_idx++) {
+		NVM_ReadByte((NVM_SIGFOX_ID_ADDRESS_OFFSET + ID_LENGTH - byte_idx - 1), &id_byte);
+		USART2_SendValue(id_byte, USART_FORMAT_HEXADECIMAL, (byte_idx==0 ? 1 : 0));
+	}
+	USART2_SendString("\r\n");
+	NVM_Disable();
+}
+
+/* SET ID COMMAND AT$ID=<id><CR>.
+ * @param arguments:	Parsed parameters.
+ * @return:				None.
+ */
+static void AT_SetIdCommand(AT_Arguments* arguments) {
+	// Local variables.
+	unsigned char byte_idx = 0;
+	// Check length.
+	if ((arguments -> at_byte_array_length) == ID_LENGTH) {
+		// Write device ID in NVM.
+		NVM_Enable();
+		for (byte_idx=0 ; byte_idx<ID_LENGTH ; byte_idx++) {
+			NVM_WriteByte((NVM_SIGFOX_ID_ADDRESS_OFFSET + ID_LENGTH - byte_idx - 1), (arguments -> at_byte_array)[byte_idx]);
+		}
+		AT_ReplyOk();
+		NVM_Disable();
+	}
+	else {
+		AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_PARAM_BYTE_ARRAY_INVALID_LENGTH);
+	}
+}
+
+/* GET KEY COMMAND AT$KEY?<CR>.
+ * @param arguments:	Parsed parameters (unused).
+ * @return:				None.
+ */
+static void AT_GetKeyCommand(AT_Arguments* arguments) {
+	// Local variables.
+	unsigned char byte_idx = 0;
+	unsigned char key_byte = 0;
+	// Retrieve device key in NVM.
+	NVM_Enable();
+	for (byte_idx=0 ; byte_idx<AES_BLOCK_SIZE ; byte_idx++) {
+		NVM_ReadByte((NVM_SIGFOX_KEY_ADDRESS_OFFSET + byte_idx), &key_byte);
+		USART2_SendValue(key_byte, USART_FORMAT_HEXADECIMAL, (byte_idx==0 ? 1 : 0));
+	}
+	USART2_SendString("\r\n");
+	NVM_Disable();
+}
+
+/* SET KEY COMMAND AT$KEY=<key><CR>.
+ * @param arguments:	Parsed parameters.
+ * @return:				None.
+ */
+static void AT_SetKeyCommand(AT_Arguments* arguments) {
+	// Local variables.
+	unsigned char byte_idx = 0;
+	// Check length.
+	if ((arguments -> at_byte_array_length) == AES_BLOCK_SIZE) {
+		// Write device key in NVM.
+		NVM_Enable();
+		for (byte_idx=0 ; byte_idx<AES_BLOCK_SIZE ; byte_idx++) {
+			NVM_WriteByte((NVM_SIGFOX_KEY_ADDRESS_OFFSET + byte_idx), (arguments -> at_byte_array)[byte_idx]);
+		}
+		AT_ReplyOk();
+		NVM_Disable();
+	}
+	else {
+		AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_PARAM_BYTE_ARRAY_INVALID_LENGTH);
+	}
+}
+#endif
+
 #ifdef AT_COMMANDS_SIGFOX
-	sfx_u8 sfx_uplink_data[12] = {0x00};
+/* SIGFOX SEND OOB COMMAND AT$SO<CR>.
+ * @param arguments:	Parsed parameters (unused).
+ * @return:				None.
+ */
+static void AT_SendOobCommand(AT_Arguments* arguments) {
+	// Local variables.
+	sfx_error_t sfx_error = 0;
+	sfx_rc_t rc1 = RC1;
+	// Send Sigfox OOB frame.
+	sfx_error = SIGFOX_API_open(&rc1);
+	if (sfx_error == SFX_ERR_NONE) {
+		sfx_error = SIGFOX_API_send_outofband(SFX_OOB_SERVICE);
+	}
+	SIGFOX_API_close();
+	if (sfx_error == SFX_ERR_NONE) {
+		AT_ReplyOk();
+	}
+	else {
+		// Error from Sigfox library.
+		AT_ReplyError(AT_ERROR_SOURCE_SFX, sfx_error);
+	}
+}
+
+/* SIGFOX SEND BIT COMMAND AT$SB=<bit>,<downlink_request><CR> (DOWNLINK REQUEST IS OPTIONAL).
+ * @param arguments:	Parsed parameters.
+ * @return:				None.
+ */
+static void AT_SendBitCommand(AT_Arguments* arguments) {
+	// Local variables.
 	sfx_u8 sfx_downlink_data[8] = {0x00};
 	sfx_error_t sfx_error = 0;
 	sfx_rc_t rc1 = RC1;
+	unsigned int downlink_request = ((arguments -> at_param_count) > 1) ? (arguments -> at_param_value)[1] : 0;
+	// Send Sigfox bit.
+	sfx_error = SIGFOX_API_open(&rc1);
+	if (sfx_error == SFX_ERR_NONE) {
+		sfx_error = SIGFOX_API_send_bit((arguments -> at_param_value)[0], sfx_downlink_data, 2, downlink_request);
+	}
+	SIGFOX_API_close();
+	if (sfx_error == SFX_ERR_NONE) {
+		if (downlink_request != 0) {
+			AT_PrintDownlinkData(sfx_downlink_data);
+		}
+		AT_ReplyOk();
+	}
+	else {
+		// Error from Sigfox library.
+		AT_ReplyError(AT_ERROR_SOURCE_SFX, sfx_error);
+	}
+}
+
+/* SIGFOX SEND FRAME COMMANDS AT$SF<CR> AND AT$SF=<data>,<downlink_request><CR> (DOWNLINK REQUEST IS OPTIONAL).
+ * @param arguments:	Parsed parameters.
+ * @return:				None.
+ */
+static void AT_SendFrameCommand(AT_Arguments* arguments) {
+	// Local variables.
+	sfx_u8 sfx_downlink_data[8] = {0x00};
+	sfx_error_t sfx_error = 0;
+	sfx_rc_t rc1 = RC1;
+	unsigned int downlink_request = ((arguments -> at_param_count) > 1) ? (arguments -> at_param_value)[1] : 0;
+	// Check length.
+	if ((arguments -> at_byte_array_length) > AT_SIGFOX_UPLINK_DATA_MAX_LENGTH) {
+		AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_PARAM_BYTE_ARRAY_INVALID_LENGTH);
+		return;
+	}
+	// Send Sigfox frame (empty frame if there is no parameter).
+	sfx_error = SIGFOX_API_open(&rc1);
+	if (sfx_error == SFX_ERR_NONE) {
+		sfx_error = SIGFOX_API_send_frame((arguments -> at_byte_array), (arguments -> at_byte_array_length), sfx_downlink_data, 2, downlink_request);
+	}
+	SIGFOX_API_close();
+	if (sfx_error == SFX_ERR_NONE) {
+		if (downlink_request != 0) {
+			AT_PrintDownlinkData(sfx_downlink_data);
+		}
+		AT_ReplyOk();
+	}
+	else {
+		// Error from Sigfox library.
+		AT_ReplyError(AT_ERROR_SOURCE_SFX, sfx_error);
+	}
+}
 #endif
-	// Empty or too short command.
-	if (at_ctx.at_rx_buf_idx < AT_COMMAND_MIN_SIZE) {
-		// Reply error.
-		AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_UNKNOWN_COMMAND);
+
+#ifdef AT_COMMANDS_CW
+/* CW COMMAND AT$CW=<frequency_hz>,<enable>,<output_power_dbm><CR> (OUTPUT POWER IS OPTIONAL).
+ * @param arguments:	Parsed parameters.
+ * @return:				None.
+ */
+static void AT_CwCommand(AT_Arguments* arguments) {
+	// Stop previous transmission.
+	SIGFOX_API_stop_continuous_transmission();
+	if ((arguments -> at_param_value)[1] != 0) {
+		SIGFOX_API_start_continuous_transmission((arguments -> at_param_value)[0], SFX_NO_MODULATION);
+		// TBD output power.
+	}
+	AT_ReplyOk();
+}
+#endif
+
+#ifdef AT_COMMANDS_TEST_MODES
+/* SIGFOX TEST MODE COMMAND AT$TM=<rc>,<test_mode><CR>.
+ * @param arguments:	Parsed parameters.
+ * @return:				None.
+ */
+static void AT_TestModeCommand(AT_Arguments* arguments) {
+	// Local variables.
+	sfx_error_t sfx_error = 0;
+	unsigned int rc = (arguments -> at_param_value)[0];
+	unsigned int test_mode = (arguments -> at_param_value)[1];
+	// Check parameters.
+	if (rc >= SFX_RC_LIST_MAX_SIZE) {
+		AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_UNKNOWN_RC);
+	}
+	else if (test_mode > SFX_TEST_MODE_NVM) {
+		AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_UNKNOWN_TEST_MODE);
 	}
 	else {
-		// Test command AT<CR>.
-		if (AT_CompareCommand(AT_IN_COMMAND_TEST) == AT_NO_ERROR) {
-			// Nothing to do, only reply OK to acknowledge serial link.
+		// Call test mode function wth public key.
+		sfx_error = ADDON_SIGFOX_RF_PROTOCOL_API_test_mode(rc, test_mode);
+		if (sfx_error == SFX_ERR_NONE) {
 			AT_ReplyOk();
 		}
-#ifdef AT_COMMANDS_GPS
-		// GPS command AT$GPS=<timeout_seconds><CR>.
-		else if (AT_CompareHeader(AT_IN_HEADER_GPS) == AT_NO_ERROR) {
-			unsigned int timeout_seconds = 0;
-			// Search timeout parameter.
-			get_param_result = AT_GetParameter(AT_PARAM_TYPE_DECIMAL, 1, &timeout_seconds);
-			if (get_param_result == AT_NO_ERROR) {
-				// Start GPS fix.
-				Position gps_position;
-				unsigned int gps_fix_duration = 0;
-				LPUART1_PowerOn();
-				NEOM8N_ReturnCode get_position_result = NEOM8N_GetPosition(&gps_position, timeout_seconds, 0, &gps_fix_duration);
-				LPUART1_PowerOff();
-				switch (get_position_result) {
-				case NEOM8N_SUCCESS:
-					AT_PrintPosition(&gps_position, gps_fix_duration);
-					break;
-				case NEOM8N_TIMEOUT:
-					AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_NEOM8N_TIMEOUT);
-					break;
-				default:
-					break;
-				}
-			}
-			else {
-				// Error in timeout parameter.
-				AT_ReplyError(AT_ERROR_SOURCE_AT, get_param_result);
-			}
+		else {
+			// Error from Sigfox library.
+			AT_ReplyError(AT_ERROR_SOURCE_SFX, sfx_error);
 		}
+	}
+}
+#endif
+
+#ifdef AT_COMMANDS_ACCOUNTING
+/* ACCOUNTING READ COMMAND AT$PWR?<CR>.
+ * @param arguments:	Parsed parameters (unused).
+ * @return:				None.
+ */
+static void AT_AccountingReadCommand(AT_Arguments* arguments) {
+	AT_PrintAccounting();
+}
+
+/* ACCOUNTING RESET COMMAND AT$PWRR<CR>.
+ * @param arguments:	Parsed parameters (unused).
+ * @return:				None.
+ */
+static void AT_AccountingResetCommand(AT_Arguments* arguments) {
+	ACCOUNTING_Reset();
+	RCC_StartClockLevelTime();
+	AT_ReplyOk();
+}
 #endif
+
+#ifdef AT_COMMANDS_PROVISIONING
+/* BINARY PROVISIONING MODE COMMAND AT$PROV<CR>.
+ * @param arguments:	Parsed parameters (unused).
+ * @return:				None.
+ */
+static void AT_ProvisioningCommand(AT_Arguments* arguments) {
 #ifdef AT_COMMANDS_SENSORS
-		// ADC command AT$ADC?<CR>.
-		else if (AT_CompareCommand(AT_IN_COMMAND_ADC) == AT_NO_ERROR) {
-			unsigned int source_voltage_mv = 0;
-			unsigned int supercap_voltage_mv = 0;
-			unsigned int mcu_supply_voltage_mv = 0;
-			// Perform ADC convertions.
-			ADC1_PowerOn();
-			ADC1_PerformAllMeasurements();
-			ADC1_PowerOff();
-			ADC1_GetSourceVoltage(&source_voltage_mv);
-			ADC1_GetSupercapVoltage(&supercap_voltage_mv);
-			ADC1_GetMcuVoltage(&mcu_supply_voltage_mv);
-			// Print results.
-			USART2_SendString("Vsrc=");
-			USART2_SendValue(source_voltage_mv, USART_FORMAT_DECIMAL, 0);
-			USART2_SendString("mV Vcap=");
-			USART2_SendValue(supercap_voltage_mv, USART_FORMAT_DECIMAL, 0);
-			USART2_SendString("mV Vmcu=");
-			USART2_SendValue(mcu_supply_voltage_mv, USART_FORMAT_DECIMAL, 0);
-			USART2_SendString("mV\r\n");
-		}
-		// Temperature and humidity sensor command AT$THS?<CR>.
-		else if (AT_CompareCommand(AT_IN_COMMAND_THS) == AT_NO_ERROR) {
-			signed char sht3x_temperature_degrees = 0;
-			unsigned char sht3x_humidity_percent = 0;
-			// Perform measurements.
-			I2C1_Init();
-			I2C1_PowerOn();
-			SHT3X_PerformMeasurements();
-			I2C1_PowerOff();
-			I2C1_Disable();
-			SHT3X_GetTemperatureComp2(&sht3x_temperature_degrees);
-			SHT3X_GetHumidity(&sht3x_humidity_percent);
-			// Print results.
-			USART2_SendString("T=");
-			if (sht3x_temperature_degrees < 0) {
-				unsigned char sht3x_temperature_abs_degrees = (-1) * sht3x_temperature_degrees;
-				USART2_SendString("-");
-				USART2_SendValue(sht3x_temperature_abs_degrees, USART_FORMAT_DECIMAL, 0);
-			}
-			else {
-				USART2_SendValue(sht3x_temperature_degrees, USART_FORMAT_DECIMAL, 0);
-			}
-			USART2_SendString("dC H=");
-			USART2_SendValue(sht3x_humidity_percent, USART_FORMAT_DECIMAL, 0);
-			USART2_SendString("%\r\n");
-		}
-		// Accelerometer check command AT$ACC?<CR>.
-		else if (AT_CompareCommand(AT_IN_COMMAND_ACC) == AT_NO_ERROR) {
-			// Get sensor ID.
-			I2C1_Init();
-			I2C1_PowerOn();
-			unsigned char mma8653fc_who_am_i = MMA8653FC_GetId();
-			I2C1_PowerOff();
-			I2C1_Disable();
-			// Print results.
-			USART2_SendString("WhoAmI=");
-			USART2_SendValue(mma8653fc_who_am_i, USART_FORMAT_HEXADECIMAL, 0);
-			USART2_SendString("\r\n");
-		}
-		// Accelerometer data command AT$ACC=<enable><CR>.
-		else if (AT_CompareHeader(AT_IN_HEADER_ACC) == AT_NO_ERROR) {
-			// Get enable parameter.
-			unsigned int enable = 0;
-			get_param_result = AT_GetParameter(AT_PARAM_TYPE_BOOLEAN, 1, &enable);
-			if (get_param_result == AT_NO_ERROR) {
-				// Check enable bit.
-				if (enable == 0) {
-					// Stop measurement.
-					I2C1_PowerOff();
-					I2C1_Disable();
-					at_ctx.accelero_measurement_flag = 0;
-					AT_ReplyOk();
-				}
-				else {
-					// Start measurement.
-					I2C1_Init();
-					I2C1_PowerOn();
-					at_ctx.accelero_measurement_flag = 1;
-					AT_ReplyOk();
-				}
-			}
-			else {
-				// Error in enable parameter.
-				AT_ReplyError(AT_ERROR_SOURCE_AT, get_param_result);
-			}
-		}
+	// Accelerometer stream would corrupt binary frames.
+	AT_StopAccelero();
+#endif
+	// Switch to binary mode, host can send frames as soon as OK is received.
+	PROV_Init();
+	at_ctx.prov_mode_flag = 1;
+	AT_ReplyOk();
+}
+#endif
+
+#ifdef AT_COMMANDS_PROFILER
+/* PROFILER READ COMMAND AT$PROF?<CR>.
+ * @param arguments:	Parsed parameters (unused).
+ * @return:				None.
+ */
+static void AT_ProfilerReadCommand(AT_Arguments* arguments) {
+	AT_PrintProfiler();
+}
+
+/* PROFILER RESET COMMAND AT$PROFR<CR>.
+ * @param arguments:	Parsed parameters (unused).
+ * @return:				None.
+ */
+static void AT_ProfilerResetCommand(AT_Arguments* arguments) {
+	PROFILER_Reset();
+	AT_ReplyOk();
+}
+#endif
+
+// Commands table (headers ending with '=' expect parameters, other commands must match the whole line).
+static const AT_Command at_commands[] = {
+	{AT_IN_COMMAND_TEST, {0}, 0, 0, &AT_TestCommand},
+#ifdef AT_COMMANDS_GPS
+	{AT_IN_HEADER_GPS, {AT_PARAM_TYPE_DECIMAL}, 1, 1, &AT_GpsCommand},
+#endif
+#ifdef AT_COMMANDS_SENSORS
+	{AT_IN_COMMAND_ADC, {0}, 0, 0, &AT_AdcCommand},
+	{AT_IN_COMMAND_THS, {0}, 0, 0, &AT_ThsCommand},
+	{AT_IN_COMMAND_ACC, {0}, 0, 0, &AT_AccCheckCommand},
+	{AT_IN_HEADER_ACC, {AT_PARAM_TYPE_BOOLEAN}, 1, 1, &AT_AccDataCommand},
+	{AT_IN_HEADER_ACCS, {AT_PARAM_TYPE_DECIMAL, AT_PARAM_TYPE_BOOLEAN}, 2, 2, &AT_AccStreamCommand},
 #endif
 #ifdef AT_COMMANDS_NVM
-		// NVM reset command AT$NVMR<CR>.
-		else if (AT_CompareCommand(AT_IN_COMMAND_NVMR) == AT_NO_ERROR) {
-			// Reset all NVM field to default value.
-			NVM_ResetDefault();
-			AT_ReplyOk();
-		}
-		// NVM read command AT$NVM=<address_offset><CR>.
-		else if (AT_CompareHeader(AT_IN_HEADER_NVM) == AT_NO_ERROR) {
-			unsigned int address_offset = 0;
-			get_param_result = AT_GetParameter(AT_PARAM_TYPE_DECIMAL, 1, &address_offset);
-			if (get_param_result == AT_NO_ERROR) {
-				// Check if address is reachable.
-				if (address_offset < EEPROM_SIZE) {
-					// Read byte at requested address.
-					unsigned char nvm_byte = 0;
-					NVM_Enable();
-					NVM_ReadByte(address_offset, &nvm_byte);
-					NVM_Disable();
-					// Print byte.
-					USART2_SendValue(nvm_byte, USART_FORMAT_HEXADECIMAL, 1);
-					USART2_SendString("\r\n");
-				}
-				else {
-					AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_NVM_ADDRESS_OVERFLOW);
-				}
-			}
-			else {
-				// Error in address parameter.
-				AT_ReplyError(AT_ERROR_SOURCE_AT, get_param_result);
-			}
-		}
-		// Get ID command AT$ID?<CR>.
-		else if (AT_CompareCommand(AT_IN_COMMAND_ID) == AT_NO_ERROR) {
-			// Enable NVM interface.
-			NVM_Enable();
-			// Retrieve device ID in NVM.
-			unsigned char id_byte = 0;
-			for (byte_idx=0 ; byte_idx<ID_LENGTH ; byte_idx++) {
-				NVM_ReadByte((NVM_SIGFOX_ID_ADDRESS_OFFSET + ID_LENGTH - byte_idx - 1), &id_byte);
-				USART2_SendValue(id_byte, USART_FORMAT_HEXADECIMAL, (byte_idx==0 ? 1 : 0));
-			}
-			USART2_SendString("\r\n");
-			// Disable NVM interface.
-			NVM_Disable();
-		}
-		// Set ID command AT$ID=<id><CR>.
-		else if (AT_CompareHeader(AT_IN_HEADER_ID) == AT_NO_ERROR) {
-			unsigned char param_id[ID_LENGTH] = {0};
-			get_param_result = AT_GetByteArray(1, param_id, ID_LENGTH, &extracted_length);
-			if (get_param_result == AT_NO_ERROR) {
-				// Check length.
-				if (extracted_length == ID_LENGTH) {
-					// Enable NVM interface.
-					NVM_Enable();
-					// Write device ID in NVM.
-					for (byte_idx=0 ; byte_idx<ID_LENGTH ; byte_idx++) {
-						NVM_WriteByte((NVM_SIGFOX_ID_ADDRESS_OFFSET + ID_LENGTH - byte_idx - 1), param_id[byte_idx]);
-					}
-					AT_ReplyOk();
-					// Disable NVM interface.
-					NVM_Disable();
-				}
-				else {
-					AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_PARAM_BYTE_ARRAY_INVALID_LENGTH);
-				}
-			}
-			else {
-				// Error in ID parameter.
-				AT_ReplyError(AT_ERROR_SOURCE_AT, get_param_result);
-			}
-		}
-		// Get key command AT$KEY?<CR>.
-		else if (AT_CompareCommand(AT_IN_COMMAND_KEY) == AT_NO_ERROR) {
-			// Enable NVM interface.
-			NVM_Enable();
-			// Retrieve device key in NVM.
-			unsigned char id_byte = 0;
-			unsigned char byte_idx = 0;
-			for (byte_idx=0 ; byte_idx<AES_BLOCK_SIZE ; byte_idx++) {
-				NVM_ReadByte((NVM_SIGFOX_KEY_ADDRESS_OFFSET + byte_idx), &id_byte);
-				USART2_SendValue(id_byte, USART_FORMAT_HEXADECIMAL, (byte_idx==0 ? 1 : 0));
-			}
-			USART2_SendString("\r\n");
-			// Disable NVM interface.
-			NVM_Disable();
-		}
-		// Set key command AT$KEY=<id><CR>.
-		else if (AT_CompareHeader(AT_IN_HEADER_KEY) == AT_NO_ERROR) {
-			unsigned char param_key[AES_BLOCK_SIZE] = {0};
-			get_param_result = AT_GetByteArray(1, param_key, AES_BLOCK_SIZE, &extracted_length);
-			if (get_param_result == AT_NO_ERROR) {
-				// Check length.
-				if (extracted_length == AES_BLOCK_SIZE) {
-					// Enable NVM interface.
-					NVM_Enable();
-					// Write device ID in NVM.
-					for (byte_idx=0 ; byte_idx<AES_BLOCK_SIZE ; byte_idx++) {
-						NVM_WriteByte((NVM_SIGFOX_KEY_ADDRESS_OFFSET + byte_idx), param_key[byte_idx]);
-					}
-					AT_ReplyOk();
-					// Disable NVM interface.
-					NVM_Disable();
-				}
-				else {
-					AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_PARAM_BYTE_ARRAY_INVALID_LENGTH);
-				}
-			}
-			else {
-				// Error in ID parameter.
-				AT_ReplyError(AT_ERROR_SOURCE_AT, get_param_result);
-			}
-		}
+	{AT_IN_COMMAND_NVMR, {0}, 0, 0, &AT_NvmResetCommand},
+	{AT_IN_HEADER_NVM, {AT_PARAM_TYPE_DECIMAL}, 1, 1, &AT_NvmReadCommand},
+	{AT_IN_HEADER_NVMD, {AT_PARAM_TYPE_DECIMAL, AT_PARAM_TYPE_DECIMAL}, 2, 2, &AT_NvmDumpCommand},
+	{AT_IN_HEADER_NVMW, {AT_PARAM_TYPE_DECIMAL, AT_PARAM_TYPE_BYTE_ARRAY}, 2, 2, &AT_NvmWriteCommand},
+	{AT_IN_HEADER_NVMC, {AT_PARAM_TYPE_DECIMAL, AT_PARAM_TYPE_DECIMAL}, 2, 2, &AT_NvmCrcCommand},
+	{AT_IN_COMMAND_ID, {0}, 0, 0, &AT_GetIdCommand},
+	{AT_IN_HEADER_ID, {AT_PARAM_TYPE_BYTE_ARRAY}, 1, 1, &AT_SetIdCommand},
+	{AT_IN_COMMAND_KEY, {0}, 0, 0, &AT_GetKeyCommand},
+	{AT_IN_HEADER_KEY, {AT_PARAM_TYPE_BYTE_ARRAY}, 1, 1, &AT_SetKeyCommand},
 #endif
 #ifdef AT_COMMANDS_SIGFOX
-		// Sigfox send OOB command AT$SO<CR>.
-		else if (AT_CompareCommand(AT_IN_COMMAND_OOB) == AT_NO_ERROR) {
-			// Send Sigfox OOB frame.
-			sfx_error = SIGFOX_API_open(&rc1);
-			if (sfx_error == SFX_ERR_NONE) {
-				sfx_error = SIGFOX_API_send_outofband(SFX_OOB_SERVICE);
-			}
-			SIGFOX_API_close();
-			if (sfx_error == SFX_ERR_NONE) {
-				AT_ReplyOk();
-			}
-			else {
-				// Error from Sigfox library.
-				AT_ReplyError(AT_ERROR_SOURCE_SFX, sfx_error);
-			}
-		}
-		// Sigfox send bit command AT$SB=<bit>,<downlink_request><CR>.
-		else if (AT_CompareHeader(AT_IN_HEADER_SB) == AT_NO_ERROR) {
-			unsigned int data_bit = 0;
-			// First try with 2 parameters.
-			get_param_result = AT_GetParameter(AT_PARAM_TYPE_BOOLEAN, 0, &data_bit);
-			if (get_param_result == AT_NO_ERROR) {
-				// Try parsing downlink request parameter.
-				unsigned int downlink_request = 0;
-				get_param_result =  AT_GetParameter(AT_PARAM_TYPE_BOOLEAN, 1, &downlink_request);
-				if (get_param_result == AT_NO_ERROR) {
-					// Send Sigfox bit with specified downlink request.
-					sfx_error = SIGFOX_API_open(&rc1);
-					if (sfx_error == SFX_ERR_NONE) {
-						sfx_error = SIGFOX_API_send_bit(data_bit, sfx_downlink_data, 2, downlink_request);
-					}
-					SIGFOX_API_close();
-					if (sfx_error == SFX_ERR_NONE) {
-						if (downlink_request != 0) {
-							AT_PrintDownlinkData(sfx_downlink_data);
-						}
-						AT_ReplyOk();
-					}
-					else {
-						// Error from Sigfox library.
-						AT_ReplyError(AT_ERROR_SOURCE_SFX, sfx_error);
-					}
-				}
-				else {
-					// Error in downlink request parameter.
-					AT_ReplyError(AT_ERROR_SOURCE_AT, get_param_result);
-				}
-			}
-			else {
-				// Try with 1 parameter.
-				get_param_result = AT_GetParameter(AT_PARAM_TYPE_BOOLEAN, 1, &data_bit);
-				if (get_param_result == AT_NO_ERROR) {
-					// Send Sigfox bit with no downlink request (by default).
-					sfx_error = SIGFOX_API_open(&rc1);
-					if (sfx_error == SFX_ERR_NONE) {
-						sfx_error = SIGFOX_API_send_bit(data_bit, sfx_downlink_data, 2, 0);
-					}
-					SIGFOX_API_close();
-					if (sfx_error == SFX_ERR_NONE) {
-						AT_ReplyOk();
-					}
-					else {
-						// Error from Sigfox library.
-						AT_ReplyError(AT_ERROR_SOURCE_SFX, sfx_error);
-					}
-				}
-				else {
-					// Error in data parameter.
-					AT_ReplyError(AT_ERROR_SOURCE_AT, get_param_result);
-				}
-			}
-		}
-		// Sigfox send empty frame command AT$SF<CR>.
-		else if (AT_CompareCommand(AT_IN_COMMAND_SF) == AT_NO_ERROR) {
-			// Send Sigfox empty frame.
-			sfx_error = SIGFOX_API_open(&rc1);
-			if (sfx_error == SFX_ERR_NONE) {
-				sfx_error = SIGFOX_API_send_frame(sfx_uplink_data, 0, sfx_downlink_data, 2, 0);
-			}
-			SIGFOX_API_close();
-			if (sfx_error == SFX_ERR_NONE) {
-				AT_ReplyOk();
-			}
-			else {
-				// Error from Sigfox library.
-				AT_ReplyError(AT_ERROR_SOURCE_SFX, sfx_error);
-			}
-		}
-		// Sigfox send frame command AT$SF=<data>,<downlink_request><CR>.
-		else if (AT_CompareHeader(AT_IN_HEADER_SF) == AT_NO_ERROR) {
-			// First try with 2 parameters.
-			get_param_result = AT_GetByteArray(0, sfx_uplink_data, 12, &extracted_length);
-			if (get_param_result == AT_NO_ERROR) {
-				// Try parsing downlink request parameter.
-				unsigned int downlink_request = 0;
-				get_param_result =  AT_GetParameter(AT_PARAM_TYPE_BOOLEAN, 1, &downlink_request);
-				if (get_param_result == AT_NO_ERROR) {
-					// Send Sigfox frame with specified downlink request.
-					sfx_error = SIGFOX_API_open(&rc1);
-					if (sfx_error == SFX_ERR_NONE) {
-						sfx_error = SIGFOX_API_send_frame(sfx_uplink_data, extracted_length, sfx_downlink_data, 2, downlink_request);
-					}
-					SIGFOX_API_close();
-					if (sfx_error == SFX_ERR_NONE) {
-						if (downlink_request != 0) {
-							AT_PrintDownlinkData(sfx_downlink_data);
-						}
-						AT_ReplyOk();
-					}
-					else {
-						// Error from Sigfox library.
-						AT_ReplyError(AT_ERROR_SOURCE_SFX, sfx_error);
-					}
-				}
-				else {
-					// Error in downlink request parameter.
-					AT_ReplyError(AT_ERROR_SOURCE_AT, get_param_result);
-				}
-			}
-			else {
-				// Try with 1 parameter.
-				get_param_result = AT_GetByteArray(1, sfx_uplink_data, 12, &extracted_length);
-				if (get_param_result == AT_NO_ERROR) {
-					// Send Sigfox frame with no downlink request (by default).
-					sfx_error = SIGFOX_API_open(&rc1);
-					if (sfx_error == SFX_ERR_NONE) {
-						sfx_error = SIGFOX_API_send_frame(sfx_uplink_data, extracted_length, sfx_downlink_data, 2, 0);
-					}
-					SIGFOX_API_close();
-					if (sfx_error == SFX_ERR_NONE) {
-						AT_ReplyOk();
-					}
-					else {
-						// Error from Sigfox library.
-						AT_ReplyError(AT_ERROR_SOURCE_SFX, sfx_error);
-					}
-				}
-				else {
-					// Error in data parameter.
-					AT_ReplyError(AT_ERROR_SOURCE_AT, get_param_result);
-				}
-			}
-		}
+	{AT_IN_COMMAND_OOB, {0}, 0, 0, &AT_SendOobCommand},
+	{AT_IN_HEADER_SB, {AT_PARAM_TYPE_BOOLEAN, AT_PARAM_TYPE_BOOLEAN}, 1, 2, &AT_SendBitCommand},
+	{AT_IN_COMMAND_SF, {0}, 0, 0, &AT_SendFrameCommand},
+	{AT_IN_HEADER_SF, {AT_PARAM_TYPE_BYTE_ARRAY, AT_PARAM_TYPE_BOOLEAN}, 1, 2, &AT_SendFrameCommand},
 #endif
 #ifdef AT_COMMANDS_CW
-		// CW command AT$CW=<frequency_hz>,<enable>,<output_power_dbm><CR>.
-		else if (AT_CompareHeader(AT_IN_HEADER_CW) == AT_NO_ERROR) {
-			unsigned int frequency_hz = 0;
-			// Search frequency parameter.
-			get_param_result = AT_GetParameter(AT_PARAM_TYPE_DECIMAL, 0, &frequency_hz);
-			if (get_param_result == AT_NO_ERROR) {
-				unsigned int enable = 0;
-				// First try with 3 parameters.
-				get_param_result = AT_GetParameter(AT_PARAM_TYPE_BOOLEAN, 0, &enable);
-				if (get_param_result == AT_OUT_ERROR_NO_SEP_FOUND) {
-					// Power is not given, try to parse enable as last parameter.
-					get_param_result = AT_GetParameter(AT_PARAM_TYPE_BOOLEAN, 1, &enable);
-					if (get_param_result == AT_NO_ERROR) {
-						// CW with default output power.
-						SIGFOX_API_stop_continuous_transmission();
-						if (enable != 0) {
-							SIGFOX_API_start_continuous_transmission(frequency_hz, SFX_NO_MODULATION);
-						}
-						AT_ReplyOk();
-					}
-					else {
-						// Error in enable parameter.
-						AT_ReplyError(AT_ERROR_SOURCE_AT, get_param_result);
-					}
-				}
-				else if (get_param_result == AT_NO_ERROR) {
-					// There is a third parameter, try to parse power.
-					unsigned int output_power_dbm = 0;
-					get_param_result = AT_GetParameter(AT_PARAM_TYPE_DECIMAL, 1, &output_power_dbm);
-					if (get_param_result == AT_NO_ERROR) {
-						// CW with given output power.
-						SIGFOX_API_stop_continuous_transmission();
-						if (enable != 0) {
-							SIGFOX_API_start_continuous_transmission(frequency_hz, SFX_NO_MODULATION);
-							// TBD output power.
-						}
-						AT_ReplyOk();
-					}
-					else {
-						// Error in power parameter.
-						AT_ReplyError(AT_ERROR_SOURCE_AT, get_param_result);
-					}
-				}
-				else {
-					// Error in enable parameter.
-					AT_ReplyError(AT_ERROR_SOURCE_AT, get_param_result);
-				}
-			}
-			else {
-				// Error in frequency parameter.
-				AT_ReplyError(AT_ERROR_SOURCE_AT, get_param_result);
-			}
-		}
+	{AT_IN_HEADER_CW, {AT_PARAM_TYPE_DECIMAL, AT_PARAM_TYPE_BOOLEAN, AT_PARAM_TYPE_DECIMAL}, 2, 3, &AT_CwCommand},
 #endif
 #ifdef AT_COMMANDS_TEST_MODES
-		// Sigfox test mode command AT$TM=<rc>,<test_mode><CR>.
-		else if (AT_CompareHeader(AT_IN_HEADER_TM) == AT_NO_ERROR) {
-			unsigned int rc = 0;
-			// Search RC parameter.
-			get_param_result = AT_GetParameter(AT_PARAM_TYPE_DECIMAL, 0, &rc);
-			if (get_param_result == AT_NO_ERROR) {
-				// Check value.
-				if (rc < SFX_RC_LIST_MAX_SIZE) {
-					// Search test mode number.
-					unsigned int test_mode = 0;
-					get_param_result =  AT_GetParameter(AT_PARAM_TYPE_DECIMAL, 1, &test_mode);
-					if (get_param_result == AT_NO_ERROR) {
-						// Check parameters.
-						if (test_mode <= SFX_TEST_MODE_NVM) {
-							// Call test mode function wth public key.
-							sfx_error = ADDON_SIGFOX_RF_PROTOCOL_API_test_mode(rc, test_mode);
-							if (sfx_error == SFX_ERR_NONE) {
-								AT_ReplyOk();
-							}
-							else {
-								// Error from Sigfox library.
-								AT_ReplyError(AT_ERROR_SOURCE_SFX, sfx_error);
-							}
-						}
-						else {
-							// Invalid test mode.
-							AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_UNKNOWN_TEST_MODE);
-						}
-					}
-					else {
-						// Error in test_mode parameter.
-						AT_ReplyError(AT_ERROR_SOURCE_AT, get_param_result);
-					}
-				}
-				else {
-					// Invalid RC.
-					AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_UNKNOWN_RC);
-				}
+	{AT_IN_HEADER_TM, {AT_PARAM_TYPE_DECIMAL, AT_PARAM_TYPE_DECIMAL}, 2, 2, &AT_TestModeCommand},
+#endif
+#ifdef AT_COMMANDS_ACCOUNTING
+	{AT_IN_COMMAND_PWR, {0}, 0, 0, &AT_AccountingReadCommand},
+	{AT_IN_COMMAND_PWRR, {0}, 0, 0, &AT_AccountingResetCommand},
+#endif
+#ifdef AT_COMMANDS_PROVISIONING
+	{AT_IN_COMMAND_PROV, {0}, 0, 0, &AT_ProvisioningCommand},
+#endif
+#ifdef AT_COMMANDS_PROFILER
+	{AT_IN_COMMAND_PROF, {0}, 0, 0, &AT_ProfilerReadCommand},
+	{AT_IN_COMMAND_PROFR, {0}, 0, 0, &AT_ProfilerResetCommand},
+#endif
+};
+
+/* COMPUTE THE HASH OF A COMMAND HEADER.
+ * @param header:			Header characters.
+ * @param header_length:	Number of characters.
+ * @return:					Index in hash table.
+ */
+static unsigned char AT_ComputeHash(volatile unsigned char* header, unsigned char header_length) {
+	// Local variables.
+	unsigned char idx = 0;
+	unsigned short hash = 0;
+	// Multiplicative string hash.
+	for (idx=0 ; idx<header_length ; idx++) {
+		hash = (hash * AT_HASH_MULTIPLIER) + header[idx];
+	}
+	return (hash & (AT_HASH_TABLE_SIZE - 1));
+}
+
+/* GET THE LENGTH OF A COMMAND HEADER.
+ * @param header:	Null terminated string.
+ * @return:			Number of characters.
+ */
+static unsigned char AT_GetHeaderLength(const char* header) {
+	unsigned char length = 0;
+	while (header[length] != AT_NULL_CHAR) length++;
+	return length;
+}
+
+/* BUILD COMMANDS HASH TABLE (OPEN ADDRESSING WITH LINEAR PROBING).
+ * @param:	None.
+ * @return:	None.
+ */
+static void AT_BuildHashTable(void) {
+	// Local variables.
+	unsigned char command_idx = 0;
+	unsigned char hash_idx = 0;
+	// Reset table.
+	for (hash_idx=0 ; hash_idx<AT_HASH_TABLE_SIZE ; hash_idx++) {
+		at_ctx.at_hash_table[hash_idx] = AT_HASH_TABLE_EMPTY;
+	}
+	// Insert all commands.
+	for (command_idx=0 ; command_idx<AT_COMMANDS_NUMBER ; command_idx++) {
+		hash_idx = AT_ComputeHash((unsigned char*) at_commands[command_idx].at_header, AT_GetHeaderLength(at_commands[command_idx].at_header));
+		while (at_ctx.at_hash_table[hash_idx] != AT_HASH_TABLE_EMPTY) {
+			hash_idx = (hash_idx + 1) & (AT_HASH_TABLE_SIZE - 1);
+		}
+		at_ctx.at_hash_table[hash_idx] = command_idx;
+	}
+}
+
+/* SEARCH THE COMMAND CORRESPONDING TO THE CURRENT AT COMMAND BUFFER.
+ * @param:	None.
+ * @return:	Index of the command in table, AT_COMMANDS_NUMBER if command is unknown.
+ */
+static unsigned char AT_SearchCommand(void) {
+	// Local variables.
+	unsigned char header_length = 0;
+	unsigned char hash_idx = 0;
+	unsigned char command_idx = 0;
+	unsigned char idx = 0;
+	// Header ends after the first '=' or before line end (last character of the buffer).
+	while ((header_length < (at_ctx.at_rx_buf_idx - 1)) && (at_ctx.at_rx_buf[header_length] != AT_EQUAL_CHAR)) {
+		header_length++;
+	}
+	if ((header_length < (at_ctx.at_rx_buf_idx - 1)) && (at_ctx.at_rx_buf[header_length] == AT_EQUAL_CHAR)) {
+		header_length++;
+	}
+	// Probe hash table until an empty slot is found.
+	hash_idx = AT_ComputeHash(at_ctx.at_rx_buf, header_length);
+	while (at_ctx.at_hash_table[hash_idx] != AT_HASH_TABLE_EMPTY) {
+		command_idx = at_ctx.at_hash_table[hash_idx];
+		// Confirm match.
+		if (AT_GetHeaderLength(at_commands[command_idx].at_header) == header_length) {
+			for (idx=0 ; idx<header_length ; idx++) {
+				if (at_commands[command_idx].at_header[idx] != at_ctx.at_rx_buf[idx]) break;
 			}
-			else {
-				// Error in RC parameter.
-				AT_ReplyError(AT_ERROR_SOURCE_AT, get_param_result);
+			if (idx == header_length) {
+				// Parameters start after header.
+				at_ctx.start_idx = header_length;
+				return command_idx;
 			}
 		}
-#endif
-		// Unknown command.
+		hash_idx = (hash_idx + 1) & (AT_HASH_TABLE_SIZE - 1);
+	}
+	return AT_COMMANDS_NUMBER;
+}
+
+/* PARSE ALL PARAMETERS OF A COMMAND ACCORDING TO ITS SCHEMA.
+ * @param command:		Command descriptor.
+ * @param arguments:	Pointer to the structure that will contain parsed parameters.
+ * @return return_code:	AT error code.
+ */
+static unsigned short AT_ParseArguments(const AT_Command* command, AT_Arguments* arguments) {
+	// Local variables.
+	unsigned short return_code = AT_NO_ERROR;
+	unsigned char param_idx = 0;
+	unsigned char param_count = 0;
+	unsigned char last_param = 0;
+	unsigned int idx = 0;
+	// Reset arguments.
+	(arguments -> at_param_count) = 0;
+	(arguments -> at_byte_array_length) = 0;
+	for (param_idx=0 ; param_idx<AT_PARAMETERS_MAX ; param_idx++) {
+		(arguments -> at_param_value)[param_idx] = 0;
+	}
+	if ((command -> at_param_count_max) == 0) return AT_NO_ERROR;
+	// Count parameters (number of separators + 1), extra separators are reported by the last parameter parsing.
+	param_count = 1;
+	for (idx=at_ctx.start_idx ; idx<at_ctx.at_rx_buf_idx ; idx++) {
+		if (at_ctx.at_rx_buf[idx] == AT_SEPARATOR_CHAR) param_count++;
+	}
+	if (param_count > (command -> at_param_count_max)) {
+		param_count = (command -> at_param_count_max);
+	}
+	if (param_count < (command -> at_param_count_min)) {
+		return AT_OUT_ERROR_NO_SEP_FOUND;
+	}
+	// Parse parameters.
+	for (param_idx=0 ; param_idx<param_count ; param_idx++) {
+		last_param = (param_idx == (param_count - 1)) ? 1 : 0;
+		if ((command -> at_param_types)[param_idx] == AT_PARAM_TYPE_BYTE_ARRAY) {
+			return_code = AT_GetByteArray(last_param, (arguments -> at_byte_array), AT_BYTE_ARRAY_MAX_LENGTH, &(arguments -> at_byte_array_length));
+		}
 		else {
-			AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_UNKNOWN_COMMAND);
+			return_code = AT_GetParameter((command -> at_param_types)[param_idx], last_param, &((arguments -> at_param_value)[param_idx]));
 		}
+		if (return_code != AT_NO_ERROR) break;
+		(arguments -> at_param_count)++;
+	}
+	return return_code;
+}
+
+/* PARSE THE CURRENT AT COMMAND BUFFER.
+ * @param:	None.
+ * @return:	None.
+ */
+static void AT_DecodeRxBuffer(void) {
+	// At this step, 'at_buf_idx' is 1 character after the first line end character (<CR> or <LF>).
+	unsigned char command_idx = AT_COMMANDS_NUMBER;
+	unsigned short get_param_result = 0;
+	AT_Arguments arguments;
+	// Empty or too short command.
+	if (at_ctx.at_rx_buf_idx < AT_COMMAND_MIN_SIZE) {
+		// Reply error.
+		AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_UNKNOWN_COMMAND);
+		return;
+	}
+	// Search command in table.
+	command_idx = AT_SearchCommand();
+	if (command_idx >= AT_COMMANDS_NUMBER) {
+		AT_ReplyError(AT_ERROR_SOURCE_AT, AT_OUT_ERROR_UNKNOWN_COMMAND);
+		return;
+	}
+	// Parse parameters and call handler.
+	get_param_result = AT_ParseArguments(&(at_commands[command_idx]), &arguments);
+	if (get_param_result == AT_NO_ERROR) {
+		at_commands[command_idx].at_handler(&arguments);
+	}
+	else {
+		AT_ReplyError(AT_ERROR_SOURCE_AT, get_param_result);
 	}
 }
 
@@ -1110,9 +1527,14 @@ static void AT_Reset(void) {
  */
 void AT_Init(void) {
 	// Init parser.
+	AT_BuildHashTable();
 	AT_Reset();
 	// Init accelero measurement flag.
-	at_ctx.accelero_measurement_flag = 0;
+	at_ctx.accelero_mode = AT_ACCELERO_MODE_OFF;
+	at_ctx.accelero_timer_id = 0;
+	at_ctx.accelero_stream_count = 0;
+	at_ctx.accelero_stream_dropped = 0;
+	at_ctx.prov_mode_flag = 0;
 }
 
 /* MAIN TASK OF AT COMMAND MANAGER.
@@ -1120,15 +1542,65 @@ void AT_Init(void) {
  * @return:	None.
  */
 void AT_Task(void) {
+#ifdef AT_COMMANDS_SENSORS
+	// Local variables.
+	signed int x = 0;
+	signed int y = 0;
+	signed int z = 0;
+#endif
+	// Binary provisioning mode.
+	if (at_ctx.prov_mode_flag != 0) {
+		if (PROV_Task() != 0) {
+			// Go back to AT mode.
+			at_ctx.prov_mode_flag = 0;
+			AT_Reset();
+		}
+		return;
+	}
 	// Trigger decoding function if line end found.
 	if (at_ctx.at_line_end_flag) {
 		AT_DecodeRxBuffer();
 		AT_Reset();
 	}
+#ifdef AT_COMMANDS_SENSORS
 	// Perform accelero measurement if required.
-	if (at_ctx.accelero_measurement_flag != 0) {
-		AT_PrintAcceleroData();
+	switch (at_ctx.accelero_mode) {
+	case AT_ACCELERO_MODE_PERIODIC:
+		if (LPTIM1_GetTimerFlag(at_ctx.accelero_timer_id) != 0) {
+			LPTIM1_ClearTimerFlag(at_ctx.accelero_timer_id);
+			// Skip sample instead of blocking if host link is too slow.
+			if (USART2_GetTxFreeSpace() >= AT_ACCELERO_LINE_LENGTH_MAX) {
+				MMA8653FC_GetData(&x, &y, &z);
+				AT_PrintAcceleroData(x, y, z);
+			}
+		}
+		break;
+	case AT_ACCELERO_MODE_STREAM_TEXT:
+	case AT_ACCELERO_MODE_STREAM_BINARY:
+		// Data ready pin stays high until sample is read (level is checked so that a missed edge can not stop the stream).
+		if (GPIO_Read(&GPIO_ACCELERO_IRQ) != 0) {
+			AT_StreamAcceleroData();
+		}
+		break;
+	default:
+		break;
 	}
+#endif
+}
+
+/* CHECK IF AT MANAGER HAS NOTHING TO PROCESS.
+ * @param:	None.
+ * @return:	1 if the MCU can enter stop mode until next interrupt, 0 if AT_Task() must be called.
+ */
+unsigned char AT_IsIdle(void) {
+	// Binary provisioning mode.
+	if (at_ctx.prov_mode_flag != 0) return PROV_IsIdle();
+	// Command line end received.
+	if (at_ctx.at_line_end_flag != 0) return 0;
+	// Accelerometer period elapsed or sample ready.
+	if ((at_ctx.accelero_mode == AT_ACCELERO_MODE_PERIODIC) && (LPTIM1_GetTimerFlag(at_ctx.accelero_timer_id) != 0)) return 0;
+	if ((at_ctx.accelero_mode >= AT_ACCELERO_MODE_STREAM_TEXT) && (GPIO_Read(&GPIO_ACCELERO_IRQ) != 0)) return 0;
+	return 1;
 }
 
 /* FILL AT COMMAND BUFFER WITH A NEW BYTE FROM USART.
@@ -1137,6 +1609,11 @@ void AT_Task(void) {
  */
 void AT_FillRxBuffer(unsigned char rx_byte) {
 	unsigned char increment_idx = 1;
+	// Give byte to binary protocol decoder.
+	if (at_ctx.prov_mode_flag != 0) {
+		PROV_FillRxBuffer(rx_byte);
+		return;
+	}
 	// Append incoming byte to buffer.
 	if ((rx_byte == AT_CR_CHAR) || (rx_byte == AT_LF_CHAR)) {
 		// Append line end only if the previous byte was not allready a line end and if other characters are allready presents.
@@ -0,0 +1,173 @@
+/*
+ * energy.c
+ */
+
+#include "energy.h"
+
+/*** ENERGY local macros ***/
+
+#define ENERGY_SUPERCAP_CAPACITANCE_MF		1000 // Supercap value in mF.
+#define ENERGY_SUPERCAP_VOLTAGE_MAX_MV		2700 // Supercap rated voltage.
+#define ENERGY_LEVEL_TARGET_LOW_PERCENT		40
+#define ENERGY_LEVEL_TARGET_HIGH_PERCENT	80
+#define ENERGY_PERIOD_FACTOR_NOMINAL		100 // Periods are multiplied by (factor / 100).
+#define ENERGY_PERIOD_FACTOR_MIN			25
+#define ENERGY_PERIOD_FACTOR_MAX			3200
+#define ENERGY_SOURCE_VOLTAGE_AVERAGE_DEPTH	4 // Exponential moving average weight (1/depth).
+
+/*** ENERGY local structures ***/
+
+typedef struct {
+	unsigned char energy_data_valid;
+	unsigned int energy_supercap_voltage_min_mv;	// Voltage under which stored energy is considered as unusable.
+	unsigned int energy_timestamp_seconds;		// Timestamp of the last update.
+	unsigned int energy_stored_mj;				// Usable energy stored in supercap.
+	unsigned char energy_level_percent;			// Usable energy relatively to supercap capacity.
+	signed int energy_balance_uw;				// Average power (harvested minus consumed) since last update.
+	unsigned int energy_source_voltage_mv;		// Averaged source voltage.
+	unsigned int energy_period_factor;
+} ENERGY_Context;
+
+/*** ENERGY local global variables ***/
+
+static ENERGY_Context energy_ctx;
+
+/*** ENERGY local functions ***/
+
+/* COMPUTE ENERGY STORED IN SUPERCAP (E=1/2*C*V^2).
+ * @param supercap_voltage_mv:	Supercap voltage in mV.
+ * @return:						Stored energy in mJ.
+ */
+static unsigned int ENERGY_ComputeSupercapEnergy(unsigned int supercap_voltage_mv) {
+	// Split computation to avoid 32-bits overflow: E(mJ) = (C(mF) * V(mV)^2) / (2 * 10^6).
+	unsigned int voltage_squared = (supercap_voltage_mv * supercap_voltage_mv) / 1000;
+	return ((voltage_squared * ENERGY_SUPERCAP_CAPACITANCE_MF) / 2000);
+}
+
+/*** ENERGY functions ***/
+
+/* INIT ENERGY MANAGER.
+ * @param supercap_voltage_min_mv:	Supercap voltage under which stored energy is considered as unusable.
+ * @return:							None.
+ */
+void ENERGY_Init(unsigned int supercap_voltage_min_mv) {
+	// Reset estimation.
+	energy_ctx.energy_data_valid = 0;
+	energy_ctx.energy_supercap_voltage_min_mv = supercap_voltage_min_mv;
+	energy_ctx.energy_timestamp_seconds = 0;
+	energy_ctx.energy_stored_mj = 0;
+	energy_ctx.energy_level_percent = 0;
+	energy_ctx.energy_balance_uw = 0;
+	energy_ctx.energy_source_voltage_mv = 0;
+	energy_ctx.energy_period_factor = ENERGY_PERIOD_FACTOR_NOMINAL;
+}
+
+/* UPDATE ENERGY ESTIMATION AND PERIODS FACTOR WITH A NEW MEASUREMENT.
+ * @param snapshot:	Sensors data.
+ * @return:			None.
+ */
+void ENERGY_Update(SENSORS_Snapshot* snapshot) {
+	// Local variables.
+	unsigned int energy_min_mj = ENERGY_ComputeSupercapEnergy(energy_ctx.energy_supercap_voltage_min_mv);
+	unsigned int energy_max_mj = ENERGY_ComputeSupercapEnergy(ENERGY_SUPERCAP_VOLTAGE_MAX_MV);
+	unsigned int stored_mj = ENERGY_ComputeSupercapEnergy((*snapshot).supercap_voltage_mv);
+	unsigned int level_percent = 0;
+	unsigned int elapsed_seconds = 0;
+	unsigned char harvesting = 0;
+	// Ignore snapshot already taken into account.
+	if ((energy_ctx.energy_data_valid != 0) && ((*snapshot).timestamp_seconds == energy_ctx.energy_timestamp_seconds)) return;
+	// Compute usable energy and level.
+	stored_mj = (stored_mj > energy_min_mj) ? (stored_mj - energy_min_mj) : 0;
+	level_percent = ((stored_mj * 100) / (energy_max_mj - energy_min_mj));
+	if (level_percent > 100) {
+		level_percent = 100;
+	}
+	energy_ctx.energy_level_percent = (unsigned char) level_percent;
+	// Compute power balance since last update.
+	if (energy_ctx.energy_data_valid != 0) {
+		elapsed_seconds = ((*snapshot).timestamp_seconds - energy_ctx.energy_timestamp_seconds);
+		if (elapsed_seconds > 0) {
+			energy_ctx.energy_balance_uw = (((signed int) stored_mj - (signed int) energy_ctx.energy_stored_mj) * 1000) / ((signed int) elapsed_seconds);
+		}
+		// Source voltage trend.
+		energy_ctx.energy_source_voltage_mv = ((energy_ctx.energy_source_voltage_mv * (ENERGY_SOURCE_VOLTAGE_AVERAGE_DEPTH - 1)) + (*snapshot).source_voltage_mv) / ENERGY_SOURCE_VOLTAGE_AVERAGE_DEPTH;
+	}
+	else {
+		energy_ctx.energy_balance_uw = 0;
+		energy_ctx.energy_source_voltage_mv = (*snapshot).source_voltage_mv;
+	}
+	energy_ctx.energy_stored_mj = stored_mj;
+	energy_ctx.energy_timestamp_seconds = (*snapshot).timestamp_seconds;
+	energy_ctx.energy_data_valid = 1;
+	// Supercap is charging when source voltage is above.
+	harvesting = (energy_ctx.energy_source_voltage_mv > (*snapshot).supercap_voltage_mv) ? 1 : 0;
+	// Adapt periods to keep energy level in target band.
+	if (energy_ctx.energy_level_percent < ENERGY_LEVEL_TARGET_LOW_PERCENT) {
+		// Stretch periods quickly to survive low harvest.
+		energy_ctx.energy_period_factor *= 2;
+	}
+	else if (energy_ctx.energy_level_percent > ENERGY_LEVEL_TARGET_HIGH_PERCENT) {
+		// Shrink periods, quickly if source is still charging the supercap.
+		energy_ctx.energy_period_factor -= (harvesting != 0) ? (energy_ctx.energy_period_factor / 2) : (energy_ctx.energy_period_factor / 4);
+	}
+	else {
+		// Follow power balance inside target band.
+		if ((energy_ctx.energy_balance_uw < 0) && (harvesting == 0)) {
+			energy_ctx.energy_period_factor += (energy_ctx.energy_period_factor / 4);
+		}
+		if (energy_ctx.energy_balance_uw > 0) {
+			energy_ctx.energy_period_factor -= (energy_ctx.energy_period_factor / 4);
+		}
+	}
+	// Clamp factor.
+	if (energy_ctx.energy_period_factor < ENERGY_PERIOD_FACTOR_MIN) {
+		energy_ctx.energy_period_factor = ENERGY_PERIOD_FACTOR_MIN;
+	}
+	if (energy_ctx.energy_period_factor > ENERGY_PERIOD_FACTOR_MAX) {
+		energy_ctx.energy_period_factor = ENERGY_PERIOD_FACTOR_MAX;
+	}
+}
+
+/* GET USABLE ENERGY STORED IN SUPERCAP.
+ * @param stored_energy_mj:	Pointer to int that will contain stored energy in mJ.
+ * @return:					None.
+ */
+void ENERGY_GetStoredEnergy(unsigned int* stored_energy_mj) {
+	(*stored_energy_mj) = energy_ctx.energy_stored_mj;
+}
+
+/* GET ENERGY LEVEL.
+ * @param level_percent:	Pointer to byte that will contain usable energy relatively to supercap capacity.
+ * @return:					None.
+ */
+void ENERGY_GetLevel(unsigned char* level_percent) {
+	(*level_percent) = energy_ctx.energy_level_percent;
+}
+
+/* GET AVERAGE POWER BALANCE BETWEEN THE TWO LAST UPDATES.
+ * @param balance_uw:	Pointer to int that will contain harvested minus consumed power in uW.
+ * @return:				None.
+ */
+void ENERGY_GetBalance(signed int* balance_uw) {
+	(*balance_uw) = energy_ctx.energy_balance_uw;
+}
+
+/* COMPUTE A PERIOD ADAPTED TO ENERGY LEVEL.
+ * @param nominal_period_seconds:	Period used when energy level is in target band and stable.
+ * @param min_period_seconds:		Minimum period.
+ * @param max_period_seconds:		Maximum period.
+ * @return period_seconds:			Adapted period.
+ */
+unsigned int ENERGY_GetPeriod(unsigned int nominal_period_seconds, unsigned int min_period_seconds, unsigned int max_period_seconds) {
+	// Scale nominal period.
+	unsigned int period_seconds = (nominal_period_seconds / ENERGY_PERIOD_FACTOR_NOMINAL) * energy_ctx.energy_period_factor;
+	period_seconds += ((nominal_period_seconds % ENERGY_PERIOD_FACTOR_NOMINAL) * energy_ctx.energy_period_factor) / ENERGY_PERIOD_FACTOR_NOMINAL;
+	// Clamp period.
+	if (period_seconds < min_period_seconds) {
+		period_seconds = min_period_seconds;
+	}
+	if (period_seconds > max_period_seconds) {
+		period_seconds = max_period_seconds;
+	}
+	return period_seconds;
+}
@@ -0,0 +1,207 @@
+/*
+ * profiler.c
+ */
+
+#include "profiler.h"
+
+#include "mode.h"
+#include "scb_reg.h"
+#include "systick_reg.h"
+
+#ifdef PROFILER
+
+/*** PROFILER local macros ***/
+
+#define PROFILER_SAMPLING_PERIOD_CYCLES		4001 // About 4kHz on HSI, prime number to avoid aliasing with periodic code.
+#define PROFILER_FLASH_START_ADDRESS		0x08000000
+#define PROFILER_FLASH_SIZE_BYTES			32768
+#define PROFILER_BUCKET_SIZE_BYTES			128 // Histogram resolution.
+#define PROFILER_BUCKET_NUMBER				(PROFILER_FLASH_SIZE_BYTES / PROFILER_BUCKET_SIZE_BYTES)
+#define PROFILER_BUCKET_COUNT_MAX			0xFFFF
+
+/*** PROFILER local structures ***/
+
+typedef struct {
+	unsigned long long probe_start_cycles;
+	unsigned long long probe_total_cycles;
+	unsigned int probe_max_cycles;
+	unsigned int probe_count;
+} PROFILER_ProbeData;
+
+typedef struct {
+	volatile unsigned int profiler_tick_count;
+	unsigned int profiler_outside_flash_count; // Program counter in RAM or system memory.
+	unsigned short profiler_histogram[PROFILER_BUCKET_NUMBER];
+	PROFILER_ProbeData profiler_probes[PROFILER_PROBE_LAST];
+} PROFILER_Context;
+
+/*** PROFILER local global variables ***/
+
+static PROFILER_Context profiler_ctx;
+
+/*** PROFILER local functions ***/
+
+/* GET NUMBER OF CORE CYCLES SINCE PROFILER START.
+ * @param:	None.
+ * @return:	Number of cycles (SysTick is stopped in stop mode, so that only active cycles are counted).
+ */
+static unsigned long long PROFILER_GetCycles(void) {
+	// Local variables.
+	unsigned int tick_count = 0;
+	unsigned int counter_value = 0;
+	unsigned int reload_pending = 0;
+	// Read again if the counter was reloaded between the reads.
+	do {
+		tick_count = profiler_ctx.profiler_tick_count;
+		reload_pending = ((SCB -> ICSR) & (0b1 << 26)); // PENDSTSET.
+		counter_value = (SYSTICK -> VAL);
+	}
+	while ((tick_count != profiler_ctx.profiler_tick_count) || (reload_pending != ((SCB -> ICSR) & (0b1 << 26))));
+	// Reload not yet handled (interrupts masked): count its period.
+	if (reload_pending != 0) {
+		tick_count++;
+	}
+	// SysTick is a down counter.
+	return ((unsigned long long) tick_count * PROFILER_SAMPLING_PERIOD_CYCLES) + ((PROFILER_SAMPLING_PERIOD_CYCLES - 1) - counter_value);
+}
+
+/*** PROFILER functions ***/
+
+/* INIT SYSTICK FOR PROGRAM COUNTER SAMPLING.
+ * @param:	None.
+ * @return:	None.
+ */
+void PROFILER_Init(void) {
+	// Reset results.
+	PROFILER_Reset();
+	profiler_ctx.profiler_tick_count = 0;
+	// Configure SysTick on core clock.
+	SYSTICK -> CTRL = 0;
+	SYSTICK -> LOAD = (PROFILER_SAMPLING_PERIOD_CYCLES - 1);
+	SYSTICK -> VAL = 0;
+	SYSTICK -> CTRL = (0b111 << 0); // CLKSOURCE='1' (core clock), TICKINT='1' and ENABLE='1'.
+}
+
+/* RESET HISTOGRAM AND PROBES.
+ * @param:	None.
+ * @return:	None.
+ */
+void PROFILER_Reset(void) {
+	// Local variables.
+	unsigned short bucket_idx = 0;
+	unsigned char probe = 0;
+	// Reset histogram.
+	profiler_ctx.profiler_outside_flash_count = 0;
+	for (bucket_idx=0 ; bucket_idx<PROFILER_BUCKET_NUMBER ; bucket_idx++) {
+		profiler_ctx.profiler_histogram[bucket_idx] = 0;
+	}
+	// Reset probes.
+	for (probe=0 ; probe<PROFILER_PROBE_LAST ; probe++) {
+		profiler_ctx.profiler_probes[probe].probe_total_cycles = 0;
+		profiler_ctx.profiler_probes[probe].probe_max_cycles = 0;
+		profiler_ctx.profiler_probes[probe].probe_count = 0;
+	}
+}
+
+/* START A MEASURED REGION.
+ * @param probe:	Region identifier.
+ * @return:			None.
+ */
+void PROFILER_Begin(PROFILER_Probe probe) {
+	profiler_ctx.profiler_probes[probe].probe_start_cycles = PROFILER_GetCycles();
+}
+
+/* END A MEASURED REGION.
+ * @param probe:	Region identifier.
+ * @return:			None.
+ */
+void PROFILER_End(PROFILER_Probe probe) {
+	// Local variables.
+	unsigned long long end_cycles = PROFILER_GetCycles();
+	unsigned int duration_cycles = 0;
+	// Clamp negative durations (e.g. probe started before PROFILER_Init()).
+	if (end_cycles > profiler_ctx.profiler_probes[probe].probe_start_cycles) {
+		duration_cycles = (unsigned int) (end_cycles - profiler_ctx.profiler_probes[probe].probe_start_cycles);
+	}
+	// Update statistics.
+	profiler_ctx.profiler_probes[probe].probe_total_cycles += duration_cycles;
+	profiler_ctx.profiler_probes[probe].probe_count++;
+	if (duration_cycles > profiler_ctx.profiler_probes[probe].probe_max_cycles) {
+		profiler_ctx.profiler_probes[probe].probe_max_cycles = duration_cycles;
+	}
+}
+
+/* GET PROGRAM COUNTER SAMPLES SUMMARY.
+ * @param sample_count:			Pointer that will contain the total number of samples.
+ * @param outside_flash_count:	Pointer that will contain the number of samples outside flash memory.
+ * @param period_cycles:		Pointer that will contain the sampling period in core cycles.
+ * @return:						None.
+ */
+void PROFILER_GetSamples(unsigned int* sample_count, unsigned int* outside_flash_count, unsigned int* period_cycles) {
+	// Local variables.
+	unsigned short bucket_idx = 0;
+	// Sum histogram.
+	(*sample_count) = profiler_ctx.profiler_outside_flash_count;
+	for (bucket_idx=0 ; bucket_idx<PROFILER_BUCKET_NUMBER ; bucket_idx++) {
+		(*sample_count) += profiler_ctx.profiler_histogram[bucket_idx];
+	}
+	(*outside_flash_count) = profiler_ctx.profiler_outside_flash_count;
+	(*period_cycles) = PROFILER_SAMPLING_PERIOD_CYCLES;
+}
+
+/* GET NUMBER OF HISTOGRAM BUCKETS.
+ * @param:	None.
+ * @return:	Number of buckets.
+ */
+unsigned short PROFILER_GetBucketNumber(void) {
+	return PROFILER_BUCKET_NUMBER;
+}
+
+/* GET ONE HISTOGRAM BUCKET.
+ * @param bucket_idx:		Bucket index.
+ * @param start_address:	Pointer that will contain the first flash address of the bucket.
+ * @param sample_count:		Pointer that will contain the number of samples in the bucket.
+ * @return:					None.
+ */
+void PROFILER_GetBucket(unsigned short bucket_idx, unsigned int* start_address, unsigned int* sample_count) {
+	(*start_address) = PROFILER_FLASH_START_ADDRESS + (bucket_idx * PROFILER_BUCKET_SIZE_BYTES);
+	(*sample_count) = (bucket_idx < PROFILER_BUCKET_NUMBER) ? profiler_ctx.profiler_histogram[bucket_idx] : 0;
+}
+
+/* GET STATISTICS OF A MEASURED REGION.
+ * @param probe:			Region identifier.
+ * @param count:			Pointer that will contain the number of executions.
+ * @param average_cycles:	Pointer that will contain the average duration in core cycles.
+ * @param max_cycles:		Pointer that will contain the maximum duration in core cycles.
+ * @return:					None.
+ */
+void PROFILER_GetProbe(PROFILER_Probe probe, unsigned int* count, unsigned int* average_cycles, unsigned int* max_cycles) {
+	(*count) = profiler_ctx.profiler_probes[probe].probe_count;
+	(*average_cycles) = 0;
+	if (profiler_ctx.profiler_probes[probe].probe_count != 0) {
+		(*average_cycles) = (unsigned int) (profiler_ctx.profiler_probes[probe].probe_total_cycles / profiler_ctx.profiler_probes[probe].probe_count);
+	}
+	(*max_cycles) = profiler_ctx.profiler_probes[probe].probe_max_cycles;
+}
+
+/* RECORD THE PROGRAM COUNTER OF THE INTERRUPTED CONTEXT (CALLED BY SYSTICK HANDLER).
+ * @param program_counter:	Stacked program counter.
+ * @return:					None.
+ */
+void PROFILER_SampleProgramCounter(unsigned int program_counter) {
+	// Local variables.
+	unsigned int offset = (program_counter - PROFILER_FLASH_START_ADDRESS);
+	// Update time base.
+	profiler_ctx.profiler_tick_count++;
+	// Update histogram.
+	if (offset < PROFILER_FLASH_SIZE_BYTES) {
+		if (profiler_ctx.profiler_histogram[offset / PROFILER_BUCKET_SIZE_BYTES] < PROFILER_BUCKET_COUNT_MAX) {
+			profiler_ctx.profiler_histogram[offset / PROFILER_BUCKET_SIZE_BYTES]++;
+		}
+	}
+	else {
+		profiler_ctx.profiler_outside_flash_count++;
+	}
+}
+
+#endif
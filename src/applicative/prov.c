@@ -0,0 +1,500 @@
+/*
+ * prov.c
+ */
+
+#include "prov.h"
+
+#include "adc.h"
+#include "aes.h"
+#include "i2c.h"
+#include "mma8653fc.h"
+#include "mode.h"
+#include "nvm.h"
+#include "sht3x.h"
+#include "sigfox_api.h"
+#include "usart.h"
+
+#ifdef ATM
+
+/*** PROV local macros ***/
+
+// Frames are COBS encoded and delimited by a null byte.
+// Decoded request:		<seq> [<opcode> <length> <payload>]* <crc16_msb> <crc16_lsb>
+// Decoded response:	<seq> <frame_status> [<opcode> <status> <length> <payload>]* <crc16_msb> <crc16_lsb>
+// CRC is CRC-16/CCITT-FALSE computed on all previous bytes.
+#define PROV_FRAME_MAX_LENGTH						80
+#define PROV_FRAME_CRC_LENGTH						2
+#define PROV_REQUEST_HEADER_LENGTH					1
+#define PROV_RESPONSE_HEADER_LENGTH					2
+#define PROV_RECORD_HEADER_LENGTH					2
+#define PROV_RECORD_RESPONSE_HEADER_LENGTH			3
+#define PROV_COBS_DELIMITER							0x00
+#define PROV_COBS_CODE_MAX							0xFF
+#define PROV_COBS_BUFFER_SIZE						(PROV_FRAME_MAX_LENGTH + (PROV_FRAME_MAX_LENGTH / 254) + 2)
+#define PROV_CRC16_INIT								0xFFFF
+// Number of frames the host can send without waiting for their response.
+#define PROV_WINDOW_SIZE							2
+#define PROV_PROTOCOL_VERSION						1
+
+#define PROV_MMA8653FC_WHO_AM_I						0x5A
+#define PROV_CREDENTIALS_LENGTH						(ID_LENGTH + AES_BLOCK_SIZE)
+
+// Frame status.
+#define PROV_FRAME_STATUS_OK						0x00
+#define PROV_FRAME_STATUS_RX_OVERFLOW				0x01	// Decoded frame exceeds buffer size.
+#define PROV_FRAME_STATUS_INVALID_LENGTH			0x02	// Frame or record length mismatch.
+#define PROV_FRAME_STATUS_CRC_ERROR					0x03	// CRC mismatch, no record was executed.
+#define PROV_FRAME_STATUS_TX_OVERFLOW				0x04	// Remaining records were not executed because response is full.
+
+// Record status.
+#define PROV_RECORD_STATUS_OK						0x00
+#define PROV_RECORD_STATUS_UNKNOWN_OPCODE			0x01
+#define PROV_RECORD_STATUS_INVALID_LENGTH			0x02
+#define PROV_RECORD_STATUS_NVM_ADDRESS_OVERFLOW		0x03
+#define PROV_RECORD_STATUS_SELF_TEST_FAILED			0x04
+
+// Self-test result bits.
+#define PROV_SELF_TEST_SHT3X_ERROR					0x01
+#define PROV_SELF_TEST_MMA8653FC_ERROR				0x02
+
+/*** PROV local structures ***/
+
+typedef enum {
+	PROV_OPCODE_PING,			// Response: <protocol_version> <window_size> <frame_max_length>.
+	PROV_OPCODE_NVM_READ,		// Payload: <address_msb> <address_lsb> <length>. Response: <data>.
+	PROV_OPCODE_NVM_WRITE,		// Payload: <address_msb> <address_lsb> <data>.
+	PROV_OPCODE_CREDENTIALS,	// Payload: <id (4 bytes, MSB first)> <key (16 bytes)>.
+	PROV_OPCODE_SELF_TEST,		// Response: <result> <vsrc_mv> <vcap_mv> <vmcu_mv> <temperature_cdeg> <humidity_cpercent> <who_am_i> (16-bits fields MSB first).
+	PROV_OPCODE_EXIT,			// Go back to AT mode once response is sent.
+	PROV_OPCODE_LAST
+} PROV_Opcode;
+
+// Record given to handlers.
+typedef struct {
+	unsigned char* prov_payload;
+	unsigned char prov_payload_length;
+	unsigned char* prov_response;
+	unsigned char prov_response_max_length;
+	unsigned char prov_response_length;
+} PROV_Record;
+
+typedef unsigned char (*PROV_RecordHandler)(PROV_Record* record);
+
+typedef struct {
+	unsigned char prov_data[PROV_FRAME_MAX_LENGTH];
+	unsigned char prov_length;
+	unsigned char prov_overflow_flag;
+	volatile unsigned char prov_ready_flag; // Set by interrupt when delimiter is received, cleared by task.
+} PROV_RxFrame;
+
+typedef struct {
+	// Reception (COBS decoded on the fly).
+	PROV_RxFrame prov_rx_frames[PROV_WINDOW_SIZE];
+	volatile unsigned char prov_rx_write_idx;
+	unsigned char prov_rx_read_idx;
+	unsigned char prov_cobs_code;
+	unsigned char prov_cobs_remaining;
+	// Transmission.
+	unsigned char prov_tx_buf[PROV_FRAME_MAX_LENGTH];
+	unsigned char prov_tx_length;
+	unsigned char prov_cobs_buf[PROV_COBS_BUFFER_SIZE];
+	unsigned char prov_exit_flag;
+} PROV_Context;
+
+/*** PROV local global variables ***/
+
+static PROV_Context prov_ctx;
+// CRC-16/CCITT-FALSE nibble table (polynomial 0x1021).
+static const unsigned short prov_crc16_table[16] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/*** PROV local functions ***/
+
+/* COMPUTE CRC-16/CCITT-FALSE OF A BUFFER.
+ * @param data:			Input buffer.
+ * @param data_length:	Number of bytes.
+ * @return crc:			Computed CRC.
+ */
+static unsigned short PROV_ComputeCrc16(unsigned char* data, unsigned char data_length) {
+	// Local variables.
+	unsigned short crc = PROV_CRC16_INIT;
+	unsigned char idx = 0;
+	// Process each nibble.
+	for (idx=0 ; idx<data_length ; idx++) {
+		crc = (crc << 4) ^ prov_crc16_table[(crc >> 12) ^ (data[idx] >> 4)];
+		crc = (crc << 4) ^ prov_crc16_table[(crc >> 12) ^ (data[idx] & 0x0F)];
+	}
+	return crc;
+}
+
+/* APPEND A DECODED BYTE TO A RECEPTION FRAME.
+ * @param rx_frame:	Frame being received.
+ * @param rx_byte:	Decoded byte.
+ * @return:			None.
+ */
+static void PROV_AppendRxByte(PROV_RxFrame* rx_frame, unsigned char rx_byte) {
+	if ((rx_frame -> prov_length) < PROV_FRAME_MAX_LENGTH) {
+		(rx_frame -> prov_data)[rx_frame -> prov_length] = rx_byte;
+		(rx_frame -> prov_length)++;
+	}
+	else {
+		(rx_frame -> prov_overflow_flag) = 1;
+	}
+}
+
+/* PING RECORD.
+ * @param record:	Record to process.
+ * @return status:	Record status.
+ */
+static unsigned char PROV_PingRecord(PROV_Record* record) {
+	// Check lengths.
+	if (((record -> prov_payload_length) != 0) || ((record -> prov_response_max_length) < 3)) return PROV_RECORD_STATUS_INVALID_LENGTH;
+	// Protocol parameters.
+	(record -> prov_response)[0] = PROV_PROTOCOL_VERSION;
+	(record -> prov_response)[1] = PROV_WINDOW_SIZE;
+	(record -> prov_response)[2] = PROV_FRAME_MAX_LENGTH;
+	(record -> prov_response_length) = 3;
+	return PROV_RECORD_STATUS_OK;
+}
+
+/* NVM BLOCK READ RECORD.
+ * @param record:	Record to process.
+ * @return status:	Record status.
+ */
+static unsigned char PROV_NvmReadRecord(PROV_Record* record) {
+	// Local variables.
+	unsigned short address_offset = 0;
+	unsigned char length = 0;
+	unsigned char read_status = 0;
+	// Check lengths.
+	if ((record -> prov_payload_length) != 3) return PROV_RECORD_STATUS_INVALID_LENGTH;
+	address_offset = ((record -> prov_payload)[0] << 8) + (record -> prov_payload)[1];
+	length = (record -> prov_payload)[2];
+	if (length > (record -> prov_response_max_length)) return PROV_RECORD_STATUS_INVALID_LENGTH;
+	// Read block.
+	NVM_Enable();
+	read_status = NVM_ReadBlock(address_offset, (record -> prov_response), length);
+	NVM_Disable();
+	if (read_status == 0) return PROV_RECORD_STATUS_NVM_ADDRESS_OVERFLOW;
+	(record -> prov_response_length) = length;
+	return PROV_RECORD_STATUS_OK;
+}
+
+/* NVM BLOCK WRITE RECORD.
+ * @param record:	Record to process.
+ * @return status:	Record status.
+ */
+static unsigned char PROV_NvmWriteRecord(PROV_Record* record) {
+	// Local variables.
+	unsigned short address_offset = 0;
+	unsigned char write_status = 0;
+	// Check lengths.
+	if ((record -> prov_payload_length) < 3) return PROV_RECORD_STATUS_INVALID_LENGTH;
+	address_offset = ((record -> prov_payload)[0] << 8) + (record -> prov_payload)[1];
+	// Write block.
+	NVM_Enable();
+	write_status = NVM_WriteBlock(address_offset, &((record -> prov_payload)[2]), ((record -> prov_payload_length) - 2));
+	NVM_Disable();
+	return ((write_status == 0) ? PROV_RECORD_STATUS_NVM_ADDRESS_OVERFLOW : PROV_RECORD_STATUS_OK);
+}
+
+/* SIGFOX CREDENTIALS RECORD.
+ * @param record:	Record to process.
+ * @return status:	Record status.
+ */
+static unsigned char PROV_CredentialsRecord(PROV_Record* record) {
+	// Local variables.
+	unsigned char byte_idx = 0;
+	// Check lengths.
+	if ((record -> prov_payload_length) != PROV_CREDENTIALS_LENGTH) return PROV_RECORD_STATUS_INVALID_LENGTH;
+	NVM_Enable();
+	// Device ID is stored LSB first (same as AT$ID=).
+	for (byte_idx=0 ; byte_idx<ID_LENGTH ; byte_idx++) {
+		NVM_WriteByte((NVM_SIGFOX_ID_ADDRESS_OFFSET + ID_LENGTH - byte_idx - 1), (record -> prov_payload)[byte_idx]);
+	}
+	// Device key.
+	for (byte_idx=0 ; byte_idx<AES_BLOCK_SIZE ; byte_idx++) {
+		NVM_WriteByte((NVM_SIGFOX_KEY_ADDRESS_OFFSET + byte_idx), (record -> prov_payload)[ID_LENGTH + byte_idx]);
+	}
+	NVM_Disable();
+	return PROV_RECORD_STATUS_OK;
+}
+
+/* STORE A 16-BITS FIELD MSB FIRST.
+ * @param buf:		Destination buffer.
+ * @param value:	Value to store.
+ * @return:			None.
+ */
+static void PROV_WriteShort(unsigned char* buf, unsigned short value) {
+	buf[0] = (value >> 8) & 0xFF;
+	buf[1] = (value >> 0) & 0xFF;
+}
+
+/* SENSORS SELF-TEST RECORD.
+ * @param record:	Record to process.
+ * @return status:	Record status.
+ */
+static unsigned char PROV_SelfTestRecord(PROV_Record* record) {
+	// Local variables.
+	unsigned char result = 0;
+	unsigned int source_voltage_mv = 0;
+	unsigned int supercap_voltage_mv = 0;
+	unsigned int mcu_supply_voltage_mv = 0;
+	signed int sht3x_temperature_centidegrees = 0;
+	unsigned int sht3x_humidity_centipercent = 0;
+	unsigned char mma8653fc_who_am_i = 0;
+	// Check lengths.
+	if (((record -> prov_payload_length) != 0) || ((record -> prov_response_max_length) < 12)) return PROV_RECORD_STATUS_INVALID_LENGTH;
+	// Analog measurements.
+	ADC1_PowerOn();
+	ADC1_PerformAllMeasurements();
+	ADC1_PowerOff();
+	ADC1_GetSourceVoltage(&source_voltage_mv);
+	ADC1_GetSupercapVoltage(&supercap_voltage_mv);
+	ADC1_GetMcuVoltage(&mcu_supply_voltage_mv);
+	// I2C sensors.
+	I2C1_Init();
+	I2C1_PowerOn();
+	if (SHT3X_PerformMeasurements(SHT3X_REPEATABILITY_HIGH) == 0) {
+		result |= PROV_SELF_TEST_SHT3X_ERROR;
+	}
+	else {
+		SHT3X_GetTemperatureCentiDegrees(&sht3x_temperature_centidegrees);
+		SHT3X_GetHumidityCentiPercent(&sht3x_humidity_centipercent);
+	}
+	mma8653fc_who_am_i = MMA8653FC_GetId();
+	if (mma8653fc_who_am_i != PROV_MMA8653FC_WHO_AM_I) {
+		result |= PROV_SELF_TEST_MMA8653FC_ERROR;
+	}
+	I2C1_PowerOff();
+	I2C1_Disable();
+	// Build response.
+	(record -> prov_response)[0] = result;
+	PROV_WriteShort(&((record -> prov_response)[1]), source_voltage_mv);
+	PROV_WriteShort(&((record -> prov_response)[3]), supercap_voltage_mv);
+	PROV_WriteShort(&((record -> prov_response)[5]), mcu_supply_voltage_mv);
+	PROV_WriteShort(&((record -> prov_response)[7]), (unsigned short) sht3x_temperature_centidegrees);
+	PROV_WriteShort(&((record -> prov_response)[9]), sht3x_humidity_centipercent);
+	(record -> prov_response)[11] = mma8653fc_who_am_i;
+	(record -> prov_response_length) = 12;
+	return ((result == 0) ? PROV_RECORD_STATUS_OK : PROV_RECORD_STATUS_SELF_TEST_FAILED);
+}
+
+/* EXIT RECORD.
+ * @param record:	Record to process.
+ * @return status:	Record status.
+ */
+static unsigned char PROV_ExitRecord(PROV_Record* record) {
+	// Check lengths.
+	if ((record -> prov_payload_length) != 0) return PROV_RECORD_STATUS_INVALID_LENGTH;
+	// Leave binary mode after this frame.
+	prov_ctx.prov_exit_flag = 1;
+	return PROV_RECORD_STATUS_OK;
+}
+
+// Records handlers (indexed by opcode).
+static const PROV_RecordHandler prov_record_handlers[PROV_OPCODE_LAST] = {
+	&PROV_PingRecord,
+	&PROV_NvmReadRecord,
+	&PROV_NvmWriteRecord,
+	&PROV_CredentialsRecord,
+	&PROV_SelfTestRecord,
+	&PROV_ExitRecord
+};
+
+/* ENCODE AND SEND THE RESPONSE FRAME.
+ * @param:	None.
+ * @return:	None.
+ */
+static void PROV_SendResponse(void) {
+	// Local variables.
+	unsigned short crc = PROV_ComputeCrc16(prov_ctx.prov_tx_buf, prov_ctx.prov_tx_length);
+	unsigned char idx = 0;
+	unsigned char code_idx = 0;
+	unsigned char cobs_idx = 1;
+	unsigned char code = 1;
+	// Append CRC.
+	PROV_WriteShort(&(prov_ctx.prov_tx_buf[prov_ctx.prov_tx_length]), crc);
+	prov_ctx.prov_tx_length += PROV_FRAME_CRC_LENGTH;
+	// COBS encoding.
+	for (idx=0 ; idx<prov_ctx.prov_tx_length ; idx++) {
+		if (prov_ctx.prov_tx_buf[idx] == PROV_COBS_DELIMITER) {
+			prov_ctx.prov_cobs_buf[code_idx] = code;
+			code_idx = cobs_idx++;
+			code = 1;
+		}
+		else {
+			prov_ctx.prov_cobs_buf[cobs_idx++] = prov_ctx.prov_tx_buf[idx];
+			code++;
+			if (code == PROV_COBS_CODE_MAX) {
+				prov_ctx.prov_cobs_buf[code_idx] = code;
+				code_idx = cobs_idx++;
+				code = 1;
+			}
+		}
+	}
+	prov_ctx.prov_cobs_buf[code_idx] = code;
+	prov_ctx.prov_cobs_buf[cobs_idx++] = PROV_COBS_DELIMITER;
+	// Send frame.
+	USART2_SendBytes(prov_ctx.prov_cobs_buf, cobs_idx);
+}
+
+/* EXECUTE ALL RECORDS OF A RECEIVED FRAME AND SEND RESPONSE.
+ * @param rx_frame:	Decoded frame.
+ * @return:			None.
+ */
+static void PROV_DecodeFrame(PROV_RxFrame* rx_frame) {
+	// Local variables.
+	unsigned char frame_status = PROV_FRAME_STATUS_OK;
+	unsigned char records_end_idx = 0;
+	unsigned char idx = PROV_REQUEST_HEADER_LENGTH;
+	unsigned char opcode = 0;
+	unsigned char record_status = 0;
+	PROV_Record record;
+	// Response header.
+	prov_ctx.prov_tx_buf[0] = (rx_frame -> prov_data)[0];
+	prov_ctx.prov_tx_length = PROV_RESPONSE_HEADER_LENGTH;
+	// Check frame.
+	if ((rx_frame -> prov_overflow_flag) != 0) {
+		frame_status = PROV_FRAME_STATUS_RX_OVERFLOW;
+	}
+	else if ((rx_frame -> prov_length) < (PROV_REQUEST_HEADER_LENGTH + PROV_FRAME_CRC_LENGTH)) {
+		frame_status = PROV_FRAME_STATUS_INVALID_LENGTH;
+	}
+	else {
+		records_end_idx = (rx_frame -> prov_length) - PROV_FRAME_CRC_LENGTH;
+		if (PROV_ComputeCrc16((rx_frame -> prov_data), records_end_idx) != (((rx_frame -> prov_data)[records_end_idx] << 8) + (rx_frame -> prov_data)[records_end_idx + 1])) {
+			frame_status = PROV_FRAME_STATUS_CRC_ERROR;
+		}
+	}
+	// Execute records.
+	while ((frame_status == PROV_FRAME_STATUS_OK) && (idx < records_end_idx)) {
+		// Check record length.
+		if (((idx + PROV_RECORD_HEADER_LENGTH) > records_end_idx) || ((idx + PROV_RECORD_HEADER_LENGTH + (rx_frame -> prov_data)[idx + 1]) > records_end_idx)) {
+			frame_status = PROV_FRAME_STATUS_INVALID_LENGTH;
+			break;
+		}
+		// Check response space.
+		if ((prov_ctx.prov_tx_length + PROV_RECORD_RESPONSE_HEADER_LENGTH + PROV_FRAME_CRC_LENGTH) > PROV_FRAME_MAX_LENGTH) {
+			frame_status = PROV_FRAME_STATUS_TX_OVERFLOW;
+			break;
+		}
+		opcode = (rx_frame -> prov_data)[idx];
+		record.prov_payload = &((rx_frame -> prov_data)[idx + PROV_RECORD_HEADER_LENGTH]);
+		record.prov_payload_length = (rx_frame -> prov_data)[idx + 1];
+		record.prov_response = &(prov_ctx.prov_tx_buf[prov_ctx.prov_tx_length + PROV_RECORD_RESPONSE_HEADER_LENGTH]);
+		record.prov_response_max_length = PROV_FRAME_MAX_LENGTH - PROV_FRAME_CRC_LENGTH - PROV_RECORD_RESPONSE_HEADER_LENGTH - prov_ctx.prov_tx_length;
+		record.prov_response_length = 0;
+		// Call handler.
+		if (opcode < PROV_OPCODE_LAST) {
+			record_status = prov_record_handlers[opcode](&record);
+		}
+		else {
+			record_status = PROV_RECORD_STATUS_UNKNOWN_OPCODE;
+		}
+		// Append record response.
+		prov_ctx.prov_tx_buf[prov_ctx.prov_tx_length] = opcode;
+		prov_ctx.prov_tx_buf[prov_ctx.prov_tx_length + 1] = record_status;
+		prov_ctx.prov_tx_buf[prov_ctx.prov_tx_length + 2] = record.prov_response_length;
+		prov_ctx.prov_tx_length += PROV_RECORD_RESPONSE_HEADER_LENGTH + record.prov_response_length;
+		idx += PROV_RECORD_HEADER_LENGTH + record.prov_payload_length;
+	}
+	// Send response (acknowledges the frame sequence number).
+	prov_ctx.prov_tx_buf[1] = frame_status;
+	PROV_SendResponse();
+}
+
+/*** PROV functions ***/
+
+/* INIT BINARY PROVISIONING PROTOCOL.
+ * @param:	None.
+ * @return:	None.
+ */
+void PROV_Init(void) {
+	// Local variables.
+	unsigned char frame_idx = 0;
+	// Init context.
+	for (frame_idx=0 ; frame_idx<PROV_WINDOW_SIZE ; frame_idx++) {
+		prov_ctx.prov_rx_frames[frame_idx].prov_length = 0;
+		prov_ctx.prov_rx_frames[frame_idx].prov_overflow_flag = 0;
+		prov_ctx.prov_rx_frames[frame_idx].prov_ready_flag = 0;
+	}
+	prov_ctx.prov_rx_write_idx = 0;
+	prov_ctx.prov_rx_read_idx = 0;
+	prov_ctx.prov_cobs_code = PROV_COBS_CODE_MAX;
+	prov_ctx.prov_cobs_remaining = 0;
+	prov_ctx.prov_tx_length = 0;
+	prov_ctx.prov_exit_flag = 0;
+}
+
+/* MAIN TASK OF BINARY PROVISIONING PROTOCOL.
+ * @param:	None.
+ * @return:	1 if binary mode must be exited, 0 otherwise.
+ */
+unsigned char PROV_Task(void) {
+	// Local variables.
+	PROV_RxFrame* rx_frame = &(prov_ctx.prov_rx_frames[prov_ctx.prov_rx_read_idx]);
+	// Process oldest received frame.
+	if ((rx_frame -> prov_ready_flag) != 0) {
+		PROV_DecodeFrame(rx_frame);
+		// Release buffer for next frame of the window.
+		(rx_frame -> prov_length) = 0;
+		(rx_frame -> prov_overflow_flag) = 0;
+		(rx_frame -> prov_ready_flag) = 0;
+		prov_ctx.prov_rx_read_idx++;
+		if (prov_ctx.prov_rx_read_idx >= PROV_WINDOW_SIZE) {
+			prov_ctx.prov_rx_read_idx = 0;
+		}
+	}
+	return prov_ctx.prov_exit_flag;
+}
+
+/* CHECK IF BINARY PROVISIONING PROTOCOL HAS NOTHING TO PROCESS.
+ * @param:	None.
+ * @return:	1 if no frame is pending, 0 otherwise.
+ */
+unsigned char PROV_IsIdle(void) {
+	return (prov_ctx.prov_rx_frames[prov_ctx.prov_rx_read_idx].prov_ready_flag == 0);
+}
+
+/* DECODE A NEW BYTE FROM USART (CALLED BY INTERRUPT).
+ * @param rx_byte:	Received byte.
+ * @return:			None.
+ */
+void PROV_FillRxBuffer(unsigned char rx_byte) {
+	// Local variables.
+	PROV_RxFrame* rx_frame = &(prov_ctx.prov_rx_frames[prov_ctx.prov_rx_write_idx]);
+	// Window is full (host did not wait for response): drop byte, frame will not be acknowledged.
+	if ((rx_frame -> prov_ready_flag) != 0) return;
+	// Frame delimiter.
+	if (rx_byte == PROV_COBS_DELIMITER) {
+		// Ignore empty frames (can be used by host to synchronize).
+		if (((rx_frame -> prov_length) != 0) || ((rx_frame -> prov_overflow_flag) != 0)) {
+			(rx_frame -> prov_ready_flag) = 1;
+			prov_ctx.prov_rx_write_idx++;
+			if (prov_ctx.prov_rx_write_idx >= PROV_WINDOW_SIZE) {
+				prov_ctx.prov_rx_write_idx = 0;
+			}
+		}
+		prov_ctx.prov_cobs_code = PROV_COBS_CODE_MAX;
+		prov_ctx.prov_cobs_remaining = 0;
+		return;
+	}
+	if (prov_ctx.prov_cobs_remaining == 0) {
+		// Code byte: previous block ends with an implicit zero (except after a maximum length block).
+		if (prov_ctx.prov_cobs_code != PROV_COBS_CODE_MAX) {
+			PROV_AppendRxByte(rx_frame, 0);
+		}
+		prov_ctx.prov_cobs_code = rx_byte;
+		prov_ctx.prov_cobs_remaining = (rx_byte - 1);
+	}
+	else {
+		// Data byte.
+		PROV_AppendRxByte(rx_frame, rx_byte);
+		prov_ctx.prov_cobs_remaining--;
+	}
+}
+
+#endif
@@ -0,0 +1,146 @@
+/*
+ * scheduler.c
+ */
+
+#include "scheduler.h"
+
+#include "iwdg.h"
+#include "rtc.h"
+
+/*** SCHEDULER local macros ***/
+
+#define SCHEDULER_WAKEUP_PERIOD_MAX_SECONDS		(IWDG_TIMEOUT_MIN_SECONDS - 2) // Margin for wake-up timer resolution and processing before watchdog reload.
+
+/*** SCHEDULER local structures ***/
+
+typedef struct {
+	SCHEDULER_Event scheduler_event;
+	unsigned int scheduler_deadline_seconds; // Absolute RTC timestamp.
+} SCHEDULER_Deadline;
+
+typedef struct {
+	SCHEDULER_Deadline scheduler_deadlines[SCHEDULER_EVENT_LAST]; // Sorted by ascending deadline.
+	unsigned char scheduler_deadlines_count;
+} SCHEDULER_Context;
+
+/*** SCHEDULER local global variables ***/
+
+static SCHEDULER_Context scheduler_ctx;
+
+/*** SCHEDULER local functions ***/
+
+/* COMPUTE REMAINING TIME BEFORE A DEADLINE.
+ * @param deadline_seconds:		Absolute deadline.
+ * @param timestamp_seconds:	Current RTC timestamp.
+ * @return:						Remaining time in seconds (negative if deadline is over).
+ */
+static signed int SCHEDULER_GetRemainingTime(unsigned int deadline_seconds, unsigned int timestamp_seconds) {
+	// Difference is computed modulo 2^32 to be robust to timestamp overflow.
+	return (signed int) (deadline_seconds - timestamp_seconds);
+}
+
+/*** SCHEDULER functions ***/
+
+/* INIT SCHEDULER.
+ * @param:	None.
+ * @return:	None.
+ */
+void SCHEDULER_Init(void) {
+	// Remove all deadlines.
+	scheduler_ctx.scheduler_deadlines_count = 0;
+}
+
+/* PROGRAM (OR RESCHEDULE) AN EVENT.
+ * @param event:			Event to program.
+ * @param delay_seconds:	Delay from now in seconds.
+ * @return:					None.
+ */
+void SCHEDULER_SetDeadline(SCHEDULER_Event event, unsigned int delay_seconds) {
+	// Local variables.
+	unsigned int timestamp_seconds = 0;
+	unsigned int deadline_seconds = 0;
+	unsigned char idx = 0;
+	// Check parameter.
+	if (event >= SCHEDULER_EVENT_LAST) return;
+	// Remove previous deadline of this event.
+	SCHEDULER_CancelDeadline(event);
+	// Compute absolute deadline.
+	RTC_GetTimestampSeconds(&timestamp_seconds);
+	deadline_seconds = timestamp_seconds + delay_seconds;
+	// Insert in sorted list (shift later deadlines).
+	idx = scheduler_ctx.scheduler_deadlines_count;
+	while ((idx > 0) && (SCHEDULER_GetRemainingTime(scheduler_ctx.scheduler_deadlines[idx - 1].scheduler_deadline_seconds, deadline_seconds) > 0)) {
+		scheduler_ctx.scheduler_deadlines[idx] = scheduler_ctx.scheduler_deadlines[idx - 1];
+		idx--;
+	}
+	scheduler_ctx.scheduler_deadlines[idx].scheduler_event = event;
+	scheduler_ctx.scheduler_deadlines[idx].scheduler_deadline_seconds = deadline_seconds;
+	scheduler_ctx.scheduler_deadlines_count++;
+}
+
+/* REMOVE AN EVENT FROM SCHEDULER.
+ * @param event:	Event to remove.
+ * @return:			None.
+ */
+void SCHEDULER_CancelDeadline(SCHEDULER_Event event) {
+	// Local variables.
+	unsigned char idx = 0;
+	unsigned char found = 0;
+	// Search event and shift next deadlines.
+	for (idx=0 ; idx<scheduler_ctx.scheduler_deadlines_count ; idx++) {
+		if (found != 0) {
+			scheduler_ctx.scheduler_deadlines[idx - 1] = scheduler_ctx.scheduler_deadlines[idx];
+		}
+		else if (scheduler_ctx.scheduler_deadlines[idx].scheduler_event == event) {
+			found = 1;
+		}
+	}
+	if (found != 0) {
+		scheduler_ctx.scheduler_deadlines_count--;
+	}
+}
+
+/* POP THE NEAREST EXPIRED EVENT.
+ * @param:	None.
+ * @return:	Expired event ('SCHEDULER_EVENT_LAST' if no deadline is over).
+ */
+SCHEDULER_Event SCHEDULER_GetExpiredEvent(void) {
+	// Local variables.
+	unsigned int timestamp_seconds = 0;
+	SCHEDULER_Event event = SCHEDULER_EVENT_LAST;
+	// Check nearest deadline.
+	if (scheduler_ctx.scheduler_deadlines_count > 0) {
+		RTC_GetTimestampSeconds(&timestamp_seconds);
+		if (SCHEDULER_GetRemainingTime(scheduler_ctx.scheduler_deadlines[0].scheduler_deadline_seconds, timestamp_seconds) <= 0) {
+			event = scheduler_ctx.scheduler_deadlines[0].scheduler_event;
+			SCHEDULER_CancelDeadline(event);
+		}
+	}
+	return event;
+}
+
+/* PROGRAM RTC WAKE-UP TIMER FOR THE NEAREST DEADLINE.
+ * @param:	None.
+ * @return:	None.
+ */
+void SCHEDULER_StartWakeUpTimer(void) {
+	// Local variables.
+	unsigned int timestamp_seconds = 0;
+	signed int remaining_seconds = 0;
+	unsigned int delay_seconds = SCHEDULER_WAKEUP_PERIOD_MAX_SECONDS;
+	// Compute delay to the nearest deadline.
+	if (scheduler_ctx.scheduler_deadlines_count > 0) {
+		RTC_GetTimestampSeconds(&timestamp_seconds);
+		remaining_seconds = SCHEDULER_GetRemainingTime(scheduler_ctx.scheduler_deadlines[0].scheduler_deadline_seconds, timestamp_seconds);
+		if (remaining_seconds < 1) {
+			remaining_seconds = 1;
+		}
+		// Watchdog can not be frozen in stop mode: wake-up period is bounded by its worst case timeout.
+		if (((unsigned int) remaining_seconds) < delay_seconds) {
+			delay_seconds = (unsigned int) remaining_seconds;
+		}
+	}
+	// Restart timer with new period.
+	RTC_StopWakeUpTimer();
+	RTC_StartWakeUpTimer(delay_seconds);
+}
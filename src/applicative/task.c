@@ -0,0 +1,54 @@
+/*
+ * task.c
+ */
+
+#include "task.h"
+
+#include "nvic.h"
+
+/*** TASK functions ***/
+
+/* RUN A LIST OF COOPERATIVE TASKS UNTIL ALL OF THEM ARE ENDED.
+ * @param task_list:		List of tasks to run.
+ * @param task_list_size:	Number of tasks in the list.
+ * @param idle_function:	Function called with interrupts masked when no task progressed during a complete round. It must check that no wake-up event is pending before entering sleep mode.
+ * @return:					None.
+ */
+void TASK_Run(TASK_Descriptor* task_list, unsigned char task_list_size, TASK_IdleFunction idle_function) {
+	// Local variables.
+	unsigned char task_idx = 0;
+	unsigned char running_count = 0;
+	unsigned char progress_flag = 0;
+	unsigned short previous_line = 0;
+	// Reset tasks.
+	for (task_idx=0 ; task_idx<task_list_size ; task_idx++) {
+		task_list[task_idx].task_ctx.task_line = 0;
+		task_list[task_idx].task_ctx.task_yield_flag = 0;
+	}
+	// Round robin.
+	do {
+		running_count = 0;
+		progress_flag = 0;
+		for (task_idx=0 ; task_idx<task_list_size ; task_idx++) {
+			// Skip ended tasks.
+			if (task_list[task_idx].task_ctx.task_line == TASK_LINE_ENDED) continue;
+			// Resume task.
+			previous_line = task_list[task_idx].task_ctx.task_line;
+			if (task_list[task_idx].task_function(&(task_list[task_idx].task_ctx)) == TASK_STATUS_WAITING) {
+				running_count++;
+			}
+			// A task which moved to another wait point may have unblocked the others.
+			if (task_list[task_idx].task_ctx.task_line != previous_line) {
+				progress_flag = 1;
+			}
+		}
+		// All tasks are waiting for an event.
+		if ((running_count > 0) && (progress_flag == 0) && (idle_function != 0)) {
+			// Mask interrupts so that an event occurring after the check of the idle function wakes-up the MCU instead of being handled before sleeping.
+			NVIC_DisableInterrupts();
+			idle_function();
+			NVIC_EnableInterrupts();
+		}
+	}
+	while (running_count > 0);
+}
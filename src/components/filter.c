@@ -9,46 +9,103 @@
 
 /*** FILTER local macros ***/
 
-#define FILTER_MEDIAN_LENGTH_MAX	0xFF
+#define FILTER_NETWORK_5_SIZE	9
+#define FILTER_NETWORK_9_SIZE	25
+#define FILTER_NETWORK_15_SIZE	59
+
+/*** FILTER local global variables ***/
+
+// Sorting networks (pairs of indexes to compare and exchange), stored in flash.
+static const unsigned char filter_network_5[FILTER_NETWORK_5_SIZE][2] = {
+	{0, 3}, {1, 4}, {0, 2}, {1, 3}, {0, 1}, {2, 4}, {1, 2}, {3, 4}, {2, 3}
+};
+static const unsigned char filter_network_9[FILTER_NETWORK_9_SIZE][2] = {
+	{0, 3}, {1, 7}, {2, 5}, {4, 8}, {0, 7}, {2, 4}, {3, 8}, {5, 6}, {0, 2}, {1, 3}, {4, 5}, {7, 8}, {1, 4},
+	{3, 6}, {5, 7}, {0, 1}, {2, 4}, {3, 5}, {6, 8}, {2, 3}, {4, 5}, {6, 7}, {1, 2}, {3, 4}, {5, 6}
+};
+static const unsigned char filter_network_15[FILTER_NETWORK_15_SIZE][2] = {
+	{0, 1}, {2, 3}, {4, 5}, {6, 7}, {8, 9}, {10, 11}, {12, 13}, {0, 2}, {1, 3}, {4, 6}, {5, 7}, {8, 10},
+	{9, 11}, {12, 14}, {1, 2}, {5, 6}, {9, 10}, {13, 14}, {0, 4}, {1, 5}, {2, 6}, {3, 7}, {8, 12}, {9, 13},
+	{10, 14}, {2, 4}, {3, 5}, {10, 12}, {11, 13}, {1, 2}, {3, 4}, {5, 6}, {9, 10}, {11, 12}, {13, 14}, {0, 8},
+	{1, 9}, {2, 10}, {3, 11}, {4, 12}, {5, 13}, {6, 14}, {4, 8}, {5, 9}, {6, 10}, {7, 11}, {2, 4}, {3, 5},
+	{6, 8}, {7, 9}, {10, 12}, {11, 13}, {1, 2}, {3, 4}, {5, 6}, {7, 8}, {9, 10}, {11, 12}, {13, 14}
+};
+
+/*** FILTER local functions ***/
+
+/* APPLY A SORTING NETWORK ON A BUFFER.
+ * @param buf:				Buffer to sort in place.
+ * @param network:			Comparators list.
+ * @param network_size:		Number of comparators.
+ * @return:					None.
+ */
+static void FILTER_ApplySortingNetwork(unsigned int* buf, const unsigned char network[][2], unsigned char network_size) {
+	// Local variables.
+	unsigned char idx = 0;
+	unsigned int low = 0;
+	unsigned int high = 0;
+	// Compare and exchange.
+	for (idx=0 ; idx<network_size ; idx++) {
+		low = buf[network[idx][0]];
+		high = buf[network[idx][1]];
+		if (low > high) {
+			buf[network[idx][0]] = high;
+			buf[network[idx][1]] = low;
+		}
+	}
+}
+
+/* SORT A BUFFER IN ASCENDING ORDER WITH INSERTION SORT (USED FOR LENGTHS WITHOUT DEDICATED NETWORK).
+ * @param buf:		Buffer to sort in place.
+ * @param length:	Number of elements.
+ * @return:			None.
+ */
+static void FILTER_InsertionSort(unsigned int* buf, unsigned char length) {
+	// Local variables.
+	unsigned char idx1 = 0;
+	unsigned char idx2 = 0;
+	unsigned int value = 0;
+	// Insert each element in the sorted head.
+	for (idx1=1 ; idx1<length ; idx1++) {
+		value = buf[idx1];
+		idx2 = idx1;
+		while ((idx2 > 0) && (buf[idx2 - 1] > value)) {
+			buf[idx2] = buf[idx2 - 1];
+			idx2--;
+		}
+		buf[idx2] = value;
+	}
+}
 
 /*** FILTER functions ***/
 
 /* COMPUTE AVERAGE MEDIAN VALUE
- * @param buf:				Input buffer.
+ * @param buf:				Input buffer (sorted in place, content is not preserved).
  * @param median_length:	Number of elements taken for median value search.
  * @param average_length:	Number of center elements taken for final average.
  * @return filter_out:		Output value of the median filter.
  */
 unsigned int FILTER_ComputeMedianFilter(unsigned int* buf, unsigned char median_length, unsigned char average_length) {
 	// Local variables.
-	unsigned int local_buf[FILTER_MEDIAN_LENGTH_MAX];
-	unsigned char buffer_sorted = 0;
-	unsigned char idx1 = 0;
-	unsigned char idx2 = 0;
+	unsigned char idx = 0;
 	unsigned char start_idx = 0;
 	unsigned char end_idx = 0;
 	unsigned int sum = 0;
 	unsigned int filter_out = 0;
-	// Copy input buffer into local buffer.
-	for (idx1=0 ; idx1<median_length ; idx1++) {
-		local_buf[idx1] = buf[idx1];
-	}
-	// Pad with zeroes.
-	for (; idx1<FILTER_MEDIAN_LENGTH_MAX ; idx1++) {
-		local_buf[idx1] = 0;
-	}
 	// Sort buffer in ascending order.
-	for (idx1=0; idx1<median_length; ++idx1) {
-		buffer_sorted = 1;
-		for (idx2=1 ; idx2<(median_length-idx1) ; ++idx2) {
-			if (local_buf[idx2 - 1] > local_buf[idx2]) {
-				unsigned int temp = local_buf[idx2 - 1];
-				local_buf[idx2 - 1] = local_buf[idx2];
-				local_buf[idx2] = temp;
-				buffer_sorted = 0;
-			}
-		}
-		if (buffer_sorted != 0) break;
+	switch (median_length) {
+	case 5:
+		FILTER_ApplySortingNetwork(buf, filter_network_5, FILTER_NETWORK_5_SIZE);
+		break;
+	case 9:
+		FILTER_ApplySortingNetwork(buf, filter_network_9, FILTER_NETWORK_9_SIZE);
+		break;
+	case 15:
+		FILTER_ApplySortingNetwork(buf, filter_network_15, FILTER_NETWORK_15_SIZE);
+		break;
+	default:
+		FILTER_InsertionSort(buf, median_length);
+		break;
 	}
 	// Compute average of center values if required.
 	if (average_length > 0) {
@@ -61,15 +118,15 @@ unsigned int FILTER_ComputeMedianFilter(unsigned int* buf, unsigned char median_
 		if (end_idx >= median_length) {
 			end_idx = (median_length - 1);
 		}
-		for (idx1=start_idx ; idx1<(end_idx+1) ; idx1++) {
-			sum += local_buf[idx1];
+		for (idx=start_idx ; idx<(end_idx+1) ; idx++) {
+			sum += buf[idx];
 		}
 		// Compute average.
 		filter_out = ((sum) / (end_idx - start_idx + 1));
 	}
 	else {
 		// Return median value.
-		filter_out = local_buf[(median_length / 2)];
+		filter_out = buf[(median_length / 2)];
 	}
 	return filter_out;
 }
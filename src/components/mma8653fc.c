@@ -17,39 +17,25 @@
 
 /*** MMA8653 local macros ***/
 
-#define MMA8653FC_I2C_ADDRESS	0x1D
+#define MMA8653FC_I2C_ADDRESS				0x1D
+#define MMA8653FC_DATA_LENGTH_BYTES			6
+#define MMA8653FC_FAST_DATA_LENGTH_BYTES	3
+#define MMA8653FC_DATA_SIGN_BIT_MASK		0x200 // Data are 10-bits signed values.
+#define MMA8653FC_STARTUP_TIME_MS			1 // Boot time is 350us max.
 
 /*** MMA8653FC local global variables ***/
 
 volatile unsigned char mma8653fc_motion_interrupt_flag = 0;
+static unsigned char mma8653fc_fast_read = 0;
 
 /*** MMA8653 local functions ***/
 
-/* COMPUTE THE TWO'S COMPLEMENT OF A GIVEN VALUE.
- * @param value:				Value on which the two's complement has to be computed.
- * @param sign_bit_position:	Position of the sign bit.
- * @return result:				Result of computation.
+/* SIGN EXTEND A 10-BITS TWO'S COMPLEMENT VALUE (BRANCHLESS).
+ * @param value:	10-bits raw value.
+ * @return:			Signed value.
  */
-static signed int MMA8653FC_ComputeTwoComplement(unsigned int value, unsigned char sign_bit_position) {
-	signed int result = 0;
-	// Check sign bit.
-	if ((value & (0b1 << sign_bit_position)) == 0) {
-		// Value is positive: nothing to do.
-		result = value;
-	}
-	else {
-		// Value is negative.
-		unsigned char bit_idx = 0;
-		unsigned int not_value = 0;
-		for (bit_idx=0 ; bit_idx<=sign_bit_position ; bit_idx++) {
-			if ((value & (0b1 << bit_idx)) == 0) {
-				not_value |= (0b1 << bit_idx);
-			}
-		}
-		unsigned int absolute_value = not_value + 1;
-		result = (-1) * absolute_value;
-	}
-	return result;
+static signed int MMA8653FC_SignExtend(unsigned int value) {
+	return ((signed int) (value ^ MMA8653FC_DATA_SIGN_BIT_MASK)) - MMA8653FC_DATA_SIGN_BIT_MASK;
 }
 
 /*** MMA8653FC functions ***/
@@ -59,8 +45,9 @@ static signed int MMA8653FC_ComputeTwoComplement(unsigned int value, unsigned ch
  * @return:	None.
  */
 void MMA8653FC_Init(void) {
-	// Init flag.
+	// Init flags.
 	mma8653fc_motion_interrupt_flag = 0;
+	mma8653fc_fast_read = 0;
 	// Configure interrupt pin.
 	GPIO_Configure(&GPIO_ACCELERO_IRQ, GPIO_MODE_INPUT, GPIO_TYPE_PUSH_PULL, GPIO_SPEED_LOW, GPIO_PULL_NONE);
 	EXTI_ConfigureGpio(&GPIO_ACCELERO_IRQ, EXTI_TRIGGER_RISING_EDGE);
@@ -73,8 +60,9 @@ void MMA8653FC_Init(void) {
 unsigned char MMA8653FC_GetId(void) {
 	unsigned char who_am_i = 0;
 	unsigned char local_addr = MMA8653FC_REG_WHO_AM_I;
-	unsigned char i2c_access = I2C1_Write(MMA8653FC_I2C_ADDRESS, &local_addr, 1, 0);
-	i2c_access = I2C1_Read(MMA8653FC_I2C_ADDRESS, &who_am_i, 1);
+	// Wait for sensor to be ready after power-on.
+	I2C1_WaitSlaveReady(MMA8653FC_STARTUP_TIME_MS);
+	I2C1_WriteRead(MMA8653FC_I2C_ADDRESS, &local_addr, 1, &who_am_i, 1);
 	return who_am_i;
 }
 
@@ -87,11 +75,17 @@ void MMA8653FC_WriteConfig(const MMA8653FC_RegisterSetting* mma8653fc_config, un
 	unsigned char i2c_access = 0;
 	unsigned char i2c_tx_data[2];
 	unsigned char reg_idx = 0;
+	// Wait for sensor to be ready after power-on.
+	I2C1_WaitSlaveReady(MMA8653FC_STARTUP_TIME_MS);
 	for (reg_idx=0 ; reg_idx<mma8653fc_config_size ; reg_idx++) {
 		i2c_tx_data[0] = (mma8653fc_config[reg_idx].mma8653fc_reg_addr);
 		i2c_tx_data[1] = (mma8653fc_config[reg_idx].mma8653fc_reg_value);
 		i2c_access = I2C1_Write(MMA8653FC_I2C_ADDRESS, i2c_tx_data, 2, 1);
 		if (i2c_access == 0) break;
+		// Track fast read mode.
+		if (i2c_tx_data[0] == MMA8653FC_REG_CTRL_REG1) {
+			mma8653fc_fast_read = ((i2c_tx_data[1] >> 1) & 0b1);
+		}
 	}
 }
 
@@ -102,55 +96,26 @@ void MMA8653FC_WriteConfig(const MMA8653FC_RegisterSetting* mma8653fc_config, un
  * @return:		None.
  */
 void MMA8653FC_GetData(signed int* x, signed int* y, signed int* z) {
-	unsigned int data = 0;
-	unsigned char reg_data = 0;
-	unsigned char local_addr = 0;
-	unsigned char i2c_access = 0;
-	// X-axis.
-	local_addr = MMA8653FC_REG_OUT_X_MSB;
-	i2c_access = I2C1_Write(MMA8653FC_I2C_ADDRESS, &local_addr, 1, 0);
-	if (i2c_access == 0) return;
-	i2c_access = I2C1_Read(MMA8653FC_I2C_ADDRESS, &reg_data, 1);
-	if (i2c_access == 0) return;
-	data = 0;
-	data |= reg_data << 2;
-	local_addr = MMA8653FC_REG_OUT_X_LSB;
-	i2c_access = I2C1_Write(MMA8653FC_I2C_ADDRESS, &local_addr, 1, 0);
-	if (i2c_access == 0) return;
-	i2c_access = I2C1_Read(MMA8653FC_I2C_ADDRESS, &reg_data, 1);
-	if (i2c_access == 0) return;
-	data |= (reg_data >> 6);
-	(*x) = MMA8653FC_ComputeTwoComplement(data, 9);
-	// Y-axis.
-	local_addr = MMA8653FC_REG_OUT_Y_MSB;
-	i2c_access = I2C1_Write(MMA8653FC_I2C_ADDRESS, &local_addr, 1, 0);
-	if (i2c_access == 0) return;
-	i2c_access = I2C1_Read(MMA8653FC_I2C_ADDRESS, &reg_data, 1);
-	if (i2c_access == 0) return;
-	data = 0;
-	data |= reg_data << 2;
-	local_addr = MMA8653FC_REG_OUT_Y_LSB;
-	i2c_access = I2C1_Write(MMA8653FC_I2C_ADDRESS, &local_addr, 1, 0);
-	if (i2c_access == 0) return;
-	i2c_access = I2C1_Read(MMA8653FC_I2C_ADDRESS, &reg_data, 1);
-	if (i2c_access == 0) return;
-	data |= (reg_data >> 6);
-	(*y) = MMA8653FC_ComputeTwoComplement(data, 9);
-	// Z-axis.
-	local_addr = MMA8653FC_REG_OUT_Z_MSB;
-	i2c_access = I2C1_Write(MMA8653FC_I2C_ADDRESS, &local_addr, 1, 0);
-	if (i2c_access == 0) return;
-	i2c_access = I2C1_Read(MMA8653FC_I2C_ADDRESS, &reg_data, 1);
-	if (i2c_access == 0) return;
-	data = 0;
-	data |= reg_data << 2;
-	local_addr = MMA8653FC_REG_OUT_Z_LSB;
-	i2c_access = I2C1_Write(MMA8653FC_I2C_ADDRESS, &local_addr, 1, 0);
-	if (i2c_access == 0) return;
-	i2c_access = I2C1_Read(MMA8653FC_I2C_ADDRESS, &reg_data, 1);
-	if (i2c_access == 0) return;
-	data |= (reg_data >> 6);
-	(*z) = MMA8653FC_ComputeTwoComplement(data, 9);
+	unsigned char local_addr = MMA8653FC_REG_OUT_X_MSB;
+	unsigned char data_buf[MMA8653FC_DATA_LENGTH_BYTES];
+	// Wait for sensor to be ready after power-on.
+	I2C1_WaitSlaveReady(MMA8653FC_STARTUP_TIME_MS);
+	// Burst read of all output registers (address is automatically incremented by the sensor).
+	if (mma8653fc_fast_read != 0) {
+		// Fast read mode: OUT_X_MSB, OUT_Y_MSB and OUT_Z_MSB only (LSB are skipped by the sensor).
+		if (I2C1_WriteRead(MMA8653FC_I2C_ADDRESS, &local_addr, 1, data_buf, MMA8653FC_FAST_DATA_LENGTH_BYTES) == 0) return;
+		// Convert to 10-bits scale.
+		(*x) = MMA8653FC_SignExtend(data_buf[0] << 2);
+		(*y) = MMA8653FC_SignExtend(data_buf[1] << 2);
+		(*z) = MMA8653FC_SignExtend(data_buf[2] << 2);
+	}
+	else {
+		if (I2C1_WriteRead(MMA8653FC_I2C_ADDRESS, &local_addr, 1, data_buf, MMA8653FC_DATA_LENGTH_BYTES) == 0) return;
+		// 10-bits data are left-justified (MSB[7:0] and LSB[7:6]).
+		(*x) = MMA8653FC_SignExtend((data_buf[0] << 2) | (data_buf[1] >> 6));
+		(*y) = MMA8653FC_SignExtend((data_buf[2] << 2) | (data_buf[3] >> 6));
+		(*z) = MMA8653FC_SignExtend((data_buf[4] << 2) | (data_buf[5] >> 6));
+	}
 }
 
 
@@ -15,6 +15,7 @@
 #include "lpuart.h"
 #include "mapping.h"
 #include "mode.h"
+#include "profiler.h"
 #include "pwr.h"
 #include "rcc.h"
 #include "rtc.h"
@@ -47,6 +48,13 @@
 #define NMEA_GGA_ALT_UNIT_FIELD_LENGTH		1
 #define NMEA_GGA_METERS						'M'
 
+#define NMEA_ZDA_MASK						0x00020000 // Provided to NEOM8N_SelectNmeaMessages() function.
+#define NMEA_ZDA_ADDRESS_FIELD_LENGTH		6
+#define NMEA_ZDA_TIME_FIELD_LENGTH			9
+#define NMEA_ZDA_DAY_FIELD_LENGTH			2
+#define NMEA_ZDA_MONTH_FIELD_LENGTH			2
+#define NMEA_ZDA_YEAR_FIELD_LENGTH			4
+
 #define NMEA_CHECKSUM_START_CHAR			'*' // To skip '$'.
 
 /*** NEOM8N local structures ***/
@@ -60,8 +68,15 @@ typedef struct {
 	// Parsing.
 	unsigned char nmea_gga_parsing_success;				// Set to '1' as soon an NMEA GGA message was successfully parsed.
 	unsigned char nmea_gga_data_valid;					// set to '1' if retrieved NMEA GGA data is valid.
-	// Energy monitoring.
-	unsigned int neom8n_supercap_voltage_mv;			// Supercap voltage in mV.
+	unsigned char nmea_zda_data_valid;					// Set to '1' as soon as RTC calendar was set from an NMEA ZDA message.
+	Position gps_position;								// Last valid position.
+	// Acquisition.
+	NEOM8N_ReturnCode acquisition_status;
+	unsigned int acquisition_start_timestamp_ms;
+	unsigned int acquisition_timeout_seconds;
+	unsigned char acquisition_timer_id;
+	unsigned char acquisition_timer_started;
+	unsigned char acquisition_supercap_monitoring;
 } NEOM8N_Context;
 
 /*** NEOM8N local global variables ***/
@@ -170,6 +185,7 @@ static unsigned char NEOM8N_ComputeNmeaChecksum(unsigned char* nmea_rx_buf) {
 static void NEOM8N_ParseNmeaGgaMessage(unsigned char* nmea_rx_buf, Position* gps_position) {
 	unsigned char error_found = 0;
 	unsigned char idx = 0;
+	PROFILER_BEGIN(PROFILER_PROBE_NEOM8N_PARSE_GGA);
 	// Verify checksum.
 	unsigned char received_checksum = NEOM8N_GetNmeaChecksum(nmea_rx_buf);
 	unsigned char computed_checksum = NEOM8N_ComputeNmeaChecksum(nmea_rx_buf);
@@ -336,6 +352,94 @@ static void NEOM8N_ParseNmeaGgaMessage(unsigned char* nmea_rx_buf, Position* gps
 		// Reset buffer.
 		for (idx=0 ; idx<NMEA_RX_BUFFER_SIZE ; idx++) nmea_rx_buf[idx] = 0;
 	}
+	PROFILER_END(PROFILER_PROBE_NEOM8N_PARSE_GGA);
+}
+
+/* DECODE AN NMEA ZDA MESSAGE.
+ * @param nmea_rx_buf:		NMEA message to decode.
+ * @param gps_timestamp:	Pointer to the structure that will contain UTC date and time.
+ * @return parsing_success:	1 if a complete and valid ZDA message was decoded, 0 otherwise.
+ */
+static unsigned char NEOM8N_ParseNmeaZdaMessage(unsigned char* nmea_rx_buf, Timestamp* gps_timestamp) {
+	// Local variables.
+	unsigned char parsing_success = 0;
+	unsigned char error_found = 0;
+	unsigned char idx = 0;
+	unsigned char sep_idx = 0;
+	unsigned char field = 0;
+	unsigned int k = 0;
+	// Verify checksum.
+	if (NEOM8N_GetNmeaChecksum(nmea_rx_buf) != NEOM8N_ComputeNmeaChecksum(nmea_rx_buf)) return 0;
+	// Extract NMEA data (see ZDA message format on p.132 of NEO-M8 programming manual).
+	while ((nmea_rx_buf[sep_idx] != NMEA_MESSAGE_START_CHAR) && (sep_idx < NMEA_RX_BUFFER_SIZE)) {
+		sep_idx++;
+	}
+	while ((nmea_rx_buf[idx] != NMEA_LF) && (idx < NMEA_RX_BUFFER_SIZE) && (error_found == 0)) {
+		if (nmea_rx_buf[idx] == NMEA_SEP) {
+			field++;
+			switch (field) {
+			// Field 1 = address = <ID><message>.
+			case 1:
+				if ((idx != NMEA_ZDA_ADDRESS_FIELD_LENGTH) || (nmea_rx_buf[sep_idx+3] != 'Z') || (nmea_rx_buf[sep_idx+4] != 'D') || (nmea_rx_buf[sep_idx+5] != 'A')) {
+					error_found = 1;
+				}
+				break;
+			// Field 2 = UTC time = <hhmmss.ss>.
+			case 2:
+				if ((idx - sep_idx) == (NMEA_ZDA_TIME_FIELD_LENGTH + 1)) {
+					(*gps_timestamp).hours = NEOM8N_AsciiToHexa(nmea_rx_buf[sep_idx+1]) * 10 + NEOM8N_AsciiToHexa(nmea_rx_buf[sep_idx+2]);
+					(*gps_timestamp).minutes = NEOM8N_AsciiToHexa(nmea_rx_buf[sep_idx+3]) * 10 + NEOM8N_AsciiToHexa(nmea_rx_buf[sep_idx+4]);
+					(*gps_timestamp).seconds = NEOM8N_AsciiToHexa(nmea_rx_buf[sep_idx+5]) * 10 + NEOM8N_AsciiToHexa(nmea_rx_buf[sep_idx+6]);
+				}
+				else {
+					error_found = 1;
+				}
+				break;
+			// Field 3 = day = <dd>.
+			case 3:
+				if ((idx - sep_idx) == (NMEA_ZDA_DAY_FIELD_LENGTH + 1)) {
+					(*gps_timestamp).date = NEOM8N_AsciiToHexa(nmea_rx_buf[sep_idx+1]) * 10 + NEOM8N_AsciiToHexa(nmea_rx_buf[sep_idx+2]);
+				}
+				else {
+					error_found = 1;
+				}
+				break;
+			// Field 4 = month = <mm>.
+			case 4:
+				if ((idx - sep_idx) == (NMEA_ZDA_MONTH_FIELD_LENGTH + 1)) {
+					(*gps_timestamp).month = NEOM8N_AsciiToHexa(nmea_rx_buf[sep_idx+1]) * 10 + NEOM8N_AsciiToHexa(nmea_rx_buf[sep_idx+2]);
+				}
+				else {
+					error_found = 1;
+				}
+				break;
+			// Field 5 = year = <yyyy>.
+			case 5:
+				if ((idx - sep_idx) == (NMEA_ZDA_YEAR_FIELD_LENGTH + 1)) {
+					(*gps_timestamp).year = 0;
+					for (k=0 ; k<4 ; k++) {
+						(*gps_timestamp).year += NEOM8N_Pow10(3-k) * NEOM8N_AsciiToHexa(nmea_rx_buf[sep_idx+1+k]);
+					}
+					// Last field retrieved, parsing process succeeded.
+					parsing_success = 1;
+				}
+				else {
+					error_found = 1;
+				}
+				break;
+			// Unused fields.
+			default:
+				break;
+			}
+			sep_idx = idx; // Update separator index.
+		}
+		// Increment index.
+		idx++;
+	}
+	if (error_found != 0) {
+		parsing_success = 0;
+	}
+	return parsing_success;
 }
 
 /* INDICATE IF A GPS POSITION IS VALID.
@@ -408,7 +512,10 @@ void NEOM8N_Init(void) {
 	neom8n_ctx.nmea_rx_lf_flag = 0;
 	neom8n_ctx.nmea_gga_parsing_success = 0;
 	neom8n_ctx.nmea_gga_data_valid = 0;
-	neom8n_ctx.neom8n_supercap_voltage_mv = 0;
+	neom8n_ctx.nmea_zda_data_valid = 0;
+	neom8n_ctx.acquisition_status = NEOM8N_TIMEOUT;
+	neom8n_ctx.acquisition_timer_started = 0;
+	neom8n_ctx.acquisition_supercap_monitoring = 0;
 }
 
 #if (defined HW1_1) && (defined NEOM8N_USE_VBCKP)
@@ -422,28 +529,31 @@ void NEOM8N_SetVbckp(unsigned char vbckp_on) {
 }
 #endif
 
-/* GET CURRENT GPS POSITION VIA NMEA GGA MESSAGES.
- * @param gps_position:			Pointer to GPS position structure that will contain the data.
- * @param timeout_seconds:		Timeout in seconds.
- * @param fix_duration_seconds:	Pointer that will contain effective fix duration.
- * @return return_code:			See NEOM8N_ReturnCode structure in neom8n.h.
+/* START GPS ACQUISITION (NON-BLOCKING, NMEA MESSAGES ARE THEN PARSED BY NEOM8N_ProcessAcquisition() FUNCTION).
+ * @param timeout_seconds:			Timeout in seconds.
+ * @param supercap_voltage_min_mv:	Supercap voltage under which acquisition is aborted (0 to disable monitoring).
+ * @return:							None.
  */
-NEOM8N_ReturnCode NEOM8N_GetPosition(Position* gps_position, unsigned int timeout_seconds, unsigned int supercap_voltage_min_mv, unsigned int* fix_duration_seconds) {
-	// Local variables.
-	NEOM8N_ReturnCode return_code = NEOM8N_TIMEOUT;
-	Position local_gps_position;
+void NEOM8N_StartAcquisition(unsigned int timeout_seconds, unsigned int supercap_voltage_min_mv) {
 	// Reset flags.
 	neom8n_ctx.nmea_gga_parsing_success = 0;
 	neom8n_ctx.nmea_gga_data_valid = 0;
+	neom8n_ctx.nmea_zda_data_valid = 0;
 	neom8n_ctx.nmea_rx_lf_flag = 0;
-	// Reset fix duration and start RTC wake-up timer for timeout.
-	(*fix_duration_seconds) = 0;
-	RTC_ClearWakeUpTimerFlag();
-	RTC_StartWakeUpTimer(timeout_seconds);
-	// Init ADC to monitor supercap voltage.
-	ADC1_Init();
-	// Select GGA message to get complete position.
-	NEOM8N_SelectNmeaMessages(NMEA_GGA_MASK);
+	neom8n_ctx.acquisition_status = NEOM8N_RUNNING;
+	// Start LPTIM timer for timeout (RTC wake-up timer is left to Sigfox library which may run concurrently).
+	neom8n_ctx.acquisition_timeout_seconds = timeout_seconds;
+	RTC_GetTimestampMilliseconds(&neom8n_ctx.acquisition_start_timestamp_ms);
+	neom8n_ctx.acquisition_timer_started = LPTIM1_StartTimer(&neom8n_ctx.acquisition_timer_id, (timeout_seconds * 1000), LPTIM_TIMER_MODE_SINGLE, 0);
+	// Start supercap voltage monitoring.
+	neom8n_ctx.acquisition_supercap_monitoring = (supercap_voltage_min_mv > 0) ? 1 : 0;
+	if (neom8n_ctx.acquisition_supercap_monitoring != 0) {
+		ADC1_Init();
+		ADC1_PowerOn();
+		ADC1_StartSupercapWatchdog(supercap_voltage_min_mv);
+	}
+	// Select GGA message to get complete position and ZDA message to get UTC date and time.
+	NEOM8N_SelectNmeaMessages(NMEA_GGA_MASK | NMEA_ZDA_MASK);
 	// Start DMA.
 	DMA1_InitChannel6();
 	DMA1_StopChannel6();
@@ -451,78 +561,166 @@ NEOM8N_ReturnCode NEOM8N_GetPosition(Position* gps_position, unsigned int timeou
 	DMA1_SetChannel6DestAddr((unsigned int) &(neom8n_ctx.nmea_rx_buf1), NMEA_RX_BUFFER_SIZE); // Start with buffer 1.
 	DMA1_StartChannel6();
 	LPUART1_EnableRx();
-	// Loop until data is retrieved or timeout expired.
-	while ((RTC_GetWakeUpTimerFlag() == 0) && (neom8n_ctx.nmea_gga_data_valid == 0)) {
-		// Lower clock while waiting for NMEA frame.
-		RCC_SwitchToMsi();
-		LPUART1_UpdateBrr();
-		// Enter low power sleep mode.
-		PWR_EnterLowPowerSleepMode();
-		// Wake-up.
-		(*fix_duration_seconds)++; // NMEA frames are output every seconds.
-		// Check LF flag to trigger parsing process.
-		if (neom8n_ctx.nmea_rx_lf_flag != 0) {
-			// Decode incoming NMEA message.
-			if (neom8n_ctx.nmea_rx_fill_buf1 != 0) {
-				NEOM8N_ParseNmeaGgaMessage(neom8n_ctx.nmea_rx_buf2, &local_gps_position); // Buffer 1 is currently filled by DMA, buffer 2 is available for parsing.
+}
+
+/* PARSE PENDING NMEA MESSAGE AND CHECK ACQUISITION END CONDITIONS (TO BE CALLED AFTER EACH WAKE-UP).
+ * @param:			None.
+ * @return status:	NEOM8N_RUNNING while no valid position was retrieved, NEOM8N_SUCCESS or NEOM8N_TIMEOUT otherwise.
+ */
+NEOM8N_ReturnCode NEOM8N_ProcessAcquisition(void) {
+	// Local variables.
+	Position local_gps_position;
+	Timestamp local_gps_timestamp;
+	unsigned char* nmea_rx_buf = 0;
+	unsigned int timestamp_ms = 0;
+	// Check current status.
+	if (neom8n_ctx.acquisition_status != NEOM8N_RUNNING) {
+		return neom8n_ctx.acquisition_status;
+	}
+	// Check LF flag to trigger parsing process.
+	if (neom8n_ctx.nmea_rx_lf_flag != 0) {
+		// Select buffer to decode.
+		if (neom8n_ctx.nmea_rx_fill_buf1 != 0) {
+			nmea_rx_buf = neom8n_ctx.nmea_rx_buf2; // Buffer 1 is currently filled by DMA, buffer 2 is available for parsing.
+		}
+		else {
+			nmea_rx_buf = neom8n_ctx.nmea_rx_buf1; // Buffer 2 is currently filled by DMA, buffer 1 is available for parsing.
+		}
+		// Decode incoming NMEA message.
+		if (NEOM8N_ParseNmeaZdaMessage(nmea_rx_buf, &local_gps_timestamp) != 0) {
+			// Set RTC calendar once per acquisition.
+			if (neom8n_ctx.nmea_zda_data_valid == 0) {
+				neom8n_ctx.nmea_zda_data_valid = RTC_SetTimestamp(&local_gps_timestamp);
 			}
-			else {
-				NEOM8N_ParseNmeaGgaMessage(neom8n_ctx.nmea_rx_buf1, &local_gps_position); // Buffer 2 is currently filled by DMA, buffer 1 is available for parsing.
+		}
+		else {
+			NEOM8N_ParseNmeaGgaMessage(nmea_rx_buf, &local_gps_position);
+		}
+		if (neom8n_ctx.nmea_gga_parsing_success != 0) {
+			// Check data.
+			if (NEOM8N_PositionIsValid(&local_gps_position) != 0) {
+				// Save data.
+				neom8n_ctx.gps_position.lat_degrees = local_gps_position.lat_degrees;
+				neom8n_ctx.gps_position.lat_minutes = local_gps_position.lat_minutes;
+				neom8n_ctx.gps_position.lat_seconds = local_gps_position.lat_seconds;
+				neom8n_ctx.gps_position.lat_north_flag = local_gps_position.lat_north_flag;
+				neom8n_ctx.gps_position.long_degrees = local_gps_position.long_degrees;
+				neom8n_ctx.gps_position.long_minutes = local_gps_position.long_minutes;
+				neom8n_ctx.gps_position.long_seconds = local_gps_position.long_seconds;
+				neom8n_ctx.gps_position.long_east_flag = local_gps_position.long_east_flag;
+				neom8n_ctx.gps_position.altitude = local_gps_position.altitude;
+				// Set flags.
+				neom8n_ctx.nmea_gga_data_valid = 1;
+				neom8n_ctx.acquisition_status = NEOM8N_SUCCESS;
 			}
-			if (neom8n_ctx.nmea_gga_parsing_success != 0) {
-				// Check data.
-				if (NEOM8N_PositionIsValid(&local_gps_position) != 0) {
-					return_code = NEOM8N_SUCCESS;
-					// Save data.
-					(*gps_position).lat_degrees = local_gps_position.lat_degrees;
-					(*gps_position).lat_minutes = local_gps_position.lat_minutes;
-					(*gps_position).lat_seconds = local_gps_position.lat_seconds;
-					(*gps_position).lat_north_flag = local_gps_position.lat_north_flag;
-					(*gps_position).long_degrees = local_gps_position.long_degrees;
-					(*gps_position).long_minutes = local_gps_position.long_minutes;
-					(*gps_position).long_seconds = local_gps_position.long_seconds;
-					(*gps_position).long_east_flag = local_gps_position.long_east_flag;
-					(*gps_position).altitude = local_gps_position.altitude;
-					// Set flag.
-					neom8n_ctx.nmea_gga_data_valid = 1;
-				}
-				else {
-					neom8n_ctx.nmea_gga_data_valid = 0;
-					neom8n_ctx.nmea_gga_parsing_success = 0;
-				}
+			else {
+				neom8n_ctx.nmea_gga_data_valid = 0;
+				neom8n_ctx.nmea_gga_parsing_success = 0;
 			}
-			// Wait for next message.
-			neom8n_ctx.nmea_rx_lf_flag = 0;
-			// Switch to high speed clock required for ADC operation.
-			RCC_SwitchToHsi();
-			// Check supercap voltage.
-			ADC1_PowerOn();
-			ADC1_PerformSupercapMeasurement();
-			ADC1_PowerOff();
-			ADC1_GetSupercapVoltage(&neom8n_ctx.neom8n_supercap_voltage_mv);
-			// Exit if supercap voltage falls below the given threshold.
-			if (neom8n_ctx.neom8n_supercap_voltage_mv < supercap_voltage_min_mv) break;
 		}
-		IWDG_Reload();
+		// Wait for next message.
+		neom8n_ctx.nmea_rx_lf_flag = 0;
+	}
+	// Check timeout and supercap voltage.
+	if (neom8n_ctx.acquisition_status == NEOM8N_RUNNING) {
+		RTC_GetTimestampMilliseconds(&timestamp_ms);
+		if ((timestamp_ms - neom8n_ctx.acquisition_start_timestamp_ms) >= (neom8n_ctx.acquisition_timeout_seconds * 1000)) {
+			neom8n_ctx.acquisition_status = NEOM8N_TIMEOUT;
+		}
+		if ((neom8n_ctx.acquisition_timer_started != 0) && (LPTIM1_GetTimerFlag(neom8n_ctx.acquisition_timer_id) != 0)) {
+			neom8n_ctx.acquisition_status = NEOM8N_TIMEOUT;
+		}
+		if ((neom8n_ctx.acquisition_supercap_monitoring != 0) && (ADC1_GetSupercapWatchdogFlag() != 0)) {
+			neom8n_ctx.acquisition_status = NEOM8N_TIMEOUT;
+		}
 	}
+	return neom8n_ctx.acquisition_status;
+}
+
+/* CHECK IF THE ACQUISITION IS WAITING FOR AN EVENT.
+ * @param:	None.
+ * @return:	1 if no NMEA message, timeout or supercap alert is pending (or if no acquisition is running), 0 otherwise.
+ */
+unsigned char NEOM8N_IsIdle(void) {
+	// No acquisition.
+	if (neom8n_ctx.acquisition_status != NEOM8N_RUNNING) return 1;
+	// NMEA message received.
+	if (neom8n_ctx.nmea_rx_lf_flag != 0) return 0;
+	// Timeout or supercap voltage alert.
+	if ((neom8n_ctx.acquisition_timer_started != 0) && (LPTIM1_GetTimerFlag(neom8n_ctx.acquisition_timer_id) != 0)) return 0;
+	if ((neom8n_ctx.acquisition_supercap_monitoring != 0) && (ADC1_GetSupercapWatchdogFlag() != 0)) return 0;
+	return 1;
+}
+
+/* STOP GPS ACQUISITION AND GET RESULT.
+ * @param gps_position:			Pointer to GPS position structure that will contain the data.
+ * @param fix_duration_seconds:	Pointer that will contain effective fix duration (measured with RTC).
+ * @return return_code:			See NEOM8N_ReturnCode structure in neom8n.h (acquisition stopped before its end is reported as timeout).
+ */
+NEOM8N_ReturnCode NEOM8N_StopAcquisition(Position* gps_position, unsigned int* fix_duration_seconds) {
+	// Local variables.
+	NEOM8N_ReturnCode return_code = NEOM8N_TIMEOUT;
+	unsigned int fix_end_timestamp_ms = 0;
+	unsigned char timer_expired = 0;
 	// Stop ADC and DMA.
-	ADC1_Disable();
+	if (neom8n_ctx.acquisition_supercap_monitoring != 0) {
+		ADC1_StopSupercapWatchdog();
+		ADC1_PowerOff();
+		ADC1_Disable();
+	}
 	DMA1_StopChannel6();
 	DMA1_Disable();
-	// Go back to HSI.
-	RCC_SwitchToHsi();
-	LPUART1_UpdateBrr();
-	// Stop RTC wake-up timer
-	RTC_StopWakeUpTimer();
+	// Stop timeout timer.
+	if (neom8n_ctx.acquisition_timer_started != 0) {
+		timer_expired = LPTIM1_GetTimerFlag(neom8n_ctx.acquisition_timer_id);
+		LPTIM1_StopTimer(neom8n_ctx.acquisition_timer_id);
+		neom8n_ctx.acquisition_timer_started = 0;
+	}
+	// Compute fix duration (rounded to the nearest second).
+	RTC_GetTimestampMilliseconds(&fix_end_timestamp_ms);
+	(*fix_duration_seconds) = ((fix_end_timestamp_ms - neom8n_ctx.acquisition_start_timestamp_ms) + 500) / 1000;
 	// Clamp fix duration.
-	if ((RTC_GetWakeUpTimerFlag() > 0) || ((*fix_duration_seconds) > timeout_seconds)) {
-		(*fix_duration_seconds) = timeout_seconds;
+	if ((timer_expired != 0) || ((*fix_duration_seconds) > neom8n_ctx.acquisition_timeout_seconds)) {
+		(*fix_duration_seconds) = neom8n_ctx.acquisition_timeout_seconds;
 	}
-	RTC_ClearWakeUpTimerFlag();
-	// Return result.
+	// Return position.
+	if (neom8n_ctx.acquisition_status == NEOM8N_SUCCESS) {
+		(*gps_position).lat_degrees = neom8n_ctx.gps_position.lat_degrees;
+		(*gps_position).lat_minutes = neom8n_ctx.gps_position.lat_minutes;
+		(*gps_position).lat_seconds = neom8n_ctx.gps_position.lat_seconds;
+		(*gps_position).lat_north_flag = neom8n_ctx.gps_position.lat_north_flag;
+		(*gps_position).long_degrees = neom8n_ctx.gps_position.long_degrees;
+		(*gps_position).long_minutes = neom8n_ctx.gps_position.long_minutes;
+		(*gps_position).long_seconds = neom8n_ctx.gps_position.long_seconds;
+		(*gps_position).long_east_flag = neom8n_ctx.gps_position.long_east_flag;
+		(*gps_position).altitude = neom8n_ctx.gps_position.altitude;
+		return_code = NEOM8N_SUCCESS;
+	}
+	neom8n_ctx.acquisition_status = NEOM8N_TIMEOUT;
 	return return_code;
 }
 
+/* GET CURRENT GPS POSITION VIA NMEA GGA MESSAGES (RTC CALENDAR IS ALSO SET FROM NMEA ZDA MESSAGES).
+ * @param gps_position:			Pointer to GPS position structure that will contain the data.
+ * @param timeout_seconds:		Timeout in seconds.
+ * @param supercap_voltage_min_mv:	Supercap voltage under which acquisition is aborted (0 to disable monitoring).
+ * @param fix_duration_seconds:	Pointer that will contain effective fix duration (measured with RTC).
+ * @return return_code:			See NEOM8N_ReturnCode structure in neom8n.h.
+ */
+NEOM8N_ReturnCode NEOM8N_GetPosition(Position* gps_position, unsigned int timeout_seconds, unsigned int supercap_voltage_min_mv, unsigned int* fix_duration_seconds) {
+	// Start acquisition.
+	(*fix_duration_seconds) = 0;
+	NEOM8N_StartAcquisition(timeout_seconds, supercap_voltage_min_mv);
+	// Loop until data is retrieved or timeout expired.
+	while (NEOM8N_ProcessAcquisition() == NEOM8N_RUNNING) {
+		// Enter low power sleep mode (clock level is set by the clock manager according to active peripherals).
+		PWR_EnterLowPowerSleepMode();
+		IWDG_Reload();
+	}
+	// Return result.
+	return NEOM8N_StopAcquisition(gps_position, fix_duration_seconds);
+}
+
 /* SWITCH DMA DESTINATION BUFFER (CALLED BY LPUART CM INTERRUPT).
  * @param lf_flag:	Indicates if characters match interrupt occured (LPUART).
  * @return:			None.
@@ -0,0 +1,90 @@
+/*
+ * sensors.c
+ */
+
+#include "sensors.h"
+
+#include "accounting.h"
+#include "adc.h"
+#include "i2c.h"
+#include "rtc.h"
+
+/*** SENSORS local structures ***/
+
+typedef struct {
+	SENSORS_Snapshot sensors_snapshot;
+	unsigned char sensors_snapshot_valid;
+} SENSORS_Context;
+
+/*** SENSORS local global variables ***/
+
+static SENSORS_Context sensors_ctx;
+
+/*** SENSORS functions ***/
+
+/* INIT SENSORS SNAPSHOT STORE.
+ * @param:	None.
+ * @return:	None.
+ */
+void SENSORS_Init(void) {
+	// Invalidate snapshot.
+	sensors_ctx.sensors_snapshot_valid = 0;
+}
+
+/* PERFORM A COMPLETE SENSORS ACQUISITION AND STORE RESULT AS NEW SNAPSHOT.
+ * @param repeatability:	SHT3x measurement repeatability.
+ * @return:					None.
+ */
+void SENSORS_PerformMeasurements(SHT3X_Repeatability repeatability) {
+	// Local variables.
+	unsigned char sht3x_status = 0;
+	ACCOUNTING_EnterState(ACCOUNTING_STATE_MEASURE);
+	// Trigger temperature and humidity conversion on SHT30.
+	I2C1_Init();
+	I2C1_PowerOn();
+	SHT3X_StartMeasurements(repeatability);
+	// Get voltages measurements while SHT30 conversion is running.
+	ADC1_Init();
+	ADC1_PowerOn();
+	ADC1_PerformAllMeasurements();
+	ADC1_PowerOff();
+	ADC1_Disable();
+	ADC1_GetSourceVoltage(&sensors_ctx.sensors_snapshot.source_voltage_mv);
+	ADC1_GetSupercapVoltage(&sensors_ctx.sensors_snapshot.supercap_voltage_mv);
+	ADC1_GetMcuVoltage(&sensors_ctx.sensors_snapshot.mcu_voltage_mv);
+	ADC1_GetMcuTemperatureComp1(&sensors_ctx.sensors_snapshot.mcu_temperature_degrees_comp1);
+	ADC1_GetMcuTemperatureComp2(&sensors_ctx.sensors_snapshot.mcu_temperature_degrees_comp2);
+	// Read SHT30 results.
+	sht3x_status = SHT3X_ReadMeasurements();
+	I2C1_PowerOff();
+	I2C1_Disable();
+	ACCOUNTING_ExitState(ACCOUNTING_STATE_MEASURE);
+	SHT3X_GetTemperatureComp1(&sensors_ctx.sensors_snapshot.temperature_degrees_comp1);
+	SHT3X_GetTemperatureComp2(&sensors_ctx.sensors_snapshot.temperature_degrees_comp2);
+	SHT3X_GetTemperatureCentiDegrees(&sensors_ctx.sensors_snapshot.temperature_centidegrees);
+	SHT3X_GetHumidity(&sensors_ctx.sensors_snapshot.humidity_percent);
+	SHT3X_GetHumidityCentiPercent(&sensors_ctx.sensors_snapshot.humidity_centipercent);
+	sensors_ctx.sensors_snapshot.repeatability = repeatability;
+	// Update timestamp.
+	RTC_GetTimestampSeconds(&sensors_ctx.sensors_snapshot.timestamp_seconds);
+	// SHT3x error (timeout or invalid CRC): previous results are used once and acquisition is performed again on next request.
+	sensors_ctx.sensors_snapshot_valid = (sht3x_status != 0) ? 1 : 0;
+}
+
+/* GET SENSORS DATA, ACQUIRED AGAIN ONLY IF THE STORED SNAPSHOT IS TOO OLD OR NOT ACCURATE ENOUGH.
+ * @param snapshot:			Pointer to the structure that will contain sensors data.
+ * @param max_age_seconds:	Maximum age of the data in seconds.
+ * @param repeatability:	Minimum SHT3x measurement repeatability.
+ * @return:					None.
+ */
+void SENSORS_GetSnapshot(SENSORS_Snapshot* snapshot, unsigned int max_age_seconds, SHT3X_Repeatability repeatability) {
+	// Local variables.
+	unsigned int timestamp_seconds = 0;
+	// Check snapshot age (RTC reset leads to a huge age and thus to a new acquisition).
+	RTC_GetTimestampSeconds(&timestamp_seconds);
+	if ((sensors_ctx.sensors_snapshot_valid == 0) || ((timestamp_seconds - sensors_ctx.sensors_snapshot.timestamp_seconds) > max_age_seconds) || (sensors_ctx.sensors_snapshot.repeatability < repeatability)) {
+		SENSORS_PerformMeasurements(repeatability);
+	}
+	// Copy snapshot.
+	(*snapshot) = sensors_ctx.sensors_snapshot;
+}
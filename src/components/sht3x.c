@@ -12,23 +12,73 @@
 
 /*** SHT3x local macros ***/
 
-#define SHT3X_I2C_ADDRESS				0x44
-#define SHT3X_FULL_SCALE				65535 // Data are 16-bits length (2^(16)-1).
-#define SHT3X_TEMPERATURE_ERROR_VALUE	0x7F
-#define SHT3X_HUMIDITY_ERROR_VALUE		0xFF
+#define SHT3X_I2C_ADDRESS						0x44
+#define SHT3X_FULL_SCALE						65535 // Data are 16-bits length (2^(16)-1).
+#define SHT3X_TEMPERATURE_ERROR_VALUE			0x7F
+#define SHT3X_HUMIDITY_ERROR_VALUE				0xFF
+#define SHT3X_TEMPERATURE_CENTIDEGREES_ERROR	0x7FFFFFFF
+#define SHT3X_HUMIDITY_CENTIPERCENT_ERROR		0xFFFFFFFF
+#define SHT3X_STARTUP_TIME_MS					2 // Power-up time is 1.5ms max.
+#define SHT3X_POLLING_PERIOD_MS					1
+#define SHT3X_MEASURE_BUFFER_LENGTH_BYTES		6
+#define SHT3X_CRC8_POLYNOMIAL					0x31 // x^(8)+x^(5)+x^(4)+1.
+#define SHT3X_CRC8_INIT_VALUE					0xFF
 
 /*** SHT3x local structures ***/
 
+typedef struct {
+	unsigned char sht3x_command_lsb;			// Single shot command LSB (MSB is 0x24: clock stretching disabled).
+	unsigned char sht3x_conversion_min_ms;		// Typical conversion time (first polling).
+	unsigned char sht3x_conversion_max_ms;		// Maximum conversion time (polling timeout).
+} SHT3X_RepeatabilitySetting;
+
 typedef struct {
 	unsigned char sht3x_temperature_degrees_comp1;
 	signed char sht3x_temperature_degrees_comp2;
+	signed int sht3x_temperature_centidegrees;
 	unsigned char sht3x_humidity_percent;
+	unsigned int sht3x_humidity_centipercent;
+	// Pending measurement.
+	unsigned char sht3x_measurement_pending;
+	SHT3X_Repeatability sht3x_repeatability;
+	unsigned char sht3x_timer_id;
 } SHT3X_Context;
 
 /*** SHT3x local global variables ***/
 
+static const SHT3X_RepeatabilitySetting sht3x_repeatability_settings[SHT3X_REPEATABILITY_LAST] = {
+	{0x16, 2, 4},	// Low.
+	{0x0B, 4, 6},	// Medium.
+	{0x00, 12, 15}	// High.
+};
 static SHT3X_Context sht3x_ctx;
 
+/*** SHT3x local functions ***/
+
+/* COMPUTE SHT3X CRC-8 OF A 16-BITS DATA WORD.
+ * @param data:	Pointer to the 2 bytes to check.
+ * @return crc:	Computed CRC.
+ */
+static unsigned char SHT3X_ComputeCrc8(unsigned char* data) {
+	// Local variables.
+	unsigned char crc = SHT3X_CRC8_INIT_VALUE;
+	unsigned char byte_idx = 0;
+	unsigned char bit_idx = 0;
+	// Process bytes MSB first.
+	for (byte_idx=0 ; byte_idx<2 ; byte_idx++) {
+		crc ^= data[byte_idx];
+		for (bit_idx=0 ; bit_idx<8 ; bit_idx++) {
+			if ((crc & 0x80) != 0) {
+				crc = (crc << 1) ^ SHT3X_CRC8_POLYNOMIAL;
+			}
+			else {
+				crc = (crc << 1);
+			}
+		}
+	}
+	return crc;
+}
+
 /*** SHT3x functions ***/
 
 /* INIT SHT3X SENSOR.
@@ -39,29 +89,74 @@ void SHT3X_Init(void) {
 	// Init context.
 	sht3x_ctx.sht3x_temperature_degrees_comp2 = SHT3X_TEMPERATURE_ERROR_VALUE;
 	sht3x_ctx.sht3x_temperature_degrees_comp1 = SHT3X_TEMPERATURE_ERROR_VALUE;
+	sht3x_ctx.sht3x_temperature_centidegrees = SHT3X_TEMPERATURE_CENTIDEGREES_ERROR;
 	sht3x_ctx.sht3x_humidity_percent = SHT3X_HUMIDITY_ERROR_VALUE;
+	sht3x_ctx.sht3x_humidity_centipercent = SHT3X_HUMIDITY_CENTIPERCENT_ERROR;
+	sht3x_ctx.sht3x_measurement_pending = 0;
 }
 
-/* PERFORM TEMPERATURE AND HUMIDITY MEASUREMENTS.
- * @param:	None.
- * @return:	None.
+/* TRIGGER TEMPERATURE AND HUMIDITY MEASUREMENTS (CONVERSION RUNS WHILE CALLER PERFORMS OTHER OPERATIONS).
+ * @param repeatability:	Measurement repeatability (accuracy versus conversion time and energy trade-off).
+ * @return status:			1 if measurements were triggered, 0 otherwise.
  */
-void SHT3X_PerformMeasurements(void) {
+unsigned char SHT3X_StartMeasurements(SHT3X_Repeatability repeatability) {
+	// Local variables.
+	unsigned char measurement_command[2] = {0x24, 0x00};
+	unsigned char i2c_access = 0;
 	// Reset results.
 	sht3x_ctx.sht3x_temperature_degrees_comp2 = SHT3X_TEMPERATURE_ERROR_VALUE;
 	sht3x_ctx.sht3x_temperature_degrees_comp1 = SHT3X_TEMPERATURE_ERROR_VALUE;
+	sht3x_ctx.sht3x_temperature_centidegrees = SHT3X_TEMPERATURE_CENTIDEGREES_ERROR;
 	sht3x_ctx.sht3x_humidity_percent = SHT3X_HUMIDITY_ERROR_VALUE;
-	// Trigger high repeatability measurement with clock stretching disabled.
-	unsigned char measurement_command[2] = {0x24, 0x00};
-	unsigned char i2c_access = I2C1_Write(SHT3X_I2C_ADDRESS, measurement_command, 2, 1);
-	if (i2c_access == 0) return;
-	// Wait for conversion to complete (at least 15ms).
-	LPTIM1_DelayMilliseconds(50, 1);
-	unsigned char measure_buf[6];
-	i2c_access = I2C1_Read(SHT3X_I2C_ADDRESS, measure_buf, 6);
-	if (i2c_access == 0) return;
-	// Compute temperature (TBC: verify checksum).
-	unsigned int temperature_16bits = (measure_buf[0] << 8) + measure_buf[1];
+	sht3x_ctx.sht3x_humidity_centipercent = SHT3X_HUMIDITY_CENTIPERCENT_ERROR;
+	sht3x_ctx.sht3x_measurement_pending = 0;
+	if (repeatability >= SHT3X_REPEATABILITY_LAST) return 0;
+	// Wait for sensor to be ready after power-on.
+	I2C1_WaitSlaveReady(SHT3X_STARTUP_TIME_MS);
+	// Trigger single shot measurement with clock stretching disabled.
+	measurement_command[1] = sht3x_repeatability_settings[repeatability].sht3x_command_lsb;
+	i2c_access = I2C1_Write(SHT3X_I2C_ADDRESS, measurement_command, 2, 1);
+	if (i2c_access == 0) return 0;
+	// Start typical conversion time timer.
+	if (LPTIM1_StartTimer(&sht3x_ctx.sht3x_timer_id, sht3x_repeatability_settings[repeatability].sht3x_conversion_min_ms, LPTIM_TIMER_MODE_SINGLE, 0) == 0) return 0;
+	sht3x_ctx.sht3x_repeatability = repeatability;
+	sht3x_ctx.sht3x_measurement_pending = 1;
+	return 1;
+}
+
+/* WAIT FOR MEASUREMENTS TRIGGERED BY SHT3X_StartMeasurements AND READ RESULTS.
+ * @param:			None.
+ * @return status:	1 if measurements succeeded (valid CRC), 0 otherwise.
+ */
+unsigned char SHT3X_ReadMeasurements(void) {
+	// Local variables.
+	unsigned char measure_buf[SHT3X_MEASURE_BUFFER_LENGTH_BYTES];
+	unsigned char i2c_access = 0;
+	unsigned char conversion_time_ms = 0;
+	unsigned int temperature_16bits = 0;
+	unsigned int humidity_16bits = 0;
+	// Check if a measurement was triggered.
+	if (sht3x_ctx.sht3x_measurement_pending == 0) return 0;
+	sht3x_ctx.sht3x_measurement_pending = 0;
+	// Wait for remaining part of typical conversion time.
+	LPTIM1_WaitTimer(sht3x_ctx.sht3x_timer_id, 1);
+	LPTIM1_StopTimer(sht3x_ctx.sht3x_timer_id);
+	conversion_time_ms = sht3x_repeatability_settings[sht3x_ctx.sht3x_repeatability].sht3x_conversion_min_ms;
+	// Poll sensor (read header is not acknowledged while conversion is running).
+	i2c_access = I2C1_Read(SHT3X_I2C_ADDRESS, measure_buf, SHT3X_MEASURE_BUFFER_LENGTH_BYTES);
+	while (i2c_access == 0) {
+		// Exit if maximum conversion time is reached.
+		if (conversion_time_ms >= sht3x_repeatability_settings[sht3x_ctx.sht3x_repeatability].sht3x_conversion_max_ms) return 0;
+		LPTIM1_DelayMilliseconds(SHT3X_POLLING_PERIOD_MS, 1);
+		conversion_time_ms += SHT3X_POLLING_PERIOD_MS;
+		i2c_access = I2C1_Read(SHT3X_I2C_ADDRESS, measure_buf, SHT3X_MEASURE_BUFFER_LENGTH_BYTES);
+	}
+	// Check CRCs.
+	if (SHT3X_ComputeCrc8(&(measure_buf[0])) != measure_buf[2]) return 0;
+	if (SHT3X_ComputeCrc8(&(measure_buf[3])) != measure_buf[5]) return 0;
+	// Compute temperature with 0.01 resolution: T = -45 + 175 * (raw / (2^(16)-1)).
+	temperature_16bits = (measure_buf[0] << 8) + measure_buf[1];
+	sht3x_ctx.sht3x_temperature_centidegrees = ((signed int) ((17500 * temperature_16bits) / (SHT3X_FULL_SCALE))) - 4500;
 	sht3x_ctx.sht3x_temperature_degrees_comp2 = ((175 * temperature_16bits) / (SHT3X_FULL_SCALE)) - 45;
 	// Convert to 1-complement value.
 	sht3x_ctx.sht3x_temperature_degrees_comp1 = 0;
@@ -73,9 +168,21 @@ void SHT3X_PerformMeasurements(void) {
 	else {
 		sht3x_ctx.sht3x_temperature_degrees_comp1 = (sht3x_ctx.sht3x_temperature_degrees_comp2 & 0x7F);
 	}
-	// Compute humidity (TBC: verify checksum).
-	unsigned int humidity_16bits = (measure_buf[3] << 8) + measure_buf[4];
+	// Compute humidity with 0.01 resolution: RH = 100 * (raw / (2^(16)-1)).
+	humidity_16bits = (measure_buf[3] << 8) + measure_buf[4];
+	sht3x_ctx.sht3x_humidity_centipercent = (10000 * humidity_16bits) / (SHT3X_FULL_SCALE);
 	sht3x_ctx.sht3x_humidity_percent = (100 * humidity_16bits) / (SHT3X_FULL_SCALE);
+	return 1;
+}
+
+/* PERFORM TEMPERATURE AND HUMIDITY MEASUREMENTS.
+ * @param repeatability:	Measurement repeatability (accuracy versus conversion time and energy trade-off).
+ * @return status:			1 if measurements succeeded (valid CRC), 0 otherwise.
+ */
+unsigned char SHT3X_PerformMeasurements(SHT3X_Repeatability repeatability) {
+	// Trigger and wait for conversion.
+	if (SHT3X_StartMeasurements(repeatability) == 0) return 0;
+	return SHT3X_ReadMeasurements();
 }
 
 /* READ TEMPERATURE FROM SHT3X SENSOR.
@@ -96,6 +203,15 @@ void SHT3X_GetTemperatureComp2(signed char* temperature_degrees) {
 	(*temperature_degrees) = sht3x_ctx.sht3x_temperature_degrees_comp2;
 }
 
+/* READ TEMPERATURE FROM SHT3X SENSOR WITH 0.01 RESOLUTION.
+ * @param temperature_centidegrees:	Pointer to signed int that will contain temperature result (1/100 degrees).
+ * @return:							None.
+ */
+void SHT3X_GetTemperatureCentiDegrees(signed int* temperature_centidegrees) {
+	// Get result.
+	(*temperature_centidegrees) = sht3x_ctx.sht3x_temperature_centidegrees;
+}
+
 /* READ HUMIDTY FROM SHT3X SENSOR.
  * @param humidity_percent:		Pointer to byte that will contain humidity result (%).
  * @return:						None.
@@ -104,3 +220,12 @@ void SHT3X_GetHumidity(unsigned char* humidity_percent) {
 	// Get result.
 	(*humidity_percent) = sht3x_ctx.sht3x_humidity_percent;
 }
+
+/* READ HUMIDTY FROM SHT3X SENSOR WITH 0.01 RESOLUTION.
+ * @param humidity_centipercent:	Pointer to int that will contain humidity result (1/100 %).
+ * @return:							None.
+ */
+void SHT3X_GetHumidityCentiPercent(unsigned int* humidity_centipercent) {
+	// Get result.
+	(*humidity_centipercent) = sht3x_ctx.sht3x_humidity_centipercent;
+}
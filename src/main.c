@@ -29,28 +29,64 @@
 #include "mma8653fc.h"
 #include "neom8n.h"
 #include "s2lp.h"
+#include "sensors.h"
 #include "sht3x.h"
 #include "sigfox_types.h"
 // Applicative.
+#include "accounting.h"
 #include "at.h"
+#include "energy.h"
 #include "mode.h"
+#include "profiler.h"
+#include "scheduler.h"
 #include "sigfox_api.h"
+#include "task.h"
 
 /*** MAIN macros ***/
 
+// Guarded values can be overridden at compile time (see sim/sweep.sh).
 #ifdef SSM
-#define TKFX_STOP_CONDITION_THRESHOLD_SECONDS			300
+#ifndef TKFX_STOP_CONDITION_THRESHOLD_SECONDS
+#define TKFX_STOP_CONDITION_THRESHOLD_SECONDS			300 // Nominal values, adapted by energy manager.
+#endif
+#define TKFX_STOP_CONDITION_THRESHOLD_MIN_SECONDS		120
+#define TKFX_STOP_CONDITION_THRESHOLD_MAX_SECONDS		3600
+#ifndef TKFX_KEEP_ALIVE_PERIOD_SECONDS
 #define TKFX_KEEP_ALIVE_PERIOD_SECONDS					3600
 #endif
+#define TKFX_KEEP_ALIVE_PERIOD_MIN_SECONDS				900
+#define TKFX_KEEP_ALIVE_PERIOD_MAX_SECONDS				86400
+#endif
 #ifdef PM
-#define TKFX_GEOLOC_PERIOD_SECONDS						120
+#ifndef TKFX_GEOLOC_PERIOD_SECONDS
+#define TKFX_GEOLOC_PERIOD_SECONDS						120 // Nominal value, adapted by energy manager.
 #endif
+#define TKFX_GEOLOC_PERIOD_MIN_SECONDS					60
+#define TKFX_GEOLOC_PERIOD_MAX_SECONDS					3600
+#endif
+#define TKFX_MEASUREMENT_MAX_AGE_SECONDS				60
+#define TKFX_KEEP_ALIVE_SHT3X_REPEATABILITY				SHT3X_REPEATABILITY_LOW
+#define TKFX_ALARM_SHT3X_REPEATABILITY					SHT3X_REPEATABILITY_MEDIUM
+#ifndef TKFX_GEOLOC_TIMEOUT_SECONDS
 #define TKFX_GEOLOC_TIMEOUT_SECONDS						180
+#endif
+#define TKFX_SIGFOX_RETRY_DELAY_SECONDS					600
+#define TKFX_SIGFOX_RETRY_COUNT_MAX						3
+#ifndef TKFX_GEOLOC_SUPERCAP_VOLTAGE_MIN_MV
 #define TKFX_GEOLOC_SUPERCAP_VOLTAGE_MIN_MV				1500
+#endif
+#ifndef TKFX_CONCURRENT_SUPERCAP_VOLTAGE_MIN_MV
+#define TKFX_CONCURRENT_SUPERCAP_VOLTAGE_MIN_MV			2000 // GPS acquisition and radio transmission can overlap above this voltage.
+#endif
 #define TKFX_SIGFOX_GEOLOC_DATA_LENGTH_BYTES			11
 #define TKFX_SIGFOX_GEOLOC_TIMEOUT_DATA_LENGTH_BYTES	1
 #define TKFX_SIGFOX_DOWNLINK_DATA_LENGTH_BYTES			8
+//#define TKFX_SIGFOX_MONITORING_ACCOUNTING				// Append charge summary byte to monitoring frame if defined.
+#ifdef TKFX_SIGFOX_MONITORING_ACCOUNTING
+#define TKFX_SIGFOX_MONITORING_DATA_LENGTH_BYTES		9
+#else
 #define TKFX_SIGFOX_MONITORING_DATA_LENGTH_BYTES		8
+#endif
 
 /*** MAIN structures ***/
 
@@ -63,8 +99,7 @@ typedef enum {
 	TKFX_STATE_ACCELERO,
 #endif
 	TKFX_STATE_OOB,
-	TKFX_STATE_MEASURE,
-	TKFX_STATE_MONITORING,
+	TKFX_STATE_ACTIVE,
 	TKFX_STATE_GEOLOC,
 	TKFX_STATE_OFF,
 	TKFX_STATE_SLEEP
@@ -80,6 +115,9 @@ typedef union {
 		unsigned supercap_voltage_mv : 12;
 		unsigned mcu_voltage_mv : 12;
 		unsigned status_byte : 8;
+#ifdef TKFX_SIGFOX_MONITORING_ACCOUNTING
+		unsigned charge_summary : 8;
+#endif
 	} __attribute__((scalar_storage_order("big-endian"))) __attribute__((packed)) field;
 } TKFX_SigfoxMonitoringData;
 
@@ -110,20 +148,32 @@ typedef enum {
 	TKFX_STATUS_BYTE_LSE_STATUS_BIT_IDX
 } TKFX_StatusBitsIndex;
 
+// High current phases bit indexes.
+typedef enum {
+	TKFX_PHASE_GPS_BIT_IDX,
+	TKFX_PHASE_RADIO_BIT_IDX
+} TKFX_PhaseBitsIndex;
+
+// Cooperative tasks.
+typedef enum {
+	TKFX_TASK_MONITORING,
+	TKFX_TASK_GEOLOC,
+	TKFX_TASK_LAST
+} TKFX_Task;
+
 // Device context.
 typedef struct {
 	// State machine.
 	TKFX_State tkfx_state;
 	unsigned char tkfx_por_flag;
 	unsigned int tkfx_lsi_frequency_hz;
-#ifdef SSM
-	unsigned int tkfx_stop_timer_seconds;
-	unsigned int tkfx_keep_alive_timer_seconds;
-#endif
-#ifdef PM
-	unsigned int tkfx_geoloc_timer_seconds;
-#endif
+	unsigned char tkfx_use_lse;
 	unsigned char tkfx_status_byte;
+	// Active phase.
+	unsigned char tkfx_monitoring_required;
+	unsigned char tkfx_geoloc_required;
+	unsigned char tkfx_measured_flag;
+	unsigned char tkfx_phases; // Bit field of high current phases currently running.
 	// Monitoring data.
 	unsigned char tkfx_temperature_degrees;
 	unsigned char tkfx_mcu_temperature_degrees;
@@ -135,9 +185,14 @@ typedef struct {
 	unsigned int tkfx_geoloc_fix_duration_seconds;
 	unsigned int tkfx_geoloc_timeout;
 	// Sigfox.
+	unsigned char tkfx_sfx_failure_flag;
+	unsigned char tkfx_sfx_retry_count;
+	sfx_rc_t tkfx_sigfox_rc;
 	TKFX_SigfoxMonitoringData tkfx_sfx_monitoring_data;
 	TKFX_SigfoxGeolocData tkfx_sfx_geoloc_data;
 	unsigned char tkfx_sfx_downlink_data[TKFX_SIGFOX_DOWNLINK_DATA_LENGTH_BYTES];
+	// Tasks.
+	TASK_Descriptor tkfx_tasks[TKFX_TASK_LAST];
 } TKFX_Context;
 #endif
 
@@ -147,6 +202,143 @@ typedef struct {
 static TKFX_Context tkfx_ctx;
 #endif
 
+/*** MAIN local functions ***/
+
+#ifndef ATM
+/* CHECK IF SUPERCAP VOLTAGE ALLOWS SEVERAL HIGH CURRENT PHASES TO RUN CONCURRENTLY.
+ * @param:	None.
+ * @return:	1 if phases can overlap, 0 otherwise.
+ */
+static unsigned char TKFX_ConcurrencyAllowed(void) {
+	return (tkfx_ctx.tkfx_supercap_voltage_mv >= TKFX_CONCURRENT_SUPERCAP_VOLTAGE_MIN_MV) ? 1 : 0;
+}
+
+/* CHECK IF A HIGH CURRENT PHASE CAN START.
+ * @param phase_bit_idx:	Phase to start.
+ * @return:					1 if the phase is admitted, 0 if it must wait for the end of other phases.
+ */
+static unsigned char TKFX_IsPhaseAdmitted(TKFX_PhaseBitsIndex phase_bit_idx) {
+	// Phase is admitted alone, or concurrently when supercap is charged enough.
+	if ((tkfx_ctx.tkfx_phases & ~(0b1 << phase_bit_idx)) == 0) {
+		return 1;
+	}
+	return TKFX_ConcurrencyAllowed();
+}
+
+/* IDLE FUNCTION CALLED (WITH INTERRUPTS MASKED) WHEN ALL TASKS ARE WAITING FOR AN INTERRUPT.
+ * @param:	None.
+ * @return:	None.
+ */
+static void TKFX_Idle(void) {
+	// Only GPS acquisition waits for interrupts: do not sleep if an event occurred since the last tasks round.
+	if (NEOM8N_IsIdle() != 0) {
+		// Lower clock to the minimum required by active peripherals while waiting for next interrupt (NMEA frame, timer or supercap alert).
+		RCC_SetClockRequest(RCC_CLOCK_CLIENT_APPLICATION, 0);
+		// Enter low power sleep mode (DMA keeps running).
+		PWR_EnterLowPowerSleepMode();
+		// Go back to HSI to resume tasks.
+		RCC_SetClockRequest(RCC_CLOCK_CLIENT_APPLICATION, RCC_HSI_FREQUENCY_KHZ);
+	}
+	IWDG_Reload();
+}
+
+/* MONITORING TASK: MEASURE SENSORS AND SEND MONITORING FRAME.
+ * @param task_ctx:	Task context.
+ * @return:			Task status.
+ */
+static TASK_Status TKFX_MonitoringTask(TASK_Context* task_ctx) {
+	// Local variables.
+	SENSORS_Snapshot sensors_snapshot;
+	unsigned int sfx_error = 0;
+	TASK_BEGIN(task_ctx);
+	IWDG_Reload();
+	// Get sensors data (new acquisition is performed only if last snapshot is too old or not accurate enough).
+	if ((tkfx_ctx.tkfx_status_byte & (0b1 << TKFX_STATUS_BYTE_ALARM_FLAG_BIT_IDX)) != 0) {
+		SENSORS_GetSnapshot(&sensors_snapshot, TKFX_MEASUREMENT_MAX_AGE_SECONDS, TKFX_ALARM_SHT3X_REPEATABILITY);
+	}
+	else {
+		SENSORS_GetSnapshot(&sensors_snapshot, TKFX_MEASUREMENT_MAX_AGE_SECONDS, TKFX_KEEP_ALIVE_SHT3X_REPEATABILITY);
+	}
+	tkfx_ctx.tkfx_temperature_degrees = sensors_snapshot.temperature_degrees_comp1;
+	tkfx_ctx.tkfx_source_voltage_mv = sensors_snapshot.source_voltage_mv;
+	tkfx_ctx.tkfx_supercap_voltage_mv = sensors_snapshot.supercap_voltage_mv;
+	tkfx_ctx.tkfx_mcu_voltage_mv = sensors_snapshot.mcu_voltage_mv;
+	tkfx_ctx.tkfx_mcu_temperature_degrees = sensors_snapshot.mcu_temperature_degrees_comp1;
+	// Update energy estimation.
+	ENERGY_Update(&sensors_snapshot);
+	// ADC is released: GPS task can start.
+	tkfx_ctx.tkfx_measured_flag = 1;
+	if (tkfx_ctx.tkfx_monitoring_required != 0) {
+		// Let GPS warm up first if both phases can overlap, otherwise keep the frame before the GPS acquisition.
+		if (TKFX_ConcurrencyAllowed() != 0) {
+			TASK_YIELD(task_ctx);
+		}
+		TASK_WAIT_UNTIL(task_ctx, TKFX_IsPhaseAdmitted(TKFX_PHASE_RADIO_BIT_IDX) != 0);
+		tkfx_ctx.tkfx_phases |= (0b1 << TKFX_PHASE_RADIO_BIT_IDX);
+		IWDG_Reload();
+		// Build Sigfox frame.
+		tkfx_ctx.tkfx_sfx_monitoring_data.field.temperature_degrees = tkfx_ctx.tkfx_temperature_degrees;
+		tkfx_ctx.tkfx_sfx_monitoring_data.field.mcu_temperature_degrees = tkfx_ctx.tkfx_mcu_temperature_degrees;
+		tkfx_ctx.tkfx_sfx_monitoring_data.field.source_voltage_mv = tkfx_ctx.tkfx_source_voltage_mv;
+		tkfx_ctx.tkfx_sfx_monitoring_data.field.supercap_voltage_mv = tkfx_ctx.tkfx_supercap_voltage_mv;
+		tkfx_ctx.tkfx_sfx_monitoring_data.field.mcu_voltage_mv = tkfx_ctx.tkfx_mcu_voltage_mv;
+		tkfx_ctx.tkfx_sfx_monitoring_data.field.status_byte = tkfx_ctx.tkfx_status_byte;
+#ifdef TKFX_SIGFOX_MONITORING_ACCOUNTING
+		tkfx_ctx.tkfx_sfx_monitoring_data.field.charge_summary = ACCOUNTING_GetSummary();
+#endif
+		// Send uplink monitoring frame (blocking, GPS messages are still received by DMA in the meantime).
+		sfx_error = SIGFOX_API_open(&tkfx_ctx.tkfx_sigfox_rc);
+		if (sfx_error == SFX_ERR_NONE) {
+			sfx_error = SIGFOX_API_send_frame(tkfx_ctx.tkfx_sfx_monitoring_data.raw_frame, TKFX_SIGFOX_MONITORING_DATA_LENGTH_BYTES, tkfx_ctx.tkfx_sfx_downlink_data, 2, 0);
+		}
+		SIGFOX_API_close();
+		if (sfx_error != SFX_ERR_NONE) {
+			tkfx_ctx.tkfx_sfx_failure_flag = 1;
+		}
+		tkfx_ctx.tkfx_phases &= ~(0b1 << TKFX_PHASE_RADIO_BIT_IDX);
+	}
+	TASK_END(task_ctx);
+}
+
+/* GEOLOC TASK: GET POSITION FROM GPS.
+ * @param task_ctx:	Task context.
+ * @return:			Task status.
+ */
+static TASK_Status TKFX_GeolocTask(TASK_Context* task_ctx) {
+	// Local variables.
+	NEOM8N_ReturnCode neom8n_return_code = NEOM8N_TIMEOUT;
+	TASK_BEGIN(task_ctx);
+	// Supercap voltage is required before starting.
+	TASK_WAIT_UNTIL(task_ctx, tkfx_ctx.tkfx_measured_flag != 0);
+	if (tkfx_ctx.tkfx_supercap_voltage_mv < TKFX_GEOLOC_SUPERCAP_VOLTAGE_MIN_MV) {
+		// Do not perform GPS fix.
+		tkfx_ctx.tkfx_geoloc_fix_duration_seconds = 0;
+		tkfx_ctx.tkfx_geoloc_timeout = 1;
+	}
+	else {
+		TASK_WAIT_UNTIL(task_ctx, TKFX_IsPhaseAdmitted(TKFX_PHASE_GPS_BIT_IDX) != 0);
+		tkfx_ctx.tkfx_phases |= (0b1 << TKFX_PHASE_GPS_BIT_IDX);
+		IWDG_Reload();
+		// Start GPS acquisition.
+		LPUART1_Init(tkfx_ctx.tkfx_use_lse);
+		LPUART1_PowerOn();
+		NEOM8N_StartAcquisition(TKFX_GEOLOC_TIMEOUT_SECONDS, TKFX_GEOLOC_SUPERCAP_VOLTAGE_MIN_MV);
+		// Parse NMEA messages until position is valid or timeout.
+		TASK_WAIT_UNTIL(task_ctx, NEOM8N_ProcessAcquisition() != NEOM8N_RUNNING);
+		neom8n_return_code = NEOM8N_StopAcquisition(&tkfx_ctx.tkfx_geoloc_position, &tkfx_ctx.tkfx_geoloc_fix_duration_seconds);
+		LPUART1_PowerOff();
+		LPUART1_Disable();
+		tkfx_ctx.tkfx_phases &= ~(0b1 << TKFX_PHASE_GPS_BIT_IDX);
+		// Parse result.
+		if (neom8n_return_code != NEOM8N_SUCCESS) {
+			tkfx_ctx.tkfx_geoloc_timeout = 1;
+		}
+	}
+	TASK_END(task_ctx);
+}
+
+#endif
+
 /*** MAIN functions ***/
 
 #ifndef ATM
@@ -167,21 +359,18 @@ int main (void) {
 	tkfx_ctx.tkfx_por_flag = 1;
 	tkfx_ctx.tkfx_lsi_frequency_hz = 0;
 	tkfx_ctx.tkfx_state = TKFX_STATE_POR;
-#ifdef SSM
-	tkfx_ctx.tkfx_stop_timer_seconds = 0;
-	tkfx_ctx.tkfx_keep_alive_timer_seconds = 0;
-#endif
-#ifdef PM
-	tkfx_ctx.tkfx_geoloc_timer_seconds = 0;
-#endif
 	tkfx_ctx.tkfx_status_byte = 0; // Reset all flags and tracker mode='00'.
+	tkfx_ctx.tkfx_sfx_failure_flag = 0;
+	tkfx_ctx.tkfx_sfx_retry_count = 0;
+	tkfx_ctx.tkfx_sigfox_rc = (sfx_rc_t) RC1;
+	tkfx_ctx.tkfx_use_lse = 0;
+	tkfx_ctx.tkfx_tasks[TKFX_TASK_MONITORING].task_function = &TKFX_MonitoringTask;
+	tkfx_ctx.tkfx_tasks[TKFX_TASK_GEOLOC].task_function = &TKFX_GeolocTask;
 	// Local variables.
-	unsigned char tkfx_use_lse = 0;
 	unsigned char hse_success = 0;
 	unsigned int sfx_error = 0;
-	sfx_rc_t tkfx_sigfox_rc = (sfx_rc_t) RC1;
 	unsigned int geoloc_fix_start_time_seconds = 0;
-	NEOM8N_ReturnCode neom8n_return_code = NEOM8N_TIMEOUT;
+	SCHEDULER_Event scheduler_event = SCHEDULER_EVENT_LAST;
 	// Main loop.
 	while (1) {
 		// Perform state machine.
@@ -190,19 +379,27 @@ int main (void) {
 			// Init watchdog.
 			IWDG_Init();
 			IWDG_Reload();
+			// Load accounting counters from backup registers before they are cleared.
+			ACCOUNTING_Init();
 			// Reset RTC before starting oscillators.
 			RTC_Reset();
 			// Low speed oscillators.
 			tkfx_ctx.tkfx_status_byte |= (RCC_EnableLsi() << TKFX_STATUS_BYTE_LSI_STATUS_BIT_IDX);
-			tkfx_use_lse = RCC_EnableLse();
+			tkfx_ctx.tkfx_use_lse = RCC_EnableLse();
 			// Switch to HSI clock.
-			RCC_SwitchToHsi();
+			RCC_SetClockRequest(RCC_CLOCK_CLIENT_APPLICATION, RCC_HSI_FREQUENCY_KHZ);
 			// Get LSI effective frequency (must be called after HSI initialization and before RTC inititialization).
 			RCC_GetLsiFrequency(&tkfx_ctx.tkfx_lsi_frequency_hz);
 			IWDG_Reload();
 			// Init RTC.
-			RTC_Init(&tkfx_use_lse, tkfx_ctx.tkfx_lsi_frequency_hz);
-			tkfx_ctx.tkfx_status_byte |= (tkfx_use_lse << TKFX_STATUS_BYTE_LSE_STATUS_BIT_IDX);
+			RTC_Init(&tkfx_ctx.tkfx_use_lse, tkfx_ctx.tkfx_lsi_frequency_hz);
+			RCC_StartClockLevelTime();
+			tkfx_ctx.tkfx_status_byte |= (tkfx_ctx.tkfx_use_lse << TKFX_STATUS_BYTE_LSE_STATUS_BIT_IDX);
+			ACCOUNTING_Save();
+			// Init sensors snapshot store and scheduler.
+			SENSORS_Init();
+			ENERGY_Init(TKFX_GEOLOC_SUPERCAP_VOLTAGE_MIN_MV);
+			SCHEDULER_Init();
 			// Compute next state.
 			tkfx_ctx.tkfx_state = TKFX_STATE_INIT;
 			break;
@@ -211,18 +408,18 @@ int main (void) {
 			// Disable RTC interrupt.
 			RTC_StopWakeUpTimer();
 #ifdef SSM
-			// Reset keep-alive timer.
-			tkfx_ctx.tkfx_keep_alive_timer_seconds = 0;
+			// Restart keep-alive period.
+			SCHEDULER_SetDeadline(SCHEDULER_EVENT_KEEP_ALIVE, ENERGY_GetPeriod(TKFX_KEEP_ALIVE_PERIOD_SECONDS, TKFX_KEEP_ALIVE_PERIOD_MIN_SECONDS, TKFX_KEEP_ALIVE_PERIOD_MAX_SECONDS));
 			// Disable accelerometer interrupt.
 			NVIC_DisableInterrupt(NVIC_IT_EXTI_0_1);
 #endif
 #ifdef PM
-			// Reset geoloc timer.
-			tkfx_ctx.tkfx_geoloc_timer_seconds = 0;
+			// Restart geoloc period.
+			SCHEDULER_SetDeadline(SCHEDULER_EVENT_GEOLOC, ENERGY_GetPeriod(TKFX_GEOLOC_PERIOD_SECONDS, TKFX_GEOLOC_PERIOD_MIN_SECONDS, TKFX_GEOLOC_PERIOD_MAX_SECONDS));
 #endif
 			// High speed oscillator.
 			IWDG_Reload();
-			RCC_SwitchToHsi();
+			RCC_SetClockRequest(RCC_CLOCK_CLIENT_APPLICATION, RCC_HSI_FREQUENCY_KHZ);
 			// Init delay timer.
 			LPTIM1_Init(tkfx_ctx.tkfx_lsi_frequency_hz);
 			// Unused communication interfaces.
@@ -232,10 +429,21 @@ int main (void) {
 			SHT3X_Init();
 #ifdef SSM
 			MMA8653FC_Init();
+#endif
+			// Select tasks to run.
+			tkfx_ctx.tkfx_monitoring_required = 1;
+#ifdef SSM
+			tkfx_ctx.tkfx_geoloc_required = 0;
+			if (((tkfx_ctx.tkfx_status_byte & (0b1 << TKFX_STATUS_BYTE_MOVING_FLAG_BIT_IDX)) == 0) && ((tkfx_ctx.tkfx_status_byte & (0b1 << TKFX_STATUS_BYTE_ALARM_FLAG_BIT_IDX)) != 0)) {
+				// Stop condition.
+				tkfx_ctx.tkfx_geoloc_required = 1;
+			}
+#else
+			tkfx_ctx.tkfx_geoloc_required = 1;
 #endif
 			// Compute next state.
 			if (tkfx_ctx.tkfx_por_flag == 0) {
-				tkfx_ctx.tkfx_state = TKFX_STATE_MEASURE;
+				tkfx_ctx.tkfx_state = TKFX_STATE_ACTIVE;
 			}
 			else {
 #ifdef SSM
@@ -261,7 +469,7 @@ int main (void) {
 		case TKFX_STATE_OOB:
 			IWDG_Reload();
 			// Send OOB frame.
-			sfx_error = SIGFOX_API_open(&tkfx_sigfox_rc);
+			sfx_error = SIGFOX_API_open(&tkfx_ctx.tkfx_sigfox_rc);
 			if (sfx_error == SFX_ERR_NONE) {
 				sfx_error = SIGFOX_API_send_outofband(SFX_OOB_SERVICE);
 			}
@@ -270,80 +478,29 @@ int main (void) {
 #ifdef SSM
 			tkfx_ctx.tkfx_state = TKFX_STATE_OFF;
 #else
-			tkfx_ctx.tkfx_state = TKFX_STATE_GEOLOC;
+			// Only geoloc frame is sent after OOB frame.
+			tkfx_ctx.tkfx_monitoring_required = 0;
+			tkfx_ctx.tkfx_state = TKFX_STATE_ACTIVE;
 #endif
 			break;
-		case TKFX_STATE_MEASURE:
+		case TKFX_STATE_ACTIVE:
 			IWDG_Reload();
-			// Get temperature from SHT30.
-			I2C1_Init();
-			I2C1_PowerOn();
-			SHT3X_PerformMeasurements();
-			I2C1_PowerOff();
-			I2C1_Disable();
-			SHT3X_GetTemperatureComp1(&tkfx_ctx.tkfx_temperature_degrees);
-			// Get voltages measurements.
-			ADC1_Init();
-			ADC1_PowerOn();
-			ADC1_PerformAllMeasurements();
-			ADC1_PowerOff();
-			ADC1_Disable();
-			ADC1_GetSourceVoltage(&tkfx_ctx.tkfx_source_voltage_mv);
-			ADC1_GetSupercapVoltage(&tkfx_ctx.tkfx_supercap_voltage_mv);
-			ADC1_GetMcuVoltage(&tkfx_ctx.tkfx_mcu_voltage_mv);
-			ADC1_GetMcuTemperatureComp1(&tkfx_ctx.tkfx_mcu_temperature_degrees);
-			// Compute next state.
-			tkfx_ctx.tkfx_state = TKFX_STATE_MONITORING;
-			break;
-		case TKFX_STATE_MONITORING:
-			IWDG_Reload();
-			// Build Sigfox frame.
-			tkfx_ctx.tkfx_sfx_monitoring_data.field.temperature_degrees = tkfx_ctx.tkfx_temperature_degrees;
-			tkfx_ctx.tkfx_sfx_monitoring_data.field.mcu_temperature_degrees = tkfx_ctx.tkfx_mcu_temperature_degrees;
-			tkfx_ctx.tkfx_sfx_monitoring_data.field.source_voltage_mv = tkfx_ctx.tkfx_source_voltage_mv;
-			tkfx_ctx.tkfx_sfx_monitoring_data.field.supercap_voltage_mv = tkfx_ctx.tkfx_supercap_voltage_mv;
-			tkfx_ctx.tkfx_sfx_monitoring_data.field.mcu_voltage_mv = tkfx_ctx.tkfx_mcu_voltage_mv;
-			tkfx_ctx.tkfx_sfx_monitoring_data.field.status_byte = tkfx_ctx.tkfx_status_byte;
-			// Send uplink monitoring frame.
-			sfx_error = SIGFOX_API_open(&tkfx_sigfox_rc);
-			if (sfx_error == SFX_ERR_NONE) {
-				sfx_error = SIGFOX_API_send_frame(tkfx_ctx.tkfx_sfx_monitoring_data.raw_frame, TKFX_SIGFOX_MONITORING_DATA_LENGTH_BYTES, tkfx_ctx.tkfx_sfx_downlink_data, 2, 0);
-			}
-			SIGFOX_API_close();
+			// Reset pipeline.
+			tkfx_ctx.tkfx_measured_flag = 0;
+			tkfx_ctx.tkfx_phases = 0;
+			tkfx_ctx.tkfx_geoloc_timeout = 0;
+			tkfx_ctx.tkfx_geoloc_fix_duration_seconds = 0;
+			// Run measurements, monitoring frame and GPS acquisition concurrently.
+			TASK_Run(tkfx_ctx.tkfx_tasks, ((tkfx_ctx.tkfx_geoloc_required != 0) ? TKFX_TASK_LAST : TKFX_TASK_GEOLOC), &TKFX_Idle);
 			// Compute next state.
-#ifdef SSM
-			if (((tkfx_ctx.tkfx_status_byte & (0b1 << TKFX_STATUS_BYTE_MOVING_FLAG_BIT_IDX)) == 0) && ((tkfx_ctx.tkfx_status_byte & (0b1 << TKFX_STATUS_BYTE_ALARM_FLAG_BIT_IDX)) != 0)) {
-				// Stop condition.
+			if (tkfx_ctx.tkfx_geoloc_required != 0) {
 				tkfx_ctx.tkfx_state = TKFX_STATE_GEOLOC;
 			}
 			else {
-				// Moving condition.
 				tkfx_ctx.tkfx_state = TKFX_STATE_OFF;
 			}
-#else
-			tkfx_ctx.tkfx_state = TKFX_STATE_GEOLOC;
-#endif
 			break;
 		case TKFX_STATE_GEOLOC:
-			IWDG_Reload();
-			// Check supercap voltage.
-			if (tkfx_ctx.tkfx_supercap_voltage_mv < TKFX_GEOLOC_SUPERCAP_VOLTAGE_MIN_MV) {
-				// Do not perform GPS fix.
-				tkfx_ctx.tkfx_geoloc_fix_duration_seconds = 0;
-				tkfx_ctx.tkfx_geoloc_timeout = 1;
-			}
-			else {
-				// Get position from GPS.
-				LPUART1_Init(tkfx_use_lse);
-				LPUART1_PowerOn();
-				neom8n_return_code = NEOM8N_GetPosition(&tkfx_ctx.tkfx_geoloc_position, TKFX_GEOLOC_TIMEOUT_SECONDS, TKFX_GEOLOC_SUPERCAP_VOLTAGE_MIN_MV, &tkfx_ctx.tkfx_geoloc_fix_duration_seconds);
-				LPUART1_PowerOff();
-				LPUART1_Disable();
-				// Parse result.
-				if (neom8n_return_code != NEOM8N_SUCCESS) {
-					tkfx_ctx.tkfx_geoloc_timeout = 1;
-				}
-			}
 			IWDG_Reload();
 			// Build Sigfox frame.
 			if (tkfx_ctx.tkfx_geoloc_timeout == 0) {
@@ -362,11 +519,14 @@ int main (void) {
 				tkfx_ctx.tkfx_sfx_geoloc_data.raw_frame[0] = tkfx_ctx.tkfx_geoloc_fix_duration_seconds;
 			}
 			// Send uplink geolocation frame.
-			sfx_error = SIGFOX_API_open(&tkfx_sigfox_rc);
+			sfx_error = SIGFOX_API_open(&tkfx_ctx.tkfx_sigfox_rc);
 			if (sfx_error == SFX_ERR_NONE) {
 				sfx_error = SIGFOX_API_send_frame(tkfx_ctx.tkfx_sfx_geoloc_data.raw_frame, (tkfx_ctx.tkfx_geoloc_timeout ? TKFX_SIGFOX_GEOLOC_TIMEOUT_DATA_LENGTH_BYTES : TKFX_SIGFOX_GEOLOC_DATA_LENGTH_BYTES), tkfx_ctx.tkfx_sfx_downlink_data, 2, 0);
 			}
 			SIGFOX_API_close();
+			if (sfx_error != SFX_ERR_NONE) {
+				tkfx_ctx.tkfx_sfx_failure_flag = 1;
+			}
 			// Reset geoloc variables.
 			tkfx_ctx.tkfx_geoloc_timeout = 0;
 			tkfx_ctx.tkfx_geoloc_fix_duration_seconds = 0;
@@ -377,8 +537,20 @@ int main (void) {
 			IWDG_Reload();
 			// Clear POR flag.
 			tkfx_ctx.tkfx_por_flag = 0;
+			// Queue a new attempt if an uplink failed.
+			if ((tkfx_ctx.tkfx_sfx_failure_flag != 0) && (tkfx_ctx.tkfx_sfx_retry_count < TKFX_SIGFOX_RETRY_COUNT_MAX)) {
+				SCHEDULER_SetDeadline(SCHEDULER_EVENT_RETRY, TKFX_SIGFOX_RETRY_DELAY_SECONDS);
+				tkfx_ctx.tkfx_sfx_retry_count++;
+			}
+			else {
+				SCHEDULER_CancelDeadline(SCHEDULER_EVENT_RETRY);
+				tkfx_ctx.tkfx_sfx_retry_count = 0;
+			}
+			tkfx_ctx.tkfx_sfx_failure_flag = 0;
 			// Turn peripherals off.
 			LPTIM1_Disable();
+			// Release system clock (wake-up events are processed at the lowest frequency).
+			RCC_SetClockRequest(RCC_CLOCK_CLIENT_APPLICATION, 0);
 			// Clear EXTI flags.
 			EXTI_ClearAllFlags();
 			RTC_ClearWakeUpTimerFlag();
@@ -387,42 +559,66 @@ int main (void) {
 			MMA8653FC_ClearMotionInterruptFlag();
 			NVIC_EnableInterrupt(NVIC_IT_EXTI_0_1);
 #endif
-			// Enable RTC interrupt.
-			RTC_StartWakeUpTimer(RTC_WAKEUP_PERIOD_SECONDS);
+			// Program RTC wake-up for the nearest deadline.
+			SCHEDULER_StartWakeUpTimer();
 			// Enter stop mode.
 			tkfx_ctx.tkfx_state = TKFX_STATE_SLEEP;
 			break;
 		case TKFX_STATE_SLEEP:
 			IWDG_Reload();
 			// Enter sleep mode.
+			ACCOUNTING_EnterState(ACCOUNTING_STATE_SLEEP);
 			PWR_EnterStopMode();
+			ACCOUNTING_ExitState(ACCOUNTING_STATE_SLEEP);
 			// Check wake-up source.
 			if (RTC_GetWakeUpTimerFlag() != 0) {
+				// Clear RTC flags.
+				RTC_ClearWakeUpTimerFlag();
+				// Process all expired deadlines (wake-up may also be a simple watchdog refresh).
+				scheduler_event = SCHEDULER_GetExpiredEvent();
+				while (scheduler_event != SCHEDULER_EVENT_LAST) {
+					switch (scheduler_event) {
 #ifdef SSM
-				// Increment timers.
-				tkfx_ctx.tkfx_keep_alive_timer_seconds += RTC_WAKEUP_PERIOD_SECONDS;
-				tkfx_ctx.tkfx_stop_timer_seconds += RTC_WAKEUP_PERIOD_SECONDS;
-				// Check keep-alive period.
-				if (tkfx_ctx.tkfx_keep_alive_timer_seconds >= TKFX_KEEP_ALIVE_PERIOD_SECONDS) {
+					case SCHEDULER_EVENT_KEEP_ALIVE:
 #endif
 #ifdef PM
-				// Increment timer.
-				tkfx_ctx.tkfx_geoloc_timer_seconds += RTC_WAKEUP_PERIOD_SECONDS;
-				// Check geolocation period.
-				if (tkfx_ctx.tkfx_geoloc_timer_seconds >= TKFX_GEOLOC_PERIOD_SECONDS) {
+					case SCHEDULER_EVENT_GEOLOC:
 #endif
-					// Reset alarm flag.
-					tkfx_ctx.tkfx_status_byte &= ~(0b1 << TKFX_STATUS_BYTE_ALARM_FLAG_BIT_IDX);
-					// Turn tracker on to send keep-alive.
-					tkfx_ctx.tkfx_state = TKFX_STATE_INIT;
+						// Reset alarm flag.
+						tkfx_ctx.tkfx_status_byte &= ~(0b1 << TKFX_STATUS_BYTE_ALARM_FLAG_BIT_IDX);
+						// Turn tracker on to send keep-alive.
+						tkfx_ctx.tkfx_state = TKFX_STATE_INIT;
+						break;
+#ifdef SSM
+					case SCHEDULER_EVENT_STOP_CONDITION:
+						// No movement detected since threshold.
+						if ((tkfx_ctx.tkfx_status_byte & (0b1 << TKFX_STATUS_BYTE_MOVING_FLAG_BIT_IDX)) != 0) {
+							// Stop condition detected.
+							tkfx_ctx.tkfx_status_byte &= ~(0b1 << TKFX_STATUS_BYTE_MOVING_FLAG_BIT_IDX);
+							tkfx_ctx.tkfx_status_byte |= (0b1 << TKFX_STATUS_BYTE_ALARM_FLAG_BIT_IDX);
+							// Turn tracker on to send stop alarm.
+							tkfx_ctx.tkfx_state = TKFX_STATE_INIT;
+						}
+						break;
+#endif
+					case SCHEDULER_EVENT_RETRY:
+						// Turn tracker on to send frames again.
+						tkfx_ctx.tkfx_state = TKFX_STATE_INIT;
+						break;
+					default:
+						break;
+					}
+					scheduler_event = SCHEDULER_GetExpiredEvent();
+				}
+				// Program next wake-up if tracker stays asleep.
+				if (tkfx_ctx.tkfx_state == TKFX_STATE_SLEEP) {
+					SCHEDULER_StartWakeUpTimer();
 				}
-				// Clear RTC flags.
-				RTC_ClearWakeUpTimerFlag();
 			}
 #ifdef SSM
 			if (MMA8653FC_GetMotionInterruptFlag() != 0) {
-				// Reset stop timer.
-				tkfx_ctx.tkfx_stop_timer_seconds = 0;
+				// Restart stop condition detection.
+				SCHEDULER_SetDeadline(SCHEDULER_EVENT_STOP_CONDITION, ENERGY_GetPeriod(TKFX_STOP_CONDITION_THRESHOLD_SECONDS, TKFX_STOP_CONDITION_THRESHOLD_MIN_SECONDS, TKFX_STOP_CONDITION_THRESHOLD_MAX_SECONDS));
 				// Wake-up from accelerometer interrupt.
 				if ((tkfx_ctx.tkfx_status_byte & (0b1 << TKFX_STATUS_BYTE_MOVING_FLAG_BIT_IDX)) == 0) {
 					// Start condition detected.
@@ -431,17 +627,11 @@ int main (void) {
 					// Turn tracker on to send start alarm.
 					tkfx_ctx.tkfx_state = TKFX_STATE_INIT;
 				}
-				MMA8653FC_ClearMotionInterruptFlag();
-			}
-			else {
-				// No movement detected.
-				if ((tkfx_ctx.tkfx_stop_timer_seconds >= TKFX_STOP_CONDITION_THRESHOLD_SECONDS) && ((tkfx_ctx.tkfx_status_byte & (0b1 << TKFX_STATUS_BYTE_MOVING_FLAG_BIT_IDX)) != 0)) {
-					// Stop condition detected.
-					tkfx_ctx.tkfx_status_byte &= ~(0b1 << TKFX_STATUS_BYTE_MOVING_FLAG_BIT_IDX);
-					tkfx_ctx.tkfx_status_byte |= (0b1 << TKFX_STATUS_BYTE_ALARM_FLAG_BIT_IDX);
-					// Turn tracker on to send stop alarm.
-					tkfx_ctx.tkfx_state = TKFX_STATE_INIT;
+				else if (tkfx_ctx.tkfx_state == TKFX_STATE_SLEEP) {
+					// Nearest deadline may have changed.
+					SCHEDULER_StartWakeUpTimer();
 				}
+				MMA8653FC_ClearMotionInterruptFlag();
 			}
 #endif
 			break;
@@ -457,6 +647,8 @@ int main (void) {
 
 #ifdef ATM
 /* MAIN FUNCTION FOR AT MODE.
+ * MCU is kept in stop mode between commands: idle current target is 200uA on supercap with GPS and radio off
+ * (HSI is kept on for USART2 wake-up), instead of about 2.5mA when polling on HSI. Sleep ratio is given by AT$PWR? command.
  * @param: 	None.
  * @return: 0.
  */
@@ -469,18 +661,23 @@ int main (void) {
 	// Init GPIOs.
 	GPIO_Init();
 	EXTI_Init();
+	// Init power module and load accounting counters from backup registers before they are cleared.
+	PWR_Init();
+	ACCOUNTING_Init();
 	// Reset RTC before starting oscillators.
 	RTC_Reset();
 	// Init clocks.
 	RCC_Init();
 	unsigned char tkfx_use_lse = RCC_EnableLse();
-	RCC_SwitchToHsi();
+	RCC_SetClockRequest(RCC_CLOCK_CLIENT_APPLICATION, RCC_HSI_FREQUENCY_KHZ);
 	// Get LSI effective frequency (must be called after HSI initialization and before RTC inititialization).
 	unsigned int tkfx_lsi_frequency_hz = 0;
 	RCC_GetLsiFrequency(&tkfx_lsi_frequency_hz);
 	IWDG_Reload();
 	// Init RTC and timers.
 	RTC_Init(&tkfx_use_lse, tkfx_lsi_frequency_hz);
+	RCC_StartClockLevelTime();
+	ACCOUNTING_Save();
 	LPTIM1_Init(tkfx_lsi_frequency_hz);
 	// Init peripherals.
 	ADC1_Init();
@@ -489,6 +686,7 @@ int main (void) {
 	// Components.
 	NEOM8N_Init();
 	SHT3X_Init();
+	SENSORS_Init();
 	MMA8653FC_Init();
 	// Configure accelerometer.
 	I2C1_Init();
@@ -498,10 +696,29 @@ int main (void) {
 	I2C1_Disable();
 	// Applicative layers.
 	AT_Init();
+#ifdef PROFILER
+	PROFILER_Init();
+#endif
 	// Main loop.
 	while (1) {
 		AT_Task();
 		IWDG_Reload();
+		// Mask interrupts so that a line end received after the check wakes-up the MCU instead of being handled before entering stop mode.
+		NVIC_DisableInterrupts();
+		if ((AT_IsIdle() != 0) && (USART2_IsTxComplete() == 0)) {
+			// DMA is still sending response: stay in sleep mode until transfer complete interrupt.
+			PWR_EnterSleepMode();
+		}
+		else if (AT_IsIdle() != 0) {
+			// Enter stop mode until next command byte, accelerometer period or watchdog refresh.
+			RTC_StartWakeUpTimer(IWDG_REFRESH_PERIOD_SECONDS);
+			ACCOUNTING_EnterState(ACCOUNTING_STATE_SLEEP);
+			PWR_EnterStopMode();
+			ACCOUNTING_ExitState(ACCOUNTING_STATE_SLEEP);
+			RTC_StopWakeUpTimer();
+			RTC_ClearWakeUpTimerFlag();
+		}
+		NVIC_EnableInterrupts();
 	}
 	return 0;
 }
@@ -12,7 +12,12 @@
 #include "gpio.h"
 #include "lptim.h"
 #include "mapping.h"
+#include "nvic.h"
+#include "profiler.h"
+#include "rcc.h"
 #include "rcc_reg.h"
+#include "rtc.h"
+#include "syscfg_reg.h"
 
 /*** ADC local macros ***/
 
@@ -31,10 +36,20 @@
 
 #define ADC_SOURCE_VOLTAGE_DIVIDER_RATIO	10
 
+#define ADC_REFERENCE_VALIDITY_SECONDS		600
+#define ADC_REFERENCE_TEMPERATURE_DRIFT_MAX	5 // In degrees.
+
 /*** ADC local structures ***/
 
 typedef struct {
+	// Calibration and reference cache.
+	unsigned char adc_calibration_done;
+	unsigned int adc_calibration_factor;
+	unsigned char adc_lm4040_valid;
+	unsigned int adc_lm4040_timestamp_seconds;
+	signed char adc_lm4040_temperature_degrees;
 	unsigned int adc_lm4040_voltage_12bits;
+	// Measurements.
 	unsigned int adc_source_voltage_mv;
 	unsigned int adc_supercap_voltage_mv;
 	unsigned int adc_mcu_voltage_mv;
@@ -45,9 +60,28 @@ typedef struct {
 /*** ADC local global variables ***/
 
 static ADC_Context adc_ctx;
+static volatile unsigned char adc_supercap_watchdog_flag = 0;
 
 /*** ADC local functions ***/
 
+/* ADC INTERRUPT HANDLER.
+ * @param:	None.
+ * @return:	None.
+ */
+void __attribute__((optimize("-O0"))) ADC1_COMP_IRQHandler(void) {
+	// Analog watchdog flag.
+	if (((ADC1 -> ISR) & (0b1 << 7)) != 0) {
+		// Set local flag.
+		if (((ADC1 -> IER) & (0b1 << 7)) != 0) {
+			adc_supercap_watchdog_flag = 1;
+			// Disable interrupt since voltage will remain out of window for next conversions.
+			ADC1 -> IER &= ~(0b1 << 7); // AWDIE='0'.
+		}
+		// Clear flag.
+		ADC1 -> ISR |= (0b1 << 7);
+	}
+}
+
 /* PERFORM A SINGLE ADC CONVERSION.
  * @param adc_channel:			Channel to convert.
  * @param adc_result_12bits:	Pointer to int that will contain ADC raw result on 12 bits.
@@ -84,6 +118,46 @@ static void ADC1_FilteredConversion(unsigned char adc_channel, unsigned int* adc
 	(*adc_result_12bits) = FILTER_ComputeMedianFilter(adc_sample_buf, ADC_MEDIAN_FILTER_LENGTH, ADC_CENTER_AVERGAE_LENGTH);
 }
 
+/* ENABLE ADC AND RESTORE CALIBRATION FACTOR.
+ * @param:					None.
+ * @return adc_ready:		'1' if ADC is ready to convert, '0' otherwise.
+ */
+static unsigned char ADC1_Enable(void) {
+	// Enable ADC peripheral.
+	ADC1 -> CR |= (0b1 << 0); // ADEN='1'.
+	unsigned int loop_count = 0;
+	while (((ADC1 -> ISR) & (0b1 << 0)) == 0) {
+		// Wait for ADC to be ready (ADRDY='1') or timeout.
+		loop_count++;
+		if (loop_count > ADC_TIMEOUT_COUNT) return 0;
+	}
+	// Restore factory calibration result (lost when peripheral clock is disabled).
+	if (adc_ctx.adc_calibration_done != 0) {
+		ADC1 -> CALFACT = adc_ctx.adc_calibration_factor;
+	}
+	return 1;
+}
+
+/* MEASURE LM4040 REFERENCE OR REUSE PREVIOUS RESULT IF STILL VALID.
+ * @param force_measurement:	Measure reference whatever the cache state if non zero.
+ * @return reference_measured:	'1' if the reference was actually measured, '0' if cached value was used.
+ */
+static unsigned char ADC1_UpdateReference(unsigned char force_measurement) {
+	// Local variables.
+	unsigned int timestamp_seconds = 0;
+	// Check cache validity.
+	RTC_GetTimestampSeconds(&timestamp_seconds);
+	if ((force_measurement == 0) && (adc_ctx.adc_lm4040_valid != 0) && ((timestamp_seconds - adc_ctx.adc_lm4040_timestamp_seconds) < ADC_REFERENCE_VALIDITY_SECONDS)) {
+		return 0;
+	}
+	// Perform measurement.
+	ADC1_FilteredConversion(ADC_CHANNEL_LM4040, &adc_ctx.adc_lm4040_voltage_12bits);
+	// Update cache (temperature is updated by the caller when measured in the same pass).
+	adc_ctx.adc_lm4040_valid = 1;
+	adc_ctx.adc_lm4040_timestamp_seconds = timestamp_seconds;
+	return 1;
+}
+
 /* COMPUTE SOURCE VOLTAGE.
  * @param:	None.
  * @return:	None.
@@ -124,9 +198,13 @@ static void ADC1_ComputeMcuVoltage(void) {
 static void ADC1_ComputeMcuTemperature(void) {
 	// Set sampling time (see p.88 of STM32L031x4/6 datasheet).
 	ADC1 -> SMPR |= (0b111 << 0); // Sampling time for temperature sensor must be greater than 10us, 160.5*(1/ADCCLK) = 20us for ADCCLK = SYSCLK/2 = 8MHz;
-	// Wake-up VREFINT and temperature sensor.
-	ADC1 -> CCR |= (0b11 << 22); // TSEN='1' and VREFEF='1'.
-	LPTIM1_DelayMilliseconds(10, 0); // Wait internal reference stabilization (max 3ms).
+	// Wait internal reference stabilization (VREFINT and temperature sensor were enabled before previous conversions).
+	unsigned int loop_count = 0;
+	while (((SYSCFG -> CFGR3) & (0b1 << 30)) == 0) {
+		// Wait for VREFINT_RDYF='1' or timeout.
+		loop_count++;
+		if (loop_count > ADC_TIMEOUT_COUNT) break;
+	}
 	// Read raw temperature.
 	int raw_temp_sensor_12bits = 0;
 	ADC1_FilteredConversion(ADC_CHANNEL_TEMPERATURE_SENSOR, &raw_temp_sensor_12bits);
@@ -135,8 +213,8 @@ static void ADC1_ComputeMcuTemperature(void) {
 	int temp_calib_degrees = raw_temp_calib_mv * ((int)(TS_CAL2_TEMP-TS_CAL1_TEMP));
 	temp_calib_degrees = (temp_calib_degrees) / ((int)(TS_CAL2 - TS_CAL1));
 	adc_ctx.adc_mcu_temperature_degrees_comp2 = temp_calib_degrees + TS_CAL1_TEMP;
-	// Switch temperature sensor off.
-	ADC1 -> CCR &= ~(0b1 << 23); // TSEN='0'.
+	// Switch temperature sensor and VREFINT off.
+	ADC1 -> CCR &= ~(0b11 << 22); // TSEN='0' and VREFEN='0'.
 	// Convert to 1-complement value.
 	adc_ctx.adc_mcu_temperature_degrees_comp1 = 0;
 	if (adc_ctx.adc_mcu_temperature_degrees_comp2 < 0) {
@@ -161,13 +239,12 @@ void ADC1_Init(void) {
 	GPIO_Configure(&GPIO_ADC1_IN6, GPIO_MODE_ANALOG, GPIO_TYPE_OPEN_DRAIN, GPIO_SPEED_LOW, GPIO_PULL_NONE);
 	GPIO_Configure(&GPIO_ADC1_IN7, GPIO_MODE_ANALOG, GPIO_TYPE_OPEN_DRAIN, GPIO_SPEED_LOW, GPIO_PULL_NONE);
 	GPIO_Configure(&GPIO_ADC1_IN8, GPIO_MODE_ANALOG, GPIO_TYPE_OPEN_DRAIN, GPIO_SPEED_LOW, GPIO_PULL_NONE);
-	// Init context.
-	adc_ctx.adc_lm4040_voltage_12bits = 0;
+	// Init context (calibration and reference cache are kept).
 	adc_ctx.adc_source_voltage_mv = 0;
 	adc_ctx.adc_supercap_voltage_mv = 0;
 	adc_ctx.adc_mcu_voltage_mv = 0;
-	adc_ctx.adc_mcu_temperature_degrees_comp2 = 0;
-	adc_ctx.adc_mcu_temperature_degrees_comp1 = 0;
+	// Synchronous ADCCLK is derived from SYSCLK: request HSI.
+	RCC_SetClockRequest(RCC_CLOCK_CLIENT_ADC1, RCC_HSI_FREQUENCY_KHZ);
 	// Enable peripheral clock.
 	RCC -> APB2ENR |= (0b1 << 9); // ADCEN='1'.
 	// Ensure ADC is disabled.
@@ -184,13 +261,20 @@ void ADC1_Init(void) {
 	ADC1 -> CFGR1 &= ~(0b11 << 0); // Data resolution = 12 bits (RES='00').
 	ADC1 -> CCR &= 0xFC03FFFF; // No prescaler.
 	ADC1 -> SMPR |= (0b111 << 0); // Maximum sampling time.
-	// ADC calibration.
-	ADC1 -> CR |= (0b1 << 31); // ADCAL='1'.
-	unsigned int loop_count = 0;
-	while ((((ADC1 -> CR) & (0b1 << 31)) != 0) && (((ADC1 -> ISR) & (0b1 << 11)) == 0)) {
-		// Wait until calibration is done or timeout.
-		loop_count++;
-		if (loop_count > ADC_TIMEOUT_COUNT) break;
+	// ADC calibration (performed only once, result is restored by ADC1_Enable() function).
+	if (adc_ctx.adc_calibration_done == 0) {
+		ADC1 -> CR |= (0b1 << 31); // ADCAL='1'.
+		unsigned int loop_count = 0;
+		while ((((ADC1 -> CR) & (0b1 << 31)) != 0) && (((ADC1 -> ISR) & (0b1 << 11)) == 0)) {
+			// Wait until calibration is done or timeout.
+			loop_count++;
+			if (loop_count > ADC_TIMEOUT_COUNT) break;
+		}
+		// Save calibration factor.
+		if (loop_count <= ADC_TIMEOUT_COUNT) {
+			adc_ctx.adc_calibration_factor = ((ADC1 -> CALFACT) & 0x7F);
+			adc_ctx.adc_calibration_done = 1;
+		}
 	}
 	// Clear all flags.
 	ADC1 -> ISR |= 0x0000089F;
@@ -209,6 +293,8 @@ void ADC1_Disable(void) {
 	ADC1 -> ISR |= 0x0000089F;
 	// Disable peripheral clock.
 	RCC -> APB2ENR &= ~(0b1 << 9); // ADCEN='0'.
+	// Release system clock.
+	RCC_SetClockRequest(RCC_CLOCK_CLIENT_ADC1, 0);
 }
 
 /* ENABLE EXTERNAL ANALOG BLOCKS SUPPLY.
@@ -235,26 +321,43 @@ void ADC1_PowerOff(void) {
  * @return:	None.
  */
 void ADC1_PerformAllMeasurements(void) {
+	// Local variables.
+	unsigned char reference_measured = 0;
+	signed char temperature_drift = 0;
 	// Enable ADC peripheral.
-	ADC1 -> CR |= (0b1 << 0); // ADEN='1'.
-	unsigned int loop_count = 0;
-	while (((ADC1 -> ISR) & (0b1 << 0)) == 0) {
-		// Wait for ADC to be ready (ADRDY='1') or timeout.
-		loop_count++;
-		if (loop_count > ADC_TIMEOUT_COUNT) return;
-	}
+	if (ADC1_Enable() == 0) return;
+	PROFILER_BEGIN(PROFILER_PROBE_ADC_MEASUREMENTS);
+	// Wake-up VREFINT and temperature sensor first, so that their stabilization time overlaps the other conversions.
+	ADC1 -> CCR |= (0b11 << 22); // TSEN='1' and VREFEN='1'.
 	// Perform measurements.
-	ADC1_FilteredConversion(ADC_CHANNEL_LM4040, &adc_ctx.adc_lm4040_voltage_12bits);
+	reference_measured = ADC1_UpdateReference(0);
 	ADC1_ComputeSourceVoltage();
 	ADC1_ComputeSupercapVoltage();
 	ADC1_ComputeMcuVoltage();
 	ADC1_ComputeMcuTemperature();
+	// Record temperature of the reference measurement.
+	if (reference_measured != 0) {
+		adc_ctx.adc_lm4040_temperature_degrees = adc_ctx.adc_mcu_temperature_degrees_comp2;
+	}
+	// Check temperature drift since cached reference measurement.
+	temperature_drift = (adc_ctx.adc_mcu_temperature_degrees_comp2 - adc_ctx.adc_lm4040_temperature_degrees);
+	if ((reference_measured == 0) && ((temperature_drift > ADC_REFERENCE_TEMPERATURE_DRIFT_MAX) || (temperature_drift < (-ADC_REFERENCE_TEMPERATURE_DRIFT_MAX)))) {
+		// Cached reference is obsolete: measure it and compute results again.
+		ADC1 -> CCR |= (0b11 << 22); // TSEN='1' and VREFEN='1'.
+		ADC1_UpdateReference(1);
+		ADC1_ComputeSourceVoltage();
+		ADC1_ComputeSupercapVoltage();
+		ADC1_ComputeMcuVoltage();
+		ADC1_ComputeMcuTemperature();
+		adc_ctx.adc_lm4040_temperature_degrees = adc_ctx.adc_mcu_temperature_degrees_comp2;
+	}
 	// Clear all flags.
 	ADC1 -> ISR |= 0x0000089F; // Clear all flags.
 	// Disable ADC peripheral.
 	if (((ADC1 -> CR) & (0b1 << 0)) != 0) {
 		ADC1 -> CR |= (0b1 << 1); // ADDIS='1'.
 	}
+	PROFILER_END(PROFILER_PROBE_ADC_MEASUREMENTS);
 }
 
 /* PERFORM SUPERCAP VOLTAGE MEASUREMENTS.
@@ -263,15 +366,9 @@ void ADC1_PerformAllMeasurements(void) {
  */
 void ADC1_PerformSupercapMeasurement(void) {
 	// Enable ADC peripheral.
-	ADC1 -> CR |= (0b1 << 0); // ADEN='1'.
-	unsigned int loop_count = 0;
-	while (((ADC1 -> ISR) & (0b1 << 0)) == 0) {
-		// Wait for ADC to be ready (ADRDY='1') or timeout.
-		loop_count++;
-		if (loop_count > ADC_TIMEOUT_COUNT) return;
-	}
-	// Perform measurements.
-	ADC1_FilteredConversion(ADC_CHANNEL_LM4040, &adc_ctx.adc_lm4040_voltage_12bits);
+	if (ADC1_Enable() == 0) return;
+	// Perform measurements (reference is reused if still valid).
+	ADC1_UpdateReference(0);
 	ADC1_ComputeSupercapVoltage();
 	// Clear all flags.
 	ADC1 -> ISR |= 0x0000089F; // Clear all flags.
@@ -281,6 +378,99 @@ void ADC1_PerformSupercapMeasurement(void) {
 	}
 }
 
+/* START SUPERCAP VOLTAGE MONITORING WITH ADC ANALOG WATCHDOG (ADC1_PowerOn() MUST BE CALLED BEFORE).
+ * @param supercap_voltage_min_mv:	Voltage under which the watchdog interrupt is triggered.
+ * @return:							None.
+ */
+void ADC1_StartSupercapWatchdog(unsigned int supercap_voltage_min_mv) {
+	// Local variables.
+	unsigned int supercap_voltage_min_12bits = 0;
+	// Reset flag.
+	adc_supercap_watchdog_flag = 0;
+	// Use HSI as asynchronous clock, so that conversions keep running when SYSCLK is switched to MSI.
+	if (RCC_SetHsiKernelRequest(1) == 0) return;
+	ADC1 -> CFGR2 &= ~(0b11 << 30); // ADCCLK = HSI (CKMODE='00').
+	ADC1 -> CCR &= ~(0b1111 << 18); // Reset bits 18-21.
+	ADC1 -> CCR |= (0b1001 << 18); // ADCCLK = HSI/64 = 250kHz (PRESC='1001').
+	ADC1 -> CCR |= (0b1 << 25); // Low frequency mode (LFMEN='1').
+	// Enable ADC peripheral.
+	if (ADC1_Enable() == 0) return;
+	// Convert threshold to raw value thanks to bandgap result (reused if still valid).
+	ADC1_UpdateReference(0);
+	supercap_voltage_min_12bits = (supercap_voltage_min_mv * adc_ctx.adc_lm4040_voltage_12bits) / (ADC_LM4040_VOLTAGE_MV);
+	if (supercap_voltage_min_12bits > ADC_FULL_SCALE_12BITS) {
+		supercap_voltage_min_12bits = ADC_FULL_SCALE_12BITS;
+	}
+	ADC1 -> TR = (ADC_FULL_SCALE_12BITS << 16) | (supercap_voltage_min_12bits << 0); // HT=full scale and LT=threshold.
+	// Configure analog watchdog on supercap channel.
+	ADC1 -> CFGR1 &= ~(0b11111 << 26); // Reset bits 26-30.
+	ADC1 -> CFGR1 |= (ADC_CHANNEL_SUPERCAP_VOLTAGE << 26); // AWDCH='00111'.
+	ADC1 -> CFGR1 |= (0b1 << 22) | (0b1 << 23); // AWDSGL='1' and AWDEN='1'.
+	ADC1 -> CFGR1 |= (0b1 << 13); // Continuous conversion mode (CONT='1').
+	ADC1 -> CHSELR &= 0xFFF80000; // Reset all bits.
+	ADC1 -> CHSELR |= (0b1 << ADC_CHANNEL_SUPERCAP_VOLTAGE);
+	// Enable interrupt.
+	ADC1 -> ISR |= (0b1 << 7); // Clear AWD flag.
+	ADC1 -> IER |= (0b1 << 7); // AWDIE='1'.
+	NVIC_EnableInterrupt(NVIC_IT_ADC_COMP);
+	// Start continuous conversions.
+	ADC1 -> CR |= (0b1 << 2); // ADSTART='1'.
+	// ADCCLK does not depend on SYSCLK anymore.
+	RCC_SetClockRequest(RCC_CLOCK_CLIENT_ADC1, 0);
+}
+
+/* STOP SUPERCAP VOLTAGE MONITORING.
+ * @param:	None.
+ * @return:	None.
+ */
+void ADC1_StopSupercapWatchdog(void) {
+	// Local variables.
+	unsigned int loop_count = 0;
+	// Synchronous ADCCLK will be used again.
+	RCC_SetClockRequest(RCC_CLOCK_CLIENT_ADC1, RCC_HSI_FREQUENCY_KHZ);
+	// Disable interrupt.
+	NVIC_DisableInterrupt(NVIC_IT_ADC_COMP);
+	ADC1 -> IER &= ~(0b1 << 7); // AWDIE='0'.
+	// Stop conversions.
+	if (((ADC1 -> CR) & (0b1 << 2)) != 0) {
+		ADC1 -> CR |= (0b1 << 4); // ADSTP='1'.
+		while (((ADC1 -> CR) & (0b1 << 2)) != 0) {
+			// Wait for ADSTART='0' or timeout.
+			loop_count++;
+			if (loop_count > ADC_TIMEOUT_COUNT) break;
+		}
+	}
+	// Restore single conversion mode without watchdog.
+	ADC1 -> CFGR1 &= ~((0b1 << 23) | (0b1 << 22) | (0b1 << 13)); // AWDEN='0', AWDSGL='0' and CONT='0'.
+	// Clear all flags.
+	ADC1 -> ISR |= 0x0000089F;
+	// Disable ADC peripheral.
+	if (((ADC1 -> CR) & (0b1 << 0)) != 0) {
+		ADC1 -> CR |= (0b1 << 1); // ADDIS='1'.
+		loop_count = 0;
+		while (((ADC1 -> CR) & (0b1 << 0)) != 0) {
+			// Wait for ADEN='0' or timeout.
+			loop_count++;
+			if (loop_count > ADC_TIMEOUT_COUNT) break;
+		}
+	}
+	// Reset flag.
+	adc_supercap_watchdog_flag = 0;
+	// Go back to synchronous clock.
+	ADC1 -> CCR &= ~((0b1 << 25) | (0b1111 << 18)); // LFMEN='0' and PRESC='0000'.
+	ADC1 -> CFGR2 &= ~(0b11 << 30); // Reset bits 30-31.
+	ADC1 -> CFGR2 |= (0b01 << 30); // Use (PCLK2/2) as ADCCLK = SYSCLK/2.
+	RCC_SetHsiKernelRequest(0);
+}
+
+/* GET SUPERCAP WATCHDOG STATUS.
+ * @param:								None.
+ * @return adc_supercap_watchdog_flag:	'1' if supercap voltage fell below the threshold since last start, '0' otherwise.
+ */
+unsigned char ADC1_GetSupercapWatchdogFlag(void) {
+	return adc_supercap_watchdog_flag;
+}
+
 /* GET SOURCE VOLTAGE.
  * @param source_voltage_mv:	Pointer to value that will contain source voltage in mV.
  * @return:						None.
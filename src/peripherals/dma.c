@@ -13,6 +13,8 @@
 #include "nvic.h"
 #include "rcc_reg.h"
 #include "spi_reg.h"
+#include "usart.h"
+#include "usart_reg.h"
 
 /*** DMA local global variables ***/
 
@@ -36,11 +38,22 @@ void __attribute__((optimize("-O0"))) DMA1_Channel2_3_IRQHandler(void) {
 	}
 }
 
-/* DMA1 CHANNEL 6 INTERRUPT HANDLER.
+/* DMA1 CHANNEL 4 AND 6 INTERRUPT HANDLER.
  * @param:	None.
  * @return:	None.
  */
 void __attribute__((optimize("-O0"))) DMA1_Channel4_5_6_7_IRQHandler(void) {
+	// Transfer complete interrupt (TCIF4='1').
+	if (((DMA1 -> ISR) & (0b1 << 13)) != 0) {
+		// Clear flag.
+		DMA1 -> IFCR |= (0b1 << 13); // CTCIF4='1'.
+#ifdef ATM
+		// Transmit next part of USART buffer.
+		if (((DMA1 -> CCR4) & (0b1 << 1)) != 0) {
+			USART2_DmaTransferComplete();
+		}
+#endif
+	}
 	// Transfer complete interrupt (TCIF6='1').
 	if (((DMA1 -> ISR) & (0b1 << 21)) != 0) {
 		// Switch DMA buffer without decoding.
@@ -128,6 +141,71 @@ unsigned char DMA1_GetChannel3Status(void) {
 	return dma1_channel3_tcif;
 }
 
+/* CONFIGURE DMA1 CHANNEL 4 FOR USART2 TX TRANSFER (AT INTERFACE).
+ * @param:	None.
+ * @return:	None.
+ */
+void DMA1_InitChannel4(void) {
+	// Enable peripheral clock.
+	RCC -> AHBENR |= (0b1 << 0); // DMAEN='1'.
+	// Disable DMA channel before configuration (EN='0').
+	// Memory and peripheral data size are 8 bits (MSIZE='00' and PSIZE='00').
+	// Disable memory to memory mode (MEM2MEM='0').
+	// Peripheral increment mode disabled (PINC='0').
+	// Circular mode disabled (CIRC='0').
+	DMA1 -> CCR4 &= ~(0b1 << 0); // EN='0'.
+	DMA1 -> CCR4 |= (0b01 << 12); // Medium priority (PL='01').
+	DMA1 -> CCR4 |= (0b1 << 7); // Memory increment mode enabled (MINC='1').
+	DMA1 -> CCR4 |= (0b1 << 1); // Enable transfer complete interrupt (TCIE='1').
+	DMA1 -> CCR4 |= (0b1 << 4); // Read from memory (DIR='1').
+	// Configure peripheral address.
+	DMA1 -> CPAR4 = (unsigned int) &(USART2 -> TDR); // Peripheral address = USART2 TX register.
+	// Configure channel 4 for USART2 TX (request number 4).
+	DMA1 -> CSELR &= ~(0b1111 << 12); // Reset bits 12-15.
+	DMA1 -> CSELR |= (0b0100 << 12); // DMA channel mapped on USART2_TX (C4S='0100').
+	// Clear all flags.
+	DMA1 -> IFCR |= 0x0000F000;
+	// Set interrupt priority.
+	NVIC_SetPriority(NVIC_IT_DMA1_CH_4_7, 1);
+}
+
+/* START DMA1 CHANNEL 4 TRANSFER.
+ * @param:	None.
+ * @return:	None.
+ */
+void DMA1_StartChannel4(void) {
+	// Peripheral may have been disabled by another driver while the channel was idle.
+	RCC -> AHBENR |= (0b1 << 0); // DMAEN='1'.
+	// Clear all flags.
+	DMA1 -> IFCR |= 0x0000F000;
+	NVIC_EnableInterrupt(NVIC_IT_DMA1_CH_4_7);
+	// Start transfer.
+	DMA1 -> CCR4 |= (0b1 << 0); // EN='1'.
+}
+
+/* STOP DMA1 CHANNEL 4 TRANSFER.
+ * @param:	None.
+ * @return:	None.
+ */
+void DMA1_StopChannel4(void) {
+	// Stop transfer (interrupt is shared with channel 6 and kept enabled).
+	DMA1 -> CCR4 &= ~(0b1 << 0); // EN='0'.
+}
+
+/* SET DMA1 CHANNEL 4 SOURCE BUFFER ADDRESS.
+ * @param source_buf_addr:	Address of source buffer (part of USART2 TX buffer).
+ * @param source_buf_size:	Number of bytes to transfer.
+ * @return:					None.
+ */
+void DMA1_SetChannel4SourceAddr(unsigned int source_buf_addr, unsigned short source_buf_size) {
+	// Set address.
+	DMA1 -> CMAR4 = source_buf_addr;
+	// Set buffer size.
+	DMA1 -> CNDTR4 = source_buf_size;
+	// Clear all flags.
+	DMA1 -> IFCR |= 0x0000F000;
+}
+
 /* CONFIGURE DMA1 CHANNEL 6 FOR LPUART RX TRANSFER (NMEA FRAMES FROM GPS MODULE).
  * @param:	None.
  * @return:	None.
@@ -175,7 +253,10 @@ void DMA1_StartChannel6(void) {
 void DMA1_StopChannel6(void) {
 	// Stop transfer.
 	DMA1 -> CCR6 &= ~(0b1 << 0); // EN='0'.
-	NVIC_DisableInterrupt(NVIC_IT_DMA1_CH_4_7);
+	// Keep shared interrupt if channel 4 is running.
+	if (((DMA1 -> CCR4) & (0b1 << 0)) == 0) {
+		NVIC_DisableInterrupt(NVIC_IT_DMA1_CH_4_7);
+	}
 }
 
 /* SET DMA1 CHANNEL 6 DESTINATION BUFFER ADDRESS.
@@ -199,6 +280,11 @@ void DMA1_SetChannel6DestAddr(unsigned int dest_buf_addr, unsigned short dest_bu
 void DMA1_Disable(void) {
 	// Disable interrupts.
 	NVIC_DisableInterrupt(NVIC_IT_DMA1_CH_2_3);
+	// Keep peripheral enabled if channel 4 is running (it is restarted by DMA1_StartChannel4() otherwise).
+	if (((DMA1 -> CCR4) & (0b1 << 0)) != 0) {
+		DMA1 -> IFCR |= 0x0FF00FFF;
+		return;
+	}
 	NVIC_DisableInterrupt(NVIC_IT_DMA1_CH_4_7);
 	// Clear all flags.
 	DMA1 -> IFCR |= 0x0FFFFFFF;
@@ -35,6 +35,7 @@ void __attribute__((optimize("-O0"))) EXTI0_1_IRQHandler(void) {
 			MMA8653FC_SetMotionInterruptFlag();
 		}
 #endif
+		// In AT mode, data ready interrupt only wakes-up the MCU (pin level is checked by AT task).
 		// Clear flag.
 		EXTI -> PR |= (0b1 << (GPIO_ACCELERO_IRQ.gpio_num)); // PIFx='1' (writing '1' clears the bit).
 	}
@@ -5,6 +5,7 @@
  *      Author: Ludo
  */
 
+#include "profiler.h"
 #include "scb_reg.h"
 
 /* NON MASKABLE INTERRUPT HANDLER.
@@ -41,6 +42,23 @@ void __attribute__((optimize("-O0"))) PendSV_Handler(void) {
 	// TBD.
 }
 
+#ifdef PROFILER
+/* SYSTEM TICK INTERRUPT HANDLER.
+ * Program counter stacked on exception entry (R0-R3, R12, LR, PC, xPSR on main stack) is given to the profiler,
+ * which returns from exception since LR still contains EXC_RETURN.
+ * @param:	None.
+ * @return:	None.
+ */
+void __attribute__((naked)) SysTick_Handler(void) {
+	__asm volatile (
+		"mrs r0, msp\n"
+		"ldr r0, [r0, #24]\n"
+		"ldr r1, =PROFILER_SampleProgramCounter\n"
+		"bx r1\n"
+		".ltorg\n"
+	);
+}
+#else
 /* SYSTEM TICK INTERRUPT HANDLER.
  * @param:	None.
  * @return:	None.
@@ -48,3 +66,4 @@ void __attribute__((optimize("-O0"))) PendSV_Handler(void) {
 void __attribute__((optimize("-O0"))) SysTick_Handler(void) {
 	// TBD.
 }
+#endif
@@ -11,26 +11,266 @@
 #include "lptim.h"
 #include "mapping.h"
 #include "i2c_reg.h"
+#include "nvic.h"
+#include "pwr.h"
 #include "rcc.h"
 #include "rcc_reg.h"
+#include "rtc.h"
 
 /*** I2C local macros ***/
 
 #define I2C_ACCESS_TIMEOUT_COUNT	1000000
+#define I2C_SCL_LOW_TIMEOUT_MS		25
+#define I2C_ANALOG_FILTER_DELAY_NS	50
+#define I2C_PRESCALER_MAX			16
+#define I2C_SCL_CYCLES_MAX			256
+#define I2C_TIMINGR_DELAY_MAX		15
+#define I2C_TIMEOUTA_MAX			0xFFF
+#define I2C_POWER_OFF_TIME_MIN_MS	100 // Minimum rail discharge time to ensure slaves reset.
+#define I2C_TIMESTAMP_MARGIN_MS		4 // RTC sub-seconds resolution.
+
+/*** I2C local structures ***/
+
+// I2C bus timings characteristics (see p.638 of RM0377 datasheet).
+typedef struct {
+	unsigned short i2c_scl_frequency_khz;
+	unsigned short i2c_t_low_min_ns;
+	unsigned short i2c_t_high_min_ns;
+	unsigned short i2c_t_su_dat_min_ns;
+	unsigned short i2c_t_fall_max_ns;
+	unsigned short i2c_clock_min_khz; // Minimum I2CCLK frequency required by clock manager.
+} I2C_Timings;
+
+typedef struct {
+	// Configuration.
+	I2C_Speed i2c_speed;
+	// Current transfer.
+	unsigned char* i2c_tx_buf;
+	unsigned char i2c_tx_buf_length;
+	unsigned char i2c_tx_idx;
+	unsigned char* i2c_rx_buf;
+	unsigned char i2c_rx_buf_length;
+	unsigned char i2c_rx_idx;
+	unsigned char i2c_stop_flag;
+	unsigned char i2c_slave_address;
+	unsigned char i2c_restart_pending;
+	volatile unsigned char i2c_transfer_done;
+	volatile unsigned char i2c_transfer_error;
+	// Slaves power supply.
+	unsigned char i2c_power_users;
+	unsigned char i2c_power_off_valid;
+	unsigned int i2c_power_on_timestamp_ms;
+	unsigned int i2c_power_off_timestamp_ms;
+} I2C_Context;
+
+/*** I2C local global variables ***/
+
+static const I2C_Timings i2c_timings[I2C_SPEED_LAST] = {
+	{100, 4700, 4000, 250, 300, 2000}, // Standard mode.
+	{400, 1300, 600, 100, 300, 8000} // Fast mode.
+};
+static I2C_Context i2c_ctx;
 
 /*** I2C local functions ***/
 
-/* CLEAR ALL I2C PERIPHERAL FLAGS
+/* I2C1 INTERRUPT HANDLER.
+ * @param:	None.
+ * @return:	None.
+ */
+void __attribute__((optimize("-O0"))) I2C1_IRQHandler(void) {
+	// Local variables.
+	unsigned int i2c_isr = (I2C1 -> ISR);
+	// Error flags (NACKF, BERR, ARLO or TIMEOUT).
+	if ((i2c_isr & ((0b1 << 4) | (0b1 << 8) | (0b1 << 9) | (0b1 << 12))) != 0) {
+		// Abort transfer.
+		I2C1 -> CR1 &= ~(0b1111111 << 1); // Disable all interrupts.
+		I2C1 -> ICR |= 0x00003F38;
+		i2c_ctx.i2c_restart_pending = 0;
+		i2c_ctx.i2c_transfer_error = 1;
+		i2c_ctx.i2c_transfer_done = 1;
+		return;
+	}
+	// Transmit buffer empty.
+	if (((i2c_isr & (0b1 << 1)) != 0) && (i2c_ctx.i2c_tx_idx < i2c_ctx.i2c_tx_buf_length)) {
+		I2C1 -> TXDR = i2c_ctx.i2c_tx_buf[i2c_ctx.i2c_tx_idx];
+		i2c_ctx.i2c_tx_idx++;
+	}
+	// Receive buffer not empty.
+	if (((i2c_isr & (0b1 << 2)) != 0) && (i2c_ctx.i2c_rx_idx < i2c_ctx.i2c_rx_buf_length)) {
+		i2c_ctx.i2c_rx_buf[i2c_ctx.i2c_rx_idx] = (I2C1 -> RXDR);
+		i2c_ctx.i2c_rx_idx++;
+	}
+	// Transfer complete (only when AUTOEND='0', i.e. at the end of a write phase).
+	if ((i2c_isr & (0b1 << 6)) != 0) {
+		if (i2c_ctx.i2c_rx_buf_length > 0) {
+			// Switch to read phase with repeated start condition.
+			I2C1 -> CR2 &= 0xFF00FFFF; // Reset bits 16-23.
+			I2C1 -> CR2 |= (i2c_ctx.i2c_rx_buf_length << 16); // NBYTES = rx_buf_length.
+			I2C1 -> CR2 |= (0b1 << 10) | (0b1 << 25); // Read request (RD_WRN='1') and automatic NACK+STOP (AUTOEND='1').
+			I2C1 -> CR2 |= (0b1 << 13); // START='1'.
+		}
+		else if (i2c_ctx.i2c_stop_flag != 0) {
+			// Generate stop condition.
+			I2C1 -> CR2 |= (0b1 << 14); // STOP='1'.
+		}
+		else {
+			// Keep bus owned for next transfer (repeated start).
+			I2C1 -> CR1 &= ~(0b1111111 << 1); // Disable all interrupts.
+			i2c_ctx.i2c_restart_pending = 1;
+			i2c_ctx.i2c_transfer_done = 1;
+		}
+	}
+	// Stop condition detected.
+	if ((i2c_isr & (0b1 << 5)) != 0) {
+		I2C1 -> ICR |= (0b1 << 5); // STOPCF='1'.
+		I2C1 -> CR1 &= ~(0b1111111 << 1); // Disable all interrupts.
+		i2c_ctx.i2c_restart_pending = 0;
+		i2c_ctx.i2c_transfer_done = 1;
+	}
+}
+
+/* CLEAR ALL I2C PERIPHERAL FLAGS AND RESET INTERNAL STATE MACHINE.
  * @param:	None.
  * @return:	None.
  */
-static void I2C_Clear(void) {
-	// Disable peripheral.
+static void I2C1_Clear(void) {
+	// Disable peripheral (PE must be kept low during at least 3 APB clock cycles).
 	I2C1 -> CR1 &= ~(0b1 << 0); // PE='0'.
-	LPTIM1_DelayMilliseconds(1, 0);
+	unsigned char idx = 0;
+	for (idx=0 ; idx<3 ; idx++) {
+		if (((I2C1 -> CR1) & (0b1 << 0)) != 0) break;
+	}
 	// Enable peripheral and clear all flags.
 	I2C1 -> CR1 |= (0b1 << 0); // PE='1'.
 	I2C1 -> ICR |= 0x00003F38;
+	i2c_ctx.i2c_restart_pending = 0;
+}
+
+/* COMPUTE TIMINGR REGISTER VALUE FOR A GIVEN BUS SPEED.
+ * @param i2c_clock_khz:	I2C kernel clock frequency in kHz.
+ * @param speed:			Bus speed (see I2C_Speed enumeration in i2c.h).
+ * @param timingr:			Pointer that will contain the TIMINGR register value.
+ * @return:					None.
+ */
+static void I2C1_ComputeTimings(unsigned int i2c_clock_khz, I2C_Speed speed, unsigned int* timingr) {
+	// Local variables.
+	const I2C_Timings* timings = &(i2c_timings[speed]);
+	unsigned int presc = 0;
+	unsigned int presc_clock_khz = 0;
+	unsigned int scl_period_cycles = 0;
+	unsigned int scll = 0;
+	unsigned int sclh = 0;
+	unsigned int scldel = 0;
+	unsigned int sdadel = 0;
+	// Search the lowest prescaler allowing the requested SCL period.
+	for (presc=0 ; presc<I2C_PRESCALER_MAX ; presc++) {
+		presc_clock_khz = (i2c_clock_khz / (presc + 1));
+		scl_period_cycles = (presc_clock_khz / (timings -> i2c_scl_frequency_khz));
+		if (scl_period_cycles <= (2 * I2C_SCL_CYCLES_MAX)) break;
+	}
+	if (presc >= I2C_PRESCALER_MAX) {
+		presc = (I2C_PRESCALER_MAX - 1);
+	}
+	// Minimum low and high durations (rounded up).
+	scll = (((timings -> i2c_t_low_min_ns) * presc_clock_khz) + 999999) / 1000000;
+	sclh = (((timings -> i2c_t_high_min_ns) * presc_clock_khz) + 999999) / 1000000;
+	if (scll == 0) scll = 1;
+	if (sclh == 0) sclh = 1;
+	// Share remaining cycles to reach SCL frequency (bus will be slower than requested if clock is too low).
+	if (scl_period_cycles > (scll + sclh)) {
+		scll += (scl_period_cycles - scll - sclh) / 2;
+		sclh = (scl_period_cycles - scll);
+	}
+	if (scll > I2C_SCL_CYCLES_MAX) scll = I2C_SCL_CYCLES_MAX;
+	if (sclh > I2C_SCL_CYCLES_MAX) sclh = I2C_SCL_CYCLES_MAX;
+	// Data setup and hold delays.
+	scldel = ((((timings -> i2c_t_fall_max_ns) + (timings -> i2c_t_su_dat_min_ns)) * presc_clock_khz) + 999999) / 1000000;
+	if (scldel > 0) scldel--;
+	sdadel = ((((timings -> i2c_t_fall_max_ns) - I2C_ANALOG_FILTER_DELAY_NS) * presc_clock_khz) + 999999) / 1000000;
+	if (scldel > I2C_TIMINGR_DELAY_MAX) scldel = I2C_TIMINGR_DELAY_MAX;
+	if (sdadel > I2C_TIMINGR_DELAY_MAX) sdadel = I2C_TIMINGR_DELAY_MAX;
+	// Build register value.
+	(*timingr) = (presc << 28) | (scldel << 20) | (sdadel << 16) | ((sclh - 1) << 8) | ((scll - 1) << 0);
+}
+
+/* PERFORM AN INTERRUPT DRIVEN TRANSFER (CPU IS IN SLEEP MODE UNTIL COMPLETION).
+ * @param slave_address:	Slave address on 7 bits.
+ * @param tx_buf:			Array containing the byte(s) to send.
+ * @param tx_buf_length:	Number of bytes to send (0 for read only transfer).
+ * @param rx_buf:			Array that will contain the byte(s) to receive.
+ * @param rx_buf_length:	Number of bytes to receive (0 for write only transfer).
+ * @param stop_flag:		Generate stop condition at the end of a write only transfer if non zero.
+ * @return:					1 in case of success, 0 in case of failure.
+ */
+static unsigned char I2C1_Transfer(unsigned char slave_address, unsigned char* tx_buf, unsigned char tx_buf_length, unsigned char* rx_buf, unsigned char rx_buf_length, unsigned char stop_flag) {
+	// Wait for I2C bus to be ready (unless it is still owned after a write without stop condition).
+	unsigned int loop_count = 0;
+	if (i2c_ctx.i2c_restart_pending == 0) {
+		while (((I2C1 -> ISR) & (0b1 << 15)) != 0) {
+			// Wait for BUSY='0' or timeout.
+			loop_count++;
+			if (loop_count > I2C_ACCESS_TIMEOUT_COUNT) {
+				I2C1_Clear();
+				return 0;
+			}
+		}
+	}
+	// Init context.
+	i2c_ctx.i2c_slave_address = slave_address;
+	i2c_ctx.i2c_tx_buf = tx_buf;
+	i2c_ctx.i2c_tx_buf_length = tx_buf_length;
+	i2c_ctx.i2c_tx_idx = 0;
+	i2c_ctx.i2c_rx_buf = rx_buf;
+	i2c_ctx.i2c_rx_buf_length = rx_buf_length;
+	i2c_ctx.i2c_rx_idx = 0;
+	i2c_ctx.i2c_stop_flag = stop_flag;
+	i2c_ctx.i2c_transfer_done = 0;
+	i2c_ctx.i2c_transfer_error = 0;
+	// Clear flags.
+	I2C1 -> ICR |= 0x00003F38;
+	// Configure first phase.
+	I2C1 -> CR2 &= 0xFC0003FF; // Reset bits 10-25.
+	I2C1 -> CR2 &= 0xFFFFFC00; // Reset bits 0-9.
+	I2C1 -> CR2 |= ((slave_address & 0x7F) << 1); // SADD = slave_address. Warning: the 7-bits address starts from bit 1!
+	if (tx_buf_length > 0) {
+		I2C1 -> CR2 |= (tx_buf_length << 16); // NBYTES = tx_buf_length and write request (RD_WRN='0').
+		if ((rx_buf_length == 0) && (stop_flag != 0)) {
+			I2C1 -> CR2 |= (0b1 << 25); // Automatic stop condition (AUTOEND='1').
+		}
+	}
+	else {
+		I2C1 -> CR2 |= (rx_buf_length << 16); // NBYTES = rx_buf_length.
+		I2C1 -> CR2 |= (0b1 << 10) | (0b1 << 25); // Read request (RD_WRN='1') and automatic NACK+STOP (AUTOEND='1').
+	}
+	// Enable interrupts (TXIE, RXIE, NACKIE, STOPIE, TCIE and ERRIE).
+	I2C1 -> CR1 |= (0b1 << 1) | (0b1 << 2) | (0b1 << 4) | (0b1 << 5) | (0b1 << 6) | (0b1 << 7);
+	// Generate (repeated) start condition.
+	i2c_ctx.i2c_restart_pending = 0;
+	I2C1 -> CR2 |= (0b1 << 13); // START='1'.
+	// Sleep until transfer completion (SCL low timeout ensures an interrupt will always occur).
+	// Interrupts are masked during the check so that a completion occurring just before sleeping still wakes-up the MCU.
+	NVIC_DisableInterrupts();
+	while (i2c_ctx.i2c_transfer_done == 0) {
+		PWR_EnterSleepMode();
+		// Execute pending interrupt.
+		NVIC_EnableInterrupts();
+		NVIC_DisableInterrupts();
+	}
+	NVIC_EnableInterrupts();
+	// Reset peripheral in case of error.
+	if (i2c_ctx.i2c_transfer_error != 0) {
+		I2C1_Clear();
+		return 0;
+	}
+	return 1;
+}
+
+/* UPDATE BUS TIMINGS AFTER A SYSTEM CLOCK CHANGE (CALLED BY CLOCK MANAGER).
+ * @param:	None.
+ * @return:	None.
+ */
+static void I2C1_UpdateTimings(void) {
+	I2C1_SetSpeed(i2c_ctx.i2c_speed);
 }
 
 /*** I2C functions ***/
@@ -40,6 +280,13 @@ static void I2C_Clear(void) {
  * @return:	None.
  */
 void I2C1_Init(void) {
+	// Nothing to do if the bus is already used by another session (shared power-on window).
+	if (i2c_ctx.i2c_power_users > 0) return;
+	// Init context.
+	i2c_ctx.i2c_speed = I2C_SPEED_STANDARD_100KHZ;
+	i2c_ctx.i2c_restart_pending = 0;
+	i2c_ctx.i2c_transfer_done = 0;
+	i2c_ctx.i2c_transfer_error = 0;
 	// Enable peripheral clock.
 	RCC -> APB1ENR |= (0b1 << 21); // I2C1EN='1'.
 	// Configure power enable pin.
@@ -51,14 +298,44 @@ void I2C1_Init(void) {
 	// Configure peripheral.
 	I2C1 -> CR1 &= ~(0b1 << 0); // Disable peripheral before configuration (PE='0').
 	I2C1 -> CR1 &= ~(0b11111 << 8); // Analog filter enabled (ANFOFF='0') and digital filter disabled (DNF='0000').
-	I2C1 -> TIMINGR = 0; // Reset all bits.
-	I2C1 -> TIMINGR |= (7 << 28); // I2CCLK = PCLK1/(PRESC+1) = SYSCLK/(PRESC+1) = 2MHz (HSI) (PRESC='1000').
-	I2C1 -> TIMINGR |= (99 << 8) + 99; // Set SCL frequency to 10kHz. See p.641 of RM0377 datasheet.
 	I2C1 -> CR1 &= ~(0b1 << 17); // Must be kept cleared in master mode (NOSTRETCH='0').
 	I2C1 -> CR2 &= ~(0b1 << 11); // 7-bits addressing mode (ADD10='0').
 	I2C1 -> CR2 &= ~(0b11 << 24); // AUTOEND='0' and RELOAD='0'.
+	// Configure bus timings according to current system clock.
+	RCC_SetClockCallback(RCC_CLOCK_CLIENT_I2C1, &I2C1_UpdateTimings);
+	I2C1_SetSpeed(i2c_ctx.i2c_speed);
+	// Enable interrupt.
+	NVIC_EnableInterrupt(NVIC_IT_I2C1);
+}
+
+/* SET I2C1 BUS SPEED (TIMINGS ARE COMPUTED FROM THE CURRENT SYSTEM CLOCK, FUNCTION MUST BE CALLED AGAIN AFTER ANY CLOCK SWITCH).
+ * @param speed:	Bus speed (see I2C_Speed enumeration in i2c.h).
+ * @return:			None.
+ */
+void I2C1_SetSpeed(I2C_Speed speed) {
+	// Local variables.
+	unsigned int i2c_clock_khz = 0;
+	unsigned int timingr = 0;
+	unsigned int timeouta = 0;
+	// Check parameter.
+	if (speed >= I2C_SPEED_LAST) return;
+	i2c_ctx.i2c_speed = speed;
+	// Request minimum system clock frequency.
+	RCC_SetClockRequest(RCC_CLOCK_CLIENT_I2C1, i2c_timings[speed].i2c_clock_min_khz);
+	i2c_clock_khz = RCC_GetSysclkKhz(); // I2CCLK = PCLK1 = SYSCLK (see RCC_Init() function).
+	// Disable peripheral before configuration.
+	I2C1 -> CR1 &= ~(0b1 << 0); // PE='0'.
+	// Bus timings.
+	I2C1_ComputeTimings(i2c_clock_khz, speed, &timingr);
+	I2C1 -> TIMINGR = timingr;
+	// SCL low timeout: (TIMEOUTA+1) * 2048 * tI2CCLK.
+	timeouta = ((I2C_SCL_LOW_TIMEOUT_MS * i2c_clock_khz) / 2048);
+	if (timeouta > 0) timeouta--;
+	if (timeouta > I2C_TIMEOUTA_MAX) timeouta = I2C_TIMEOUTA_MAX;
+	I2C1 -> TIMEOUTR = (0b1 << 15) | (timeouta << 0); // TIMOUTEN='1', TIDLE='0' and TIMEOUTA=timeouta.
 	// Enable peripheral.
 	I2C1 -> CR1 |= (0b1 << 0); // PE='1'.
+	i2c_ctx.i2c_restart_pending = 0;
 }
 
 /* DISABLE I2C PERIPHERAL.
@@ -66,41 +343,86 @@ void I2C1_Init(void) {
  * @return:	None.
  */
 void I2C1_Disable(void) {
+	// Keep peripheral enabled if the bus is still used by another session.
+	if (i2c_ctx.i2c_power_users > 0) return;
+	// Disable interrupt.
+	NVIC_DisableInterrupt(NVIC_IT_I2C1);
 	// Disable power control pin.
 	GPIO_Configure(&GPIO_SENSORS_POWER_ENABLE, GPIO_MODE_ANALOG, GPIO_TYPE_OPEN_DRAIN, GPIO_SPEED_LOW, GPIO_PULL_NONE);
 	// Disable I2C1 peripheral.
 	I2C1 -> CR1 &= ~(0b1 << 0);
+	// Release system clock.
+	RCC_SetClockCallback(RCC_CLOCK_CLIENT_I2C1, 0);
+	RCC_SetClockRequest(RCC_CLOCK_CLIENT_I2C1, 0);
 	// Clear all flags.
 	I2C1 -> ICR |= 0x00003F38;
 	// Disable peripheral clock.
 	RCC -> APB1ENR &= ~(0b1 << 21); // I2C1EN='0'.
 }
 
-/* SWITCH ALL I2C1 SLAVES ON.
+/* SWITCH ALL I2C1 SLAVES ON (POWER-ON WINDOW IS SHARED BY ALL SESSIONS UNTIL THE LAST I2C1_PowerOff() CALL).
  * @param:	None.
  * @return:	None.
  */
 void I2C1_PowerOn(void) {
+	// Local variables.
+	unsigned int timestamp_ms = 0;
+	unsigned int power_off_duration_ms = 0;
+	// Check if rail is already on.
+	i2c_ctx.i2c_power_users++;
+	if (i2c_ctx.i2c_power_users > 1) return;
+	// Ensure slaves were switched off long enough to be properly reset.
+	if (i2c_ctx.i2c_power_off_valid != 0) {
+		RTC_GetTimestampMilliseconds(&timestamp_ms);
+		power_off_duration_ms = (timestamp_ms - i2c_ctx.i2c_power_off_timestamp_ms);
+		if (power_off_duration_ms < I2C_POWER_OFF_TIME_MIN_MS) {
+			LPTIM1_DelayMilliseconds((I2C_POWER_OFF_TIME_MIN_MS - power_off_duration_ms), 1);
+		}
+	}
 	// Enable GPIOs.
 	GPIO_Configure(&GPIO_I2C1_SCL, GPIO_MODE_ALTERNATE_FUNCTION, GPIO_TYPE_OPEN_DRAIN, GPIO_SPEED_LOW, GPIO_PULL_NONE);
 	GPIO_Configure(&GPIO_I2C1_SDA, GPIO_MODE_ALTERNATE_FUNCTION, GPIO_TYPE_OPEN_DRAIN, GPIO_SPEED_LOW, GPIO_PULL_NONE);
 	// Turn SHT3x and pull-up resistors on.
 	GPIO_Write(&GPIO_SENSORS_POWER_ENABLE, 1);
-	LPTIM1_DelayMilliseconds(100, 1);
+	RTC_GetTimestampMilliseconds(&i2c_ctx.i2c_power_on_timestamp_ms);
 }
 
-/* SWITCH ALL I2C1 SLAVES ON.
+/* SWITCH ALL I2C1 SLAVES OFF.
  * @param:	None.
  * @return:	None.
  */
 void I2C1_PowerOff(void) {
+	// Check if rail is still used.
+	if (i2c_ctx.i2c_power_users > 0) {
+		i2c_ctx.i2c_power_users--;
+	}
+	if (i2c_ctx.i2c_power_users > 0) return;
 	// Turn SHT3x and pull-up resistors off.
 	GPIO_Write(&GPIO_SENSORS_POWER_ENABLE, 0);
 	// Disable I2C alternate function.
 	GPIO_Configure(&GPIO_I2C1_SCL, GPIO_MODE_ANALOG, GPIO_TYPE_OPEN_DRAIN, GPIO_SPEED_LOW, GPIO_PULL_NONE);
 	GPIO_Configure(&GPIO_I2C1_SDA, GPIO_MODE_ANALOG, GPIO_TYPE_OPEN_DRAIN, GPIO_SPEED_LOW, GPIO_PULL_NONE);
-	// Delay required if another cycle is requested by applicative layer.
-	LPTIM1_DelayMilliseconds(100, 1);
+	// Save timestamp (delay is only applied if another cycle is requested too early).
+	RTC_GetTimestampMilliseconds(&i2c_ctx.i2c_power_off_timestamp_ms);
+	i2c_ctx.i2c_power_off_valid = 1;
+}
+
+/* WAIT UNTIL A SLAVE IS READY AFTER POWER-ON (MCU IS IN STOP MODE DURING THE REMAINING TIME).
+ * @param startup_time_ms:	Slave startup time in ms (from datasheet).
+ * @return:					None.
+ */
+void I2C1_WaitSlaveReady(unsigned int startup_time_ms) {
+	// Local variables.
+	unsigned int timestamp_ms = 0;
+	unsigned int power_on_duration_ms = 0;
+	// Check rail state.
+	if (i2c_ctx.i2c_power_users == 0) return;
+	// Compute remaining time.
+	RTC_GetTimestampMilliseconds(&timestamp_ms);
+	power_on_duration_ms = (timestamp_ms - i2c_ctx.i2c_power_on_timestamp_ms);
+	if (power_on_duration_ms < (startup_time_ms + I2C_TIMESTAMP_MARGIN_MS)) {
+		LPTIM1_DelayMilliseconds((startup_time_ms + I2C_TIMESTAMP_MARGIN_MS - power_on_duration_ms), 1);
+	}
 }
 
 /* WRITE DATA ON I2C1 BUS (see algorithme on p.607 of RM0377 datasheet).
@@ -111,64 +433,7 @@ void I2C1_PowerOff(void) {
  * @return:					1 in case of success, 0 in case of failure.
  */
 unsigned char I2C1_Write(unsigned char slave_address, unsigned char* tx_buf, unsigned char tx_buf_length, unsigned char stop_flag) {
-	// Clear peripheral.
-	I2C_Clear();
-	// Wait for I2C bus to be ready.
-	unsigned int loop_count = 0;
-	while (((I2C1 -> ISR) & (0b1 << 15)) != 0) {
-		// Wait for BUSY='0' or timeout.
-		loop_count++;
-		if (loop_count > I2C_ACCESS_TIMEOUT_COUNT) return 0;
-	}
-	// Configure number of bytes to send.
-	I2C1 -> CR2 &= 0xFF00FFFF; // Reset bits 16-23.
-	I2C1 -> CR2 |= (tx_buf_length << 16); // NBYTES = tx_buf_length.
-	// Send 7-bits slave address with write request.
-	I2C1 -> CR2 &= ~(0b1 << 10); // Write request (RD_WRN='0').
-	I2C1 -> CR2 &= 0xFFFFFC00; // Reset bits 0-9.
-	I2C1 -> CR2 |= ((slave_address & 0x7F) << 1); // SADD = slave_address. Warning: the 7-bits address starts from bit 1!
-	// Generate start condition.
-	I2C1 -> CR2 |= (0b1 << 13); // START='1'.
-	loop_count = 0;
-	while (((I2C1 -> CR2) & (0b1 << 13)) != 0) {
-		// Wait for START bit to be cleared by hardware or timeout.
-		loop_count++;
-		if (loop_count > I2C_ACCESS_TIMEOUT_COUNT) return 0;
-	}
-	// Send bytes.
-	unsigned char byte_idx = 0;
-	loop_count = 0;
-	while ((byte_idx < tx_buf_length) && (((I2C1 -> ISR) & (0b1 << 4)) == 0)) {
-		// Wait for transmit buffer to be empty (TXIS='1').
-		if (((I2C1 -> ISR) & (0b1 << 1)) != 0) {
-			// Send next byte.
-			I2C1 -> TXDR = tx_buf[byte_idx];
-			byte_idx++;
-		}
-		// Exit if timeout.
-		loop_count++;
-		if (loop_count > I2C_ACCESS_TIMEOUT_COUNT) return 0;
-	}
-	// Wait for last byte to be sent.
-	loop_count = 0;
-	while (((I2C1 -> ISR) & (0b1 << 6)) == 0) {
-		// Wait for TC='1' or timeout.
-		loop_count++;
-		if (loop_count > I2C_ACCESS_TIMEOUT_COUNT) return 0;
-	}
-	if (stop_flag != 0) {
-		// Generate stop condition.
-		I2C1 -> CR2 |= (0b1 << 14);
-		loop_count = 0;
-		while (((I2C1 -> ISR) & (0b1 << 5)) == 0) {
-			// Wait for STOPF='1' or timeout.
-			loop_count++;
-			if (loop_count > I2C_ACCESS_TIMEOUT_COUNT) return 0;
-		}
-		// Clear flag.
-		I2C1 -> ICR |= (0b1 << 5); // STOPCF='1'.
-	}
-	return 1;
+	return I2C1_Transfer(slave_address, tx_buf, tx_buf_length, 0, 0, stop_flag);
 }
 
 /* READ BYTES FROM I2C1 BUS (see algorithme on p.611 of RM0377 datasheet).
@@ -178,55 +443,17 @@ unsigned char I2C1_Write(unsigned char slave_address, unsigned char* tx_buf, uns
  * @return:					1 in case of success, 0 in case of failure.
  */
 unsigned char I2C1_Read(unsigned char slave_address, unsigned char* rx_buf, unsigned char rx_buf_length) {
-	// Clear peripheral.
-	I2C_Clear();
-	// Wait for I2C bus to be ready/
-	unsigned int loop_count = 0;
-	while (((I2C1 -> ISR) & (0b1 << 15)) != 0) {
-		// Wait for BUSY='0' or timeout.
-		loop_count++;
-		if (loop_count > I2C_ACCESS_TIMEOUT_COUNT) return 0;
-	}
-	// Configure number of bytes to send.
-	I2C1 -> CR2 &= 0xFF00FFFF; // Reset bits 16-23.
-	I2C1 -> CR2 |= (rx_buf_length << 16); // NBYTES = rx_buf_length.
-	// Send 7-bits slave address with write request.
-	I2C1 -> CR2 |= (0b1 << 10); // Read request (RD_WRN='1').
-	I2C1 -> CR2 |= (0b1 << 12); // 7-bits mode.
-	I2C1 -> CR2 &= 0xFFFFFC00; // Reset bits 0-9.
-	I2C1 -> CR2 |= ((slave_address & 0x7F) << 1); // SADD = slave_address. Warning: the 7-bits address starts from bit 1!
-	// Generate start condition.
-	I2C1 -> CR2 |= (0b1 << 13); // START='1'.
-	loop_count = 0;
-	while (((I2C1 -> CR2) & (0b1 << 13)) != 0) {
-		// Wait for START bit to be cleared by hardware or timeout.
-		loop_count++;
-		if (loop_count > I2C_ACCESS_TIMEOUT_COUNT) return 0;
-	}
-	// Get bytes.
-	unsigned char byte_idx = 0;
-	loop_count = 0;
-	while (byte_idx < rx_buf_length) {
-		// Wait for incoming data (RXNE='1').
-		if (((I2C1 -> ISR) & (0b1 << 2)) != 0) {
-			// Fill RX buffer with new byte */
-			rx_buf[byte_idx] = I2C1 -> RXDR;
-			byte_idx++;
-		}
-		// Exit if timeout.
-		loop_count++;
-		if (loop_count > I2C_ACCESS_TIMEOUT_COUNT) return 0;
-	}
-	// Send a NACK and STOP condition after last byte.
-	I2C1 -> CR2 |= (0b1 << 15);
-	I2C1 -> CR2 |= (0b1 << 14);
-	loop_count = 0;
-	while (((I2C1 -> ISR) & (0b1 << 5)) == 0) {
-		// Wait for STOPF='1' or timeout.
-		loop_count++;
-		if (loop_count > I2C_ACCESS_TIMEOUT_COUNT) return 0;
-	}
-	// Clear flag.
-	I2C1 -> ICR |= (0b1 << 5); // STOPCF='1'.
-	return 1;
+	return I2C1_Transfer(slave_address, 0, 0, rx_buf, rx_buf_length, 1);
+}
+
+/* WRITE DATA THEN READ BYTES WITH A REPEATED START CONDITION (TYPICALLY REGISTER ADDRESS FOLLOWED BY REGISTER VALUE(S)).
+ * @param slave_address:	Slave address on 7 bits.
+ * @param tx_buf:			Array containing the byte(s) to send.
+ * @param tx_buf_length:	Number of bytes to send (length of 'tx_buf').
+ * @param rx_buf:			Array that will contain the byte(s) to receive.
+ * @param rx_buf_length:	Number of bytes to receive (length of 'rx_buf').
+ * @return:					1 in case of success, 0 in case of failure.
+ */
+unsigned char I2C1_WriteRead(unsigned char slave_address, unsigned char* tx_buf, unsigned char tx_buf_length, unsigned char* rx_buf, unsigned char rx_buf_length) {
+	return I2C1_Transfer(slave_address, tx_buf, tx_buf_length, rx_buf, rx_buf_length, 1);
 }
@@ -16,31 +16,170 @@
 
 /*** LPTIM local macros ***/
 
-#define LPTIM_TIMEOUT_COUNT		1000000
-#define LPTIM_DELAY_MS_MIN		1
-#define LPTIM_DELAY_MS_MAX		55000
+#define LPTIM_TIMEOUT_COUNT			1000000
+#define LPTIM_DELAY_MS_MIN			1
+#define LPTIM_DELAY_MS_MAX			55000
+#define LPTIM_ARR_VALUE				0xFFFF // Free running counter.
+#define LPTIM_COUNTER_HALF_RANGE	0x8000
+
+/*** LPTIM local structures ***/
+
+typedef struct {
+	unsigned char lptim_timer_allocated;				// Slot owned by a client until LPTIM1_StopTimer() is called.
+	unsigned char lptim_timer_running;					// Cleared on single shot expiry.
+	LPTIM_TimerMode lptim_timer_mode;
+	unsigned int lptim_timer_period_ticks;
+	unsigned int lptim_timer_expiry_ticks;				// Absolute expiry on the 32-bits extended counter.
+	LPTIM_TimerCallback lptim_timer_callback;			// Called under interrupt (optional).
+	volatile unsigned char lptim_timer_flag;
+} LPTIM_Timer;
+
+typedef struct {
+	unsigned int lptim_clock_frequency_hz;
+	volatile unsigned int lptim_counter_msb;			// Number of counter overflows (16 MSB of extended counter).
+	LPTIM_Timer lptim_timers[LPTIM_TIMER_NUMBER];
+} LPTIM_Context;
 
 /*** LPTIM local global variables ***/
 
-static unsigned int lptim_clock_frequency_hz = 0;
-static volatile unsigned char lptim_wake_up = 0;
+static LPTIM_Context lptim_ctx;
 
 /*** LPTIM local functions ***/
 
+/* READ LPTIM COUNTER (ASYNCHRONOUS CLOCK REQUIRES TWO IDENTICAL READS).
+ * @param:	None.
+ * @return:	Counter value.
+ */
+static unsigned int LPTIM1_ReadCounter(void) {
+	// Local variables.
+	unsigned int cnt = 0;
+	// Read until stable.
+	do {
+		cnt = ((LPTIM1 -> CNT) & 0xFFFF);
+	}
+	while (cnt != ((LPTIM1 -> CNT) & 0xFFFF));
+	return cnt;
+}
+
+/* GET 32-BITS EXTENDED COUNTER VALUE.
+ * @param:	None.
+ * @return:	Number of LPTIM ticks since timer service start (modulo 2^32).
+ */
+static unsigned int LPTIM1_GetTicks(void) {
+	// Local variables.
+	unsigned int msb = 0;
+	unsigned int cnt = 0;
+	// Read overflow count and counter coherently.
+	do {
+		msb = lptim_ctx.lptim_counter_msb;
+		cnt = LPTIM1_ReadCounter();
+	}
+	while (msb != lptim_ctx.lptim_counter_msb);
+	// ARRM is set when CNT=ARR, the counter rolls over on the next tick.
+	if (((LPTIM1 -> ISR) & (0b1 << 1)) != 0) {
+		// Overflow not processed yet.
+		if (cnt < LPTIM_COUNTER_HALF_RANGE) {
+			msb++;
+		}
+	}
+	else {
+		// Overflow already processed while counter still equals ARR.
+		if (cnt == LPTIM_ARR_VALUE) {
+			return ((msb << 16) - 1);
+		}
+	}
+	return ((msb << 16) + cnt);
+}
+
+/* CONVERT MILLISECONDS TO LPTIM TICKS (ROUNDED UP).
+ * @param duration_ms:	Duration in milliseconds.
+ * @return:				Duration in ticks.
+ */
+static unsigned int LPTIM1_MillisecondsToTicks(unsigned int duration_ms) {
+	// Split computation to avoid 32-bits overflow.
+	unsigned int ticks = (duration_ms / 1000) * lptim_ctx.lptim_clock_frequency_hz;
+	ticks += (((duration_ms % 1000) * lptim_ctx.lptim_clock_frequency_hz) + 999) / 1000;
+	if (ticks == 0) {
+		ticks = 1;
+	}
+	return ticks;
+}
+
+/* PROCESS EXPIRED TIMERS AND PROGRAM COMPARE REGISTER FOR THE NEAREST EXPIRY.
+ * @param:	None.
+ * @return:	None.
+ */
+static void LPTIM1_UpdateTimers(void) {
+	// Local variables.
+	unsigned int now_ticks = 0;
+	unsigned int next_expiry_ticks = 0;
+	unsigned char next_expiry_found = 0;
+	unsigned char timer_idx = 0;
+	unsigned int loop_count = 0;
+	while (1) {
+		now_ticks = LPTIM1_GetTicks();
+		next_expiry_found = 0;
+		// Process expired timers.
+		for (timer_idx=0 ; timer_idx<LPTIM_TIMER_NUMBER ; timer_idx++) {
+			if (lptim_ctx.lptim_timers[timer_idx].lptim_timer_running == 0) continue;
+			if (((signed int) (lptim_ctx.lptim_timers[timer_idx].lptim_timer_expiry_ticks - now_ticks)) <= 0) {
+				// Update timer.
+				if (lptim_ctx.lptim_timers[timer_idx].lptim_timer_mode == LPTIM_TIMER_MODE_PERIODIC) {
+					lptim_ctx.lptim_timers[timer_idx].lptim_timer_expiry_ticks += lptim_ctx.lptim_timers[timer_idx].lptim_timer_period_ticks;
+				}
+				else {
+					lptim_ctx.lptim_timers[timer_idx].lptim_timer_running = 0;
+				}
+				// Notify client.
+				lptim_ctx.lptim_timers[timer_idx].lptim_timer_flag = 1;
+				if (lptim_ctx.lptim_timers[timer_idx].lptim_timer_callback != 0) {
+					lptim_ctx.lptim_timers[timer_idx].lptim_timer_callback();
+				}
+			}
+			// Search nearest expiry.
+			if (lptim_ctx.lptim_timers[timer_idx].lptim_timer_running != 0) {
+				if ((next_expiry_found == 0) || (((signed int) (lptim_ctx.lptim_timers[timer_idx].lptim_timer_expiry_ticks - next_expiry_ticks)) < 0)) {
+					next_expiry_ticks = lptim_ctx.lptim_timers[timer_idx].lptim_timer_expiry_ticks;
+					next_expiry_found = 1;
+				}
+			}
+		}
+		// Nothing to program if no timer is running, if expiry is beyond current counter period or matches ARR (overflow interrupt will handle it).
+		if (next_expiry_found == 0) break;
+		if ((next_expiry_ticks - now_ticks) > LPTIM_ARR_VALUE) break;
+		if ((next_expiry_ticks & 0xFFFF) == LPTIM_ARR_VALUE) break;
+		// Program compare register.
+		LPTIM1 -> ICR |= (0b1 << 3); // CMPOKCF='1'.
+		LPTIM1 -> CMP = (next_expiry_ticks & 0xFFFF);
+		loop_count = 0;
+		while (((LPTIM1 -> ISR) & (0b1 << 3)) == 0) {
+			// Wait for CMPOK='1' or timeout.
+			loop_count++;
+			if (loop_count > LPTIM_TIMEOUT_COUNT) break;
+		}
+		// Exit if expiry is still in the future, otherwise the match may have been missed: process again.
+		if (((signed int) (next_expiry_ticks - LPTIM1_GetTicks())) > 0) break;
+	}
+}
+
 /* LPTIM INTERRUPT HANDLER.
  * @param:	None.
  * @return:	None.
  */
 void __attribute__((optimize("-O0"))) LPTIM1_IRQHandler(void) {
-	// Check flag.
+	// Autoreload match (counter overflow).
 	if (((LPTIM1 -> ISR) & (0b1 << 1)) != 0) {
-		// Set local flag.
-		if (((LPTIM1 -> IER) & (0b1 << 1)) != 0) {
-			lptim_wake_up = 1;
-		}
+		lptim_ctx.lptim_counter_msb++;
 		// Clear flag.
 		LPTIM1 -> ICR |= (0b1 << 1);
 	}
+	// Compare match.
+	if (((LPTIM1 -> ISR) & (0b1 << 0)) != 0) {
+		// Clear flag.
+		LPTIM1 -> ICR |= (0b1 << 0);
+	}
+	// Process timers.
+	LPTIM1_UpdateTimers();
 }
 
 /* WRITE ARR REGISTER.
@@ -70,30 +209,45 @@ static void LPTIM1_WriteArr(unsigned int arr_value) {
 
 /*** LPTIM functions ***/
 
-/* INIT LPTIM FOR DELAY OPERATION.
+/* INIT LPTIM AND START TIMER SERVICE.
  * @param lsi_freq_hz:	Effective LSI oscillator frequency.
  * @return:				None.
  */
 void LPTIM1_Init(unsigned int lsi_freq_hz) {
+	// Local variables.
+	unsigned char timer_idx = 0;
 	// Disable peripheral.
+	NVIC_DisableInterrupt(NVIC_IT_LPTIM1);
 	RCC -> APB1ENR &= ~(0b1 << 31); // LPTIM1EN='0'.
+	// Init context.
+	lptim_ctx.lptim_counter_msb = 0;
+	for (timer_idx=0 ; timer_idx<LPTIM_TIMER_NUMBER ; timer_idx++) {
+		lptim_ctx.lptim_timers[timer_idx].lptim_timer_allocated = 0;
+		lptim_ctx.lptim_timers[timer_idx].lptim_timer_running = 0;
+		lptim_ctx.lptim_timers[timer_idx].lptim_timer_flag = 0;
+	}
 	// Enable peripheral clock.
 	RCC -> CCIPR &= ~(0b11 << 18); // Reset bits 18-19.
 	RCC -> CCIPR |= (0b01 << 18); // LPTIMSEL='01' (LSI clock selected).
-	lptim_clock_frequency_hz = (lsi_freq_hz >> 5);
+	lptim_ctx.lptim_clock_frequency_hz = (lsi_freq_hz >> 5);
 	RCC -> APB1ENR |= (0b1 << 31); // LPTIM1EN='1'.
 	// Configure peripheral.
 	LPTIM1 -> CR &= ~(0b1 << 0); // Disable LPTIM1 (ENABLE='0'), needed to write CFGR.
 	LPTIM1 -> CFGR &= ~(0b1 << 0);
 	LPTIM1 -> CFGR |= (0b101 << 9); // Prescaler = 32.
-	LPTIM1 -> CNT &= 0xFFFF0000; // Reset counter.
-	// Enable LPTIM EXTI line.
-	LPTIM1 -> IER |= (0b1 << 1); // ARRMIE='1'.
+	// Enable compare and autoreload match interrupts.
+	LPTIM1 -> IER |= (0b11 << 0); // CMPMIE='1' and ARRMIE='1'.
 	EXTI_ConfigureLine(EXTI_LINE_LPTIM1, EXTI_TRIGGER_RISING_EDGE);
 	// Set interrupt priority.
 	NVIC_SetPriority(NVIC_IT_LPTIM1, 2);
 	// Clear all flags.
 	LPTIM1 -> ICR |= (0b1111111 << 0);
+	// Start free running counter.
+	LPTIM1 -> CR |= (0b1 << 0); // Enable LPTIM1 (ENABLE='1').
+	LPTIM1_WriteArr(LPTIM_ARR_VALUE);
+	LPTIM1 -> ICR |= (0b1111111 << 0);
+	NVIC_EnableInterrupt(NVIC_IT_LPTIM1);
+	LPTIM1 -> CR |= (0b1 << 2); // CNTSTRT='1'.
 }
 
 /* ENABLE LPTIM1 PERIPHERAL.
@@ -105,26 +259,128 @@ void LPTIM1_Enable(void) {
 	RCC -> APB1ENR |= (0b1 << 31); // LPTIM1EN='1'.
 }
 
-/* DISABLE LPTIM1 PERIPHERAL.
+/* DISABLE LPTIM1 PERIPHERAL (ALL TIMERS ARE STOPPED BUT REMAIN ALLOCATED).
  * @param:	None.
  * @return:	None.
  */
 void LPTIM1_Disable(void) {
-	// Disable timer.
+	// Local variables.
+	unsigned char timer_idx = 0;
+	// Disable interrupt and timer.
+	NVIC_DisableInterrupt(NVIC_IT_LPTIM1);
 	LPTIM1 -> CR &= ~(0b1 << 0); // Disable LPTIM1 (ENABLE='0').
-	LPTIM1 -> CNT &= 0xFFFF0000;
+	// Stop all timers.
+	for (timer_idx=0 ; timer_idx<LPTIM_TIMER_NUMBER ; timer_idx++) {
+		lptim_ctx.lptim_timers[timer_idx].lptim_timer_running = 0;
+	}
 	// Clear all flags.
 	LPTIM1 -> ICR |= (0b1111111 << 0);
 	// Disable peripheral clock.
 	RCC -> APB1ENR &= ~(0b1 << 31); // LPTIM1EN='0'.
 }
 
+/* START A SOFTWARE TIMER (THE IDENTIFIER REMAINS VALID UNTIL LPTIM1_StopTimer IS CALLED, EVEN AFTER A SINGLE SHOT EXPIRY).
+ * @param timer_id:		Pointer that will contain the allocated timer identifier.
+ * @param duration_ms:	Timer duration (or period) in milliseconds.
+ * @param mode:			Single shot or periodic timer.
+ * @param callback:		Function called under interrupt on each expiry (0 if not used, expiry flag is always set).
+ * @return status:		1 if timer was started, 0 if no timer is available.
+ */
+unsigned char LPTIM1_StartTimer(unsigned char* timer_id, unsigned int duration_ms, LPTIM_TimerMode mode, LPTIM_TimerCallback callback) {
+	// Local variables.
+	unsigned char status = 0;
+	unsigned char timer_idx = 0;
+	// Prevent interrupt from updating timers list.
+	NVIC_DisableInterrupt(NVIC_IT_LPTIM1);
+	// Search free timer.
+	for (timer_idx=0 ; timer_idx<LPTIM_TIMER_NUMBER ; timer_idx++) {
+		if (lptim_ctx.lptim_timers[timer_idx].lptim_timer_allocated == 0) {
+			// Configure timer.
+			lptim_ctx.lptim_timers[timer_idx].lptim_timer_mode = mode;
+			lptim_ctx.lptim_timers[timer_idx].lptim_timer_period_ticks = LPTIM1_MillisecondsToTicks(duration_ms);
+			lptim_ctx.lptim_timers[timer_idx].lptim_timer_expiry_ticks = LPTIM1_GetTicks() + lptim_ctx.lptim_timers[timer_idx].lptim_timer_period_ticks;
+			lptim_ctx.lptim_timers[timer_idx].lptim_timer_callback = callback;
+			lptim_ctx.lptim_timers[timer_idx].lptim_timer_flag = 0;
+			lptim_ctx.lptim_timers[timer_idx].lptim_timer_allocated = 1;
+			lptim_ctx.lptim_timers[timer_idx].lptim_timer_running = 1;
+			(*timer_id) = timer_idx;
+			status = 1;
+			break;
+		}
+	}
+	// Program nearest expiry.
+	LPTIM1_UpdateTimers();
+	NVIC_EnableInterrupt(NVIC_IT_LPTIM1);
+	return status;
+}
+
+/* STOP A SOFTWARE TIMER AND RELEASE ITS IDENTIFIER.
+ * @param timer_id:	Timer to stop.
+ * @return:			None.
+ */
+void LPTIM1_StopTimer(unsigned char timer_id) {
+	// Check parameter.
+	if (timer_id >= LPTIM_TIMER_NUMBER) return;
+	// Release timer.
+	NVIC_DisableInterrupt(NVIC_IT_LPTIM1);
+	lptim_ctx.lptim_timers[timer_id].lptim_timer_running = 0;
+	lptim_ctx.lptim_timers[timer_id].lptim_timer_allocated = 0;
+	NVIC_EnableInterrupt(NVIC_IT_LPTIM1);
+}
+
+/* GET SOFTWARE TIMER EXPIRY FLAG.
+ * @param timer_id:	Timer to check.
+ * @return:			1 if the timer expired since its start or last flag clear, 0 otherwise.
+ */
+unsigned char LPTIM1_GetTimerFlag(unsigned char timer_id) {
+	// Check parameter.
+	if (timer_id >= LPTIM_TIMER_NUMBER) return 0;
+	return lptim_ctx.lptim_timers[timer_id].lptim_timer_flag;
+}
+
+/* CLEAR SOFTWARE TIMER EXPIRY FLAG.
+ * @param timer_id:	Timer flag to clear.
+ * @return:			None.
+ */
+void LPTIM1_ClearTimerFlag(unsigned char timer_id) {
+	// Check parameter.
+	if (timer_id >= LPTIM_TIMER_NUMBER) return;
+	lptim_ctx.lptim_timers[timer_id].lptim_timer_flag = 0;
+}
+
+/* WAIT FOR A SOFTWARE TIMER EXPIRY (OTHER TIMERS KEEP RUNNING MEANWHILE).
+ * @param timer_id:		Timer to wait for.
+ * @param stop_mode:	Enter stop mode during wait if non zero.
+ * @return:				None.
+ */
+void LPTIM1_WaitTimer(unsigned char timer_id, unsigned char stop_mode) {
+	// Check parameter.
+	if (timer_id >= LPTIM_TIMER_NUMBER) return;
+	// Wait for expiry (or timer stop).
+	if (stop_mode != 0) {
+		// Interrupts are masked during the check so that an expiry occurring just before entering stop mode still wakes-up the MCU.
+		NVIC_DisableInterrupts();
+		while ((lptim_ctx.lptim_timers[timer_id].lptim_timer_flag == 0) && (lptim_ctx.lptim_timers[timer_id].lptim_timer_running != 0)) {
+			PWR_EnterStopMode();
+			// Execute pending interrupt.
+			NVIC_EnableInterrupts();
+			NVIC_DisableInterrupts();
+		}
+		NVIC_EnableInterrupts();
+	}
+	else {
+		while ((lptim_ctx.lptim_timers[timer_id].lptim_timer_flag == 0) && (lptim_ctx.lptim_timers[timer_id].lptim_timer_running != 0));
+	}
+}
+
 /* DELAY FUNCTION.
  * @param delay_ms:		Number of milliseconds to wait.
  * @param stop_mode:	Enter stop mode during delay if non zero.
  * @return:				None.
  */
 void LPTIM1_DelayMilliseconds(unsigned int delay_ms, unsigned char stop_mode) {
+	// Local variables.
+	unsigned char timer_id = 0;
 	// Clamp value if required.
 	unsigned int local_delay_ms = delay_ms;
 	if (local_delay_ms > LPTIM_DELAY_MS_MAX) {
@@ -133,24 +389,8 @@ void LPTIM1_DelayMilliseconds(unsigned int delay_ms, unsigned char stop_mode) {
 	if (local_delay_ms < LPTIM_DELAY_MS_MIN) {
 		local_delay_ms = LPTIM_DELAY_MS_MIN;
 	}
-	// Enable timer.
-	LPTIM1 -> CR |= (0b1 << 0); // Enable LPTIM1 (ENABLE='1').
-	// Reset counter.
-	LPTIM1 -> CNT &= 0xFFFF0000;
-	// Compute ARR value.
-	unsigned int arr = ((local_delay_ms * lptim_clock_frequency_hz) / (1000)) & 0x0000FFFF;
-	LPTIM1_WriteArr(arr);
-	// Start timer.
-	NVIC_EnableInterrupt(NVIC_IT_LPTIM1);
-	lptim_wake_up = 0;
-	LPTIM1 -> CR |= (0b1 << 1); // SNGSTRT='1'.
-	// Wait for interrupt.
-	while (lptim_wake_up == 0) {
-		if (stop_mode != 0) {
-			PWR_EnterStopMode();
-		}
-	}
-	// Disable timer.
-	LPTIM1 -> CR &= ~(0b1 << 0); // Disable LPTIM1 (ENABLE='0').
-	NVIC_DisableInterrupt(NVIC_IT_LPTIM1);
+	// Start single shot timer and wait for expiry.
+	if (LPTIM1_StartTimer(&timer_id, local_delay_ms, LPTIM_TIMER_MODE_SINGLE, 0) == 0) return;
+	LPTIM1_WaitTimer(timer_id, stop_mode);
+	LPTIM1_StopTimer(timer_id);
 }
@@ -7,6 +7,7 @@
 
 #include "lpuart.h"
 
+#include "accounting.h"
 #include "gpio.h"
 #include "lptim.h"
 #include "lpuart_reg.h"
@@ -57,6 +58,8 @@ void LPUART1_Init(unsigned char lpuart_use_lse) {
 	if (lpuart_use_lse == 0) {
 		RCC -> CCIPR |= (0b01 << 10); // LPUART1SEL='01'.
 		lpuart_clock_hz = RCC_GetSysclkKhz() * 1000;
+		// Baud rate must be updated after each system clock change.
+		RCC_SetClockCallback(RCC_CLOCK_CLIENT_LPUART1, &LPUART1_UpdateBrr);
 	}
 	else {
 		RCC -> CCIPR |= (0b11 << 10); // LPUART1SEL='11'.
@@ -144,6 +147,7 @@ void LPUART1_Disable(void) {
 	LPUART1 -> ICR |= 0x0012025F;
 	// Disable peripheral clock.
 	RCC -> APB1ENR &= ~(0b1 << 18); // LPUARTEN='0'.
+	RCC_SetClockCallback(RCC_CLOCK_CLIENT_LPUART1, 0);
 }
 
 /* POWER LPUART1 SLAVE ON.
@@ -156,6 +160,7 @@ void LPUART1_PowerOn(void) {
 	GPIO_Configure(&GPIO_LPUART1_RX, GPIO_MODE_ALTERNATE_FUNCTION, GPIO_TYPE_PUSH_PULL, GPIO_SPEED_LOW, GPIO_PULL_NONE);
 	// Turn NEOM8N on.
 	GPIO_Write(&GPIO_GPS_POWER_ENABLE, 1);
+	ACCOUNTING_EnterState(ACCOUNTING_STATE_GPS);
 	LPTIM1_DelayMilliseconds(100, 1);
 }
 
@@ -166,6 +171,7 @@ void LPUART1_PowerOn(void) {
 void LPUART1_PowerOff(void) {
 	// Turn NEOM8N off.
 	GPIO_Write(&GPIO_GPS_POWER_ENABLE, 0);
+	ACCOUNTING_ExitState(ACCOUNTING_STATE_GPS);
 	// Disable LPUART alternate function.
 	GPIO_Configure(&GPIO_LPUART1_TX, GPIO_MODE_ANALOG, GPIO_TYPE_OPEN_DRAIN, GPIO_SPEED_LOW, GPIO_PULL_NONE);
 	GPIO_Configure(&GPIO_LPUART1_RX, GPIO_MODE_ANALOG, GPIO_TYPE_OPEN_DRAIN, GPIO_SPEED_LOW, GPIO_PULL_NONE);
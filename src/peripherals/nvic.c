@@ -40,6 +40,22 @@ void NVIC_DisableInterrupt(NVIC_InterruptVector it_num) {
 	NVIC -> ICER = (0b1 << (it_num & 0x1F));
 }
 
+/* MASK ALL INTERRUPTS (A PENDING INTERRUPT STILL WAKES-UP THE CORE FROM SLEEP OR STOP MODE).
+ * @param:	None.
+ * @return:	None.
+ */
+void NVIC_DisableInterrupts(void) {
+	__asm volatile ("cpsid i");
+}
+
+/* UNMASK ALL INTERRUPTS (PENDING INTERRUPTS ARE EXECUTED IMMEDIATELY).
+ * @param:	None.
+ * @return:	None.
+ */
+void NVIC_EnableInterrupts(void) {
+	__asm volatile ("cpsie i");
+}
+
 /* SET THE PRIORITY OF AN INTERRUPT LINE.
  * @param it_num:	Interrupt number (use enum defined in 'nvic.h').
  * @param priority:	Interrupt priority (0 to 3).
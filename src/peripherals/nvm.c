@@ -10,6 +10,19 @@
 #include "flash_reg.h"
 #include "rcc_reg.h"
 
+/*** NVM local macros ***/
+
+#define NVM_CRC32_INIT		0xFFFFFFFF
+#define NVM_CRC32_XOR_OUT	0xFFFFFFFF
+
+/*** NVM local global variables ***/
+
+// CRC-32 (IEEE 802.3, reflected polynomial 0xEDB88320) nibble table.
+static const unsigned int nvm_crc32_table[16] = {
+	0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+	0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
 /*** NVM local functions ***/
 
 /* UNLOCK NVM.
@@ -92,6 +105,75 @@ void NVM_WriteByte(unsigned short address_offset, unsigned char byte_to_store) {
 	NVM_Lock();
 }
 
+/* READ A BLOCK OF BYTES STORED IN NVM.
+ * @param address_offset:	Address offset of the first byte starting from NVM start address.
+ * @param data:				Pointer to buffer that will contain the bytes.
+ * @param data_length:		Number of bytes to read.
+ * @return:					1 in case of success, 0 if the block exceeds NVM size.
+ */
+unsigned char NVM_ReadBlock(unsigned short address_offset, unsigned char* data, unsigned short data_length) {
+	// Local variables.
+	unsigned short idx = 0;
+	// Check range.
+	if ((address_offset + data_length) > EEPROM_SIZE) return 0;
+	// Read bytes.
+	for (idx=0 ; idx<data_length ; idx++) {
+		data[idx] = *((unsigned char*) (EEPROM_START_ADDRESS + address_offset + idx));
+	}
+	return 1;
+}
+
+/* WRITE A BLOCK OF BYTES TO NVM.
+ * @param address_offset:	Address offset of the first byte starting from NVM start address.
+ * @param data:				Bytes to store.
+ * @param data_length:		Number of bytes to write.
+ * @return:					1 in case of success, 0 if the block exceeds NVM size.
+ */
+unsigned char NVM_WriteBlock(unsigned short address_offset, unsigned char* data, unsigned short data_length) {
+	// Local variables.
+	unsigned short idx = 0;
+	unsigned char* nvm_byte = 0;
+	// Check range.
+	if ((address_offset + data_length) > EEPROM_SIZE) return 0;
+	// Unlock NVM once for the whole block.
+	NVM_Unlock();
+	for (idx=0 ; idx<data_length ; idx++) {
+		nvm_byte = (unsigned char*) (EEPROM_START_ADDRESS + address_offset + idx);
+		// Skip bytes which are already up to date (saves a 3.2ms erase/program cycle and EEPROM endurance).
+		if ((*nvm_byte) != data[idx]) {
+			(*nvm_byte) = data[idx];
+			// Wait end of operation.
+			while (((FLASH -> SR) & (0b1 << 0)) != 0); // Wait till BSY='1'.
+		}
+	}
+	// Lock NVM.
+	NVM_Lock();
+	return 1;
+}
+
+/* COMPUTE THE CRC-32 OF AN NVM RANGE (SAME AS ZLIB CRC32).
+ * @param address_offset:	Address offset of the first byte starting from NVM start address.
+ * @param data_length:		Number of bytes.
+ * @param crc32:			Pointer to the computed CRC.
+ * @return:					1 in case of success, 0 if the range exceeds NVM size.
+ */
+unsigned char NVM_ComputeCrc32(unsigned short address_offset, unsigned short data_length, unsigned int* crc32) {
+	// Local variables.
+	unsigned short idx = 0;
+	unsigned char nvm_byte = 0;
+	unsigned int crc = NVM_CRC32_INIT;
+	// Check range.
+	if ((address_offset + data_length) > EEPROM_SIZE) return 0;
+	// Process each nibble (LSB first).
+	for (idx=0 ; idx<data_length ; idx++) {
+		nvm_byte = *((unsigned char*) (EEPROM_START_ADDRESS + address_offset + idx));
+		crc = (crc >> 4) ^ nvm_crc32_table[(crc ^ nvm_byte) & 0x0F];
+		crc = (crc >> 4) ^ nvm_crc32_table[(crc ^ (nvm_byte >> 4)) & 0x0F];
+	}
+	(*crc32) = (crc ^ NVM_CRC32_XOR_OUT);
+	return 1;
+}
+
 /* RESET ALL NVM FIELDS TO DEFAULT VALUE.
  * @param:	None.
  * @return:	None.
@@ -9,6 +9,8 @@
 
 #include "exti_reg.h"
 #include "flash_reg.h"
+#include "mapping.h"
+#include "nvic.h"
 #include "nvic_reg.h"
 #include "pwr_reg.h"
 #include "rcc_reg.h"
@@ -75,11 +77,15 @@ void PWR_EnterStopMode(void) {
 	// Enter stop mode when CPU enters deepsleep.
 	PWR -> CR &= ~(0b1 << 1); // PDDS='0'.
 	// Clear all EXTI line, RTC an peripherals interrupt pending bits.
+	// Accelerometer line is kept: an edge received after the caller checked the pin level must still wake-up the MCU.
 	RCC -> CICR |= 0x000001BF;
-	EXTI -> PR |= 0x007BFFFF; // PIFx='1'.
+	EXTI -> PR = (0x007BFFFF & ~(0b1 << (GPIO_ACCELERO_IRQ.gpio_num))); // PIFx='1' (direct write to keep accelerometer flag).
 	RTC -> ISR &= 0xFFFF005F; // Reset alarms, wake-up, tamper and timestamp flags.
-	NVIC -> ICPR = 0xFFFFFFFF; // CLEARPENDx='1'.
+	NVIC -> ICPR = ~(0b1 << NVIC_IT_EXTI_0_1); // CLEARPENDx='1'.
 	// Enter stop mode.
+	RCC_EnterStopMode();
 	SCB -> SCR |= (0b1 << 2); // SLEEPDEEP='1'.
 	__asm volatile ("wfi"); // Wait For Interrupt core instruction.
+	// Restore system clock level.
+	RCC_ExitStopMode();
 }
@@ -15,6 +15,7 @@
 #include "nvic.h"
 #include "pwr_reg.h"
 #include "rcc_reg.h"
+#include "rtc.h"
 #include "scb_reg.h"
 #include "tim.h"
 
@@ -27,9 +28,24 @@
 #define RCC_LSI_FREQUENCY_MIN_HZ		26000
 #define RCC_LSI_FREQUENCY_MAX_HZ		56000
 
+/*** RCC local structures ***/
+
+typedef struct {
+	RCC_ClockLevel rcc_clock_level;
+	unsigned int rcc_clock_requests_khz[RCC_CLOCK_CLIENT_LAST];		// Minimum frequency required by each client (0 if none).
+	RCC_ClockCallback rcc_clock_callbacks[RCC_CLOCK_CLIENT_LAST];	// Called after each system clock change (prescalers update).
+	unsigned int rcc_clock_level_time_ms[RCC_CLOCK_LEVEL_LAST];		// Time spent in each level (stop mode excluded).
+	unsigned int rcc_clock_level_start_ms;
+	unsigned char rcc_clock_level_time_enabled;						// RTC must be running before time is accounted.
+} RCC_Context;
+
 /*** RCC local global variables ***/
 
 static unsigned int rcc_sysclk_khz;
+static unsigned char rcc_hsi_kernel_request;
+static RCC_Context rcc_ctx;
+// MSIRANGE field value is the level index for MSI levels.
+static const unsigned int rcc_clock_level_khz[RCC_CLOCK_LEVEL_LAST] = {RCC_MSI_FREQUENCY_KHZ, 131, 262, 524, 1048, 2097, 4194, RCC_HSI_FREQUENCY_KHZ};
 
 /*** RCC local functions ***/
 
@@ -49,6 +65,139 @@ static void RCC_Delay(void) {
 	}
 }
 
+/* ADD TIME ELAPSED SINCE LAST CLOCK CHANGE TO THE CURRENT LEVEL.
+ * @param:	None.
+ * @return:	None.
+ */
+static void RCC_UpdateClockLevelTime(void) {
+	// Local variables.
+	unsigned int timestamp_ms = 0;
+	// Check if accounting is started.
+	if (rcc_ctx.rcc_clock_level_time_enabled == 0) return;
+	// Update statistics.
+	RTC_GetTimestampMilliseconds(&timestamp_ms);
+	rcc_ctx.rcc_clock_level_time_ms[rcc_ctx.rcc_clock_level] += (timestamp_ms - rcc_ctx.rcc_clock_level_start_ms);
+	rcc_ctx.rcc_clock_level_start_ms = timestamp_ms;
+}
+
+/* SWITCH SYSTEM CLOCK TO A GIVEN LEVEL AND UPDATE CLIENTS PRESCALERS.
+ * @param level:		Clock level to use.
+ * @return switch_ok:	'1' if SYSCLK was successfully switched, 0 otherwise.
+ */
+static unsigned char RCC_SwitchClockLevel(RCC_ClockLevel level) {
+	// Local variables.
+	unsigned char switch_ok = 0;
+	unsigned int loop_count = 0;
+	unsigned char client_idx = 0;
+	// Statistics are updated at the highest frequency to limit overhead.
+	if (level < rcc_ctx.rcc_clock_level) {
+		RCC_UpdateClockLevelTime();
+	}
+	if (level == RCC_CLOCK_LEVEL_HSI_16MHZ) {
+		// Set flash latency.
+		FLASH_SetLatency(1);
+		// Init HSI.
+		RCC -> CR |= (0b1 << 0); // Enable HSI (HSI16ON='1').
+		// Wait for HSI to be stable.
+		while ((((RCC -> CR) & (0b1 << 2)) == 0) && (loop_count < RCC_TIMEOUT_COUNT)) {
+			RCC_Delay();
+			loop_count++; // Wait for HSIRDYF='1' or timeout.
+		}
+		// Check timeout.
+		if (loop_count < RCC_TIMEOUT_COUNT) {
+			// Switch SYSCLK.
+			RCC -> CFGR &= ~(0b11 << 0); // Reset bits 0-1.
+			RCC -> CFGR |= (0b01 << 0); // Use HSI as system clock (SW='01').
+			// Wait for clock switch.
+			loop_count = 0;
+			while ((((RCC -> CFGR) & (0b11 << 2)) != (0b01 << 2)) && (loop_count < RCC_TIMEOUT_COUNT)) {
+				RCC_Delay();
+				loop_count++; // Wait for SWS='01' or timeout.
+			}
+			// Check timeout.
+			if (loop_count < RCC_TIMEOUT_COUNT) {
+				// Disable MSI and HSE.
+				RCC -> CR &= ~(0b1 << 8); // Disable MSI (MSION='0').
+				RCC -> CR &= ~(0b1 << 16); // Disable HSE (HSEON='0').
+				switch_ok = 1;
+			}
+		}
+	}
+	else {
+		// Init MSI (range can be changed on the fly when MSI is ready).
+		RCC -> ICSCR &= ~(0b111 << 13); // Reset bits 13-15.
+		RCC -> ICSCR |= (level << 13); // MSIRANGE=level.
+		RCC -> CR |= (0b1 << 8); // Enable MSI (MSION='1').
+		// Wait for MSI to be stable.
+		while ((((RCC -> CR) & (0b1 << 9)) == 0) && (loop_count < RCC_TIMEOUT_COUNT)) {
+			RCC_Delay();
+			loop_count++; // Wait for MSIRDYF='1' or timeout.
+		}
+		// Check timeout.
+		if (loop_count < RCC_TIMEOUT_COUNT) {
+			// Switch SYSCLK.
+			RCC -> CFGR &= ~(0b11 << 0); // Use MSI as system clock (SW='00').
+			// Wait for clock switch.
+			loop_count = 0;
+			while ((((RCC -> CFGR) & (0b11 << 2)) != (0b00 << 2)) && (loop_count < RCC_TIMEOUT_COUNT)) {
+				RCC_Delay();
+				loop_count++; // Wait for SWS='00' or timeout.
+			}
+			// Check timeout.
+			if (loop_count < RCC_TIMEOUT_COUNT) {
+				// Set flash latency.
+				FLASH_SetLatency(0);
+				// Disable HSI (if not used as peripheral kernel clock) and HSE.
+				if (rcc_hsi_kernel_request == 0) {
+					RCC -> CR &= ~(0b1 << 0); // Disable HSI (HSI16ON='0').
+				}
+				RCC -> CR &= ~(0b1 << 16); // Disable HSE (HSEON='0').
+				switch_ok = 1;
+			}
+		}
+	}
+	if (switch_ok != 0) {
+		// Update statistics, level and frequency.
+		if (level > rcc_ctx.rcc_clock_level) {
+			RCC_UpdateClockLevelTime();
+		}
+		rcc_ctx.rcc_clock_level = level;
+		rcc_sysclk_khz = rcc_clock_level_khz[level];
+		// Update clients prescalers.
+		for (client_idx=0 ; client_idx<RCC_CLOCK_CLIENT_LAST ; client_idx++) {
+			if (rcc_ctx.rcc_clock_callbacks[client_idx] != 0) {
+				rcc_ctx.rcc_clock_callbacks[client_idx]();
+			}
+		}
+	}
+	return switch_ok;
+}
+
+/* SWITCH TO THE LOWEST CLOCK LEVEL SATISFYING ALL CLIENTS REQUESTS.
+ * @param:	None.
+ * @return:	None.
+ */
+static void RCC_ApplyClockRequests(void) {
+	// Local variables.
+	unsigned int frequency_min_khz = 0;
+	unsigned char client_idx = 0;
+	RCC_ClockLevel level = RCC_CLOCK_LEVEL_MSI_65KHZ;
+	// Get highest request.
+	for (client_idx=0 ; client_idx<RCC_CLOCK_CLIENT_LAST ; client_idx++) {
+		if (rcc_ctx.rcc_clock_requests_khz[client_idx] > frequency_min_khz) {
+			frequency_min_khz = rcc_ctx.rcc_clock_requests_khz[client_idx];
+		}
+	}
+	// Search lowest level.
+	while ((level < RCC_CLOCK_LEVEL_HSI_16MHZ) && (rcc_clock_level_khz[level] < frequency_min_khz)) {
+		level++;
+	}
+	// Switch if needed.
+	if (level != rcc_ctx.rcc_clock_level) {
+		RCC_SwitchClockLevel(level);
+	}
+}
+
 /*** RCC functions ***/
 
 /* CONFIGURE PERIPHERALs CLOCK PRESCALER AND SOURCES.
@@ -64,6 +213,18 @@ void RCC_Init(void) {
 	RCC -> CCIPR &= 0xFFF0C3F0; // All peripherals clocked via the corresponding APBx line.
 	// Reset clock is MSI 2.1MHz.
 	rcc_sysclk_khz = RCC_MSI_RESET_FREQUENCY_KHZ;
+	rcc_hsi_kernel_request = 0;
+	// Init clock manager.
+	unsigned char idx = 0;
+	for (idx=0 ; idx<RCC_CLOCK_CLIENT_LAST ; idx++) {
+		rcc_ctx.rcc_clock_requests_khz[idx] = 0;
+		rcc_ctx.rcc_clock_callbacks[idx] = 0;
+	}
+	rcc_ctx.rcc_clock_level = RCC_CLOCK_LEVEL_MSI_2MHZ;
+	// Clock level time is accounted once RTC is initialized (see RCC_StartClockLevelTime() function).
+	for (idx=0 ; idx<RCC_CLOCK_LEVEL_LAST ; idx++) rcc_ctx.rcc_clock_level_time_ms[idx] = 0;
+	rcc_ctx.rcc_clock_level_start_ms = 0;
+	rcc_ctx.rcc_clock_level_time_enabled = 0;
 }
 
 /* RETURN THE CURRENT SYSTEM CLOCK FREQUENCY.
@@ -74,84 +235,122 @@ unsigned int RCC_GetSysclkKhz(void) {
 	return rcc_sysclk_khz;
 }
 
-/* CONFIGURE AND USE MSI AS SYSTEM CLOCK.
- * @param:					None.
- * @return sysclk_on_hsi:	'1' if SYSCLK source was successfully switched to MSI, 0 otherwise.
- */
-unsigned char RCC_SwitchToMsi(void) {
-	// Init MSI.
-	RCC -> ICSCR &= ~(0b111 << 13); // Set frequency to 65kHz (MSIRANGE='000').
-	RCC -> CR |= (0b1 << 8); // Enable MSI (MSION='1').
-	// Wait for MSI to be stable.
-	unsigned char sysclk_on_msi = 0;
+/* KEEP HSI RUNNING AS PERIPHERAL KERNEL CLOCK (E.G. ADC ASYNCHRONOUS CLOCK), WHATEVER THE SYSTEM CLOCK SOURCE.
+ * @param hsi_kernel_request:	'1' to keep HSI enabled, '0' to release it.
+ * @return hsi_available:		'1' if HSI is running (or was successfully released), 0 otherwise.
+ */
+unsigned char RCC_SetHsiKernelRequest(unsigned char hsi_kernel_request) {
+	// Local variables.
+	unsigned char hsi_available = 1;
 	unsigned int loop_count = 0;
-	while ((((RCC -> CR) & (0b1 << 9)) == 0) && (loop_count < RCC_TIMEOUT_COUNT)) {
-		RCC_Delay();
-		loop_count++; // Wait for MSIRDYF='1' or timeout.
-	}
-	// Check timeout.
-	if (loop_count < RCC_TIMEOUT_COUNT) {
-		// Switch SYSCLK.
-		RCC -> CFGR &= ~(0b11 << 0); // Use MSI as system clock (SW='00').
-		// Wait for clock switch.
-		loop_count = 0;
-		while ((((RCC -> CFGR) & (0b11 << 2)) != (0b00 << 2)) && (loop_count < RCC_TIMEOUT_COUNT)) {
+	// Update request.
+	rcc_hsi_kernel_request = hsi_kernel_request;
+	if (hsi_kernel_request != 0) {
+		// Enable HSI.
+		RCC -> CR |= (0b1 << 0); // Enable HSI (HSI16ON='1').
+		while ((((RCC -> CR) & (0b1 << 2)) == 0) && (loop_count < RCC_TIMEOUT_COUNT)) {
 			RCC_Delay();
-			loop_count++; // Wait for SWS='00' or timeout.
+			loop_count++; // Wait for HSIRDYF='1' or timeout.
 		}
-		// Check timeout.
-		if (loop_count < RCC_TIMEOUT_COUNT) {
-			// Set flash latency.
-			FLASH_SetLatency(0);
-			// Disable HSI and HSE.
+		if (loop_count >= RCC_TIMEOUT_COUNT) {
+			hsi_available = 0;
+		}
+	}
+	else {
+		// Disable HSI if it is not the system clock.
+		if (((RCC -> CFGR) & (0b11 << 2)) != (0b01 << 2)) {
 			RCC -> CR &= ~(0b1 << 0); // Disable HSI (HSI16ON='0').
-			RCC -> CR &= ~(0b1 << 16); // Disable HSE (HSEON='0').
-			// Update flag and frequency.
-			sysclk_on_msi = 1;
-			rcc_sysclk_khz = RCC_MSI_FREQUENCY_KHZ;
 		}
 	}
-	return sysclk_on_msi;
+	return hsi_available;
 }
 
-/* CONFIGURE AND USE HSI AS SYSTEM CLOCK (16MHz INTERNAL RC).
- * @param:					None.
- * @return sysclk_on_hsi:	'1' if SYSCLK source was successfully switched to HSI, 0 otherwise.
+/* DECLARE THE MINIMUM SYSTEM CLOCK FREQUENCY REQUIRED BY A CLIENT (SYSTEM CLOCK IS SWITCHED TO THE LOWEST LEVEL SATISFYING ALL CLIENTS).
+ * @param client:				Client issuing the request.
+ * @param frequency_min_khz:	Minimum frequency in kHz (0 to release the request).
+ * @return:						None.
  */
-unsigned char RCC_SwitchToHsi(void) {
-	// Set flash latency.
+void RCC_SetClockRequest(RCC_ClockClient client, unsigned int frequency_min_khz) {
+	// Check parameter.
+	if (client >= RCC_CLOCK_CLIENT_LAST) return;
+	// Update request and clock.
+	rcc_ctx.rcc_clock_requests_khz[client] = frequency_min_khz;
+	RCC_ApplyClockRequests();
+}
+
+/* REGISTER A FUNCTION CALLED AFTER EACH SYSTEM CLOCK CHANGE (E.G. TO UPDATE BAUD RATE OR TIMINGS).
+ * @param client:	Client registering the callback.
+ * @param callback:	Function to call (0 to unregister).
+ * @return:			None.
+ */
+void RCC_SetClockCallback(RCC_ClockClient client, RCC_ClockCallback callback) {
+	// Check parameter.
+	if (client >= RCC_CLOCK_CLIENT_LAST) return;
+	rcc_ctx.rcc_clock_callbacks[client] = callback;
+}
+
+/* PREPARE CLOCK MANAGER BEFORE ENTERING STOP MODE.
+ * @param:	None.
+ * @return:	None.
+ */
+void RCC_EnterStopMode(void) {
+	RCC_UpdateClockLevelTime();
+	// Wake-up is performed on HSI: set flash latency accordingly.
 	FLASH_SetLatency(1);
-	// Init HSI.
-	RCC -> CR |= (0b1 << 0); // Enable HSI (HSI16ON='1').
-	// Wait for HSI to be stable.
-	unsigned char sysclk_on_hsi = 0;
-	unsigned int loop_count = 0;
-	while ((((RCC -> CR) & (0b1 << 2)) == 0) && (loop_count < RCC_TIMEOUT_COUNT)) {
-		RCC_Delay();
-		loop_count++; // Wait for HSIRDYF='1' or timeout.
+}
+
+/* RESTORE CLOCK LEVEL AFTER STOP MODE (SYSTEM ALWAYS WAKES-UP ON HSI, SEE PWR_Init() FUNCTION).
+ * @param:	None.
+ * @return:	None.
+ */
+void RCC_ExitStopMode(void) {
+	// Stop mode duration is not accounted.
+	if (rcc_ctx.rcc_clock_level_time_enabled != 0) {
+		RTC_GetTimestampMilliseconds(&rcc_ctx.rcc_clock_level_start_ms);
 	}
-	// Check timeout.
-	if (loop_count < RCC_TIMEOUT_COUNT) {
-		// Switch SYSCLK.
-		RCC -> CFGR &= ~(0b11 << 0); // Reset bits 0-1.
-		RCC -> CFGR |= (0b01 << 0); // Use HSI as system clock (SW='01').
-		// Wait for clock switch.
-		loop_count = 0;
-		while ((((RCC -> CFGR) & (0b11 << 2)) != (0b01 << 2)) && (loop_count < RCC_TIMEOUT_COUNT)) {
-			RCC_Delay();
-			loop_count++; // Wait for SWS='01' or timeout.
-		}
-		// Check timeout.
-		if (loop_count < RCC_TIMEOUT_COUNT) {
-			// Disable MSI and HSE.
-			RCC -> CR &= ~(0b1 << 8); // Disable MSI (MSION='0').
-			RCC -> CR &= ~(0b1 << 16); // Disable HSE (HSEON='0').
-			// Update flag and frequency.
-			sysclk_on_hsi = 1;
-			rcc_sysclk_khz = RCC_HSI_FREQUENCY_KHZ;
+	if (rcc_ctx.rcc_clock_level != RCC_CLOCK_LEVEL_HSI_16MHZ) {
+		// Update level and prescalers.
+		rcc_ctx.rcc_clock_level = RCC_CLOCK_LEVEL_HSI_16MHZ;
+		rcc_sysclk_khz = RCC_HSI_FREQUENCY_KHZ;
+		RCC_ApplyClockRequests();
+		if (rcc_ctx.rcc_clock_level == RCC_CLOCK_LEVEL_HSI_16MHZ) {
+			unsigned char client_idx = 0;
+			for (client_idx=0 ; client_idx<RCC_CLOCK_CLIENT_LAST ; client_idx++) {
+				if (rcc_ctx.rcc_clock_callbacks[client_idx] != 0) {
+					rcc_ctx.rcc_clock_callbacks[client_idx]();
+				}
+			}
 		}
 	}
-	return sysclk_on_hsi;
+}
+
+/* RESET AND START CLOCK LEVEL TIME ACCOUNTING (RTC_Init() MUST BE CALLED BEFORE).
+ * @param:	None.
+ * @return:	None.
+ */
+void RCC_StartClockLevelTime(void) {
+	// Local variables.
+	unsigned char idx = 0;
+	// Reset statistics and start current slot.
+	for (idx=0 ; idx<RCC_CLOCK_LEVEL_LAST ; idx++) rcc_ctx.rcc_clock_level_time_ms[idx] = 0;
+	RTC_GetTimestampMilliseconds(&rcc_ctx.rcc_clock_level_start_ms);
+	rcc_ctx.rcc_clock_level_time_enabled = 1;
+}
+
+/* GET TIME SPENT IN A CLOCK LEVEL.
+ * @param level:	Clock level.
+ * @param time_ms:	Pointer that will contain the time spent in this level in ms (stop mode excluded).
+ * @return:			None.
+ */
+void RCC_GetClockLevelTime(RCC_ClockLevel level, unsigned int* time_ms) {
+	// Check parameter.
+	(*time_ms) = 0;
+	if (level >= RCC_CLOCK_LEVEL_LAST) return;
+	// Include current slot.
+	if (level == rcc_ctx.rcc_clock_level) {
+		RCC_UpdateClockLevelTime();
+	}
+	(*time_ms) = rcc_ctx.rcc_clock_level_time_ms[level];
 }
 
 /* CONFIGURE AND USE LSI AS LOW SPEED OSCILLATOR (32kHz INTERNAL RC).
@@ -19,10 +19,23 @@
 
 #define RTC_INIT_TIMEOUT_COUNT		1000
 #define RTC_WAKEUP_TIMER_DELAY_MAX	65536
+#define RTC_SECONDS_PER_DAY			86400
+#define RTC_YEAR_ORIGIN				2000
+#define RTC_YEAR_MAX				2099
+#define RTC_WEEKDAY_ORIGIN			6 // 01/01/2000 was a Saturday (Monday=1).
+
+/*** RTC local structures ***/
+
+typedef struct {
+	volatile unsigned char rtc_wakeup_timer_flag;
+	volatile unsigned char rtc_alarm_flag[RTC_ALARM_LAST];
+	unsigned int rtc_calendar_offset_seconds; // Sum of all calendar updates (modulo 2^32).
+} RTC_Context;
 
 /*** RTC local global variables ***/
 
-static volatile unsigned char rtc_wakeup_timer_flag = 0;
+static RTC_Context rtc_ctx;
+static const unsigned short rtc_days_before_month[12] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
 
 /*** RTC local functions ***/
 
@@ -35,12 +48,32 @@ void __attribute__((optimize("-O0"))) RTC_IRQHandler(void) {
 	if (((RTC -> ISR) & (0b1 << 10)) != 0) {
 		// Set local flag.
 		if (((RTC -> CR) & (0b1 << 14)) != 0) {
-			rtc_wakeup_timer_flag = 1;
+			rtc_ctx.rtc_wakeup_timer_flag = 1;
 		}
 		// Clear flags.
 		RTC -> ISR &= ~(0b1 << 10); // WUTF='0'.
 		EXTI -> PR |= (0b1 << EXTI_LINE_RTC_WAKEUP_TIMER);
 	}
+	// Alarm A interrupt.
+	if (((RTC -> ISR) & (0b1 << 8)) != 0) {
+		// Set local flag.
+		if (((RTC -> CR) & (0b1 << 12)) != 0) {
+			rtc_ctx.rtc_alarm_flag[RTC_ALARM_A] = 1;
+		}
+		// Clear flags.
+		RTC -> ISR &= ~(0b1 << 8); // ALRAF='0'.
+		EXTI -> PR |= (0b1 << EXTI_LINE_RTC_ALARM);
+	}
+	// Alarm B interrupt.
+	if (((RTC -> ISR) & (0b1 << 9)) != 0) {
+		// Set local flag.
+		if (((RTC -> CR) & (0b1 << 13)) != 0) {
+			rtc_ctx.rtc_alarm_flag[RTC_ALARM_B] = 1;
+		}
+		// Clear flags.
+		RTC -> ISR &= ~(0b1 << 9); // ALRBF='0'.
+		EXTI -> PR |= (0b1 << EXTI_LINE_RTC_ALARM);
+	}
 }
 
 /* ENTER INITIALIZATION MODE TO ENABLE RTC REGISTERS UPDATE.
@@ -74,6 +107,130 @@ static void RTC_ExitInitializationMode(void) {
 	RTC -> ISR &= ~(0b1 << 7); // INIT='0'.
 }
 
+/* DISABLE WAKE-UP TIMER AND WAIT FOR ITS CONFIGURATION TO BE WRITABLE.
+ * @param:						None.
+ * @return wutwf_success:		1 if wake-up timer can be configured, 0 otherwise.
+ */
+static unsigned char RTC_WaitWakeUpTimerWriteAccess(void) {
+	// Local variables.
+	unsigned char wutwf_success = 1;
+	unsigned int loop_count = 0;
+	// Enable register access.
+	RTC -> WPR = 0xCA;
+	RTC -> WPR = 0x53;
+	RTC -> CR &= ~(0b1 << 10); // Disable wake-up timer.
+	while (((RTC -> ISR) & (0b1 << 2)) == 0) {
+		// Wait for WUTWF='1' or timeout.
+		if (loop_count > RTC_INIT_TIMEOUT_COUNT) {
+			wutwf_success = 0;
+			break;
+		}
+		loop_count++;
+	}
+	return wutwf_success;
+}
+
+/* CONVERT A BCD VALUE TO BINARY.
+ * @param bcd_value:	Value to convert in BCD format.
+ * @return:				Value in binary format.
+ */
+static unsigned char RTC_BcdToBinary(unsigned char bcd_value) {
+	return ((bcd_value >> 4) * 10) + (bcd_value & 0x0F);
+}
+
+/* CONVERT A BINARY VALUE TO BCD.
+ * @param binary_value:	Value to convert in binary format (0 to 99).
+ * @return:				Value in BCD format.
+ */
+static unsigned char RTC_BinaryToBcd(unsigned char binary_value) {
+	return ((binary_value / 10) << 4) + (binary_value % 10);
+}
+
+/* CONVERT A CALENDAR DATE AND TIME TO SECONDS.
+ * @param timestamp:	Pointer to the date and time to convert.
+ * @return:				Number of seconds elapsed since 01/01/2000 00:00:00.
+ */
+static unsigned int RTC_TimestampToSeconds(Timestamp* timestamp) {
+	// Local variables.
+	unsigned char year = ((timestamp -> year) - RTC_YEAR_ORIGIN);
+	unsigned char month = (timestamp -> month);
+	unsigned int days = 0;
+	unsigned int seconds = 0;
+	// Compute number of days.
+	if ((month < 1) || (month > 12)) {
+		month = 1;
+	}
+	days = (365 * year) + ((year + 3) / 4); // Leap days of previous years (2000 is a leap year).
+	days += rtc_days_before_month[month - 1];
+	if (((year % 4) == 0) && (month > 2)) {
+		days++;
+	}
+	days += (timestamp -> date) - 1;
+	// Add time of day.
+	seconds = (days * RTC_SECONDS_PER_DAY);
+	seconds += (timestamp -> hours) * 3600;
+	seconds += (timestamp -> minutes) * 60;
+	seconds += (timestamp -> seconds);
+	return seconds;
+}
+
+/* CONVERT SECONDS TO CALENDAR DATE AND TIME.
+ * @param seconds:		Number of seconds elapsed since 01/01/2000 00:00:00.
+ * @param timestamp:	Pointer to the structure that will contain the date and time.
+ * @return weekday:		Day of the week (Monday=1 to Sunday=7).
+ */
+static unsigned char RTC_SecondsToTimestamp(unsigned int seconds, Timestamp* timestamp) {
+	// Local variables.
+	unsigned int days = (seconds / RTC_SECONDS_PER_DAY);
+	unsigned int seconds_of_day = (seconds % RTC_SECONDS_PER_DAY);
+	unsigned char weekday = (((days + RTC_WEEKDAY_ORIGIN - 1) % 7) + 1);
+	unsigned short days_in_year = 366;
+	unsigned char leap_day = 0;
+	unsigned char month = 12;
+	// Time of day.
+	(timestamp -> hours) = (seconds_of_day / 3600);
+	(timestamp -> minutes) = ((seconds_of_day % 3600) / 60);
+	(timestamp -> seconds) = (seconds_of_day % 60);
+	// Year.
+	(timestamp -> year) = RTC_YEAR_ORIGIN;
+	while (days >= days_in_year) {
+		days -= days_in_year;
+		(timestamp -> year)++;
+		days_in_year = (((timestamp -> year) % 4) == 0) ? 366 : 365;
+	}
+	// Month and date.
+	leap_day = (days_in_year == 366) ? 1 : 0;
+	while ((month > 1) && (days < (rtc_days_before_month[month - 1] + ((month > 2) ? leap_day : 0)))) {
+		month--;
+	}
+	(timestamp -> month) = month;
+	(timestamp -> date) = days - (rtc_days_before_month[month - 1] + ((month > 2) ? leap_day : 0)) + 1;
+	return weekday;
+}
+
+/* READ RTC CALENDAR.
+ * @param timestamp:	Pointer to the structure that will contain the current date and time.
+ * @return:				None.
+ */
+static void RTC_ReadCalendar(Timestamp* timestamp) {
+	// Local variables.
+	unsigned int rtc_tr = 0;
+	unsigned int rtc_dr = 0;
+	// Read time and date registers until both are coherent (shadow registers are bypassed).
+	do {
+		rtc_tr = (RTC -> TR);
+		rtc_dr = (RTC -> DR);
+	}
+	while ((rtc_tr != (RTC -> TR)) || (rtc_dr != (RTC -> DR)));
+	// Convert fields.
+	(timestamp -> year) = RTC_YEAR_ORIGIN + RTC_BcdToBinary((rtc_dr >> 16) & 0xFF);
+	(timestamp -> month) = RTC_BcdToBinary((rtc_dr >> 8) & 0x1F);
+	(timestamp -> date) = RTC_BcdToBinary(rtc_dr & 0x3F);
+	(timestamp -> hours) = RTC_BcdToBinary((rtc_tr >> 16) & 0x3F);
+	(timestamp -> minutes) = RTC_BcdToBinary((rtc_tr >> 8) & 0x7F);
+	(timestamp -> seconds) = RTC_BcdToBinary(rtc_tr & 0x7F);
+}
+
 /*** RTC functions ***/
 
 /* RESET RTC PERIPHERAL.
@@ -136,12 +293,19 @@ void RTC_Init(unsigned char* rtc_use_lse, unsigned int lsi_freq_hz) {
 	RTC -> CR &= ~(0b111 << 0);
 	RTC -> CR |= (0b100 << 0); // Wake-up timer clocked by RTC clock (1Hz).
 	RTC_ExitInitializationMode();
-	// Configure EXTI line.
+	// Init context.
+	rtc_ctx.rtc_wakeup_timer_flag = 0;
+	rtc_ctx.rtc_alarm_flag[RTC_ALARM_A] = 0;
+	rtc_ctx.rtc_alarm_flag[RTC_ALARM_B] = 0;
+	rtc_ctx.rtc_calendar_offset_seconds = 0;
+	// Configure EXTI lines.
 	EXTI_ConfigureLine(EXTI_LINE_RTC_WAKEUP_TIMER, EXTI_TRIGGER_RISING_EDGE);
-	// Disable interrupt and clear all flags.
-	RTC -> CR &= ~(0b1 << 14);
+	EXTI_ConfigureLine(EXTI_LINE_RTC_ALARM, EXTI_TRIGGER_RISING_EDGE);
+	// Disable interrupts and clear all flags.
+	RTC -> CR &= ~(0b111 << 12);
 	RTC -> ISR &= 0xFFFE0000;
 	EXTI -> PR |= (0b1 << EXTI_LINE_RTC_WAKEUP_TIMER);
+	EXTI -> PR |= (0b1 << EXTI_LINE_RTC_ALARM);
 	// Set interrupt priority.
 	NVIC_SetPriority(NVIC_IT_RTC, 2);
 	NVIC_EnableInterrupt(NVIC_IT_RTC);
@@ -159,10 +323,9 @@ void RTC_StartWakeUpTimer(unsigned int delay_seconds) {
 	}
 	// Check if timer si not allready running.
 	if (((RTC -> CR) & (0b1 << 10)) == 0) {
-		// Enable RTC and register access.
-		RTC_EnterInitializationMode();
+		// Wait for timer to be writable (initialization mode is not used to keep calendar running).
+		if (RTC_WaitWakeUpTimerWriteAccess() == 0) return;
 		// Configure wake-up timer.
-		RTC -> CR &= ~(0b1 << 10); // Disable wake-up timer.
 		RTC -> WUTR = (local_delay_seconds - 1);
 		// Clear flags.
 		RTC -> ISR &= ~(0b1 << 10); // WUTF='0'.
@@ -171,7 +334,6 @@ void RTC_StartWakeUpTimer(unsigned int delay_seconds) {
 		RTC -> CR |= (0b1 << 14); // WUTE='1'.
 		// Start timer.
 		RTC -> CR |= (0b1 << 10); // Enable wake-up timer.
-		RTC_ExitInitializationMode();
 	}
 }
 
@@ -180,10 +342,10 @@ void RTC_StartWakeUpTimer(unsigned int delay_seconds) {
  * @return:	None.
  */
 void RTC_StopWakeUpTimer(void) {
-	// Enable RTC and register access.
-	RTC_EnterInitializationMode();
+	// Enable register access.
+	RTC -> WPR = 0xCA;
+	RTC -> WPR = 0x53;
 	RTC -> CR &= ~(0b1 << 10); // Disable wake-up timer.
-	RTC_ExitInitializationMode();
 	// Disable interrupt.
 	RTC -> CR &= ~(0b1 << 14); // WUTE='0'.
 }
@@ -193,7 +355,7 @@ void RTC_StopWakeUpTimer(void) {
  * @return:	1 if the RTC interrupt occured, 0 otherwise.
  */
 volatile unsigned char RTC_GetWakeUpTimerFlag(void) {
-	return rtc_wakeup_timer_flag;
+	return rtc_ctx.rtc_wakeup_timer_flag;
 }
 
 /* CLEAR ALARM A INTERRUPT FLAG.
@@ -204,5 +366,206 @@ void RTC_ClearWakeUpTimerFlag(void) {
 	// Clear all flags.
 	RTC -> ISR &= ~(0b1 << 10); // WUTF='0'.
 	EXTI -> PR |= (0b1 << EXTI_LINE_RTC_WAKEUP_TIMER);
-	rtc_wakeup_timer_flag = 0;
+	rtc_ctx.rtc_wakeup_timer_flag = 0;
+}
+
+/* START RTC ALARM.
+ * @param alarm:		Alarm to use.
+ * @param utc_seconds:	Absolute UTC date and time of the alarm, in seconds since 01/01/2000 00:00:00.
+ * @return:				None.
+ */
+void RTC_StartAlarm(RTC_Alarm alarm, unsigned int utc_seconds) {
+	// Local variables.
+	Timestamp alarm_timestamp;
+	unsigned int alarm_register = 0;
+	unsigned int loop_count = 0;
+	// Check parameter.
+	if (alarm >= RTC_ALARM_LAST) return;
+	// Compute register value (date, hours, minutes and seconds are compared, MSKx='0').
+	RTC_SecondsToTimestamp(utc_seconds, &alarm_timestamp);
+	alarm_register |= (RTC_BinaryToBcd(alarm_timestamp.date) << 24);
+	alarm_register |= (RTC_BinaryToBcd(alarm_timestamp.hours) << 16);
+	alarm_register |= (RTC_BinaryToBcd(alarm_timestamp.minutes) << 8);
+	alarm_register |= (RTC_BinaryToBcd(alarm_timestamp.seconds) << 0);
+	// Enable register access.
+	RTC -> WPR = 0xCA;
+	RTC -> WPR = 0x53;
+	// Disable alarm and wait for write access.
+	RTC -> CR &= ~(0b1 << (8 + alarm)); // ALRxE='0'.
+	while (((RTC -> ISR) & (0b1 << alarm)) == 0) {
+		// Wait for ALRxWF='1' or timeout.
+		if (loop_count > RTC_INIT_TIMEOUT_COUNT) return;
+		loop_count++;
+	}
+	// Configure alarm (sub-seconds are not compared).
+	if (alarm == RTC_ALARM_A) {
+		RTC -> ALRMAR = alarm_register;
+		RTC -> ALRMASSR = 0;
+	}
+	else {
+		RTC -> ALRMBR = alarm_register;
+		RTC -> ALRMBSSR = 0;
+	}
+	// Clear flags.
+	RTC -> ISR &= ~(0b1 << (8 + alarm)); // ALRxF='0'.
+	EXTI -> PR |= (0b1 << EXTI_LINE_RTC_ALARM);
+	rtc_ctx.rtc_alarm_flag[alarm] = 0;
+	// Enable interrupt and alarm.
+	RTC -> CR |= (0b1 << (12 + alarm)); // ALRxIE='1'.
+	RTC -> CR |= (0b1 << (8 + alarm)); // ALRxE='1'.
+}
+
+/* STOP RTC ALARM.
+ * @param alarm:	Alarm to stop.
+ * @return:			None.
+ */
+void RTC_StopAlarm(RTC_Alarm alarm) {
+	// Check parameter.
+	if (alarm >= RTC_ALARM_LAST) return;
+	// Enable register access.
+	RTC -> WPR = 0xCA;
+	RTC -> WPR = 0x53;
+	// Disable alarm and interrupt.
+	RTC -> CR &= ~(0b1 << (8 + alarm)); // ALRxE='0'.
+	RTC -> CR &= ~(0b1 << (12 + alarm)); // ALRxIE='0'.
+}
+
+/* RETURN THE CURRENT ALARM INTERRUPT STATUS.
+ * @param alarm:	Alarm to check.
+ * @return:			1 if the alarm occured, 0 otherwise.
+ */
+volatile unsigned char RTC_GetAlarmFlag(RTC_Alarm alarm) {
+	// Check parameter.
+	if (alarm >= RTC_ALARM_LAST) return 0;
+	return rtc_ctx.rtc_alarm_flag[alarm];
+}
+
+/* CLEAR ALARM INTERRUPT FLAG.
+ * @param alarm:	Alarm flag to clear.
+ * @return:			None.
+ */
+void RTC_ClearAlarmFlag(RTC_Alarm alarm) {
+	// Check parameter.
+	if (alarm >= RTC_ALARM_LAST) return;
+	// Clear flags.
+	RTC -> ISR &= ~(0b1 << (8 + alarm)); // ALRxF='0'.
+	EXTI -> PR |= (0b1 << EXTI_LINE_RTC_ALARM);
+	rtc_ctx.rtc_alarm_flag[alarm] = 0;
+}
+
+/* SET RTC CALENDAR (UTC).
+ * @param timestamp:	Pointer to the UTC date and time to set.
+ * @return status:		1 if calendar was updated, 0 otherwise.
+ */
+unsigned char RTC_SetTimestamp(Timestamp* timestamp) {
+	// Local variables.
+	Timestamp previous_timestamp;
+	Timestamp normalized_timestamp;
+	unsigned char weekday = 0;
+	unsigned int rtc_tr = 0;
+	unsigned int rtc_dr = 0;
+	// Check parameters.
+	if (((timestamp -> year) < RTC_YEAR_ORIGIN) || ((timestamp -> year) > RTC_YEAR_MAX)) return 0;
+	if (((timestamp -> month) < 1) || ((timestamp -> month) > 12)) return 0;
+	if (((timestamp -> date) < 1) || ((timestamp -> date) > 31)) return 0;
+	if (((timestamp -> hours) > 23) || ((timestamp -> minutes) > 59) || ((timestamp -> seconds) > 59)) return 0;
+	// Compute registers value (24-hour format).
+	weekday = RTC_SecondsToTimestamp(RTC_TimestampToSeconds(timestamp), &normalized_timestamp);
+	rtc_dr |= (RTC_BinaryToBcd((timestamp -> year) - RTC_YEAR_ORIGIN) << 16);
+	rtc_dr |= (weekday << 13);
+	rtc_dr |= (RTC_BinaryToBcd(timestamp -> month) << 8);
+	rtc_dr |= (RTC_BinaryToBcd(timestamp -> date) << 0);
+	rtc_tr |= (RTC_BinaryToBcd(timestamp -> hours) << 16);
+	rtc_tr |= (RTC_BinaryToBcd(timestamp -> minutes) << 8);
+	rtc_tr |= (RTC_BinaryToBcd(timestamp -> seconds) << 0);
+	// Update calendar.
+	RTC_ReadCalendar(&previous_timestamp);
+	if (RTC_EnterInitializationMode() == 0) {
+		RTC_ExitInitializationMode();
+		return 0;
+	}
+	RTC -> TR = rtc_tr;
+	RTC -> DR = rtc_dr;
+	RTC_ExitInitializationMode();
+	// Keep monotonic timestamps continuous.
+	rtc_ctx.rtc_calendar_offset_seconds += (RTC_TimestampToSeconds(timestamp) - RTC_TimestampToSeconds(&previous_timestamp));
+	return 1;
+}
+
+/* GET RTC CALENDAR (UTC).
+ * @param timestamp:	Pointer to the structure that will contain the current UTC date and time.
+ * @return:				None.
+ */
+void RTC_GetTimestamp(Timestamp* timestamp) {
+	RTC_ReadCalendar(timestamp);
+}
+
+/* GET CURRENT UTC TIME.
+ * @param utc_seconds:	Pointer that will contain the number of seconds elapsed since 01/01/2000 00:00:00 UTC.
+ * @return:				None.
+ */
+void RTC_GetUtcSeconds(unsigned int* utc_seconds) {
+	// Local variables.
+	Timestamp timestamp;
+	// Read and convert calendar.
+	RTC_ReadCalendar(&timestamp);
+	(*utc_seconds) = RTC_TimestampToSeconds(&timestamp);
+}
+
+/* GET CURRENT RTC TIMESTAMP.
+ * @param timestamp_seconds:	Pointer that will contain the monotonic timestamp in seconds (not affected by calendar updates, used to measure durations).
+ * @return:						None.
+ */
+void RTC_GetTimestampSeconds(unsigned int* timestamp_seconds) {
+	// Local variables.
+	unsigned int utc_seconds = 0;
+	// Remove calendar updates.
+	RTC_GetUtcSeconds(&utc_seconds);
+	(*timestamp_seconds) = (utc_seconds - rtc_ctx.rtc_calendar_offset_seconds);
+}
+
+/* GET CURRENT RTC TIMESTAMP WITH SUB-SECOND RESOLUTION.
+ * @param timestamp_ms:	Pointer that will contain the monotonic timestamp in milliseconds (modulo 2^32).
+ * @return:				None.
+ */
+void RTC_GetTimestampMilliseconds(unsigned int* timestamp_ms) {
+	// Local variables.
+	unsigned int timestamp_seconds = 0;
+	unsigned int rtc_ssr = 0;
+	unsigned int prediv_s = ((RTC -> PRER) & 0x7FFF);
+	// Read sub-seconds and calendar until both are coherent (sub-seconds counter is reloaded every second).
+	do {
+		rtc_ssr = ((RTC -> SSR) & 0xFFFF);
+		RTC_GetTimestampSeconds(&timestamp_seconds);
+	}
+	while (((RTC -> SSR) & 0xFFFF) > rtc_ssr);
+	// Sub-seconds counter is a down-counter from PREDIV_S.
+	if (rtc_ssr > prediv_s) {
+		rtc_ssr = prediv_s;
+	}
+	(*timestamp_ms) = (timestamp_seconds * 1000) + (((prediv_s - rtc_ssr) * 1000) / (prediv_s + 1));
+}
+
+/* WRITE AN RTC BACKUP REGISTER (CONTENT IS KEPT DURING STOP MODE AND SYSTEM RESETS, UNTIL BACKUP DOMAIN IS RESET).
+ * @param register_idx:	Register index (0 to RTC_BACKUP_REGISTERS_NUMBER-1).
+ * @param value:		Value to write.
+ * @return:				None.
+ */
+void RTC_WriteBackupRegister(unsigned char register_idx, unsigned int value) {
+	// Check parameter (access is unlocked by DBP bit in PWR_Init()).
+	if (register_idx < RTC_BACKUP_REGISTERS_NUMBER) {
+		(&(RTC -> BKP0R))[register_idx] = value;
+	}
+}
+
+/* READ AN RTC BACKUP REGISTER.
+ * @param register_idx:	Register index (0 to RTC_BACKUP_REGISTERS_NUMBER-1).
+ * @param value:		Pointer that will contain the register value (0 if index is invalid).
+ * @return:				None.
+ */
+void RTC_ReadBackupRegister(unsigned char register_idx, unsigned int* value) {
+	(*value) = 0;
+	if (register_idx < RTC_BACKUP_REGISTERS_NUMBER) {
+		(*value) = (&(RTC -> BKP0R))[register_idx];
+	}
 }
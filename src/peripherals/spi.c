@@ -10,6 +10,7 @@
 #include "gpio.h"
 #include "lptim.h"
 #include "mapping.h"
+#include "rcc.h"
 #include "rcc_reg.h"
 #include "spi_reg.h"
 
@@ -24,6 +25,8 @@
  * @return:	None.
  */
 void SPI1_Init(void) {
+	// SPI clock and radio bit timing are derived from SYSCLK: request HSI.
+	RCC_SetClockRequest(RCC_CLOCK_CLIENT_SPI1, RCC_HSI_FREQUENCY_KHZ);
 	// Enable peripheral clock.
 	RCC -> APB2ENR |= (0b1 << 12); // SPI1EN='1'.
 	// Configure power enable pins.
@@ -52,6 +55,8 @@ void SPI1_Init(void) {
  * @return:	None.
  */
 void SPI1_Enable(void) {
+	// Request HSI.
+	RCC_SetClockRequest(RCC_CLOCK_CLIENT_SPI1, RCC_HSI_FREQUENCY_KHZ);
 	// Enable SPI1 peripheral.
 	RCC -> APB2ENR |= (0b1 << 12); // SPI1EN='1'.
 	SPI1 -> CR1 |= (0b1 << 6);
@@ -73,6 +78,8 @@ void SPI1_Disable(void) {
 	SPI1 -> SR &= 0xFFFFFEEF;
 	// Disable peripheral clock.
 	RCC -> APB2ENR &= ~(0b1 << 12); // SPI1EN='0'.
+	// Release system clock.
+	RCC_SetClockRequest(RCC_CLOCK_CLIENT_SPI1, 0);
 }
 
 /* SWITCH ALL SPI1 SLAVES ON.
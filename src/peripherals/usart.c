@@ -8,6 +8,8 @@
 #include "usart.h"
 
 #include "at.h"
+#include "dma.h"
+#include "exti.h"
 #include "gpio.h"
 #include "lptim.h"
 #include "mode.h"
@@ -20,29 +22,28 @@
 #ifdef ATM
 /*** USART local macros ***/
 
-// If defined, use TXE interrupt for sending data.
-//#define USE_TXE_INTERRUPT
 // Baud rate.
-#define USART_BAUD_RATE 		9600
+#define USART_BAUD_RATE 				9600
 // TX buffer size.
-#define USART_TX_BUFFER_SIZE	128
-#define USART2_TIMEOUT_COUNT	100000
+#define USART_TX_BUFFER_SIZE			256
+#define USART2_TIMEOUT_COUNT			100000
+// Decimal conversion.
+#define USART_DECIMAL_DIGITS_MAX		10
 
 /*** USART local structures ***/
 
-#ifdef USE_TXE_INTERRUPT
 typedef struct {
 	unsigned char tx_buf[USART_TX_BUFFER_SIZE]; 	// Transmit buffer.
-	unsigned int tx_buf_read_idx; 					// Reading index in TX buffer.
-	unsigned int tx_buf_write_idx; 					// Writing index in TX buffer.
+	unsigned short tx_buf_read_idx; 				// Reading index in TX buffer (updated by DMA interrupt).
+	unsigned short tx_buf_write_idx; 				// Writing index in TX buffer.
+	unsigned short tx_dma_length;					// Number of bytes currently transferred by DMA (0 if idle).
 } USART_Context;
-#endif
 
 /*** USART local global variables ***/
 
-#ifdef USE_TXE_INTERRUPT
 static volatile USART_Context usart_ctx;
-#endif
+// Powers of 10 used for division-free decimal conversion.
+static const unsigned int usart_pow10[USART_DECIMAL_DIGITS_MAX] = {1000000000, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10, 1};
 
 /*** USART local functions ***/
 
@@ -51,22 +52,11 @@ static volatile USART_Context usart_ctx;
  * @return:	None.
  */
 void __attribute__((optimize("-O0"))) USART2_IRQHandler(void) {
-#ifdef USE_TXE_INTERRUPT
-	// TXE interrupt.
-	if (((USART2 -> ISR) & (0b1 << 7)) != 0) {
-		if ((usart_ctx.tx_buf_read_idx) != (usart_ctx.tx_buf_write_idx)) {
-			USART2 -> TDR = (usart_ctx.tx_buf)[usart_ctx.tx_buf_read_idx]; // Fill transmit data register with new byte.
-			usart_ctx.tx_buf_read_idx++; // Increment TX read index.
-			if (usart_ctx.tx_buf_read_idx == USART_TX_BUFFER_SIZE) {
-				usart_ctx.tx_buf_read_idx = 0; // Manage roll-over.
-			}
-		}
-		else {
-			// No more bytes, disable TXE interrupt.
-			USART2 -> CR1 &= ~(0b1 << 7); // TXEIE = '0'.
-		}
+	// Transmission complete interrupt (only used to wake-up from sleep mode).
+	if ((((USART2 -> CR1) & (0b1 << 6)) != 0) && (((USART2 -> ISR) & (0b1 << 6)) != 0)) {
+		// Disable interrupt but keep TC flag for USART2_IsTxComplete().
+		USART2 -> CR1 &= ~(0b1 << 6); // TCIE='0'.
 	}
-#endif
 	// RXNE interrupt.
 	if (((USART2 -> ISR) & (0b1 << 5)) != 0) {
 		// Transmit incoming byte to AT command manager.
@@ -79,6 +69,40 @@ void __attribute__((optimize("-O0"))) USART2_IRQHandler(void) {
 		// Clear ORE flag.
 		USART2 -> ICR |= (0b1 << 3);
 	}
+	// Wake-up from stop mode interrupt.
+	if (((USART2 -> ISR) & (0b1 << 20)) != 0) {
+		// Clear WUF flag (received byte is processed by RXNE interrupt).
+		USART2 -> ICR |= (0b1 << 20);
+	}
+}
+
+/* START DMA TRANSFER OF THE NEXT CONTIGUOUS PART OF TX BUFFER (MUST BE CALLED WITH INTERRUPTS MASKED).
+ * @param:	None.
+ * @return:	None.
+ */
+static void USART2_StartDmaTransfer(void) {
+	// Check DMA state and pending bytes.
+	if ((usart_ctx.tx_dma_length != 0) || (usart_ctx.tx_buf_read_idx == usart_ctx.tx_buf_write_idx)) return;
+	// Transfer up to write index or buffer end.
+	if (usart_ctx.tx_buf_write_idx > usart_ctx.tx_buf_read_idx) {
+		usart_ctx.tx_dma_length = (usart_ctx.tx_buf_write_idx - usart_ctx.tx_buf_read_idx);
+	}
+	else {
+		usart_ctx.tx_dma_length = (USART_TX_BUFFER_SIZE - usart_ctx.tx_buf_read_idx);
+	}
+	DMA1_SetChannel4SourceAddr((unsigned int) &(usart_ctx.tx_buf[usart_ctx.tx_buf_read_idx]), usart_ctx.tx_dma_length);
+	DMA1_StartChannel4();
+}
+
+/* TRIGGER TRANSMISSION OF TX BUFFER CONTENT.
+ * @param:	None.
+ * @return:	None.
+ */
+static void USART2_FlushTxBuffer(void) {
+	// Indexes are shared with DMA interrupt.
+	NVIC_DisableInterrupts();
+	USART2_StartDmaTransfer();
+	NVIC_EnableInterrupts();
 }
 
 /* FILL USART TX BUFFER WITH A NEW BYTE.
@@ -86,25 +110,22 @@ void __attribute__((optimize("-O0"))) USART2_IRQHandler(void) {
  * @return:			None.
  */
 static void USART2_FillTxBuffer(unsigned char tx_byte) {
-#ifdef USE_TXE_INTERRUPT
-	// Fill buffer.
-	usart_ctx.tx_buf[usart_ctx.tx_buf_write_idx] = tx_byte;
-	// Manage index roll-over.
-	usart_ctx.tx_buf_write_idx++;
-	if (usart_ctx.tx_buf_write_idx == USART_TX_BUFFER_SIZE) {
-		usart_ctx.tx_buf_write_idx = 0;
+	// Compute next index.
+	unsigned short next_write_idx = (usart_ctx.tx_buf_write_idx + 1);
+	if (next_write_idx == USART_TX_BUFFER_SIZE) {
+		next_write_idx = 0;
 	}
-#else
-	// Fill transmit register.
-	USART2 -> TDR = tx_byte;
-	// Wait for transmission to complete.
+	// Wait for DMA to free space if buffer is full.
 	unsigned int loop_count = 0;
-	while (((USART2 -> ISR) & (0b1 << 7)) == 0) {
-		// Wait for TXE='1' or timeout.
+	while (next_write_idx == usart_ctx.tx_buf_read_idx) {
+		USART2_FlushTxBuffer();
+		// Drop byte in case of timeout.
 		loop_count++;
-		if (loop_count > USART2_TIMEOUT_COUNT) break;
+		if (loop_count > USART2_TIMEOUT_COUNT) return;
 	}
-#endif
+	// Fill buffer.
+	usart_ctx.tx_buf[usart_ctx.tx_buf_write_idx] = tx_byte;
+	usart_ctx.tx_buf_write_idx = next_write_idx;
 }
 
 /* CONVERTS A 4-BIT WORD TO THE ASCII CODE OF THE CORRESPONDING HEXADECIMAL CHARACTER.
@@ -119,17 +140,29 @@ static char USART2_HexaToAscii(unsigned char hexa_value) {
 	return hexa_ascii;
 }
 
-/* COMPUTE A POWER A 10.
- * @param power:	The desired power.
- * @return result:	Result of computation.
+/* CONVERT A VALUE TO DECIMAL DIGITS WITHOUT DIVISION (REPEATED SUBTRACTION OF POWERS OF 10).
+ * @param value:	Value to convert.
+ * @param digits:	Pointer to buffer that will contain the ASCII digits (most significant first, at least USART_DECIMAL_DIGITS_MAX bytes).
+ * @return length:	Number of significant digits (at least 1).
  */
-static unsigned int USART2_Pow10(unsigned char power) {
-	unsigned int result = 0;
-	unsigned int pow10_buf[10] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
-	if (power <= 9) {
-		result = pow10_buf[power];
+static unsigned char USART2_ConvertDecimal(unsigned int value, char* digits) {
+	// Local variables.
+	unsigned char idx = 0;
+	unsigned char length = 0;
+	char current_digit = 0;
+	for (idx=0 ; idx<USART_DECIMAL_DIGITS_MAX ; idx++) {
+		current_digit = '0';
+		while (value >= usart_pow10[idx]) {
+			value -= usart_pow10[idx];
+			current_digit++;
+		}
+		// Skip leading zeros.
+		if ((length != 0) || (current_digit != '0') || (idx == (USART_DECIMAL_DIGITS_MAX - 1))) {
+			digits[length] = current_digit;
+			length++;
+		}
 	}
-	return result;
+	return length;
 }
 #endif
 
@@ -141,14 +174,13 @@ static unsigned int USART2_Pow10(unsigned char power) {
  */
 void USART2_Init(void) {
 #ifdef ATM
-#ifdef USE_TXE_INTERRUPT
 	// Init context.
 	unsigned int idx = 0;
 	for (idx=0 ; idx<USART_TX_BUFFER_SIZE ; idx++) usart_ctx.tx_buf[idx] = 0;
 	usart_ctx.tx_buf_write_idx = 0;
 	usart_ctx.tx_buf_read_idx = 0;
-#endif
-	// Enable peripheral clock.
+	usart_ctx.tx_dma_length = 0;
+	// Enable peripheral clock (HSI kernel clock is independent of the system clock level).
 	RCC -> CR |= (0b1 << 1); // Enable HSI in stop mode (HSI16KERON='1').
 	RCC -> CCIPR |= (0b10 << 2); // Select HSI as USART clock.
 	RCC -> APB1ENR |= (0b1 << 17); // USART2EN='1'.
@@ -158,13 +190,18 @@ void USART2_Init(void) {
 	GPIO_Configure(&GPIO_USART2_RX, GPIO_MODE_ALTERNATE_FUNCTION, GPIO_TYPE_PUSH_PULL, GPIO_SPEED_HIGH, GPIO_PULL_NONE);
 	// Configure peripheral.
 	USART2 -> CR3 |= (0b1 << 12) | (0b1 << 23); // No overrun detection (OVRDIS='1') and clock enable in stop mode (UCESM='1').
+	USART2 -> CR3 |= (0b11 << 20) | (0b1 << 22); // Wake-up from stop mode on RXNE (WUS='11' and WUFIE='1').
+	USART2 -> CR3 |= (0b1 << 7); // Transmit with DMA (DMAT='1').
 	USART2 -> BRR = ((RCC_HSI_FREQUENCY_KHZ * 1000) / (USART_BAUD_RATE)); // BRR = (fCK)/(baud rate). See p.730 of RM0377 datasheet.
 	// Enable transmitter and receiver.
 	USART2 -> CR1 |= (0b1 << 5) | (0b11 << 2); // TE='1', RE='1' and RXNEIE='1'.
 	// Set interrupt priority.
 	NVIC_SetPriority(NVIC_IT_USART2, 3);
-	// Enable peripheral.
-	USART2 -> CR1 |= (0b11 << 0);
+	EXTI_ConfigureLine(EXTI_LINE_USART2, EXTI_TRIGGER_RISING_EDGE);
+	// Configure TX DMA channel.
+	DMA1_InitChannel4();
+	// Enable peripheral and wake-up from stop mode.
+	USART2 -> CR1 |= (0b11 << 0); // UE='1' and UESM='1'.
 #else
 	// Configure TX and RX GPIOs.
 	GPIO_Configure(&GPIO_USART2_TX, GPIO_MODE_ANALOG, GPIO_TYPE_OPEN_DRAIN, GPIO_SPEED_LOW, GPIO_PULL_NONE);
@@ -173,6 +210,26 @@ void USART2_Init(void) {
 }
 
 #ifdef ATM
+/* CALLBACK CALLED BY DMA INTERRUPT WHEN A PART OF TX BUFFER HAS BEEN TRANSFERRED.
+ * @param:	None.
+ * @return:	None.
+ */
+void USART2_DmaTransferComplete(void) {
+	// Release transferred bytes.
+	DMA1_StopChannel4();
+	usart_ctx.tx_buf_read_idx += usart_ctx.tx_dma_length;
+	if (usart_ctx.tx_buf_read_idx >= USART_TX_BUFFER_SIZE) {
+		usart_ctx.tx_buf_read_idx = 0;
+	}
+	usart_ctx.tx_dma_length = 0;
+	// Transmit remaining bytes.
+	USART2_StartDmaTransfer();
+	// Wake-up core when last byte is out of shift register.
+	if (usart_ctx.tx_dma_length == 0) {
+		USART2 -> CR1 |= (0b1 << 6); // TCIE='1'.
+	}
+}
+
 /* SEND A BYTE THROUGH USART.
  * @param byte_to_send:	The byte to send.
  * @param format:		Display format (see ByteDisplayFormat enumeration in usart.h).
@@ -180,14 +237,12 @@ void USART2_Init(void) {
  * @return: 			None.
  */
 void USART2_SendValue(unsigned int tx_value, USART_Format format, unsigned char print_prefix) {
-	// Disable interrupt.
-	NVIC_DisableInterrupt(NVIC_IT_USART2);
 	// Local variables.
 	unsigned char first_non_zero_found = 0;
 	unsigned int idx;
 	unsigned char current_value = 0;
-	unsigned int current_power = 0;
-	unsigned int previous_decade = 0;
+	char digits[USART_DECIMAL_DIGITS_MAX];
+	unsigned char digits_length = 0;
 	// Fill TX buffer according to format.
 	switch (format) {
 	case USART_FORMAT_BINARY:
@@ -220,12 +275,12 @@ void USART2_SendValue(unsigned int tx_value, USART_Format format, unsigned char
 		}
 		// Maximum 4 bytes.
 		for (idx=3 ; idx>=0 ; idx--) {
-			current_value = (tx_value & (0xFF << (8*idx))) >> (8*idx);
+			current_value = (tx_value >> (8 * idx)) & 0xFF;
 			if (current_value != 0) {
 				first_non_zero_found = 1;
 			}
 			if ((first_non_zero_found != 0) || (idx == 0)) {
-				USART2_FillTxBuffer(USART2_HexaToAscii((current_value & 0xF0) >> 4));
+				USART2_FillTxBuffer(USART2_HexaToAscii(current_value >> 4));
 				USART2_FillTxBuffer(USART2_HexaToAscii(current_value & 0x0F));
 			}
 			if (idx == 0) {
@@ -235,19 +290,9 @@ void USART2_SendValue(unsigned int tx_value, USART_Format format, unsigned char
 		break;
 	case USART_FORMAT_DECIMAL:
 		// Maximum 10 digits.
-		for (idx=9 ; idx>=0 ; idx--) {
-			current_power = USART2_Pow10(idx);
-			current_value = (tx_value - previous_decade) / current_power;
-			previous_decade += current_value * current_power;
-			if (current_value != 0) {
-				first_non_zero_found = 1;
-			}
-			if ((first_non_zero_found != 0) || (idx == 0)) {
-				USART2_FillTxBuffer(current_value + '0');
-			}
-			if (idx == 0) {
-				break;
-			}
+		digits_length = USART2_ConvertDecimal(tx_value, digits);
+		for (idx=0 ; idx<digits_length ; idx++) {
+			USART2_FillTxBuffer(digits[idx]);
 		}
 		break;
 	case USART_FORMAT_ASCII:
@@ -257,12 +302,64 @@ void USART2_SendValue(unsigned int tx_value, USART_Format format, unsigned char
 		}
 		break;
 	}
+	// Start transmission.
+	USART2_FlushTxBuffer();
+}
 
-	/* Enable interrupt */
-#ifdef USE_TXE_INTERRUPT
-	USART2 -> CR1 |= (0b1 << 7); // (TXEIE = '1').
-#endif
-	NVIC_EnableInterrupt(NVIC_IT_USART2);
+/* SEND A SIGNED DECIMAL VALUE THROUGH USART2.
+ * @param tx_value:	Value to send.
+ * @return:			None.
+ */
+void USART2_SendSignedValue(signed int tx_value) {
+	// Print sign and absolute value.
+	if (tx_value < 0) {
+		USART2_FillTxBuffer('-');
+		// Negate in unsigned arithmetic to support INT_MIN.
+		USART2_SendValue((0u - (unsigned int) tx_value), USART_FORMAT_DECIMAL, 0);
+	}
+	else {
+		USART2_SendValue((unsigned int) tx_value, USART_FORMAT_DECIMAL, 0);
+	}
+}
+
+/* SEND A SIGNED FIXED-POINT VALUE THROUGH USART2.
+ * @param tx_value:		Value to send, expressed in units of 10^(-number_of_decimals) (e.g. centi-degrees).
+ * @param number_of_decimals:	Number of digits after the decimal point.
+ * @return:				None.
+ */
+void USART2_SendFixedPoint(signed int tx_value, unsigned char number_of_decimals) {
+	// Local variables.
+	char digits[USART_DECIMAL_DIGITS_MAX];
+	unsigned char digits_length = 0;
+	unsigned char idx = 0;
+	unsigned int tx_value_abs = (unsigned int) tx_value;
+	// Print sign (negate in unsigned arithmetic to support INT_MIN).
+	if (tx_value < 0) {
+		USART2_FillTxBuffer('-');
+		tx_value_abs = 0u - (unsigned int) tx_value;
+	}
+	digits_length = USART2_ConvertDecimal(tx_value_abs, digits);
+	// Integer part.
+	if (digits_length > number_of_decimals) {
+		for (idx=0 ; idx<(digits_length - number_of_decimals) ; idx++) {
+			USART2_FillTxBuffer(digits[idx]);
+		}
+	}
+	else {
+		USART2_FillTxBuffer('0');
+	}
+	// Fractional part with leading zeros.
+	if (number_of_decimals > 0) {
+		USART2_FillTxBuffer('.');
+		for (idx=digits_length ; idx<number_of_decimals ; idx++) {
+			USART2_FillTxBuffer('0');
+		}
+		for (idx=((digits_length > number_of_decimals) ? (digits_length - number_of_decimals) : 0) ; idx<digits_length ; idx++) {
+			USART2_FillTxBuffer(digits[idx]);
+		}
+	}
+	// Start transmission.
+	USART2_FlushTxBuffer();
 }
 
 /* SEND A BYTE ARRAY THROUGH USART2.
@@ -270,16 +367,57 @@ void USART2_SendValue(unsigned int tx_value, USART_Format format, unsigned char
  * @return:				None.
  */
 void USART2_SendString(char* tx_string) {
-	// Disable interrupt.
-	NVIC_DisableInterrupt(NVIC_IT_USART2);
 	// Fill TX buffer with new bytes.
 	while (*tx_string) {
 		USART2_FillTxBuffer((unsigned char) *(tx_string++));
 	}
-	// Enable interrupt.
-	#ifdef USE_TXE_INTERRUPT
-		USART2 -> CR1 |= (0b1 << 7); // (TXEIE = '1').
-	#endif
-	NVIC_EnableInterrupt(NVIC_IT_USART2);
+	// Start transmission.
+	USART2_FlushTxBuffer();
+}
+
+/* SEND RAW BYTES THROUGH USART2.
+ * @param tx_bytes:		Bytes to send (may contain null bytes).
+ * @param tx_length:	Number of bytes.
+ * @return:				None.
+ */
+void USART2_SendBytes(unsigned char* tx_bytes, unsigned int tx_length) {
+	// Local variables.
+	unsigned int idx = 0;
+	// Fill TX buffer with new bytes.
+	for (idx=0 ; idx<tx_length ; idx++) {
+		USART2_FillTxBuffer(tx_bytes[idx]);
+	}
+	// Start transmission.
+	USART2_FlushTxBuffer();
+}
+
+/* GET FREE SPACE IN USART2 TX BUFFER.
+ * @param:					None.
+ * @return tx_free_space:	Number of bytes which can be sent without waiting.
+ */
+unsigned int USART2_GetTxFreeSpace(void) {
+	// Local variables.
+	unsigned int tx_used_space = 0;
+	unsigned short tx_buf_read_idx = usart_ctx.tx_buf_read_idx;
+	// Compute used space.
+	if (usart_ctx.tx_buf_write_idx >= tx_buf_read_idx) {
+		tx_used_space = (usart_ctx.tx_buf_write_idx - tx_buf_read_idx);
+	}
+	else {
+		tx_used_space = (USART_TX_BUFFER_SIZE + usart_ctx.tx_buf_write_idx - tx_buf_read_idx);
+	}
+	return (USART_TX_BUFFER_SIZE - 1 - tx_used_space);
+}
+
+/* CHECK IF ALL BYTES HAVE BEEN TRANSMITTED.
+ * @param:	None.
+ * @return:	1 if TX buffer is empty and last frame is completed (stop mode allowed), 0 otherwise.
+ */
+unsigned char USART2_IsTxComplete(void) {
+	// Check buffer, DMA and TC flag.
+	if (usart_ctx.tx_buf_read_idx != usart_ctx.tx_buf_write_idx) return 0;
+	if (usart_ctx.tx_dma_length != 0) return 0;
+	if (((USART2 -> ISR) & (0b1 << 6)) == 0) return 0;
+	return 1;
 }
 #endif
@@ -7,23 +7,22 @@
 
 #include "mcu_api.h"
 
-#include "adc.h"
 #include "aes.h"
 #include "exti.h"
-#include "i2c.h"
 #include "iwdg.h"
 #include "lptim.h"
 #include "mode.h"
 #include "nvm.h"
 #include "pwr.h"
 #include "rtc.h"
-#include "sht3x.h"
+#include "sensors.h"
 #include "sigfox_types.h"
 #include "usart.h"
 
 /*** MCU API local macros ***/
 
-#define MCU_API_MALLOC_BUFFER_SIZE		200
+#define MCU_API_MALLOC_BUFFER_SIZE					200
+#define MCU_API_MEASUREMENT_MAX_AGE_SECONDS			300
 
 /*** MCU API local structures ***/
 
@@ -97,27 +96,14 @@ sfx_u8 MCU_API_free(sfx_u8* ptr) {
  * \retval MCU_ERR_API_VOLT_TEMP:                Get voltage/temperature error
  *******************************************************************/
 sfx_u8 MCU_API_get_voltage_temperature(sfx_u16* voltage_idle, sfx_u16* voltage_tx, sfx_s16* temperature) {
-	// Perform temperature measurement.
-	I2C1_Init();
-	I2C1_PowerOn();
-	SHT3X_PerformMeasurements();
-	I2C1_PowerOff();
-	I2C1_Disable();
-	// Perform voltage measurement.
-	ADC1_Init();
-	ADC1_PowerOn();
-	ADC1_PerformAllMeasurements();
-	ADC1_PowerOff();
-	ADC1_Disable();
+	// Get sensors data (reuse last snapshot if recent enough).
+	SENSORS_Snapshot sensors_snapshot;
+	SENSORS_GetSnapshot(&sensors_snapshot, MCU_API_MEASUREMENT_MAX_AGE_SECONDS, SHT3X_REPEATABILITY_LOW);
 	// Get MCU supply voltage.
-	unsigned int mcu_supply_voltage_mv = 0;
-	ADC1_GetMcuVoltage(&mcu_supply_voltage_mv);
-	(*voltage_idle) = (sfx_u16) mcu_supply_voltage_mv;
-	(*voltage_tx) = (sfx_u16) mcu_supply_voltage_mv;
-	// Get MCU internal temperature.
-	signed char mcu_temperature_degrees = 0;
-	SHT3X_GetTemperatureComp2(&mcu_temperature_degrees);
-	(*temperature) = ((sfx_s16) mcu_temperature_degrees) * 10; // Unit = 1/10 of degrees.
+	(*voltage_idle) = (sfx_u16) sensors_snapshot.mcu_voltage_mv;
+	(*voltage_tx) = (sfx_u16) sensors_snapshot.mcu_voltage_mv;
+	// Get temperature.
+	(*temperature) = ((sfx_s16) sensors_snapshot.temperature_degrees_comp2) * 10; // Unit = 1/10 of degrees.
 	return SFX_ERR_NONE;
 }
 
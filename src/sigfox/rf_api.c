@@ -7,12 +7,14 @@
 
 #include "rf_api.h"
 
+#include "accounting.h"
 #include "dma.h"
 #include "exti.h"
 #include "iwdg.h"
 #include "mapping.h"
 #include "mode.h"
 #include "nvic.h"
+#include "profiler.h"
 #include "pwr.h"
 #include "rcc.h"
 #include "rtc.h"
@@ -190,6 +192,7 @@ sfx_u8 RF_API_send(sfx_u8 *stream, sfx_modulation_type_t type, sfx_u8 size) {
 	unsigned char stream_bit_idx = 0;
 	unsigned char s2lp_fifo_sample_idx = 0;
 	unsigned char s2lp_fdev = RF_API_S2LP_FDEV_NEGATIVE; // Effective deviation.
+	PROFILER_BEGIN(PROFILER_PROBE_RF_API_SEND);
 	// Go to ready state.
 	S2LP_SendCommand(S2LP_CMD_READY);
 	S2LP_WaitForStateSwitch(S2LP_STATE_READY);
@@ -205,6 +208,7 @@ sfx_u8 RF_API_send(sfx_u8 *stream, sfx_modulation_type_t type, sfx_u8 size) {
 	NVIC_EnableInterrupt(NVIC_IT_EXTI_4_15);
 	// Start radio
 	S2LP_SendCommand(S2LP_CMD_TX);
+	ACCOUNTING_EnterState(ACCOUNTING_STATE_TX);
 	// Byte loop.
 	for (stream_byte_idx=0 ; stream_byte_idx<size ; stream_byte_idx++) {
 		// Bit loop.
@@ -253,9 +257,11 @@ sfx_u8 RF_API_send(sfx_u8 *stream, sfx_modulation_type_t type, sfx_u8 size) {
 	NVIC_DisableInterrupt(NVIC_IT_EXTI_4_15);
 	// Stop radio.
 	S2LP_SendCommand(S2LP_CMD_SABORT);
+	ACCOUNTING_ExitState(ACCOUNTING_STATE_TX);
 	S2LP_WaitForStateSwitch(S2LP_STATE_READY);
 	S2LP_SendCommand(S2LP_CMD_STANDBY);
 	S2LP_WaitForStateSwitch(S2LP_STATE_STANDBY);
+	PROFILER_END(PROFILER_PROBE_RF_API_SEND);
 	// Return.
 	return SFX_ERR_NONE;
 }
@@ -352,6 +358,7 @@ sfx_u8 RF_API_wait_frame(sfx_u8 *frame, sfx_s16 *rssi, sfx_rx_state_enum_t * sta
 		rf_api_ctx.rf_api_s2lp_irq_flag = 0;
 		// Start radio.
 		S2LP_SendCommand(S2LP_CMD_RX);
+		ACCOUNTING_EnterState(ACCOUNTING_STATE_RX);
 		// Enable external GPIO.
 		EXTI_ClearAllFlags();
 		NVIC_EnableInterrupt(NVIC_IT_EXTI_4_15);
@@ -385,6 +392,7 @@ sfx_u8 RF_API_wait_frame(sfx_u8 *frame, sfx_s16 *rssi, sfx_rx_state_enum_t * sta
 		}
 		// Stop radio.
 		S2LP_SendCommand(S2LP_CMD_SABORT);
+		ACCOUNTING_ExitState(ACCOUNTING_STATE_RX);
 		S2LP_WaitForStateSwitch(S2LP_STATE_READY);
 		S2LP_SendCommand(S2LP_CMD_FLUSHRXFIFO);
 		S2LP_SendCommand(S2LP_CMD_STANDBY);